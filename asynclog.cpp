@@ -0,0 +1,412 @@
+#include "asynclog.h"
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+using namespace std;
+using namespace gdlib;
+
+
+network::AsyncLog::state_t network::AsyncLog::s_state;
+
+
+
+/**
+ * @brief ...the ring empty, each slot waiting for the write of its position
+ *
+ */
+network::AsyncLog::state_t::state_t()
+{
+   for( uint32_t nIndex=0; nIndex<s_nRecords; ++nIndex )
+   {
+      aRecords[nIndex].nSequence.store( nIndex, std::memory_order_relaxed );
+   }
+}
+
+
+
+/**
+ * @brief ...process exit, the drain thread hands over what is left before it ends
+ *
+ */
+network::AsyncLog::state_t::~state_t()
+{
+   {
+      lock_guard<std::mutex> lock( mux );
+      bStop = true;
+   }
+   cvStop.notify_all();
+   if( true == thdDrain.joinable() )
+   {
+      thdDrain.join();
+   }
+   for( const int32_t fd : { fdFile, fdRetired } )
+   {
+      if( -1 != fd )
+      {
+         ::close( fd );
+      }
+   }
+}
+
+
+
+/**
+ * @brief ...take the next free record of the ring, lock-free between the writers
+ *
+ * @return network::AsyncLog::record_t* nullptr the ring is full
+ */
+network::AsyncLog::record_t* network::AsyncLog::claim_()
+{
+   uint64_t nPosition = s_state.nTail.load( std::memory_order_relaxed );
+   while( true )
+   {
+      record_t&      record    = s_state.aRecords[nPosition & (s_nRecords - 1)];
+      const uint64_t nSequence = record.nSequence.load( std::memory_order_acquire );
+      const int64_t  nDiff     = static_cast<int64_t>( nSequence - nPosition );
+      if( 0 == nDiff )
+      {
+         if( true == s_state.nTail.compare_exchange_weak( nPosition, nPosition + 1, std::memory_order_relaxed ) )
+         {
+            return &record;
+         }
+      } else if( nDiff < 0 )
+      {
+         // the drain thread has not read this slot a lap ago
+         return nullptr;
+      } else
+      {
+         nPosition = s_state.nTail.load( std::memory_order_relaxed );
+      }
+   }
+}
+
+
+
+/**
+ * @brief ...start the drain thread, once.  the only write that is not free of syscalls
+ *
+ */
+void network::AsyncLog::start_()
+{
+   lock_guard<std::mutex> lock( s_state.mux );
+   if( (true == s_state.bStarted.load( std::memory_order_relaxed )) || (true == s_state.bStop) )
+   {
+      return;
+   }
+   s_state.thdDrain = std::thread( &AsyncLog::drain_ );
+   s_state.bStarted.store( true, std::memory_order_release );
+}
+
+
+
+/**
+ * @brief ...drain thread, every interval format the records written since and hand them to the sink.  the sink is taken
+ * under the lock and called without it, a callback may call the setters or write
+ *
+ */
+void network::AsyncLog::drain_()
+{
+   std::string strLines;
+   std::string strLine;
+   unique_lock<std::mutex> lock( s_state.mux );
+   while( true )
+   {
+      const bool bStop = s_state.cvStop.wait_for( lock, std::chrono::milliseconds( s_state.nInterval_ms ), []{ return s_state.bStop; } );
+      bool       bMore = true;
+      while( true == bMore )
+      {
+         // per batch, a setter takes effect on the next one
+         const logCallBack_t cbLog = s_state.cbLog;
+         s_state.fdInUse = (-1 != s_state.fdFile) ? s_state.fdFile : STDERR_FILENO;
+         const int32_t       fd    = s_state.fdInUse;
+         lock.unlock();
+         bMore = consume_( cbLog, fd, strLines, strLine );
+         lock.lock();
+         s_state.fdInUse = -1;
+         if( -1 != s_state.fdRetired )
+         {
+            ::close( s_state.fdRetired );
+            s_state.fdRetired = -1;
+         }
+      }
+      if( true == bStop )
+      {
+         return;
+      }
+   }
+}
+
+
+
+/**
+ * @brief ...drain thread, hand over a batch of records.  a file or stderr gets the batch in one write, each line prefixed
+ * with the time and the level
+ *
+ * @param a_cbLog ...the callback of the sink, nullptr none
+ * @param a_fd ...else the file or stderr
+ * @param a_strLines ...scratch
+ * @param a_strLine ...scratch
+ * @return bool true when records were read, there may be more
+ */
+bool network::AsyncLog::consume_( const logCallBack_t a_cbLog, const int32_t a_fd, std::string& a_strLines, std::string& a_strLine )
+{
+   static const char* s_apszLevels[] = { "ALERT", "ERR", "WRN_ALERT", "WRN", "INF", "OK" };
+   a_strLines.clear();
+   uint64_t nHead  = s_state.nHead.load( std::memory_order_relaxed );
+   uint32_t nCount = 0;
+   for( ; nCount<256; ++nCount, ++nHead )
+   {
+      record_t& record = s_state.aRecords[nHead & (s_nRecords - 1)];
+      if( record.nSequence.load( std::memory_order_acquire ) != nHead + 1 )
+      {
+         break;
+      }
+      format_( record, a_strLine );
+      const LogLevel level = record.level;
+      const uint64_t nTime_ns = record.nTime_ns;
+      record.nSequence.store( nHead + s_nRecords, std::memory_order_release );   // free for the writer a lap ahead
+      s_state.nHead.store( nHead + 1, std::memory_order_release );
+      if( nullptr != a_cbLog )
+      {
+         a_cbLog( level, a_strLine.c_str() );
+         continue;
+      }
+      const time_t nSeconds = static_cast<time_t>( nTime_ns / 1000000000 );
+      struct tm    tmLocal;
+      char         szPrefix[64];
+      localtime_r( &nSeconds, &tmLocal );
+      const size_t nLength = strftime( szPrefix, sizeof( szPrefix ), "%Y-%m-%d %H:%M:%S", &tmLocal );
+      snprintf( szPrefix + nLength, sizeof( szPrefix ) - nLength, ".%06lu %s ", (nTime_ns % 1000000000) / 1000,
+                s_apszLevels[static_cast<uint32_t>( level ) % (sizeof( s_apszLevels ) / sizeof( s_apszLevels[0] ))] );
+      a_strLines.append( szPrefix ).append( a_strLine ).append( 1, '\n' );
+   }
+   if( false == a_strLines.empty() )
+   {
+      size_t nDone = 0;
+      while( nDone < a_strLines.size() )
+      {
+         const ssize_t nWritten = ::write( a_fd, a_strLines.data() + nDone, a_strLines.size() - nDone );
+         if( nWritten <= 0 )
+         {
+            if( (-1 == nWritten) && (EINTR == errno) )
+            {
+               continue;
+            }
+            break;
+         }
+         nDone += static_cast<size_t>( nWritten );
+      }
+   }
+   return 0 != nCount;
+}
+
+
+
+/**
+ * @brief ...drain thread, the text of a record: its format with the arguments, printf conversions applied to the type
+ * the argument was stored as
+ *
+ * @param a_record ...
+ * @param a_strLine ...the text
+ */
+void network::AsyncLog::format_( const record_t& a_record, std::string& a_strLine )
+{
+   a_strLine.clear();
+   const char* pszFormat = (nullptr != a_record.pszFormat) ? a_record.pszFormat : "";
+   uint32_t    nArg      = 0;
+   char        szSpec[32];
+   char        szValue[128];
+   while( '\0' != *pszFormat )
+   {
+      const char* pszPercent = strchr( pszFormat, '%' );
+      if( nullptr == pszPercent )
+      {
+         a_strLine.append( pszFormat );
+         break;
+      }
+      a_strLine.append( pszFormat, static_cast<size_t>( pszPercent - pszFormat ) );
+      pszFormat = pszPercent + 1;
+      if( '%' == *pszFormat )
+      {
+         a_strLine.append( 1, '%' );
+         ++pszFormat;
+         continue;
+      }
+      if( 'm' == *pszFormat )
+      {
+         char szError[128];
+         a_strLine.append( strerror_r( a_record.nError, szError, sizeof( szError ) ) );
+         ++pszFormat;
+         continue;
+      }
+      // flags, width and precision are kept, the length modifier is the one of the stored type
+      size_t nSpec = 0;
+      szSpec[nSpec++] = '%';
+      while( ('\0' != *pszFormat) && (nullptr != strchr( "-+ #0123456789.", *pszFormat )) && (nSpec < sizeof( szSpec ) - 4) )
+      {
+         szSpec[nSpec++] = *pszFormat++;
+      }
+      while( ('\0' != *pszFormat) && (nullptr != strchr( "hlLqjzt", *pszFormat )) )
+      {
+         ++pszFormat;
+      }
+      const char cConversion = *pszFormat;
+      if( '\0' == cConversion )
+      {
+         break;
+      }
+      ++pszFormat;
+      if( nArg >= a_record.nArgs )
+      {
+         a_strLine.append( "<?>" );
+         continue;
+      }
+      const arg_t& arg = a_record.aArgs[nArg++];
+      switch( arg.type )
+      {
+         case argType_t::INT:
+         case argType_t::UINT:
+         {
+            const char cInteger = (nullptr != strchr( "diouxXc", cConversion )) ? cConversion : ((argType_t::INT == arg.type) ? 'd' : 'u');
+            if( 'c' == cInteger )
+            {
+               szSpec[nSpec++] = 'c';
+               szSpec[nSpec]   = '\0';
+               snprintf( szValue, sizeof( szValue ), szSpec, static_cast<int>( arg.nInt ) );
+            } else
+            {
+               szSpec[nSpec++] = 'l';
+               szSpec[nSpec++] = 'l';
+               szSpec[nSpec++] = cInteger;
+               szSpec[nSpec]   = '\0';
+               if( argType_t::INT == arg.type )
+               {
+                  snprintf( szValue, sizeof( szValue ), szSpec, static_cast<long long>( arg.nInt ) );
+               } else
+               {
+                  snprintf( szValue, sizeof( szValue ), szSpec, static_cast<unsigned long long>( arg.nUint ) );
+               }
+            }
+            break;
+         }
+         case argType_t::DOUBLE:
+            szSpec[nSpec++] = (nullptr != strchr( "feEgGaA", cConversion )) ? cConversion : 'g';
+            szSpec[nSpec]   = '\0';
+            snprintf( szValue, sizeof( szValue ), szSpec, arg.dDouble );
+            break;
+         case argType_t::TEXT:
+            szSpec[nSpec++] = 's';
+            szSpec[nSpec]   = '\0';
+            snprintf( szValue, sizeof( szValue ), szSpec, (arg.nUint < s_nText) ? a_record.szText + arg.nUint : "(null)" );
+            break;
+         default:
+            snprintf( szValue, sizeof( szValue ), "%p", reinterpret_cast<void*>( arg.nUint ) );
+            break;
+      }
+      a_strLine.append( szValue );
+   }
+}
+
+
+
+/**
+ * @brief ...the drain thread hands each line to a_cbLog instead of writing it, nullptr back to the file or stderr.  from
+ * the next batch on
+ *
+ * @param a_cbLog ...called on the drain thread
+ */
+void network::AsyncLog::setCallback( const logCallBack_t a_cbLog )
+{
+   lock_guard<std::mutex> lock( s_state.mux );
+   s_state.cbLog = a_cbLog;
+}
+
+
+
+/**
+ * @brief ...append the lines to a file instead of stderr, when there is no callback
+ *
+ * @param a_strPath ...created if missing, empty back to stderr
+ * @return bool false, errno from open
+ */
+bool network::AsyncLog::setFile( const std::string& a_strPath )
+{
+   int32_t fd = -1;
+   if( false == a_strPath.empty() )
+   {
+      fd = ::open( a_strPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644 );
+      if( -1 == fd )
+      {
+         return false;
+      }
+   }
+   lock_guard<std::mutex> lock( s_state.mux );
+   if( s_state.fdFile == s_state.fdInUse )
+   {
+      s_state.fdRetired = s_state.fdFile;     // the batch being written keeps it
+   } else if( -1 != s_state.fdFile )
+   {
+      ::close( s_state.fdFile );
+   }
+   s_state.fdFile = fd;
+   return true;
+}
+
+
+
+/**
+ * @brief ...how often the drain thread looks at the ring.  the writers never wake it, a shorter interval shows the
+ * lines sooner and a longer one leaves the drain thread asleep longer
+ *
+ * @param a_nInterval_ms ...default 20
+ */
+void network::AsyncLog::setInterval( const uint32_t a_nInterval_ms )
+{
+   lock_guard<std::mutex> lock( s_state.mux );
+   s_state.nInterval_ms = (0 != a_nInterval_ms) ? a_nInterval_ms : 1;
+}
+
+
+
+/**
+ * @brief ...wait until the drain thread has handed over the records written before the call.  returns at once on the
+ * drain thread (a callback) and once the drain thread is stopping, what is written then may never be handed over
+ *
+ */
+void network::AsyncLog::flush()
+{
+   const uint64_t nTail = s_state.nTail.load( std::memory_order_acquire );
+   if( (false == s_state.bStarted.load( std::memory_order_acquire )) || (std::this_thread::get_id() == s_state.thdDrain.get_id()) )
+   {
+      return;
+   }
+   while( s_state.nHead.load( std::memory_order_acquire ) < nTail )
+   {
+      {
+         lock_guard<std::mutex> lock( s_state.mux );
+         if( true == s_state.bStop )
+         {
+            return;
+         }
+      }
+      std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+   }
+}
+
+
+
+/**
+ * @brief ...
+ *
+ * @return network::logStats_t
+ */
+network::logStats_t network::AsyncLog::stats()
+{
+   logStats_t stats;
+   stats.nWritten = s_state.nWritten.load( std::memory_order_relaxed );
+   stats.nDropped = s_state.nDropped.load( std::memory_order_relaxed );
+   return stats;
+}
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <type_traits>
+#include <time.h>
+#include "sockets.h"
+
+namespace gdlib {
+namespace network
+{
+   /**
+    * @brief usage of the log ring, see AsyncLog::stats
+    */
+   struct logStats_t
+   {
+      uint64_t    nWritten       = 0;     // records taken by the ring
+      uint64_t    nDropped       = 0;     // records lost, the ring was full or below the level
+   };
+
+
+
+   /**
+    * @brief process wide diagnostics of the library, off the reactor threads.  write copies a binary record into a
+    * preallocated lock-free ring (multi producer, one consumer): the format pointer, the arguments as numbers or
+    * a short copied text, the errno and a timestamp.  no lock, no allocation and no syscall, a full ring drops the record
+    * and counts it.  a drain thread, started on the first write, formats the records every setInterval ms and hands
+    * each line to the sink: setCallback (logCallBack_t), else setFile, else stderr
+    *
+    * the format is printf like and must outlive the record, a string literal.  %s takes a const char* or std::string
+    * (copied, cut at about 100 bytes for all texts of a record), the integer and floating conversions take any integer
+    * or floating argument whatever the length modifier, %p a pointer and %m the strerror of the errno of the call (or
+    * of a_nError with writeError).  at most 6 arguments
+    *
+    * setLevel drops the records less severe than the level on the calling thread, flush waits until the drain thread
+    * has handed over what was written
+    */
+   class AsyncLog
+   {
+      private:
+         static constexpr uint32_t s_nRecords   = 4096;      // power of 2
+         static constexpr uint32_t s_nArgs      = 6;
+         static constexpr uint32_t s_nText      = 104;
+
+         enum struct argType_t: uint8_t { INT, UINT, DOUBLE, TEXT, POINTER };
+
+         struct arg_t
+         {
+            argType_t   type        = argType_t::INT;
+            union
+            {
+               int64_t  nInt;
+               uint64_t nUint;
+               double   dDouble;
+            };
+            arg_t() : nInt( 0 ) {}
+         };
+
+         struct record_t
+         {
+            std::atomic<uint64_t>   nSequence      = {0};       // Vyukov: position + 1 once written, position + s_nRecords once read
+            uint64_t                nTime_ns       = 0;         // CLOCK_REALTIME
+            const char*             pszFormat      = nullptr;
+            LogLevel                level          = LogLevel::EINF;
+            int32_t                 nError         = 0;
+            uint8_t                 nArgs          = 0;
+            uint8_t                 nText          = 0;         // bytes of szText used
+            arg_t                   aArgs[s_nArgs] = {};
+            char                    szText[s_nText] = {};       // the TEXT arguments, nul terminated one after the other
+         };
+
+         struct state_t
+         {
+            alignas( 64 ) std::atomic<uint64_t> nTail    = {0};   // next position to write
+            alignas( 64 ) std::atomic<uint64_t> nHead    = {0};   // next position to read, the drain thread
+            std::atomic<uint64_t>   nWritten       = {0};
+            std::atomic<uint64_t>   nDropped       = {0};
+            std::atomic<int32_t>    nLevel         = {static_cast<int32_t>( LogLevel::EOK )};
+            std::atomic<bool>       bStarted       = {false};
+            record_t                aRecords[s_nRecords];
+
+            std::mutex              mux            = {};        // the settings below, the sink is called without it
+            std::condition_variable cvStop         = {};
+            std::thread             thdDrain       = std::thread();
+            bool                    bStop          = false;
+            uint32_t                nInterval_ms   = 20;
+            logCallBack_t           cbLog          = nullptr;
+            int32_t                 fdFile         = -1;
+            int32_t                 fdInUse        = -1;        // written to by the drain thread, a setFile meanwhile leaves it open
+            int32_t                 fdRetired      = -1;        // replaced while in use, closed by the drain thread after the batch
+
+            state_t();
+            state_t( const state_t& ) = delete;
+            ~state_t();
+
+            state_t& operator =( const state_t& ) = delete;
+         };
+
+         static state_t s_state;
+
+         static record_t* claim_();
+         static void      start_();
+         static void      drain_();
+         static bool      consume_( const logCallBack_t a_cbLog, const int32_t a_fd, std::string& a_strLines, std::string& a_strLine );
+         static void      format_( const record_t& a_record, std::string& a_strLine );
+
+         static void      pack_( record_t& ) {}
+
+         template<typename T, typename... Args>
+         static void      pack_( record_t& a_record, const T& a_arg, const Args&... a_args );
+
+      public:
+         AsyncLog() = delete;
+
+         template<typename... Args>
+         static bool      write( const LogLevel a_level, const char* a_pszFormat, const Args&... a_args )
+         {
+            return writeError( a_level, errno, a_pszFormat, a_args... );
+         }
+
+         template<typename... Args>
+         static bool      writeError( const LogLevel a_level, const int32_t a_nError, const char* a_pszFormat, const Args&... a_args );
+
+         static void      setCallback( const logCallBack_t a_cbLog );
+         static bool      setFile( const std::string& a_strPath );
+         static void      setLevel( const LogLevel a_level )               { s_state.nLevel.store( static_cast<int32_t>( a_level ), std::memory_order_relaxed ); }
+         static void      setInterval( const uint32_t a_nInterval_ms );
+         static void      flush();
+         static logStats_t stats();
+   };
+
+
+
+   /**
+    * @brief ...any thread, copy a record into the ring for the drain thread.  never blocks
+    *
+    * @param a_level ...
+    * @param a_nError ...errno for %m
+    * @param a_pszFormat ...printf like, a string literal
+    * @param a_args ...
+    * @return bool false the record was dropped, below the level or the ring full
+    */
+   template<typename... Args>
+   bool AsyncLog::writeError( const LogLevel a_level, const int32_t a_nError, const char* a_pszFormat, const Args&... a_args )
+   {
+      static_assert( sizeof...( Args ) <= s_nArgs, "too many log arguments" );
+      if( static_cast<int32_t>( a_level ) > s_state.nLevel.load( std::memory_order_relaxed ) )
+      {
+         return false;
+      }
+      if( false == s_state.bStarted.load( std::memory_order_acquire ) )
+      {
+         start_();
+      }
+      record_t* pRecord = claim_();
+      if( nullptr == pRecord )
+      {
+         s_state.nDropped.fetch_add( 1, std::memory_order_relaxed );
+         return false;
+      }
+      struct timespec ts;
+      clock_gettime( CLOCK_REALTIME, &ts );    // vDSO
+      pRecord->nTime_ns  = static_cast<uint64_t>( ts.tv_sec ) * 1000000000 + static_cast<uint64_t>( ts.tv_nsec );
+      pRecord->pszFormat = a_pszFormat;
+      pRecord->level     = a_level;
+      pRecord->nError    = a_nError;
+      pRecord->nArgs     = 0;
+      pRecord->nText     = 0;
+      pack_( *pRecord, a_args... );
+      // publish, see claim_
+      const uint64_t nPosition = pRecord->nSequence.load( std::memory_order_relaxed );
+      pRecord->nSequence.store( nPosition + 1, std::memory_order_release );
+      s_state.nWritten.fetch_add( 1, std::memory_order_relaxed );
+      return true;
+   }
+
+
+
+   /**
+    * @brief ...store one argument of a record and the rest after it
+    *
+    * @param a_record ...
+    * @param a_arg ...
+    * @param a_args ...
+    */
+   template<typename T, typename... Args>
+   void AsyncLog::pack_( record_t& a_record, const T& a_arg, const Args&... a_args )
+   {
+      arg_t& arg = a_record.aArgs[a_record.nArgs++];
+      using type_t = typename std::decay<T>::type;
+      if constexpr( std::is_floating_point<type_t>::value )
+      {
+         arg.type    = argType_t::DOUBLE;
+         arg.dDouble = static_cast<double>( a_arg );
+      } else if constexpr( std::is_enum<type_t>::value )
+      {
+         arg.type = argType_t::INT;
+         arg.nInt = static_cast<int64_t>( a_arg );
+      } else if constexpr( std::is_integral<type_t>::value && std::is_signed<type_t>::value )
+      {
+         arg.type = argType_t::INT;
+         arg.nInt = static_cast<int64_t>( a_arg );
+      } else if constexpr( std::is_integral<type_t>::value )
+      {
+         arg.type  = argType_t::UINT;
+         arg.nUint = static_cast<uint64_t>( a_arg );
+      } else if constexpr( std::is_same<type_t, std::string>::value || std::is_same<type_t, const char*>::value || std::is_same<type_t, char*>::value )
+      {
+         // copied, a text too long for what is left of the record is cut
+         const char* pszText = nullptr;
+         if constexpr( std::is_same<type_t, std::string>::value )
+         {
+            pszText = a_arg.c_str();
+         } else
+         {
+            pszText = a_arg;
+         }
+         arg.type  = argType_t::TEXT;
+         arg.nUint = s_nText;      // none, formatted as "(null)"
+         if( (nullptr != pszText) && (a_record.nText < s_nText) )
+         {
+            const size_t nLength = strnlen( pszText, s_nText - a_record.nText - 1 );
+            arg.nUint = a_record.nText;
+            memcpy( a_record.szText + a_record.nText, pszText, nLength );
+            a_record.szText[a_record.nText + nLength] = '\0';
+            a_record.nText = static_cast<uint8_t>( a_record.nText + nLength + 1 );
+         }
+      } else
+      {
+         static_assert( std::is_pointer<type_t>::value, "log argument must be a number, a pointer or a string" );
+         arg.type  = argType_t::POINTER;
+         arg.nUint = reinterpret_cast<uintptr_t>( a_arg );
+      }
+      pack_( a_record, a_args... );
+   }
+}
+}
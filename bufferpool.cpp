@@ -0,0 +1,313 @@
+#include "bufferpool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <new>
+
+
+using namespace std;
+using namespace gdlib;
+
+
+network::BufferPool::central_t              network::BufferPool::s_aCentral[s_nClassCount + 1];
+thread_local network::BufferPool::cache_t   network::BufferPool::t_cache;
+
+
+
+/**
+ * @brief ...thread exit, hand the cached buffers to the shared free lists
+ *
+ */
+network::BufferPool::cache_t::~cache_t()
+{
+   for( uint32_t nClass=0; nClass<s_nClassCount; ++nClass )
+   {
+      block_t* pFirst = apFree[nClass];
+      if( nullptr == pFirst )
+      {
+         continue;
+      }
+      block_t* pLast = pFirst;
+      while( nullptr != pLast->pNext )
+      {
+         pLast = pLast->pNext;
+      }
+      toCentral_( nClass, pFirst, pLast );
+      apFree[nClass]  = nullptr;
+      anCount[nClass] = 0;
+   }
+}
+
+
+
+/**
+ * @brief ...buffers of a class a thread may keep, about s_nCacheBytes but at least 2 and at most s_nCacheMax
+ *
+ * @param a_nClass ...
+ * @return uint32_t
+ */
+uint32_t network::BufferPool::cacheLimit_( const uint32_t a_nClass )
+{
+   const size_t nLimit = s_nCacheBytes / classSize( a_nClass );
+   if( nLimit < 2 )
+   {
+      return 2;
+   }
+   return (nLimit > s_nCacheMax) ? s_nCacheMax : static_cast<uint32_t>( nLimit );
+}
+
+
+
+/**
+ * @brief ...count a buffer handed out and track the high water mark
+ *
+ * @param a_central ...stats of the class
+ */
+void network::BufferPool::acquired_( central_t& a_central )
+{
+   const uint64_t nInUse     = a_central.nInUse.fetch_add( 1, std::memory_order_relaxed ) + 1;
+   uint64_t       nHighWater = a_central.nHighWater.load( std::memory_order_relaxed );
+   while( (nInUse > nHighWater) && (false == a_central.nHighWater.compare_exchange_weak( nHighWater, nInUse, std::memory_order_relaxed )) )
+   {
+   }
+}
+
+
+
+/**
+ * @brief ...push a chain of free blocks onto the shared list of their class
+ *
+ * @param a_nClass ...
+ * @param a_pFirst ...
+ * @param a_pLast ...linked from a_pFirst
+ */
+void network::BufferPool::toCentral_( const uint32_t a_nClass, block_t* a_pFirst, block_t* a_pLast )
+{
+   central_t& central = s_aCentral[a_nClass];
+   lock_guard<std::mutex> lock( central.mux );
+   a_pLast->pNext = central.pFree;
+   central.pFree  = a_pFirst;
+}
+
+
+
+/**
+ * @brief ...get a buffer of at least a_nSize bytes with one reference.  from the thread cache, else a few buffers are
+ * moved from the shared list to the cache, else allocated
+ *
+ * @param a_nSize ...bytes needed
+ * @param a_nCapacity ...out, bytes usable, the size of the class
+ * @return uint8_t* nullptr if the allocation failed
+ */
+uint8_t* network::BufferPool::acquire( const size_t a_nSize, size_t& a_nCapacity )
+{
+   uint32_t nClass = 0;
+   while( (nClass < s_nClassCount) && (classSize( nClass ) < a_nSize) )
+   {
+      ++nClass;
+   }
+
+   block_t* pBlock = nullptr;
+   if( nClass == s_nClassCount )
+   {
+      // larger than the largest class, not pooled
+      void* pMemory = nullptr;
+      if( 0 != posix_memalign( &pMemory, s_nHeaderSize, s_nHeaderSize + a_nSize ) )
+      {
+         errno = ENOMEM;
+         return nullptr;
+      }
+      pBlock = new( pMemory ) block_t();
+      pBlock->nClass    = nClass;
+      pBlock->nCapacity = a_nSize;
+      s_aCentral[nClass].nMisses.fetch_add( 1, std::memory_order_relaxed );
+   } else
+   {
+      central_t& central = s_aCentral[nClass];
+      if( nullptr == t_cache.apFree[nClass] )
+      {
+         lock_guard<std::mutex> lock( central.mux );
+         for( uint32_t nIndex=0; (nIndex<s_nRefill) && (nullptr != central.pFree); ++nIndex )
+         {
+            block_t* pFree          = central.pFree;
+            central.pFree           = pFree->pNext;
+            pFree->pNext            = t_cache.apFree[nClass];
+            t_cache.apFree[nClass]  = pFree;
+            ++t_cache.anCount[nClass];
+         }
+      }
+      pBlock = t_cache.apFree[nClass];
+      if( nullptr != pBlock )
+      {
+         t_cache.apFree[nClass] = pBlock->pNext;
+         --t_cache.anCount[nClass];
+         central.nHits.fetch_add( 1, std::memory_order_relaxed );
+      } else
+      {
+         void* pMemory = nullptr;
+         if( 0 != posix_memalign( &pMemory, s_nHeaderSize, s_nHeaderSize + classSize( nClass ) ) )
+         {
+            errno = ENOMEM;
+            return nullptr;
+         }
+         pBlock = new( pMemory ) block_t();
+         pBlock->nClass    = nClass;
+         pBlock->nCapacity = classSize( nClass );
+         central.nMisses.fetch_add( 1, std::memory_order_relaxed );
+      }
+   }
+
+   pBlock->pNext = nullptr;
+   pBlock->nRefs.store( 1, std::memory_order_relaxed );
+   acquired_( s_aCentral[nClass] );
+   a_nCapacity = pBlock->nCapacity;
+   return buffer_( pBlock );
+}
+
+
+
+/**
+ * @brief ...one more owner of the buffer
+ *
+ * @param a_pBuffer ...from acquire
+ */
+void network::BufferPool::addRef( const void* a_pBuffer )
+{
+   block_( a_pBuffer )->nRefs.fetch_add( 1, std::memory_order_relaxed );
+}
+
+
+
+/**
+ * @brief ...drop a reference, the last one returns the buffer to the cache of the calling thread.  when the cache is
+ * over its limit half of it goes to the shared list
+ *
+ * @param a_pBuffer ...from acquire, nullptr is ignored
+ */
+void network::BufferPool::release( const void* a_pBuffer )
+{
+   if( nullptr == a_pBuffer )
+   {
+      return;
+   }
+   block_t* pBlock = block_( a_pBuffer );
+   if( 1 != pBlock->nRefs.fetch_sub( 1, std::memory_order_acq_rel ) )
+   {
+      return;
+   }
+
+   const uint32_t nClass = pBlock->nClass;
+   s_aCentral[nClass].nInUse.fetch_sub( 1, std::memory_order_relaxed );
+   if( nClass == s_nClassCount )
+   {
+      pBlock->~block_t();
+      free( pBlock );
+      return;
+   }
+
+   pBlock->pNext          = t_cache.apFree[nClass];
+   t_cache.apFree[nClass] = pBlock;
+   if( ++t_cache.anCount[nClass] > cacheLimit_( nClass ) )
+   {
+      // keep half, the rest can be used by other threads
+      const uint32_t nKeep = t_cache.anCount[nClass] / 2;
+      block_t* pLast = t_cache.apFree[nClass];
+      for( uint32_t nIndex=1; nIndex<nKeep; ++nIndex )
+      {
+         pLast = pLast->pNext;
+      }
+      block_t* pFirst = pLast->pNext;
+      block_t* pEnd   = pFirst;
+      while( nullptr != pEnd->pNext )
+      {
+         pEnd = pEnd->pNext;
+      }
+      pLast->pNext            = nullptr;
+      t_cache.anCount[nClass] = nKeep;
+      toCentral_( nClass, pFirst, pEnd );
+   }
+}
+
+
+
+/**
+ * @brief ...current reference count
+ *
+ * @param a_pBuffer ...from acquire
+ * @return uint32_t
+ */
+uint32_t network::BufferPool::refs( const void* a_pBuffer )
+{
+   return block_( a_pBuffer )->nRefs.load( std::memory_order_relaxed );
+}
+
+
+
+/**
+ * @brief ...usage of a size class, use it to size the classes and the caches
+ *
+ * @param a_nClass ...0..s_nClassCount-1, s_nClassCount for the oversize (not pooled) buffers
+ * @return network::poolStats_t
+ */
+network::poolStats_t network::BufferPool::stats( const uint32_t a_nClass )
+{
+   poolStats_t stats;
+   if( a_nClass > s_nClassCount )
+   {
+      return stats;
+   }
+   const central_t& central = s_aCentral[a_nClass];
+   stats.nSize       = (a_nClass < s_nClassCount) ? classSize( a_nClass ) : 0;
+   stats.nHits       = central.nHits.load( std::memory_order_relaxed );
+   stats.nMisses     = central.nMisses.load( std::memory_order_relaxed );
+   stats.nInUse      = central.nInUse.load( std::memory_order_relaxed );
+   stats.nHighWater  = central.nHighWater.load( std::memory_order_relaxed );
+   return stats;
+}
+
+
+
+/**
+ * @brief ...sum over all classes, nHighWater is the sum of the per class high water marks
+ *
+ * @return network::poolStats_t
+ */
+network::poolStats_t network::BufferPool::totals()
+{
+   poolStats_t totals;
+   for( uint32_t nClass=0; nClass<=s_nClassCount; ++nClass )
+   {
+      const poolStats_t stats = BufferPool::stats( nClass );
+      totals.nHits      += stats.nHits;
+      totals.nMisses    += stats.nMisses;
+      totals.nInUse     += stats.nInUse;
+      totals.nHighWater += stats.nHighWater;
+   }
+   return totals;
+}
+
+
+
+/**
+ * @brief ...free the buffers on the shared lists, the thread caches are kept
+ *
+ */
+void network::BufferPool::trim()
+{
+   for( uint32_t nClass=0; nClass<s_nClassCount; ++nClass )
+   {
+      block_t* pFree = nullptr;
+      {
+         lock_guard<std::mutex> lock( s_aCentral[nClass].mux );
+         pFree = s_aCentral[nClass].pFree;
+         s_aCentral[nClass].pFree = nullptr;
+      }
+      while( nullptr != pFree )
+      {
+         block_t* pNext = pFree->pNext;
+         pFree->~block_t();
+         free( pFree );
+         pFree = pNext;
+      }
+   }
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+
+namespace gdlib {
+namespace network
+{
+   /**
+    * @brief usage of one size class of the pool, see BufferPool::stats
+    */
+   struct poolStats_t
+   {
+      size_t      nSize          = 0;     // bytes per buffer of the class, 0 for the oversize totals
+      uint64_t    nHits          = 0;     // acquires served from a thread cache or the shared free list
+      uint64_t    nMisses        = 0;     // acquires that had to allocate
+      uint64_t    nInUse         = 0;     // buffers handed out now
+      uint64_t    nHighWater     = 0;     // most buffers handed out at once
+   };
+
+
+
+   /**
+    * @brief process wide pool of network buffers shared by the reactors.  Buffers come in fixed size classes (256 bytes
+    * to 4M, factor 4), a request is rounded up to its class and larger requests are plain malloc.  Each thread keeps a
+    * small cache per class so acquire/release on a reactor thread do not lock, overflow goes to a shared free list per
+    * class.  Memory is kept for reuse, trim returns the shared free lists to the system.
+    *
+    * every buffer carries a reference count, acquire returns it with one reference, addRef/release move it and the last
+    * release returns the buffer.  PoolBuffer is the handle doing that for you.
+    *
+    * thread safe.  a buffer can be released on another thread than the one that acquired it
+    */
+   class BufferPool
+   {
+      public:
+         static constexpr uint32_t s_nClassCount = 8;
+
+      private:
+         struct block_t
+         {
+            std::atomic<uint32_t> nRefs   = {0};
+            uint32_t    nClass            = 0;           // s_nClassCount for an oversize buffer
+            size_t      nCapacity         = 0;
+            block_t*    pNext             = nullptr;     // free list
+         };
+
+         struct central_t
+         {
+            std::mutex  mux               = {};
+            block_t*    pFree             = nullptr;
+            std::atomic<uint64_t> nHits       = {0};
+            std::atomic<uint64_t> nMisses     = {0};
+            std::atomic<uint64_t> nInUse      = {0};
+            std::atomic<uint64_t> nHighWater  = {0};
+         };
+
+         struct cache_t
+         {
+            block_t*    apFree[s_nClassCount]  = {};
+            uint32_t    anCount[s_nClassCount] = {};
+
+            cache_t() = default;
+            cache_t( const cache_t& ) = delete;
+            ~cache_t();
+
+            cache_t& operator =( const cache_t& ) = delete;
+         };
+
+         static constexpr size_t   s_nHeaderSize     = 64;          // block_t in front of the buffer, keeps the buffer cache line aligned
+         static constexpr size_t   s_nSmallestClass  = 256;
+         static constexpr size_t   s_nCacheBytes     = 1024*1024;   // per thread and class
+         static constexpr uint32_t s_nCacheMax       = 64;          // buffers per thread and class
+         static constexpr uint32_t s_nRefill         = 8;           // buffers moved from the shared list to an empty cache
+
+         static central_t              s_aCentral[s_nClassCount + 1];    // last entry counts the oversize buffers
+         static thread_local cache_t   t_cache;
+
+         static block_t*   block_( const void* a_pBuffer )      { return reinterpret_cast<block_t*>( reinterpret_cast<uintptr_t>( a_pBuffer ) - s_nHeaderSize ); }
+         static uint8_t*   buffer_( block_t* a_pBlock )         { return reinterpret_cast<uint8_t*>( a_pBlock ) + s_nHeaderSize; }
+         static uint32_t   cacheLimit_( const uint32_t a_nClass );
+         static void       acquired_( central_t& a_central );
+         static void       toCentral_( const uint32_t a_nClass, block_t* a_pFirst, block_t* a_pLast );
+
+      public:
+         BufferPool() = delete;
+
+         static uint8_t*   acquire( const size_t a_nSize, size_t& a_nCapacity );
+         static void       addRef( const void* a_pBuffer );
+         static void       release( const void* a_pBuffer );
+         static uint32_t   refs( const void* a_pBuffer );
+         static size_t     classSize( const uint32_t a_nClass )    { return s_nSmallestClass << (2 * a_nClass); }
+         static poolStats_t stats( const uint32_t a_nClass );      // a_nClass s_nClassCount for the oversize buffers
+         static poolStats_t totals();
+         static void       trim();
+   };
+
+
+
+   /**
+    * @brief reference counted handle of a pool buffer.  copies share the buffer, the last handle returns it to the pool
+    */
+   class PoolBuffer
+   {
+      private:
+         uint8_t*    m_pBuffer      = nullptr;
+         size_t      m_nCapacity    = 0;
+
+      public:
+         PoolBuffer() = default;
+         explicit PoolBuffer( const size_t a_nSize )    { m_pBuffer = BufferPool::acquire( a_nSize, m_nCapacity ); }
+         PoolBuffer( const PoolBuffer& a_other ) : m_pBuffer( a_other.m_pBuffer ), m_nCapacity( a_other.m_nCapacity )
+         {
+            if( nullptr != m_pBuffer )
+            {
+               BufferPool::addRef( m_pBuffer );
+            }
+         }
+         PoolBuffer( PoolBuffer&& a_other ) noexcept : m_pBuffer( a_other.m_pBuffer ), m_nCapacity( a_other.m_nCapacity )
+         {
+            a_other.m_pBuffer   = nullptr;
+            a_other.m_nCapacity = 0;
+         }
+         ~PoolBuffer()                                   { reset(); }
+
+         PoolBuffer& operator =( const PoolBuffer& a_other )
+         {
+            PoolBuffer copy( a_other );
+            swap( copy );
+            return *this;
+         }
+         PoolBuffer& operator =( PoolBuffer&& a_other ) noexcept
+         {
+            swap( a_other );
+            return *this;
+         }
+
+         void        swap( PoolBuffer& a_other ) noexcept
+         {
+            uint8_t* pBuffer   = m_pBuffer;
+            size_t   nCapacity = m_nCapacity;
+            m_pBuffer          = a_other.m_pBuffer;
+            m_nCapacity        = a_other.m_nCapacity;
+            a_other.m_pBuffer   = pBuffer;
+            a_other.m_nCapacity = nCapacity;
+         }
+         void        reset()
+         {
+            if( nullptr != m_pBuffer )
+            {
+               BufferPool::release( m_pBuffer );
+               m_pBuffer   = nullptr;
+               m_nCapacity = 0;
+            }
+         }
+         uint8_t*    data() const                        { return m_pBuffer; }
+         size_t      capacity() const                    { return m_nCapacity; }
+         bool        valid() const                       { return nullptr != m_pBuffer; }
+         uint32_t    refs() const                        { return (nullptr == m_pBuffer) ? 0 : BufferPool::refs( m_pBuffer ); }
+   };
+}
+}
@@ -0,0 +1,191 @@
+#include "busypoll.h"
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+
+
+using namespace std;
+using namespace gdlib;
+
+
+
+/**
+ * @brief ...one thread writes the counters, no read-modify-write needed
+ *
+ * @param a_counter ...
+ * @param a_nValue ...added
+ */
+static inline void bump( std::atomic<uint64_t>& a_counter, const uint64_t a_nValue = 1 )
+{
+   a_counter.store( a_counter.load( std::memory_order_relaxed ) + a_nValue, std::memory_order_relaxed );
+}
+
+
+
+/**
+ * @brief ...CLOCK_MONOTONIC in ns
+ *
+ * @return uint64_t
+ */
+uint64_t network::BusyPoll::now_ns()
+{
+   struct timespec ts;
+   clock_gettime( CLOCK_MONOTONIC, &ts );
+   return static_cast<uint64_t>( ts.tv_sec ) * 1000000000 + static_cast<uint64_t>( ts.tv_nsec );
+}
+
+
+
+/**
+ * @brief ...before the reactor starts
+ *
+ * @param a_nSpin_us ...poll this long after the last event before blocking, 0 always block, s_nSpinForever never block
+ * @param a_nTimeout_ms ...epoll_wait timeout when blocking, -1 until an event
+ */
+void network::BusyPoll::configure( const uint32_t a_nSpin_us, const int32_t a_nTimeout_ms )
+{
+   m_nSpin_us      = a_nSpin_us;
+   m_nTimeout_ms   = a_nTimeout_ms;
+   m_nSpinUntil_ns = 0;
+   m_nWake_ns      = 0;
+}
+
+
+
+/**
+ * @brief ...epoll_wait, spinning with a zero timeout while in the spin time.  an empty poll returns 0 so the reactor
+ * re-checks its run flag, stop is seen while spinning
+ *
+ * @param a_fdEpoll ...
+ * @param a_pEvents ...
+ * @param a_nMaxEvents ...
+ * @return int32_t as epoll_wait
+ */
+int32_t network::BusyPoll::wait( const int32_t a_fdEpoll, epoll_event* a_pEvents, const int32_t a_nMaxEvents )
+{
+   int32_t nCount;
+   if( (s_nSpinForever == m_nSpin_us) || ((0 != m_nSpin_us) && (now_ns() < m_nSpinUntil_ns)) )
+   {
+      nCount = epoll_wait( a_fdEpoll, a_pEvents, a_nMaxEvents, 0 );
+      if( 0 == nCount )
+      {
+         bump( m_nEmptyPolls );
+         return 0;
+      }
+   } else
+   {
+      bump( m_nBlocks );
+      nCount = epoll_wait( a_fdEpoll, a_pEvents, a_nMaxEvents, m_nTimeout_ms );
+   }
+   if( 0 < nCount )
+   {
+      bump( m_nWakeups );
+      m_nWake_ns = now_ns();
+      if( (0 != m_nSpin_us) && (s_nSpinForever != m_nSpin_us) )
+      {
+         m_nSpinUntil_ns = m_nWake_ns + static_cast<uint64_t>( m_nSpin_us ) * 1000;
+      }
+   }
+   return nCount;
+}
+
+
+
+/**
+ * @brief ...first callback since the wakeup, add its latency
+ *
+ */
+void network::BusyPoll::sample_()
+{
+   const uint64_t nLatency_ns = now_ns() - m_nWake_ns;
+   m_nWake_ns = 0;
+   bump( m_nSamples );
+   bump( m_nCallback_ns, nLatency_ns );
+   if( nLatency_ns > m_nCallbackMax_ns.load( std::memory_order_relaxed ) )
+   {
+      m_nCallbackMax_ns.store( nLatency_ns, std::memory_order_relaxed );
+   }
+}
+
+
+
+/**
+ * @brief ...counters so far
+ *
+ * @return network::pollStats_t
+ */
+network::pollStats_t network::BusyPoll::stats() const
+{
+   pollStats_t stats;
+   stats.nWakeups        = m_nWakeups.load( std::memory_order_relaxed );
+   stats.nEmptyPolls     = m_nEmptyPolls.load( std::memory_order_relaxed );
+   stats.nBlocks         = m_nBlocks.load( std::memory_order_relaxed );
+   stats.nCallbackMax_ns = m_nCallbackMax_ns.load( std::memory_order_relaxed );
+   const uint64_t nSamples = m_nSamples.load( std::memory_order_relaxed );
+   if( 0 != nSamples )
+   {
+      stats.nCallbackAvg_ns = m_nCallback_ns.load( std::memory_order_relaxed ) / nSamples;
+   }
+   return stats;
+}
+
+
+
+/**
+ * @brief ...pin the calling thread to one cpu
+ *
+ * @param a_nCpu ...-1 leaves the thread where it is
+ * @return bool false with errno EINVAL when the cpu does not exist
+ */
+bool network::BusyPoll::pin( const int32_t a_nCpu )
+{
+   if( -1 == a_nCpu )
+   {
+      return true;
+   }
+   if( (0 > a_nCpu) || (CPU_SETSIZE <= a_nCpu) )
+   {
+      errno = EINVAL;
+      return false;
+   }
+   cpu_set_t cpus;
+   CPU_ZERO( &cpus );
+   CPU_SET( static_cast<size_t>( a_nCpu ), &cpus );
+   const int32_t nResult = pthread_setaffinity_np( pthread_self(), sizeof( cpus ), &cpus );
+   if( 0 != nResult )
+   {
+      errno = nResult;
+      return false;
+   }
+   return true;
+}
+
+
+
+/**
+ * @brief ...SO_BUSY_POLL, and SO_PREFER_BUSY_POLL where the headers know it, so a read on the socket polls the device
+ * queue for up to a_nBusyPoll_us.  raising it above net.core.busy_read needs CAP_NET_ADMIN
+ *
+ * @param a_fd ...
+ * @param a_nBusyPoll_us ...0 does nothing
+ * @return bool false, errno EPERM without the capability
+ */
+bool network::BusyPoll::tune( const int32_t a_fd, const uint32_t a_nBusyPoll_us )
+{
+   if( 0 == a_nBusyPoll_us )
+   {
+      return true;
+   }
+   int32_t nOptValue = static_cast<int32_t>( a_nBusyPoll_us );
+   if( -1 == setsockopt( a_fd, SOL_SOCKET, SO_BUSY_POLL, &nOptValue, sizeof( nOptValue ) ) )
+   {
+      return false;
+   }
+#ifdef SO_PREFER_BUSY_POLL
+   nOptValue = 1;
+   setsockopt( a_fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &nOptValue, sizeof( nOptValue ) );
+#endif
+   return true;
+}
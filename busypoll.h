@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <sys/epoll.h>
+
+namespace gdlib {
+namespace network
+{
+   /**
+    * @brief how a reactor waited, see BusyPoll::stats
+    */
+   struct pollStats_t
+   {
+      uint64_t    nWakeups             = 0;     // waits that returned events
+      uint64_t    nEmptyPolls          = 0;     // zero timeout polls without events, spinning
+      uint64_t    nBlocks              = 0;     // waits that went to sleep in the kernel
+      uint64_t    nCallbackAvg_ns      = 0;     // wakeup to the first callback of the events, average
+      uint64_t    nCallbackMax_ns      = 0;
+   };
+
+
+
+   /**
+    * @brief epoll_wait of one reactor.  blocking it waits as before, with a spin time it polls with a zero timeout for
+    * a_nSpin_us after the last event before it blocks again, s_nSpinForever never blocks and keeps the core busy.  spinning
+    * saves the wakeup of a sleeping thread (several us, more on a loaded box) per message burst.  the reactor stamps when
+    * the wait returned and callback() measures from there to the first callback, stats gives the counts and the latency
+    *
+    * pin and tune are the other halves of a low latency reactor: the thread on its own core, SO_BUSY_POLL on the sockets so
+    * the kernel polls the device queue instead of waiting for the interrupt
+    *
+    * wait and callback on the reactor thread, stats from any thread
+    */
+   class BusyPoll
+   {
+      private:
+         uint32_t                m_nSpin_us           = 0;
+         int32_t                 m_nTimeout_ms        = -1;
+         uint64_t                m_nSpinUntil_ns      = 0;
+         uint64_t                m_nWake_ns           = 0;          // last wakeup, 0 when its first callback was measured
+         std::atomic<uint64_t>   m_nWakeups           = {0};
+         std::atomic<uint64_t>   m_nEmptyPolls        = {0};
+         std::atomic<uint64_t>   m_nBlocks            = {0};
+         std::atomic<uint64_t>   m_nSamples           = {0};
+         std::atomic<uint64_t>   m_nCallback_ns       = {0};
+         std::atomic<uint64_t>   m_nCallbackMax_ns    = {0};
+
+         void        sample_();
+
+      public:
+         static constexpr uint32_t s_nSpinForever = UINT32_MAX;
+
+         BusyPoll() = default;
+         BusyPoll( const BusyPoll& ) = delete;
+
+         BusyPoll& operator =( const BusyPoll& ) = delete;
+
+         void        configure( const uint32_t a_nSpin_us, const int32_t a_nTimeout_ms );
+         int32_t     wait( const int32_t a_fdEpoll, epoll_event* a_pEvents, const int32_t a_nMaxEvents );
+         void        callback()                  { if( 0 != m_nWake_ns ) { sample_(); } }
+         pollStats_t stats() const;
+
+         static bool pin( const int32_t a_nCpu );
+         static bool tune( const int32_t a_fd, const uint32_t a_nBusyPoll_us );
+         static uint64_t now_ns();
+   };
+}
+}
@@ -0,0 +1,288 @@
+#include "connector.h"
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/socket.h>
+
+
+using namespace std;
+using namespace gdlib;
+
+
+
+/**
+ * @brief ...CLOCK_MONOTONIC, the clock of the deadlines
+ *
+ * @return uint64_t ns
+ */
+uint64_t network::Connector::now_ns()
+{
+   struct timespec ts;
+   clock_gettime( CLOCK_MONOTONIC, &ts );
+   return static_cast<uint64_t>( ts.tv_sec ) * 1000000000 + static_cast<uint64_t>( ts.tv_nsec );
+}
+
+
+
+/**
+ * @brief ...resolve the host and connect to its first address.  a connect in progress is cancelled first
+ *
+ * @param a_strHost ...hostname or IP
+ * @param a_strPort ...port as a string, ex "5000"
+ * @param a_nFamily ...AF_INET, AF_INET6 or AF_UNSPEC
+ * @param a_nType ...SOCK_STREAM or SOCK_DGRAM
+ * @param a_nAttempt_ms ...deadline of each address, 0 none
+ * @param a_nTimeout_ms ...deadline of the connect, 0 none
+ * @return network::connectStatus_t IN_PROGRESS wait for fd to become writable, CONNECTED, FAILED see error
+ */
+network::connectStatus_t network::Connector::start( const std::string& a_strHost, const std::string& a_strPort, const int32_t a_nFamily, const int32_t a_nType,
+                                                    const uint32_t a_nAttempt_ms, const uint32_t a_nTimeout_ms )
+{
+   cancel();
+   const uint64_t nStart_ns = now_ns();
+   const int32_t  nError    = Resolver::resolve( a_strHost, a_strPort, a_nFamily, a_nType, m_vecAddresses );
+   if( 0 != nError )
+   {
+      m_nError = nError;
+      return done_( connectStatus_t::FAILED );
+   }
+   // the time the lookup took counts against the deadline of the connect
+   const uint64_t nSpent_ms = (now_ns() - nStart_ns) / 1000000;
+   if( (0 != a_nTimeout_ms) && (nSpent_ms >= a_nTimeout_ms) )
+   {
+      m_nError = ETIMEDOUT;
+      return done_( connectStatus_t::FAILED );
+   }
+   std::vector<address_t> vecAddresses;
+   vecAddresses.swap( m_vecAddresses );
+   return start( vecAddresses, a_nAttempt_ms, (0 != a_nTimeout_ms) ? a_nTimeout_ms - static_cast<uint32_t>( nSpent_ms ) : 0 );
+}
+
+
+
+/**
+ * @brief ...connect to the first of addresses already resolved.  a connect in progress is cancelled first
+ *
+ * @param a_vecAddresses ...from Resolver, tried in order
+ * @param a_nAttempt_ms ...deadline of each address, 0 none
+ * @param a_nTimeout_ms ...deadline of the connect, 0 none
+ * @return network::connectStatus_t IN_PROGRESS wait for fd to become writable, CONNECTED, FAILED see error
+ */
+network::connectStatus_t network::Connector::start( const std::vector<address_t>& a_vecAddresses, const uint32_t a_nAttempt_ms, const uint32_t a_nTimeout_ms )
+{
+   cancel();
+   m_nError       = 0;
+   m_nAttempt_ms  = a_nAttempt_ms;
+   m_nEnd_ns      = (0 != a_nTimeout_ms) ? now_ns() + static_cast<uint64_t>( a_nTimeout_ms ) * 1000000 : 0;
+   m_vecAddresses = a_vecAddresses;
+   m_nNext        = 0;
+   return next_();
+}
+
+
+
+/**
+ * @brief ...connect to the next address until one connects at once or is in progress
+ *
+ * @return network::connectStatus_t
+ */
+network::connectStatus_t network::Connector::next_()
+{
+   for( ; m_nNext < m_vecAddresses.size(); ++m_nNext )
+   {
+      const address_t& address = m_vecAddresses[m_nNext];
+      const uint64_t nNow_ns = now_ns();
+      if( (0 != m_nEnd_ns) && (nNow_ns >= m_nEnd_ns) )
+      {
+         m_nError = ETIMEDOUT;
+         break;
+      }
+      m_fd = ::socket( address.nFamily, address.nType | SOCK_NONBLOCK, address.nProtocol );
+      if( -1 == m_fd )
+      {
+         m_nError = errno;
+         continue;
+      }
+      if( 0 == ::connect( m_fd, reinterpret_cast<const struct sockaddr*>( &address.addr ), address.nLength ) )
+      {
+         return done_( connectStatus_t::CONNECTED );
+      }
+      if( EINPROGRESS == errno )
+      {
+         m_nAttemptEnd_ns = (0 != m_nAttempt_ms) ? nNow_ns + static_cast<uint64_t>( m_nAttempt_ms ) * 1000000 : 0;
+         if( (0 != m_nEnd_ns) && ((0 == m_nAttemptEnd_ns) || (m_nEnd_ns < m_nAttemptEnd_ns)) )
+         {
+            m_nAttemptEnd_ns = m_nEnd_ns;
+         }
+         ++m_nNext;
+         return connectStatus_t::IN_PROGRESS;
+      }
+      m_nError = errno;
+      ::close( m_fd );
+      m_fd = -1;
+   }
+   if( 0 == m_nError )
+   {
+      m_nError = EHOSTUNREACH;   // no address
+   }
+   return done_( connectStatus_t::FAILED );
+}
+
+
+
+/**
+ * @brief ...the connect ended, the addresses are not needed any more
+ *
+ * @param a_status ...CONNECTED or FAILED
+ * @return network::connectStatus_t a_status
+ */
+network::connectStatus_t network::Connector::done_( const connectStatus_t a_status )
+{
+   m_vecAddresses.clear();
+   m_nNext          = 0;
+   m_nAttemptEnd_ns = 0;
+   if( (connectStatus_t::FAILED == a_status) && (-1 != m_fd) )
+   {
+      ::close( m_fd );
+      m_fd = -1;
+   }
+   return a_status;
+}
+
+
+
+/**
+ * @brief ...the socket of the attempt is writable (or in error), SO_ERROR tells if it connected
+ *
+ * @return network::connectStatus_t IN_PROGRESS not connected yet or the next address is tried on a new socket, CONNECTED, FAILED
+ */
+network::connectStatus_t network::Connector::writable()
+{
+   if( -1 == m_fd )
+   {
+      return connectStatus_t::FAILED;
+   }
+   int32_t   nError  = 0;
+   socklen_t nLength = sizeof( nError );
+   if( -1 == getsockopt( m_fd, SOL_SOCKET, SO_ERROR, &nError, &nLength ) )
+   {
+      nError = errno;
+   }
+   if( 0 == nError )
+   {
+      struct sockaddr_storage peer;
+      socklen_t               nPeerLength = sizeof( peer );
+      if( (-1 == getpeername( m_fd, reinterpret_cast<struct sockaddr*>( &peer ), &nPeerLength )) && (ENOTCONN == errno) )
+      {
+         // an event of an earlier socket with the same fd, this one is still connecting
+         return connectStatus_t::IN_PROGRESS;
+      }
+      return done_( connectStatus_t::CONNECTED );
+   }
+   m_nError = nError;
+   ::close( m_fd );
+   m_fd = -1;
+   return next_();
+}
+
+
+
+/**
+ * @brief ...check the deadlines, an attempt that ran out of time is given up for the next address
+ *
+ * @return network::connectStatus_t IN_PROGRESS still waiting or the next address is tried, FAILED no time or address left
+ */
+network::connectStatus_t network::Connector::expired()
+{
+   if( -1 == m_fd )
+   {
+      return connectStatus_t::FAILED;
+   }
+   if( (0 == m_nAttemptEnd_ns) || (now_ns() < m_nAttemptEnd_ns) )
+   {
+      return connectStatus_t::IN_PROGRESS;
+   }
+   m_nError = ETIMEDOUT;
+   ::close( m_fd );
+   m_fd = -1;
+   return next_();
+}
+
+
+
+/**
+ * @brief ...give up the connect in progress, its socket is closed
+ *
+ */
+void network::Connector::cancel()
+{
+   done_( connectStatus_t::FAILED );
+}
+
+
+
+/**
+ * @brief ...take the connected socket, the connector forgets it
+ *
+ * @return int32_t -1 when not connected
+ */
+int32_t network::Connector::release()
+{
+   const int32_t fd = m_fd;
+   m_fd = -1;
+   return fd;
+}
+
+
+
+/**
+ * @brief ...blocking connect within the deadlines, the non-blocking connects waited for with poll
+ *
+ * @param a_strHost ...hostname or IP
+ * @param a_strPort ...port as a string
+ * @param a_nFamily ...AF_INET, AF_INET6 or AF_UNSPEC
+ * @param a_nType ...SOCK_STREAM or SOCK_DGRAM
+ * @param a_nAttempt_ms ...deadline of each address, 0 none
+ * @param a_nTimeout_ms ...deadline of the connect, 0 none
+ * @return int32_t the connected socket, non-blocking.  -1 errno set
+ */
+int32_t network::Connector::connect( const std::string& a_strHost, const std::string& a_strPort, const int32_t a_nFamily, const int32_t a_nType,
+                                     const uint32_t a_nAttempt_ms, const uint32_t a_nTimeout_ms )
+{
+   Connector       connector;
+   connectStatus_t status = connector.start( a_strHost, a_strPort, a_nFamily, a_nType, a_nAttempt_ms, a_nTimeout_ms );
+   while( connectStatus_t::IN_PROGRESS == status )
+   {
+      int32_t nWait_ms = -1;
+      if( 0 != connector.deadline_ns() )
+      {
+         const uint64_t nNow_ns = now_ns();
+         nWait_ms = (connector.deadline_ns() > nNow_ns) ? static_cast<int32_t>( (connector.deadline_ns() - nNow_ns + 999999) / 1000000 ) : 0;
+      }
+      struct pollfd pfd;
+      pfd.fd      = connector.fd();
+      pfd.events  = POLLOUT;
+      pfd.revents = 0;
+      const int nReady = ::poll( &pfd, 1, nWait_ms );
+      if( nReady > 0 )
+      {
+         status = connector.writable();
+      } else if( 0 == nReady )
+      {
+         status = connector.expired();
+      } else if( EINTR != errno )
+      {
+         connector.m_nError = errno;
+         connector.cancel();
+         status = connectStatus_t::FAILED;
+      }
+   }
+   if( connectStatus_t::FAILED == status )
+   {
+      errno = connector.error();
+      return -1;
+   }
+   return connector.release();
+}
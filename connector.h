@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "resolver.h"
+
+namespace gdlib {
+namespace network
+{
+   enum struct connectStatus_t: int32_t { IN_PROGRESS, CONNECTED, FAILED };
+
+   using connectCallback_t = void( * )( const int32_t& a_fd, const int32_t a_nError, void* const a_pData );  // a_fd connected, or -1 and a_nError the errno of the failure
+
+   /**
+    * @brief one non-blocking connect over the addresses of a host.  start resolves the host (Resolver, cached) and issues the
+    * connect of the first address on a SOCK_NONBLOCK socket, the owner waits for the socket to become writable (EPOLLOUT, POLLOUT) and
+    * calls writable, which reads SO_ERROR: connected, or the attempt failed and the next address is tried on a new socket.
+    * nothing blocks but a resolve that misses the cache, a host that does not answer costs a socket and a deadline instead
+    * of a thread.  the start of addresses already resolved (Resolver::resolveAsync) does not block at all
+    *
+    * two deadlines, 0 none: a_nAttempt_ms for each address, a_nTimeout_ms for the whole connect.  deadline_ns is the nearer
+    * of the two for the attempt in flight, the owner calls expired once it passed (a poll timeout or a timer).  ETIMEDOUT
+    * when an attempt or the connect ran out of time
+    *
+    * the socket changes when the next address is tried, fd gives the one to wait on.  the socket of a failed attempt is
+    * closed, the connected one is taken with release, it is still non-blocking.  connect is the blocking form with poll
+    *
+    * not thread safe, one owner
+    */
+   class Connector
+   {
+      private:
+         std::vector<address_t>  m_vecAddresses    = std::vector<address_t>();   // cleared when the connect ends
+         size_t                  m_nNext           = 0;         // next address to try
+         int32_t                 m_fd              = -1;        // socket of the attempt in flight
+         int32_t                 m_nError          = 0;         // errno of the last failed attempt
+         uint32_t                m_nAttempt_ms     = 0;
+         uint64_t                m_nAttemptEnd_ns  = 0;         // deadline of the attempt in flight, 0 none
+         uint64_t                m_nEnd_ns         = 0;         // deadline of the connect, 0 none
+
+         connectStatus_t next_();
+         connectStatus_t done_( const connectStatus_t a_status );
+
+      public:
+         Connector() = default;
+         Connector( const Connector& ) = delete;
+         ~Connector()                                    { cancel(); }
+
+         Connector& operator =( const Connector& ) = delete;
+
+         connectStatus_t start( const std::string& a_strHost, const std::string& a_strPort, const int32_t a_nFamily = AF_INET, const int32_t a_nType = SOCK_STREAM,
+                                const uint32_t a_nAttempt_ms = 0, const uint32_t a_nTimeout_ms = 0 );
+         connectStatus_t start( const std::vector<address_t>& a_vecAddresses, const uint32_t a_nAttempt_ms = 0, const uint32_t a_nTimeout_ms = 0 );
+         connectStatus_t writable();
+         connectStatus_t expired();
+         void     cancel();
+         int32_t  release();
+         int32_t  fd() const                             { return m_fd; }
+         int32_t  error() const                          { return m_nError; }
+         uint64_t deadline_ns() const                    { return m_nAttemptEnd_ns; }
+
+         static int32_t  connect( const std::string& a_strHost, const std::string& a_strPort, const int32_t a_nFamily = AF_INET, const int32_t a_nType = SOCK_STREAM,
+                                  const uint32_t a_nAttempt_ms = 0, const uint32_t a_nTimeout_ms = 0 );
+         static uint64_t now_ns();
+   };
+}
+}
@@ -0,0 +1,227 @@
+#include "framing.h"
+#include "bufferpool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+
+using namespace std;
+using namespace gdlib;
+
+
+
+/**
+ * @brief ...
+ *
+ */
+network::RecvBuffer::~RecvBuffer()
+{
+   release();
+}
+
+
+
+/**
+ * @brief ...get the buffer from the pool, called when the connection is opened
+ *
+ * @param a_nCapacity ...bytes, also the largest frame that can be received, a LENGTH_PREFIX header included
+ * @return bool
+ */
+bool network::RecvBuffer::allocate( const size_t a_nCapacity )
+{
+   if( (nullptr != m_pBuffer) && (m_nCapacity == a_nCapacity) )
+   {
+      reset();
+      return true;
+   }
+   release();
+   size_t nPoolCapacity = 0;
+   m_pBuffer = BufferPool::acquire( a_nCapacity, nPoolCapacity );
+   if( nullptr == m_pBuffer )
+   {
+      return false;
+   }
+   m_nCapacity = a_nCapacity;     // the requested size, it is the largest message
+   reset();
+   return true;
+}
+
+
+
+/**
+ * @brief ...return the buffer to the pool
+ *
+ */
+void network::RecvBuffer::release()
+{
+   if( nullptr != m_pBuffer )
+   {
+      BufferPool::release( m_pBuffer );
+      m_pBuffer = nullptr;
+   }
+   m_nCapacity = 0;
+   reset();
+}
+
+
+
+/**
+ * @brief ...one read from a non-blocking fd into the free space at the tail.  unread bytes are moved to the front first
+ * if the tail is at the end of the buffer
+ *
+ * @param a_fd ...non-blocking socket
+ * @return ssize_t  > 0 bytes read
+ *                  0   EOF, peer closed
+ *                  -1  error, errno EAGAIN when there is no data, ENOBUFS when the buffer is full
+ */
+ssize_t network::RecvBuffer::fill( const int32_t a_fd )
+{
+   if( m_nTail == m_nCapacity )
+   {
+      if( 0 == m_nHead )
+      {
+         errno = ENOBUFS;
+         return -1;
+      }
+      // make room at the tail, a partial frame is now at the start of the buffer
+      memmove( m_pBuffer, m_pBuffer + m_nHead, m_nTail - m_nHead );
+      m_nTail -= m_nHead;
+      m_nHead  = 0;
+   }
+
+   ssize_t nBytesRead;
+   do
+   {
+      nBytesRead = ::read( a_fd, m_pBuffer + m_nTail, m_nCapacity - m_nTail );
+   } while( (-1 == nBytesRead) && (EINTR == errno) );
+
+   if( nBytesRead > 0 )
+   {
+      m_nTail += static_cast<size_t>( nBytesRead );
+   }
+   return nBytesRead;
+}
+
+
+
+/**
+ * @brief ...copy bytes that were received elsewhere (io_uring provided buffer) to the tail, moving unread bytes to the
+ * front if needed
+ *
+ * @param a_pData ...
+ * @param a_nSize ...
+ * @return size_t bytes taken, less than a_nSize when the buffer is full
+ */
+size_t network::RecvBuffer::append( const uint8_t* a_pData, const size_t a_nSize )
+{
+   if( (m_nTail + a_nSize > m_nCapacity) && (m_nHead > 0) )
+   {
+      memmove( m_pBuffer, m_pBuffer + m_nHead, m_nTail - m_nHead );
+      m_nTail -= m_nHead;
+      m_nHead  = 0;
+   }
+   const size_t nTaken = (a_nSize < m_nCapacity - m_nTail) ? a_nSize : (m_nCapacity - m_nTail);
+   memcpy( m_pBuffer + m_nTail, a_pData, nTaken );
+   m_nTail += nTaken;
+   return nTaken;
+}
+
+
+
+/**
+ * @brief ...cut the next complete message from the buffer
+ * the view points into the buffer and is valid until the next fill
+ *
+ * @param a_spec ...framing
+ * @param a_pMessage ...out, first byte of the message
+ * @param a_nLength ...out, message length
+ * @return frameStatus_t
+ *       FRAME       a_pMessage/a_nLength set and consumed from the buffer
+ *       INCOMPLETE  need more data
+ *       OVERSIZE    the message can not fit in the buffer, the connection should be closed
+ */
+network::frameStatus_t network::RecvBuffer::nextFrame( const framingSpec_t& a_spec, const uint8_t*& a_pMessage, size_t& a_nLength )
+{
+   const size_t nAvailable = m_nTail - m_nHead;
+   if( 0 == nAvailable )
+   {
+      reset();
+      return frameStatus_t::INCOMPLETE;
+   }
+
+   const uint8_t* pHead = m_pBuffer + m_nHead;
+   size_t         nFrameSize;        // bytes consumed from the buffer
+   switch( a_spec.type )
+   {
+      case framing_t::LENGTH_PREFIX:
+      {
+         if( nAvailable < a_spec.nHeaderSize )
+         {
+            return frameStatus_t::INCOMPLETE;
+         }
+         size_t nPayload = 0;
+         for( uint32_t nIndex=0; nIndex<a_spec.nHeaderSize; ++nIndex )
+         {
+            nPayload = (nPayload << 8) | pHead[nIndex];
+         }
+         if( nPayload + a_spec.nHeaderSize > m_nCapacity )
+         {
+            return frameStatus_t::OVERSIZE;
+         }
+         if( nAvailable < nPayload + a_spec.nHeaderSize )
+         {
+            return frameStatus_t::INCOMPLETE;
+         }
+         a_pMessage  = pHead + a_spec.nHeaderSize;
+         a_nLength   = nPayload;
+         nFrameSize  = nPayload + a_spec.nHeaderSize;
+         break;
+      }
+
+      case framing_t::DELIMITER:
+      {
+         // only search the bytes that arrived since the last call
+         const void* pDelimiter = memchr( pHead + m_nScanned, a_spec.cDelimiter, nAvailable - m_nScanned );
+         if( nullptr == pDelimiter )
+         {
+            m_nScanned = nAvailable;
+            return (nAvailable == m_nCapacity) ? frameStatus_t::OVERSIZE : frameStatus_t::INCOMPLETE;
+         }
+         a_pMessage  = pHead;
+         a_nLength   = static_cast<size_t>( reinterpret_cast<const uint8_t*>( pDelimiter ) - pHead );
+         nFrameSize  = a_nLength + 1;
+         m_nScanned  = 0;
+         break;
+      }
+
+      case framing_t::FIXED:
+         if( (0 == a_spec.nFixedSize) || (a_spec.nFixedSize > m_nCapacity) )
+         {
+            return frameStatus_t::OVERSIZE;
+         }
+         if( nAvailable < a_spec.nFixedSize )
+         {
+            return frameStatus_t::INCOMPLETE;
+         }
+         a_pMessage  = pHead;
+         a_nLength   = a_spec.nFixedSize;
+         nFrameSize  = a_spec.nFixedSize;
+         break;
+
+      case framing_t::NONE:
+      default:
+         a_pMessage  = pHead;
+         a_nLength   = nAvailable;
+         nFrameSize  = nAvailable;
+         break;
+   }
+
+   m_nHead += nFrameSize;
+   if( m_nHead == m_nTail )
+   {
+      // buffer empty, start over at the front, the view stays valid untill the next fill
+      m_nHead = m_nTail = 0;
+   }
+   return frameStatus_t::FRAME;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+namespace gdlib {
+namespace network
+{
+   enum struct framing_t: int32_t   { NONE, LENGTH_PREFIX, DELIMITER, FIXED };
+   enum struct frameStatus_t: int32_t { FRAME, INCOMPLETE, OVERSIZE };
+
+   /**
+    * @brief how a byte stream is cut into messages
+    * NONE           every read is delivered as is
+    * LENGTH_PREFIX  big endian length header of nHeaderSize (1, 2 or 4) bytes followed by the payload, the header is not delivered
+    * DELIMITER      message ends with cDelimiter, the delimiter is not delivered.  default 0 for null terminated strings
+    * FIXED          every message is nFixedSize bytes
+    */
+   struct framingSpec_t
+   {
+      framing_t   type           = framing_t::NONE;
+      uint32_t    nHeaderSize    = 4;
+      uint8_t     cDelimiter     = 0;
+      uint32_t    nFixedSize     = 0;
+   };
+
+
+
+   /**
+    * @brief per connection receive buffer.  Data is read straight from the socket into the free space at the tail and
+    * complete frames are handed out as a pointer/length view into the buffer, no copy and no allocation per message.
+    * When the tail reaches the end of the buffer the unread bytes are moved to the front so a frame is always contiguous,
+    * the largest frame is capacity bytes, for LENGTH_PREFIX the header counts, the payload is at most capacity - header.
+    * the buffer comes from the BufferPool
+    *
+    * not thread safe, used by the reactor owning the connection
+    */
+   class RecvBuffer
+   {
+      private:
+         uint8_t*    m_pBuffer      = nullptr;
+         size_t      m_nCapacity    = 0;
+         size_t      m_nHead        = 0;     // first unread byte
+         size_t      m_nTail        = 0;     // first free byte
+         size_t      m_nScanned     = 0;     // DELIMITER, bytes after head already searched for the delimiter
+
+      public:
+         RecvBuffer() = default;
+         RecvBuffer( const RecvBuffer& ) = delete;
+         ~RecvBuffer();
+
+         RecvBuffer& operator =( const RecvBuffer& ) = delete;
+
+         bool        allocate( const size_t a_nCapacity );
+         void        release();
+         void        reset()                 { m_nHead = m_nTail = m_nScanned = 0; }
+         bool        isAllocated() const     { return nullptr != m_pBuffer; }
+         size_t      size() const            { return m_nTail - m_nHead; }
+         size_t      capacity() const        { return m_nCapacity; }
+
+         ssize_t        fill( const int32_t a_fd );
+         size_t         append( const uint8_t* a_pData, const size_t a_nSize );
+         frameStatus_t  nextFrame( const framingSpec_t& a_spec, const uint8_t*& a_pMessage, size_t& a_nLength );
+   };
+}
+}
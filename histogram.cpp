@@ -0,0 +1,287 @@
+#include "histogram.h"
+#include <stdio.h>
+
+
+using namespace std;
+using namespace gdlib;
+
+
+
+/**
+ * @brief ...one thread writes the counters, no read-modify-write needed
+ *
+ * @param a_counter ...
+ * @param a_nValue ...added
+ */
+static inline void bump( std::atomic<uint64_t>& a_counter, const uint64_t a_nValue = 1 )
+{
+   a_counter.store( a_counter.load( std::memory_order_relaxed ) + a_nValue, std::memory_order_relaxed );
+}
+
+
+
+/**
+ * @brief ...a copy of the counters, empty if a reset is pending
+ *
+ * @param a_other ...
+ */
+network::Histogram::Histogram( const Histogram& a_other ) :
+   Histogram()
+{
+   merge( a_other );
+}
+
+
+
+/**
+ * @brief ...
+ *
+ * @param a_other ...
+ * @return network::Histogram&
+ */
+network::Histogram& network::Histogram::operator =( const Histogram& a_other )
+{
+   if( this != &a_other )
+   {
+      clear_();
+      merge( a_other );
+   }
+   return *this;
+}
+
+
+
+/**
+ * @brief ...bucket of a value, values below 256 have a bucket each, above the leading bit picks the power of 2 and the
+ * next 7 bits the sub-bucket
+ *
+ * @param a_nValue ...
+ * @return uint32_t
+ */
+uint32_t network::Histogram::index_( uint64_t a_nValue )
+{
+   if( a_nValue < 2 * s_nSub )
+   {
+      return static_cast<uint32_t>( a_nValue );
+   }
+   if( a_nValue >= (static_cast<uint64_t>( 1 ) << s_nMaxBits) )
+   {
+      a_nValue = (static_cast<uint64_t>( 1 ) << s_nMaxBits) - 1;
+   }
+   const uint32_t nShift = static_cast<uint32_t>( 63 - __builtin_clzll( a_nValue ) ) - s_nSubBits;
+   return (nShift << s_nSubBits) + static_cast<uint32_t>( a_nValue >> nShift );
+}
+
+
+
+/**
+ * @brief ...smallest value counted in a bucket
+ *
+ * @param a_nIndex ...
+ * @return uint64_t
+ */
+uint64_t network::Histogram::lowest_( const uint32_t a_nIndex )
+{
+   if( a_nIndex < 2 * s_nSub )
+   {
+      return a_nIndex;
+   }
+   const uint32_t nShift = (a_nIndex >> s_nSubBits) - 1;
+   return static_cast<uint64_t>( (a_nIndex & (s_nSub - 1)) | s_nSub ) << nShift;
+}
+
+
+
+/**
+ * @brief ...largest value counted in a bucket, what the percentiles report
+ *
+ * @param a_nIndex ...
+ * @return uint64_t
+ */
+uint64_t network::Histogram::highest_( const uint32_t a_nIndex )
+{
+   if( a_nIndex < 2 * s_nSub )
+   {
+      return a_nIndex;
+   }
+   return lowest_( a_nIndex ) + (static_cast<uint64_t>( 1 ) << ((a_nIndex >> s_nSubBits) - 1)) - 1;
+}
+
+
+
+/**
+ * @brief ...owner thread, the counters back to empty
+ *
+ */
+void network::Histogram::clear_()
+{
+   for( auto& count : m_anCounts )
+   {
+      count.store( 0, std::memory_order_relaxed );
+   }
+   m_nCount.store( 0, std::memory_order_relaxed );
+   m_nSum.store( 0, std::memory_order_relaxed );
+   m_nMin.store( UINT64_MAX, std::memory_order_relaxed );
+   m_nMax.store( 0, std::memory_order_relaxed );
+   m_bReset.store( false, std::memory_order_release );
+}
+
+
+
+/**
+ * @brief ...owner thread, count one value
+ *
+ * @param a_nValue_ns ...
+ */
+void network::Histogram::record( const uint64_t a_nValue_ns )
+{
+   if( true == m_bReset.load( std::memory_order_acquire ) )
+   {
+      clear_();
+   }
+   bump( m_anCounts[index_( a_nValue_ns )] );
+   bump( m_nCount );
+   bump( m_nSum, a_nValue_ns );
+   if( a_nValue_ns < m_nMin.load( std::memory_order_relaxed ) )
+   {
+      m_nMin.store( a_nValue_ns, std::memory_order_relaxed );
+   }
+   if( a_nValue_ns > m_nMax.load( std::memory_order_relaxed ) )
+   {
+      m_nMax.store( a_nValue_ns, std::memory_order_relaxed );
+   }
+}
+
+
+
+/**
+ * @brief ...add the counts of a_other, ex the reactors into one.  this must not be recorded into meanwhile, a_other can be
+ *
+ * @param a_other ...
+ */
+void network::Histogram::merge( const Histogram& a_other )
+{
+   if( true == a_other.m_bReset.load( std::memory_order_acquire ) )
+   {
+      return;
+   }
+   for( uint32_t nIndex=0; nIndex<s_nBuckets; ++nIndex )
+   {
+      const uint64_t nCount = a_other.m_anCounts[nIndex].load( std::memory_order_relaxed );
+      if( 0 != nCount )
+      {
+         bump( m_anCounts[nIndex], nCount );
+      }
+   }
+   bump( m_nCount, a_other.m_nCount.load( std::memory_order_relaxed ) );
+   bump( m_nSum, a_other.m_nSum.load( std::memory_order_relaxed ) );
+   if( a_other.m_nMin.load( std::memory_order_relaxed ) < m_nMin.load( std::memory_order_relaxed ) )
+   {
+      m_nMin.store( a_other.m_nMin.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+   }
+   if( a_other.m_nMax.load( std::memory_order_relaxed ) > m_nMax.load( std::memory_order_relaxed ) )
+   {
+      m_nMax.store( a_other.m_nMax.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+   }
+}
+
+
+
+/**
+ * @brief ...
+ *
+ * @return double 0 when empty
+ */
+double network::Histogram::mean() const
+{
+   const uint64_t nCount = count();
+   return (0 != nCount) ? static_cast<double>( m_nSum.load( std::memory_order_relaxed ) ) / static_cast<double>( nCount ) : 0.0;
+}
+
+
+
+/**
+ * @brief ...value below which a_dPercent of the recorded values are, within the precision of its bucket.  query a copy,
+ * the counts of a histogram being recorded move while they are walked
+ *
+ * @param a_dPercent ...0..100, ex 99.9
+ * @return uint64_t ns, 0 when empty
+ */
+uint64_t network::Histogram::percentile( const double a_dPercent ) const
+{
+   uint64_t nTotal = 0;
+   for( const auto& count : m_anCounts )
+   {
+      nTotal += count.load( std::memory_order_relaxed );
+   }
+   if( 0 == nTotal )
+   {
+      return 0;
+   }
+   const double   dPercent = (a_dPercent < 0) ? 0 : ((a_dPercent > 100) ? 100 : a_dPercent);
+   uint64_t       nRank    = static_cast<uint64_t>( dPercent / 100 * static_cast<double>( nTotal ) + 0.5 );
+   nRank = (0 == nRank) ? 1 : ((nRank > nTotal) ? nTotal : nRank);
+   uint64_t nSeen = 0;
+   for( uint32_t nIndex=0; nIndex<s_nBuckets; ++nIndex )
+   {
+      nSeen += m_anCounts[nIndex].load( std::memory_order_relaxed );
+      if( nSeen >= nRank )
+      {
+         const uint64_t nHighest = highest_( nIndex );
+         return (nHighest < max()) ? nHighest : max();
+      }
+   }
+   return max();
+}
+
+
+
+/**
+ * @brief ...one line, count, mean and the usual percentiles in us
+ *
+ * @return std::string
+ */
+std::string network::Histogram::toText() const
+{
+   char szLine[256];
+   snprintf( szLine, sizeof( szLine ),
+             "count %lu, mean %.3f us, min %.3f, p50 %.3f, p90 %.3f, p99 %.3f, p99.9 %.3f, p99.99 %.3f, max %.3f us",
+             count(), mean() / 1e3, static_cast<double>( min() ) / 1e3,
+             static_cast<double>( percentile( 50 ) ) / 1e3, static_cast<double>( percentile( 90 ) ) / 1e3,
+             static_cast<double>( percentile( 99 ) ) / 1e3, static_cast<double>( percentile( 99.9 ) ) / 1e3,
+             static_cast<double>( percentile( 99.99 ) ) / 1e3, static_cast<double>( max() ) / 1e3 );
+   return std::string( szLine );
+}
+
+
+
+/**
+ * @brief ...the non empty buckets, one line each with the header line first: highest value of the bucket in ns, its
+ * count, the running count and the percentile it reaches
+ *
+ * @return std::string
+ */
+std::string network::Histogram::toCsv() const
+{
+   std::string str( "value_ns,count,cumulative,percentile\n" );
+   uint64_t nTotal = 0;
+   for( const auto& count : m_anCounts )
+   {
+      nTotal += count.load( std::memory_order_relaxed );
+   }
+   uint64_t nSeen = 0;
+   char     szLine[96];
+   for( uint32_t nIndex=0; (nIndex<s_nBuckets) && (0 != nTotal); ++nIndex )
+   {
+      const uint64_t nCount = m_anCounts[nIndex].load( std::memory_order_relaxed );
+      if( 0 == nCount )
+      {
+         continue;
+      }
+      nSeen += nCount;
+      snprintf( szLine, sizeof( szLine ), "%lu,%lu,%lu,%.6f\n", highest_( nIndex ), nCount, nSeen,
+                100.0 * static_cast<double>( nSeen ) / static_cast<double>( nTotal ) );
+      str.append( szLine );
+   }
+   return str;
+}
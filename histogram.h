@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <string>
+
+namespace gdlib {
+namespace network
+{
+   /**
+    * @brief log-linear latency histogram in ns, HDR style.  each power of 2 is cut into 128 linear sub-buckets, so a
+    * recorded value is kept within 1/128 (0.8%) of its bucket whatever its size, from 1 ns to 2^36 ns (68 s, larger values
+    * are counted in the last bucket).  the memory is fixed, 3840 counters (30 kB), and a record is an index computed
+    * from the leading bit plus a few relaxed stores, no allocation and no lock
+    *
+    * one thread records (the reactor that owns it), any thread copies, merges or queries a copy.  reset from any thread
+    * is a request, the owner clears the counters before its next record and copies see it empty until then
+    */
+   class Histogram
+   {
+      private:
+         static constexpr uint32_t s_nSubBits   = 7;
+         static constexpr uint32_t s_nSub       = 1 << s_nSubBits;
+         static constexpr uint32_t s_nMaxBits   = 36;
+         static constexpr uint32_t s_nBuckets   = (s_nMaxBits - s_nSubBits + 1) * s_nSub;
+
+         std::atomic<uint64_t>   m_anCounts[s_nBuckets]  = {};
+         std::atomic<uint64_t>   m_nCount                = {0};
+         std::atomic<uint64_t>   m_nSum                  = {0};
+         std::atomic<uint64_t>   m_nMin                  = {UINT64_MAX};
+         std::atomic<uint64_t>   m_nMax                  = {0};
+         std::atomic<bool>       m_bReset                = {false};
+
+         void     clear_();
+
+         static uint32_t index_( uint64_t a_nValue );
+         static uint64_t lowest_( const uint32_t a_nIndex );
+         static uint64_t highest_( const uint32_t a_nIndex );
+
+      public:
+         Histogram() = default;
+         Histogram( const Histogram& a_other );
+
+         Histogram& operator =( const Histogram& a_other );
+
+         void     record( const uint64_t a_nValue_ns );
+         void     reset()                        { m_bReset.store( true, std::memory_order_release ); }
+         void     merge( const Histogram& a_other );
+
+         uint64_t count() const                  { return m_nCount.load( std::memory_order_relaxed ); }
+         uint64_t min() const                    { return (0 != count()) ? m_nMin.load( std::memory_order_relaxed ) : 0; }
+         uint64_t max() const                    { return m_nMax.load( std::memory_order_relaxed ); }
+         double   mean() const;
+         uint64_t percentile( const double a_dPercent ) const;
+         std::string toText() const;
+         std::string toCsv() const;
+   };
+
+
+
+   /**
+    * @brief latency of one reactor (or of the ClientAsync receiver thread), see ServerAsync::getLatency
+    */
+   struct latency_t
+   {
+      Histogram   callback    = Histogram();     // socket and message callbacks, how long each held the thread
+      Histogram   send        = Histogram();     // send, sendv and sendFile from entry to return
+   };
+}
+}
@@ -0,0 +1,126 @@
+#include "metrics.h"
+#include <stdio.h>
+#include <time.h>
+
+
+using namespace std;
+using namespace gdlib;
+
+
+
+/**
+ * @brief ...sum, to aggregate the reactors
+ *
+ * @param a_other ...
+ * @return network::metrics_t&
+ */
+network::metrics_t& network::metrics_t::operator +=( const metrics_t& a_other )
+{
+   nWakeups       += a_other.nWakeups;
+   nEvents        += a_other.nEvents;
+   nAccepts       += a_other.nAccepts;
+   nCloses        += a_other.nCloses;
+   nBytesIn       += a_other.nBytesIn;
+   nBytesOut      += a_other.nBytesOut;
+   nMessagesIn    += a_other.nMessagesIn;
+   nMessagesOut   += a_other.nMessagesOut;
+   nReadEagain    += a_other.nReadEagain;
+   nSendEagain    += a_other.nSendEagain;
+   nSendRetries   += a_other.nSendRetries;
+   nDispatchDrops += a_other.nDispatchDrops;
+   nBusy_ns       += a_other.nBusy_ns;
+   return *this;
+}
+
+
+
+/**
+ * @brief ...reactor thread, the wait returned
+ *
+ * @param a_nEvents ...events it returned
+ */
+void network::Metrics::wakeup( const uint64_t a_nEvents )
+{
+   struct timespec ts;
+   clock_gettime( CLOCK_MONOTONIC, &ts );
+   m_nWake_ns = static_cast<uint64_t>( ts.tv_sec ) * 1000000000 + static_cast<uint64_t>( ts.tv_nsec );
+   add( metric_t::WAKEUPS );
+   add( metric_t::EVENTS, a_nEvents );
+}
+
+
+
+/**
+ * @brief ...reactor thread, about to wait, the time since the wakeup was busy
+ *
+ */
+void network::Metrics::waiting()
+{
+   if( 0 != m_nWake_ns )
+   {
+      struct timespec ts;
+      clock_gettime( CLOCK_MONOTONIC, &ts );
+      add( metric_t::BUSY_NS, static_cast<uint64_t>( ts.tv_sec ) * 1000000000 + static_cast<uint64_t>( ts.tv_nsec ) - m_nWake_ns );
+      m_nWake_ns = 0;
+   }
+}
+
+
+
+/**
+ * @brief ...read the counters without stopping the reactor, each is exact, together they may be a few events apart
+ *
+ * @return network::metrics_t
+ */
+network::metrics_t network::Metrics::snapshot() const
+{
+   metrics_t metrics;
+   metrics.nWakeups     = get( metric_t::WAKEUPS );
+   metrics.nEvents      = get( metric_t::EVENTS );
+   metrics.nAccepts     = get( metric_t::ACCEPTS );
+   metrics.nCloses      = get( metric_t::CLOSES );
+   metrics.nBytesIn     = get( metric_t::BYTES_IN );
+   metrics.nBytesOut    = get( metric_t::BYTES_OUT );
+   metrics.nMessagesIn  = get( metric_t::MESSAGES_IN );
+   metrics.nMessagesOut = get( metric_t::MESSAGES_OUT );
+   metrics.nReadEagain  = get( metric_t::READ_EAGAIN );
+   metrics.nSendEagain  = get( metric_t::SEND_EAGAIN );
+   metrics.nSendRetries = get( metric_t::SEND_RETRIES );
+   metrics.nDispatchDrops = get( metric_t::DISPATCH_DROPS );
+   metrics.nBusy_ns     = get( metric_t::BUSY_NS );
+   return metrics;
+}
+
+
+
+/**
+ * @brief ...one line of rates between two snapshots, for the periodic log
+ *
+ * @param a_now ...
+ * @param a_before ...snapshot a_dSeconds earlier
+ * @param a_dSeconds ...
+ * @return std::string
+ */
+std::string network::Metrics::format( const metrics_t& a_now, const metrics_t& a_before, const double a_dSeconds )
+{
+   const double   dSeconds  = (a_dSeconds > 0) ? a_dSeconds : 1;
+   const uint64_t nWakeups  = a_now.nWakeups - a_before.nWakeups;
+   char szLine[512];
+   snprintf( szLine, sizeof( szLine ),
+             "wakeups/s %.0f, events/wakeup %.2f, accepts %lu, closes %lu, in %.3f MB/s %.0f msg/s, out %.3f MB/s %.0f msg/s, "
+             "read eagain %lu, send eagain %lu, send retries %lu, dispatch drops %lu, busy %.1f%%",
+             static_cast<double>( nWakeups ) / dSeconds,
+             (0 != nWakeups) ? static_cast<double>( a_now.nEvents - a_before.nEvents ) / static_cast<double>( nWakeups ) : 0.0,
+             a_now.nAccepts - a_before.nAccepts,
+             a_now.nCloses - a_before.nCloses,
+             static_cast<double>( a_now.nBytesIn - a_before.nBytesIn ) / dSeconds / 1e6,
+             static_cast<double>( a_now.nMessagesIn - a_before.nMessagesIn ) / dSeconds,
+             static_cast<double>( a_now.nBytesOut - a_before.nBytesOut ) / dSeconds / 1e6,
+             static_cast<double>( a_now.nMessagesOut - a_before.nMessagesOut ) / dSeconds,
+             a_now.nReadEagain - a_before.nReadEagain,
+             a_now.nSendEagain - a_before.nSendEagain,
+             a_now.nSendRetries - a_before.nSendRetries,
+             a_now.nDispatchDrops - a_before.nDispatchDrops,
+             static_cast<double>( a_now.nBusy_ns - a_before.nBusy_ns ) / dSeconds / 1e7 );
+   return std::string( szLine );
+}
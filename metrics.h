@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <string>
+
+namespace gdlib {
+namespace network
+{
+   enum struct metric_t: uint32_t { WAKEUPS, EVENTS, ACCEPTS, CLOSES, BYTES_IN, BYTES_OUT, MESSAGES_IN, MESSAGES_OUT, READ_EAGAIN, SEND_EAGAIN, SEND_RETRIES, DISPATCH_DROPS, BUSY_NS, COUNT };
+
+   /**
+    * @brief counters of one reactor, or the sum of all, see Metrics::snapshot
+    */
+   struct metrics_t
+   {
+      uint64_t    nWakeups       = 0;     // waits that returned events
+      uint64_t    nEvents        = 0;     // events (completions with IO_URING) handled
+      uint64_t    nAccepts       = 0;
+      uint64_t    nCloses        = 0;
+      uint64_t    nBytesIn       = 0;     // read by the library, with a message callback
+      uint64_t    nBytesOut      = 0;     // taken by send, written or queued
+      uint64_t    nMessagesIn    = 0;     // message callbacks
+      uint64_t    nMessagesOut   = 0;     // sends
+      uint64_t    nReadEagain    = 0;     // reads that found no data, the end of each drain
+      uint64_t    nSendEagain    = 0;     // sends the socket did not take at once, the rest was queued
+      uint64_t    nSendRetries   = 0;     // writes of queued bytes once the socket was writable
+      uint64_t    nDispatchDrops = 0;     // messages the worker pool refused, its queue was full
+      uint64_t    nBusy_ns       = 0;     // from a wakeup to the next wait, the callbacks included
+
+      metrics_t& operator +=( const metrics_t& a_other );
+   };
+
+
+
+   /**
+    * @brief counters of one reactor.  only the reactor thread writes them, an increment is a relaxed load and store of
+    * its own cache lines (no lock prefix, no sharing with the other reactors), snapshot reads them from any thread while
+    * the reactor runs.  wakeup after the wait returned and waiting before the next wait take one clock pair per wakeup for the
+    * busy time.  the reactor publishes its instance in a thread_local so the read and send paths count without
+    * being handed the reactor
+    */
+   class alignas( 64 ) Metrics
+   {
+      private:
+         std::atomic<uint64_t>   m_anCounters[static_cast<size_t>( metric_t::COUNT )] = {};
+         uint64_t                m_nWake_ns        = 0;     // wakeup being handled, 0 while waiting
+
+      public:
+         Metrics() = default;
+         Metrics( const Metrics& ) = delete;
+
+         Metrics& operator =( const Metrics& ) = delete;
+
+         void        add( const metric_t a_metric, const uint64_t a_nValue = 1 )
+         {
+            std::atomic<uint64_t>& counter = m_anCounters[static_cast<size_t>( a_metric )];
+            counter.store( counter.load( std::memory_order_relaxed ) + a_nValue, std::memory_order_relaxed );
+         }
+         void        wakeup( const uint64_t a_nEvents );
+         void        waiting();
+         uint64_t    get( const metric_t a_metric ) const  { return m_anCounters[static_cast<size_t>( a_metric )].load( std::memory_order_relaxed ); }
+         metrics_t   snapshot() const;
+
+         static std::string format( const metrics_t& a_now, const metrics_t& a_before, const double a_dSeconds );
+   };
+}
+}
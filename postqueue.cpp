@@ -0,0 +1,247 @@
+#include "postqueue.h"
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <new>
+
+
+using namespace std;
+using namespace gdlib;
+
+
+
+/**
+ * @brief ...messages still queued are dropped
+ *
+ */
+network::PostQueue::~PostQueue()
+{
+   close();
+}
+
+
+
+/**
+ * @brief ...create the eventfd, call before the reactor starts.  a queue already open is kept
+ *
+ * @return bool
+ */
+bool network::PostQueue::open()
+{
+   if( -1 != m_fdWake )
+   {
+      return true;
+   }
+   m_fdWake = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+   return -1 != m_fdWake;
+}
+
+
+
+/**
+ * @brief ...drop what is queued and close the eventfd.  no producer may post meanwhile
+ *
+ */
+void network::PostQueue::close()
+{
+   node_t* pNode;
+   while( nullptr != (pNode = pop_()) )
+   {
+      free_( pNode );
+   }
+   if( -1 != m_fdWake )
+   {
+      ::close( m_fdWake );
+      m_fdWake = -1;
+   }
+   m_bWakePending.store( false );
+}
+
+
+
+/**
+ * @brief ...copy a message and queue it
+ *
+ * @param a_fd ...where the reactor sends it
+ * @param a_nTag ...handed back with the message
+ * @param a_pBuffer ...
+ * @param a_nLength ...
+ * @return bool false, errno EBADF if the queue is not open, ENOMEM
+ */
+bool network::PostQueue::post( const int32_t a_fd, const uint64_t a_nTag, const void* a_pBuffer, const size_t a_nLength )
+{
+   if( -1 == m_fdWake )
+   {
+      errno = EBADF;
+      return false;
+   }
+   size_t   nCapacity;
+   uint8_t* pMemory = BufferPool::acquire( s_nNodeSize + a_nLength, nCapacity );
+   if( nullptr == pMemory )
+   {
+      return false;
+   }
+   node_t* pNode  = new( pMemory ) node_t();
+   pNode->fd      = a_fd;
+   pNode->nTag    = a_nTag;
+   pNode->pBuffer = pMemory + s_nNodeSize;
+   pNode->nLength = a_nLength;
+   memcpy( pMemory + s_nNodeSize, a_pBuffer, a_nLength );
+   push_( pNode );
+   wake();
+   return true;
+}
+
+
+
+/**
+ * @brief ...queue a pool buffer without copying, the queue holds a reference until the reactor sent it
+ *
+ * @param a_fd ...where the reactor sends it
+ * @param a_nTag ...handed back with the message
+ * @param a_buffer ...must not be changed until sent
+ * @param a_nLength ...bytes of the buffer to send
+ * @return bool false, errno EBADF if the queue is not open, EINVAL, ENOMEM
+ */
+bool network::PostQueue::post( const int32_t a_fd, const uint64_t a_nTag, const PoolBuffer& a_buffer, const size_t a_nLength )
+{
+   if( -1 == m_fdWake )
+   {
+      errno = EBADF;
+      return false;
+   }
+   if( (false == a_buffer.valid()) || (a_nLength > a_buffer.capacity()) )
+   {
+      errno = EINVAL;
+      return false;
+   }
+   size_t   nCapacity;
+   uint8_t* pMemory = BufferPool::acquire( s_nNodeSize, nCapacity );
+   if( nullptr == pMemory )
+   {
+      return false;
+   }
+   BufferPool::addRef( a_buffer.data() );
+   node_t* pNode  = new( pMemory ) node_t();
+   pNode->fd      = a_fd;
+   pNode->nTag    = a_nTag;
+   pNode->pBuffer = a_buffer.data();
+   pNode->nLength = a_nLength;
+   pNode->bShared = true;
+   push_( pNode );
+   wake();
+   return true;
+}
+
+
+
+/**
+ * @brief ...make the reactor drain, one eventfd write until it did
+ *
+ */
+void network::PostQueue::wake()
+{
+   // pairs with the fence in clearWake_, either the reactor sees the message or this sees the flag cleared
+   std::atomic_thread_fence( std::memory_order_seq_cst );
+   if( (-1 != m_fdWake) && (false == m_bWakePending.exchange( true )) )
+   {
+      const uint64_t nOne = 1;
+      if( -1 == ::write( m_fdWake, &nOne, sizeof( nOne ) ) )
+      {
+         m_bWakePending.store( false );   // counter full, cannot happen with one write per drain
+      }
+   }
+}
+
+
+
+/**
+ * @brief ...link a node at the head, wait free
+ *
+ * @param a_pNode ...
+ */
+void network::PostQueue::push_( node_t* a_pNode )
+{
+   a_pNode->pNext.store( nullptr, std::memory_order_relaxed );
+   node_t* pPrev = m_pHead.exchange( a_pNode, std::memory_order_acq_rel );
+   pPrev->pNext.store( a_pNode, std::memory_order_release );
+}
+
+
+
+/**
+ * @brief ...take the oldest node, reactor only.  returns nullptr when empty or when a producer is between its exchange
+ * and its link, that producer then sees the wake flag cleared and writes the eventfd again
+ *
+ * @return network::PostQueue::node_t*
+ */
+network::PostQueue::node_t* network::PostQueue::pop_()
+{
+   node_t* pTail = m_pTail;
+   node_t* pNext = pTail->pNext.load( std::memory_order_acquire );
+   if( &m_stub == pTail )
+   {
+      if( nullptr == pNext )
+      {
+         return nullptr;
+      }
+      m_pTail = pNext;
+      pTail   = pNext;
+      pNext   = pNext->pNext.load( std::memory_order_acquire );
+   }
+   if( nullptr != pNext )
+   {
+      m_pTail = pNext;
+      return pTail;
+   }
+   if( pTail != m_pHead.load( std::memory_order_acquire ) )
+   {
+      return nullptr;
+   }
+   // last node, put the stub behind it so it can be taken
+   push_( &m_stub );
+   pNext = pTail->pNext.load( std::memory_order_acquire );
+   if( nullptr != pNext )
+   {
+      m_pTail = pNext;
+      return pTail;
+   }
+   return nullptr;
+}
+
+
+
+/**
+ * @brief ...return a node and its message to the pool
+ *
+ * @param a_pNode ...
+ */
+void network::PostQueue::free_( node_t* a_pNode )
+{
+   if( true == a_pNode->bShared )
+   {
+      BufferPool::release( a_pNode->pBuffer );
+   }
+   a_pNode->~node_t();
+   BufferPool::release( a_pNode );
+}
+
+
+
+/**
+ * @brief ...reset the eventfd and the flag before draining, a post after this writes the eventfd again
+ *
+ */
+void network::PostQueue::clearWake_()
+{
+   uint64_t nCount;
+   if( -1 != m_fdWake )
+   {
+      while( (-1 == ::read( m_fdWake, &nCount, sizeof( nCount ) )) && (EINTR == errno) )
+      {
+      }
+   }
+   m_bWakePending.store( false );
+   std::atomic_thread_fence( std::memory_order_seq_cst );
+}
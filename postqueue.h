@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include "bufferpool.h"
+
+namespace gdlib {
+namespace network
+{
+   /**
+    * @brief messages handed from application threads to one reactor.  post copies the message into a BufferPool buffer
+    * (or takes a reference to a PoolBuffer) and links it into a lock-free multi producer / single consumer queue, the
+    * eventfd is written only when the reactor is not already woken, so producers do not lock and do not make a syscall
+    * per message.  the reactor has fd() in its epoll set (or ring) and calls drain, which hands back every queued
+    * message in post order on the reactor thread
+    *
+    * post and wake from any thread, drain from the reactor only
+    */
+   class PostQueue
+   {
+      private:
+         struct node_t
+         {
+            std::atomic<node_t*> pNext    = {nullptr};
+            int32_t     fd                = -1;
+            uint64_t    nTag              = 0;           // what the fd was when posted, checked by the reactor
+            const uint8_t* pBuffer        = nullptr;
+            size_t      nLength           = 0;
+            bool        bShared           = false;       // pBuffer is a reference to a PoolBuffer, else it follows the node
+         };
+
+         static constexpr size_t s_nNodeSize = 64;      // node rounded to a cache line, a copied message follows it
+
+         node_t                  m_stub;
+         alignas( 64 ) std::atomic<node_t*> m_pHead  = {&m_stub};    // producers link here
+         alignas( 64 ) node_t*   m_pTail             = &m_stub;      // reactor takes from here
+         std::atomic<bool>       m_bWakePending      = {false};      // eventfd written, reactor has not drained yet
+         int32_t                 m_fdWake            = -1;
+
+         void     push_( node_t* a_pNode );
+         node_t*  pop_();
+         void     free_( node_t* a_pNode );
+         void     clearWake_();
+
+      public:
+         PostQueue() : m_stub() {}
+         PostQueue( const PostQueue& ) = delete;
+         ~PostQueue();
+
+         PostQueue& operator =( const PostQueue& ) = delete;
+
+         bool     open();
+         void     close();
+         int32_t  fd() const                             { return m_fdWake; }
+         bool     post( const int32_t a_fd, const uint64_t a_nTag, const void* a_pBuffer, const size_t a_nLength );
+         bool     post( const int32_t a_fd, const uint64_t a_nTag, const PoolBuffer& a_buffer, const size_t a_nLength );
+         void     wake();
+
+         /**
+          * @brief ...reactor, reset the wakeup and call a_fn( fd, tag, buffer, length ) for each queued message in order.
+          * the buffer is returned to the pool when a_fn returns
+          *
+          * @return uint32_t messages handed back
+          */
+         template<typename Fn>
+         uint32_t drain( Fn&& a_fn )
+         {
+            clearWake_();
+            uint32_t nCount = 0;
+            node_t*  pNode;
+            while( nullptr != (pNode = pop_()) )
+            {
+               a_fn( pNode->fd, pNode->nTag, pNode->pBuffer, pNode->nLength );
+               free_( pNode );
+               ++nCount;
+            }
+            return nCount;
+         }
+   };
+}
+}
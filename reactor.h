@@ -0,0 +1,716 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <vector>
+#include <thread>
+#include <type_traits>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/eventfd.h>
+
+#include "sockets.h"
+
+namespace gdlib {
+namespace network
+{
+   /**
+    * @brief compile time options of BasicServerAsync
+    * EDGE           EPOLLET, a readable connection is read until EAGAIN.  else level trigger, one read per event
+    * STACK_EVENTS   epoll_wait fills an array on the reactor stack, else a heap array
+    * MAX_EVENTS     events per epoll_wait
+    */
+   template<bool EDGE = false, bool STACK_EVENTS = true, int32_t MAX_EVENTS = 512>
+   struct reactorPolicy_t
+   {
+      static constexpr bool      s_bEdgeTriggered  = EDGE;
+      static constexpr bool      s_bStackEvents    = STACK_EVENTS;
+      static constexpr int32_t   s_nMaxEvents      = MAX_EVENTS;
+   };
+   using levelTriggered_t = reactorPolicy_t<false>;
+   using edgeTriggered_t  = reactorPolicy_t<true>;
+
+
+
+   /**
+    * @brief handler for BasicServerAsync calling the function pointer callbacks of ServerAsync, to move code over
+    * without rewriting the callbacks.  MESSAGE is not used, the library reads and frames the data
+    */
+   struct callbackHandler_t
+   {
+      socketCallback_t     cbSocketEvent  = nullptr;
+      messageCallback_t    cbMessage      = nullptr;
+      errorCallBack_t      cbError        = nullptr;
+      void*                pData          = nullptr;
+
+      void onOpen( const socketfd_t a_fd )
+      {
+         if( nullptr != cbSocketEvent )
+         {
+            cbSocketEvent( a_fd, callBack_t::SESION_OPEN, pData );
+         }
+      }
+      void onMessage( const socketfd_t a_fd, const uint8_t* a_pMessage, const size_t a_nLength )
+      {
+         if( nullptr != cbMessage )
+         {
+            cbMessage( a_fd, a_pMessage, a_nLength, pData );
+         }
+      }
+      void onClose( const socketfd_t a_fd )
+      {
+         if( nullptr != cbSocketEvent )
+         {
+            cbSocketEvent( a_fd, callBack_t::SESSION_CLOSE, pData );
+         }
+      }
+      void onError( const int32_t a_nErrno, const char* a_pszError )
+      {
+         if( nullptr != cbError )
+         {
+            cbError( a_nErrno, a_pszError, pData );
+         }
+      }
+   };
+
+
+
+   /**
+    * @brief ...async server with the handler and the options fixed at compile time.  The reactor calls the members of
+    * the handler directly, so they can be inlined, and trigger mode and event storage are template parameters, the
+    * hot loop has no callback pointer checks and no runtime mode branches
+    * @example see testing/template/server.cpp
+    *
+    * @details Handler provides
+    *    void onOpen( const socketfd_t a_fd );
+    *    void onMessage( const socketfd_t a_fd, const uint8_t* a_pMessage, const size_t a_nLength );  complete message, view into the receive buffer
+    *    void onClose( const socketfd_t a_fd );
+    *    void onError( const int32_t a_nErrno, const char* a_pszError );
+    * Policy is a reactorPolicy_t
+    *
+    * open, setReactorCount, setFraming, setReceiveBufferSize, send, sendv, nonblockingListener, startAsync, stop, wakeup and
+    * join work as in ServerAsync.  EPOLL engine and TCP only, use ServerAsync for io_uring, zero copy, sendFile and UDP
+    *
+    * the handler is not owned, it must outlive the server.  with more than one reactor its members are called from all
+    * reactor threads, for different connections
+    */
+   template<typename Handler, typename Policy = levelTriggered_t>
+   class BasicServerAsync : public Server
+   {
+      private:
+         struct reactor_t
+         {
+            int32_t     nId                  = 0;
+            socketfd_t  fdListener           = -1;
+            int32_t     fdEpoll              = -1;
+            int32_t     fdWake               = -1;    // eventfd in the epoll set, written by stop and wakeup
+         };
+
+         struct connection_t
+         {
+            RecvBuffer  recvBuffer      = RecvBuffer();
+            SendQueue   sendQueue       = SendQueue();
+            int32_t     fdEpoll         = -1;            // epoll set of the reactor owning the connection, -1 when closed
+            bool        bWritePending   = false;         // EPOLLOUT registered
+         };
+
+         using events_t = typename std::conditional<Policy::s_bStackEvents, std::array<epoll_event, Policy::s_nMaxEvents>, std::vector<epoll_event>>::type;
+
+         static constexpr uint32_t s_nReadEvents = EPOLLIN | EPOLLRDHUP | (Policy::s_bEdgeTriggered ? static_cast<uint32_t>( EPOLLET ) : 0u);
+
+         Handler&                   m_handler;
+         int32_t                    m_nEpollTimeout_ms   = -1;      // blocks until an event or wakeup
+         int32_t                    m_nReactorCount      = 1;
+         std::atomic<bool>          m_bAsyncRunFlag      = {true};
+         std::vector<reactor_t>     m_vecReactors        = std::vector<reactor_t>();
+         std::vector<std::thread>   m_vecReactorThreads  = std::vector<std::thread>();
+         std::vector<connection_t*> m_vecConnections     = std::vector<connection_t*>();   // indexed by fd
+         framingSpec_t              m_framing            = framingSpec_t();
+         uint32_t                   m_nReceiveBufferSize = 65536;
+
+         bool prepareReactors_();
+         bool reactorLoop_( reactor_t& a_reactor );
+         void accept_( const reactor_t& a_reactor );
+         bool read_( const socketfd_t a_fd, connection_t* a_pConnection );
+         bool flush_( const socketfd_t a_fd, connection_t* a_pConnection );
+         void armWrite_( const socketfd_t a_fd, connection_t* a_pConnection );
+         void closeConnection_( const socketfd_t a_fd, connection_t* a_pConnection );
+         connection_t* connection_( const socketfd_t a_fd ) const;
+
+      public:
+         explicit BasicServerAsync( Handler& a_handler ) : m_handler( a_handler ) {}
+         BasicServerAsync( const BasicServerAsync& ) = delete;
+         ~BasicServerAsync();
+
+         BasicServerAsync& operator =( const BasicServerAsync& ) = delete;
+
+         bool     nonblockingListener();
+         bool     startAsync();
+         void     join();
+         ssize_t  send( const socketfd_t a_fd, const void* a_pBuffer, const size_t a_nBufferSize );
+         ssize_t  sendv( const socketfd_t a_fd, const struct iovec* a_pIov, const int32_t a_nCount );
+
+         void     setEpollWaitTimeout( int32_t a_nEpollTimeout_ms )  { m_nEpollTimeout_ms = a_nEpollTimeout_ms; }
+         void     setReactorCount( int32_t a_nCount )                { m_nReactorCount = a_nCount > 0 ? a_nCount : 1; setReusePort( m_nReactorCount > 1 ); }
+         void     setFraming( const framing_t a_type, const uint32_t a_nValue = 0 );
+         void     setReceiveBufferSize( uint32_t a_nSize )           { m_nReceiveBufferSize = a_nSize; }
+         void     stop()                                             { m_bAsyncRunFlag = false; wakeup(); }
+         void     wakeup();
+         int32_t  getReactorCount() const                            { return m_nReactorCount; }
+   };
+
+
+
+   /**
+    * @brief ...stop the reactors, close the connections and the listener
+    *
+    */
+   template<typename Handler, typename Policy>
+   BasicServerAsync<Handler, Policy>::~BasicServerAsync()
+   {
+      stop();
+      join();
+      for( auto pConnection : m_vecConnections )
+      {
+         delete pConnection;
+      }
+      m_vecConnections.clear();
+   }
+
+
+
+   /**
+    * @brief ...how messages are cut from the stream, see ServerAsync::setFraming
+    *
+    * @param a_type ...framing
+    * @param a_nValue ...LENGTH_PREFIX header size 1, 2 or 4, DELIMITER delimiter byte, FIXED message size
+    */
+   template<typename Handler, typename Policy>
+   void BasicServerAsync<Handler, Policy>::setFraming( const framing_t a_type, const uint32_t a_nValue )
+   {
+      m_framing.type = a_type;
+      switch( a_type )
+      {
+         case framing_t::LENGTH_PREFIX:
+            m_framing.nHeaderSize = ( (1 == a_nValue) || (2 == a_nValue) ) ? a_nValue : 4;
+            break;
+         case framing_t::DELIMITER:
+            m_framing.cDelimiter  = static_cast<uint8_t>( a_nValue );
+            break;
+         case framing_t::FIXED:
+            m_framing.nFixedSize  = a_nValue;
+            break;
+         default:
+            break;
+      }
+   }
+
+
+
+   /**
+    * @brief ...size the connection table and create one listener per reactor, see ServerAsync::prepareReactors_
+    *
+    * @return bool
+    */
+   template<typename Handler, typename Policy>
+   bool BasicServerAsync<Handler, Policy>::prepareReactors_()
+   {
+      if( (sockType_t::SERVER != m_type) || (protocol_t::UDP == m_protocol) || (false == m_vecReactorThreads.empty()) )
+      {
+         return false;
+      }
+
+      struct rlimit fileLimit;
+      size_t        nTableSize = 65536;
+      if( (0 == getrlimit( RLIMIT_NOFILE, &fileLimit )) && (RLIM_INFINITY != fileLimit.rlim_cur) )
+      {
+         nTableSize = static_cast<size_t>( fileLimit.rlim_cur );
+      }
+      if( m_vecConnections.size() < nTableSize )
+      {
+         m_vecConnections.resize( nTableSize, nullptr );
+      }
+
+      m_bAsyncRunFlag = true;
+      m_vecReactors.clear();
+      m_vecReactors.resize( static_cast<size_t>( m_nReactorCount ) );
+      m_vecReactors[0].fdListener = m_fdSocket;
+      for( size_t nIndex=1; nIndex<m_vecReactors.size(); ++nIndex )
+      {
+         m_vecReactors[nIndex].nId        = static_cast<int32_t>( nIndex );
+         m_vecReactors[nIndex].fdListener = reusePortListener_();
+         if( -1 == m_vecReactors[nIndex].fdListener )
+         {
+            m_handler.onError( errno, "reactor listener failed, call setReactorCount before open" );
+            for( size_t nUndo=1; nUndo<nIndex; ++nUndo )
+            {
+               ::close( m_vecReactors[nUndo].fdListener );
+            }
+            m_vecReactors.clear();
+            return false;
+         }
+      }
+      for( auto& reactor : m_vecReactors )
+      {
+         makeNonBlocking( reactor.fdListener );   // accepted until EAGAIN
+         reactor.fdWake = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+         if( -1 == reactor.fdWake )
+         {
+            m_handler.onError( errno, strerror( errno ) );
+            for( auto& undo : m_vecReactors )
+            {
+               if( -1 != undo.fdWake )
+               {
+                  ::close( undo.fdWake );
+               }
+               if( m_fdSocket != undo.fdListener )
+               {
+                  ::close( undo.fdListener );
+               }
+            }
+            m_vecReactors.clear();
+            return false;
+         }
+      }
+      return true;
+   }
+
+
+
+   /**
+    * @brief ...make every reactor return from epoll_wait and re-check its state.  any thread, while running
+    *
+    */
+   template<typename Handler, typename Policy>
+   void BasicServerAsync<Handler, Policy>::wakeup()
+   {
+      const uint64_t nOne = 1;
+      for( const auto& reactor : m_vecReactors )
+      {
+         if( (-1 != reactor.fdWake) && (-1 == ::write( reactor.fdWake, &nOne, sizeof( nOne ) )) )
+         {
+            // counter full, the reactor is woken already
+         }
+      }
+   }
+
+
+
+   /**
+    * @brief ...blocking run, reactors 1..n-1 on their own threads and reactor 0 on the calling thread.  returns when stopped
+    *
+    * @return bool
+    */
+   template<typename Handler, typename Policy>
+   bool BasicServerAsync<Handler, Policy>::nonblockingListener()
+   {
+      if( false == prepareReactors_() )
+      {
+         return false;
+      }
+      for( size_t nIndex=1; nIndex<m_vecReactors.size(); ++nIndex )
+      {
+         m_vecReactorThreads.emplace_back( &BasicServerAsync::reactorLoop_, this, std::ref( m_vecReactors[nIndex] ) );
+      }
+      bool bResult = reactorLoop_( m_vecReactors[0] );
+      if( false == bResult )
+      {
+         stop();
+      }
+      join();
+      return bResult;
+   }
+
+
+
+   /**
+    * @brief ...start all reactors on their own threads and return.  stop ends the reactors, join waits for them
+    *
+    * @return bool
+    */
+   template<typename Handler, typename Policy>
+   bool BasicServerAsync<Handler, Policy>::startAsync()
+   {
+      if( false == prepareReactors_() )
+      {
+         return false;
+      }
+      for( auto& reactor : m_vecReactors )
+      {
+         m_vecReactorThreads.emplace_back( &BasicServerAsync::reactorLoop_, this, std::ref( reactor ) );
+      }
+      return true;
+   }
+
+
+
+   /**
+    * @brief ...wait for the reactor threads to end then close the listener
+    *
+    */
+   template<typename Handler, typename Policy>
+   void BasicServerAsync<Handler, Policy>::join()
+   {
+      for( auto& thd : m_vecReactorThreads )
+      {
+         if( thd.joinable() )
+         {
+            thd.join();
+         }
+      }
+      m_vecReactorThreads.clear();
+      if( false == m_vecReactors.empty() )
+      {
+         for( auto& reactor : m_vecReactors )
+         {
+            ::close( reactor.fdWake );
+         }
+         m_vecReactors.clear();
+         close();
+      }
+   }
+
+
+
+   /**
+    * @brief ...open connection of a fd
+    *
+    * @param a_fd ...
+    * @return connection_t* nullptr if the fd is not an open connection
+    */
+   template<typename Handler, typename Policy>
+   typename BasicServerAsync<Handler, Policy>::connection_t* BasicServerAsync<Handler, Policy>::connection_( const socketfd_t a_fd ) const
+   {
+      if( (a_fd < 0) || (static_cast<size_t>( a_fd ) >= m_vecConnections.size()) )
+      {
+         return nullptr;
+      }
+      connection_t* pConnection = m_vecConnections[static_cast<size_t>( a_fd )];
+      if( (nullptr == pConnection) || (-1 == pConnection->fdEpoll) )
+      {
+         return nullptr;
+      }
+      return pConnection;
+   }
+
+
+
+   /**
+    * @brief ...non-blocking send on a connection, call on the reactor thread of the connection (from the handler).
+    * what the socket does not take is queued and written on EPOLLOUT
+    *
+    * @param a_fd ...connection
+    * @param a_pBuffer ...
+    * @param a_nBufferSize ...
+    * @return ssize_t a_nBufferSize when written or queued, -1 on error
+    */
+   template<typename Handler, typename Policy>
+   ssize_t BasicServerAsync<Handler, Policy>::send( const socketfd_t a_fd, const void* a_pBuffer, const size_t a_nBufferSize )
+   {
+      connection_t* pConnection = connection_( a_fd );
+      if( (nullptr == pConnection) || (nullptr == a_pBuffer) || (-1 == pConnection->sendQueue.write( a_fd, a_pBuffer, a_nBufferSize )) )
+      {
+         return -1;
+      }
+      armWrite_( a_fd, pConnection );
+      return static_cast<ssize_t>( a_nBufferSize );
+   }
+
+
+
+   /**
+    * @brief ...non-blocking scatter-gather send on a connection, same rules as send
+    *
+    * @param a_fd ...connection
+    * @param a_pIov ...buffers
+    * @param a_nCount ...number of entries
+    * @return ssize_t total bytes written or queued, -1 on error
+    */
+   template<typename Handler, typename Policy>
+   ssize_t BasicServerAsync<Handler, Policy>::sendv( const socketfd_t a_fd, const struct iovec* a_pIov, const int32_t a_nCount )
+   {
+      connection_t* pConnection = connection_( a_fd );
+      if( (nullptr == pConnection) || (nullptr == a_pIov) || (a_nCount <= 0) || (-1 == pConnection->sendQueue.writev( a_fd, a_pIov, a_nCount )) )
+      {
+         return -1;
+      }
+      ssize_t nTotal = 0;
+      for( int32_t nIndex=0; nIndex<a_nCount; ++nIndex )
+      {
+         nTotal += static_cast<ssize_t>( a_pIov[nIndex].iov_len );
+      }
+      armWrite_( a_fd, pConnection );
+      return nTotal;
+   }
+
+
+
+   /**
+    * @brief ...register EPOLLOUT when bytes were queued
+    *
+    * @param a_fd ...connection
+    * @param a_pConnection ...its state
+    */
+   template<typename Handler, typename Policy>
+   void BasicServerAsync<Handler, Policy>::armWrite_( const socketfd_t a_fd, connection_t* a_pConnection )
+   {
+      if( (false == a_pConnection->sendQueue.empty()) && (false == a_pConnection->bWritePending) )
+      {
+         epoll_event epEvent;
+         epEvent.data.fd = a_fd;
+         epEvent.events  = s_nReadEvents | EPOLLOUT;
+         epoll_ctl( a_pConnection->fdEpoll, EPOLL_CTL_MOD, a_fd, &epEvent );
+         a_pConnection->bWritePending = true;
+      }
+   }
+
+
+
+   /**
+    * @brief ...socket is writable, write the queued bytes.  EPOLLOUT is removed when the queue is empty
+    *
+    * @param a_fd ...connection
+    * @param a_pConnection ...its state
+    * @return bool false on socket error
+    */
+   template<typename Handler, typename Policy>
+   bool BasicServerAsync<Handler, Policy>::flush_( const socketfd_t a_fd, connection_t* a_pConnection )
+   {
+      if( -1 == a_pConnection->sendQueue.flush( a_fd ) )
+      {
+         return false;
+      }
+      if( (true == a_pConnection->sendQueue.empty()) && (true == a_pConnection->bWritePending) )
+      {
+         epoll_event epEvent;
+         epEvent.data.fd = a_fd;
+         epEvent.events  = s_nReadEvents;
+         epoll_ctl( a_pConnection->fdEpoll, EPOLL_CTL_MOD, a_fd, &epEvent );
+         a_pConnection->bWritePending = false;
+      }
+      return true;
+   }
+
+
+
+   /**
+    * @brief ...read into the receive buffer and hand each complete message to the handler.  edge trigger reads until
+    * EAGAIN, level trigger once
+    *
+    * @param a_fd ...connection
+    * @param a_pConnection ...its state
+    * @return bool false when the connection should be closed, EOF, socket error or a message larger than the buffer
+    */
+   template<typename Handler, typename Policy>
+   bool BasicServerAsync<Handler, Policy>::read_( const socketfd_t a_fd, connection_t* a_pConnection )
+   {
+      const uint8_t* pMessage;
+      size_t         nLength;
+      frameStatus_t  status;
+      do
+      {
+         ssize_t nBytesRead = a_pConnection->recvBuffer.fill( a_fd );
+         if( 0 == nBytesRead )
+         {
+            return false;
+         }
+         if( -1 == nBytesRead )
+         {
+            if( EAGAIN == errno )
+            {
+               return true;
+            }
+            m_handler.onError( errno, strerror( errno ) );
+            return false;
+         }
+         while( frameStatus_t::FRAME == (status = a_pConnection->recvBuffer.nextFrame( m_framing, pMessage, nLength )) )
+         {
+            m_handler.onMessage( a_fd, pMessage, nLength );
+         }
+         if( frameStatus_t::OVERSIZE == status )
+         {
+            m_handler.onError( EMSGSIZE, "message larger than receive buffer, closing connection" );
+            return false;
+         }
+      } while( Policy::s_bEdgeTriggered );
+      return true;
+   }
+
+
+
+   /**
+    * @brief ...accept the waiting connections of the reactors listener and add them to its epoll set
+    *
+    * @param a_reactor ...
+    */
+   template<typename Handler, typename Policy>
+   void BasicServerAsync<Handler, Policy>::accept_( const reactor_t& a_reactor )
+   {
+      for( ;; )
+      {
+         socketfd_t fdRemote = ::accept4( a_reactor.fdListener, nullptr, nullptr, SOCK_NONBLOCK );
+         if( -1 == fdRemote )
+         {
+            if( (EAGAIN != errno) && (EINTR != errno) )
+            {
+               m_handler.onError( errno, strerror( errno ) );
+            }
+            return;
+         }
+         if( static_cast<size_t>( fdRemote ) >= m_vecConnections.size() )
+         {
+            m_handler.onError( EMFILE, "descriptor beyond connection table" );
+            ::close( fdRemote );
+            continue;
+         }
+         connection_t*& pConnection = m_vecConnections[static_cast<size_t>( fdRemote )];
+         if( nullptr == pConnection )
+         {
+            pConnection = new connection_t();
+         }
+         if( false == pConnection->recvBuffer.allocate( m_nReceiveBufferSize ) )
+         {
+            m_handler.onError( ENOMEM, "receive buffer allocation failed" );
+            ::close( fdRemote );
+            continue;
+         }
+         pConnection->fdEpoll       = a_reactor.fdEpoll;
+         pConnection->bWritePending = false;
+
+         epoll_event epEvent;
+         epEvent.data.fd = fdRemote;
+         epEvent.events  = s_nReadEvents;
+         if( -1 == epoll_ctl( a_reactor.fdEpoll, EPOLL_CTL_ADD, fdRemote, &epEvent ) )
+         {
+            m_handler.onError( errno, strerror( errno ) );
+            pConnection->fdEpoll = -1;
+            ::close( fdRemote );
+            continue;
+         }
+         m_handler.onOpen( fdRemote );
+      }
+   }
+
+
+
+   /**
+    * @brief ...tell the handler, return the buffers to the pool and close the fd
+    *
+    * @param a_fd ...connection
+    * @param a_pConnection ...its state
+    */
+   template<typename Handler, typename Policy>
+   void BasicServerAsync<Handler, Policy>::closeConnection_( const socketfd_t a_fd, connection_t* a_pConnection )
+   {
+      m_handler.onClose( a_fd );
+      a_pConnection->recvBuffer.release();
+      a_pConnection->sendQueue.release();
+      a_pConnection->fdEpoll = -1;
+      ::close( a_fd );
+   }
+
+
+
+   /**
+    * @brief ...epoll loop of one reactor.  the connections of the reactor are closed when it ends
+    *
+    * @param a_reactor ...listener and epoll of this reactor
+    * @return bool
+    */
+   template<typename Handler, typename Policy>
+   bool BasicServerAsync<Handler, Policy>::reactorLoop_( reactor_t& a_reactor )
+   {
+      events_t events{};
+      if constexpr( false == Policy::s_bStackEvents )
+      {
+         events.resize( static_cast<size_t>( Policy::s_nMaxEvents ) );
+      }
+
+      a_reactor.fdEpoll = epoll_create1( 0 );
+      if( -1 == a_reactor.fdEpoll )
+      {
+         m_handler.onError( errno, strerror( errno ) );
+         return false;
+      }
+      for( const int32_t fdReactor : { a_reactor.fdListener, a_reactor.fdWake } )
+      {
+         epoll_event epEventReactor;
+         epEventReactor.data.fd = fdReactor;
+         epEventReactor.events  = EPOLLIN;
+         if( -1 == epoll_ctl( a_reactor.fdEpoll, EPOLL_CTL_ADD, fdReactor, &epEventReactor ) )
+         {
+            m_handler.onError( errno, strerror( errno ) );
+            ::close( a_reactor.fdEpoll );
+            a_reactor.fdEpoll = -1;
+            return false;
+         }
+      }
+
+      while( m_bAsyncRunFlag )
+      {
+         const int32_t fdCount = epoll_wait( a_reactor.fdEpoll, events.data(), Policy::s_nMaxEvents, m_nEpollTimeout_ms );
+         if( -1 == fdCount )
+         {
+            if( EINTR == errno )
+            {
+               continue;
+            }
+            m_handler.onError( errno, "epoll error" );
+            m_bAsyncRunFlag = false;
+            break;
+         }
+
+         for( int32_t nIndex=0; nIndex<fdCount; ++nIndex )
+         {
+            const socketfd_t fd       = events[static_cast<size_t>( nIndex )].data.fd;
+            const uint32_t   nEvents  = events[static_cast<size_t>( nIndex )].events;
+            if( a_reactor.fdListener == fd )
+            {
+               accept_( a_reactor );
+               continue;
+            }
+            if( a_reactor.fdWake == fd )
+            {
+               uint64_t nCount;
+               while( (-1 == ::read( a_reactor.fdWake, &nCount, sizeof( nCount ) )) && (EINTR == errno) )
+               {
+               }
+               continue;      // stop or wakeup, the loop condition is checked again
+            }
+
+            connection_t* pConnection = m_vecConnections[static_cast<size_t>( fd )];
+            if( -1 == pConnection->fdEpoll )
+            {
+               continue;      // closed earlier in this batch
+            }
+            if( (nEvents & EPOLLERR) ||
+                ((nEvents & EPOLLOUT) && (false == flush_( fd, pConnection ))) ||
+                ((nEvents & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) && (false == read_( fd, pConnection ))) )
+            {
+               closeConnection_( fd, pConnection );
+            }
+         }
+      }
+
+      // deterministic shutdown, every connection of this reactor gets onClose
+      for( size_t nFd=0; nFd<m_vecConnections.size(); ++nFd )
+      {
+         connection_t* pConnection = m_vecConnections[nFd];
+         if( (nullptr != pConnection) && (a_reactor.fdEpoll == pConnection->fdEpoll) )
+         {
+            closeConnection_( static_cast<socketfd_t>( nFd ), pConnection );
+         }
+      }
+      if( a_reactor.fdListener != m_fdSocket )
+      {
+         ::close( a_reactor.fdListener );
+      }
+      a_reactor.fdListener = -1;
+      ::close( a_reactor.fdEpoll );
+      a_reactor.fdEpoll = -1;
+      return true;
+   }
+}
+}
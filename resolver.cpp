@@ -0,0 +1,418 @@
+#include "resolver.h"
+#include "connector.h"
+#include <string.h>
+#include <errno.h>
+#include <netdb.h>
+#include <sys/un.h>
+
+
+using namespace std;
+using namespace gdlib;
+
+
+network::Resolver::state_t network::Resolver::s_state;
+
+
+
+/**
+ * @brief ...process exit, the resolver threads end after the lookup they are in, queued lookups are not called back
+ *
+ */
+network::Resolver::state_t::~state_t()
+{
+   {
+      lock_guard<std::mutex> lock( mux );
+      bStop = true;
+   }
+   cvJobs.notify_all();
+   for( std::thread& thd : vecThreads )
+   {
+      thd.join();
+   }
+}
+
+
+
+/**
+ * @brief ...cache key
+ *
+ * @return std::string
+ */
+std::string network::Resolver::key_( const std::string& a_strHost, const std::string& a_strPort, const int32_t a_nFamily, const int32_t a_nType )
+{
+   return a_strHost + '\n' + a_strPort + '\n' + to_string( a_nFamily ) + '\n' + to_string( a_nType );
+}
+
+
+
+/**
+ * @brief ...getaddrinfo, no lock held
+ *
+ * @param a_vecAddresses ...filled with the addresses in the order getaddrinfo gave them
+ * @return int32_t 0 or the errno, EHOSTUNREACH when the name does not resolve
+ */
+int32_t network::Resolver::lookup_( const std::string& a_strHost, const std::string& a_strPort, const int32_t a_nFamily, const int32_t a_nType, std::vector<address_t>& a_vecAddresses )
+{
+   a_vecAddresses.clear();
+   struct addrinfo hints;
+   memset( &hints, 0, sizeof( struct addrinfo ) );
+   hints.ai_socktype = a_nType;
+   hints.ai_family   = a_nFamily;
+   hints.ai_flags    = AI_NUMERICSERV;
+   struct addrinfo* pResult = nullptr;
+   const int nResult = getaddrinfo( a_strHost.c_str(), a_strPort.c_str(), &hints, &pResult );
+   if( 0 != nResult )
+   {
+      return (EAI_SYSTEM == nResult) ? errno : EHOSTUNREACH;
+   }
+   for( const struct addrinfo* pNext = pResult; nullptr != pNext; pNext = pNext->ai_next )
+   {
+      if( pNext->ai_addrlen > sizeof( sockaddr_storage ) )
+      {
+         continue;
+      }
+      address_t address;
+      memcpy( &address.addr, pNext->ai_addr, pNext->ai_addrlen );
+      address.nLength   = pNext->ai_addrlen;
+      address.nFamily   = pNext->ai_family;
+      address.nType     = pNext->ai_socktype;
+      address.nProtocol = pNext->ai_protocol;
+      a_vecAddresses.push_back( address );
+   }
+   freeaddrinfo( pResult );
+   return a_vecAddresses.empty() ? EHOSTUNREACH : 0;
+}
+
+
+
+/**
+ * @brief ...a lookup finished, cache it and call back the resolveAsync waiting for it
+ *
+ * @param a_strKey ...
+ * @param a_nError ...0 or the errno
+ * @param a_vecAddresses ...
+ */
+void network::Resolver::store_( const std::string& a_strKey, const int32_t a_nError, std::vector<address_t>&& a_vecAddresses )
+{
+   std::vector<waiter_t>   vecWaiters;
+   std::vector<address_t>  vecAddresses;
+   {
+      lock_guard<std::mutex> lock( s_state.mux );
+      entry_t& entry = s_state.mapEntries[a_strKey];
+      entry.vecAddresses = std::move( a_vecAddresses );
+      entry.nError       = a_nError;
+      entry.nExpiry_ns   = Connector::now_ns() + static_cast<uint64_t>( (0 == a_nError) ? s_state.nTtl_ms : s_state.nNegativeTtl_ms ) * 1000000;
+      entry.bPending     = false;
+      vecWaiters.swap( entry.vecWaiters );
+      if( false == vecWaiters.empty() )
+      {
+         vecAddresses = entry.vecAddresses;
+      }
+   }
+   s_state.cvDone.notify_all();
+   for( const waiter_t& waiter : vecWaiters )
+   {
+      waiter.cbResolved( a_nError, vecAddresses, waiter.pData );
+   }
+}
+
+
+
+/**
+ * @brief ...resolver thread, run the queued lookups until process exit
+ *
+ */
+void network::Resolver::work_()
+{
+   while( true )
+   {
+      job_t job;
+      {
+         unique_lock<std::mutex> lock( s_state.mux );
+         s_state.cvJobs.wait( lock, []{ return (true == s_state.bStop) || (false == s_state.dqJobs.empty()); } );
+         if( true == s_state.bStop )
+         {
+            return;
+         }
+         job = std::move( s_state.dqJobs.front() );
+         s_state.dqJobs.pop_front();
+      }
+      std::vector<address_t> vecAddresses;
+      const int32_t nError = lookup_( job.strHost, job.strPort, job.nFamily, job.nType, vecAddresses );
+      store_( job.strKey, nError, std::move( vecAddresses ) );
+   }
+}
+
+
+
+/**
+ * @brief ...blocking, the cached addresses or a lookup on the calling thread.  when the host is being resolved already
+ * the call waits for that lookup
+ *
+ * @param a_strHost ...hostname or IP
+ * @param a_strPort ...port as a string, ex "5000"
+ * @param a_nFamily ...AF_INET, AF_INET6 or AF_UNSPEC
+ * @param a_nType ...SOCK_STREAM or SOCK_DGRAM
+ * @param a_vecAddresses ...the addresses, empty on error
+ * @return int32_t 0 or the errno of the lookup, EHOSTUNREACH when the name does not resolve
+ */
+int32_t network::Resolver::resolve( const std::string& a_strHost, const std::string& a_strPort, const int32_t a_nFamily, const int32_t a_nType, std::vector<address_t>& a_vecAddresses )
+{
+   if( true == isUnixPath( a_strHost ) )
+   {
+      a_vecAddresses.resize( 1 );
+      const int32_t nError = unixAddress( a_strHost, a_nType, a_vecAddresses[0] );
+      if( 0 != nError )
+      {
+         a_vecAddresses.clear();
+      }
+      return nError;
+   }
+   const std::string strKey = key_( a_strHost, a_strPort, a_nFamily, a_nType );
+   {
+      unique_lock<std::mutex> lock( s_state.mux );
+      bool bJoined = false;
+      while( true == s_state.mapEntries[strKey].bPending )
+      {
+         bJoined = true;
+         s_state.cvDone.wait( lock );
+      }
+      entry_t& entry = s_state.mapEntries[strKey];   // clear may have dropped it meanwhile
+      if( (true == bJoined) || (Connector::now_ns() < entry.nExpiry_ns) )
+      {
+         ++(bJoined ? s_state.stats.nJoined : s_state.stats.nHits);
+         a_vecAddresses = entry.vecAddresses;
+         return entry.nError;
+      }
+      entry.bPending = true;
+      ++s_state.stats.nMisses;
+   }
+   std::vector<address_t> vecAddresses;
+   const int32_t nError = lookup_( a_strHost, a_strPort, a_nFamily, a_nType, vecAddresses );
+   a_vecAddresses = vecAddresses;
+   store_( strKey, nError, std::move( vecAddresses ) );
+   return nError;
+}
+
+
+
+/**
+ * @brief ...never blocks.  a cached host is called back at once on the calling thread, else a resolver thread calls back
+ * once the lookup is done
+ *
+ * @param a_strHost ...hostname or IP
+ * @param a_strPort ...port as a string
+ * @param a_nFamily ...AF_INET, AF_INET6 or AF_UNSPEC
+ * @param a_nType ...SOCK_STREAM or SOCK_DGRAM
+ * @param a_cbResolved ...callback( errno or 0, addresses, a_pData ), nullptr only fills the cache
+ * @param a_pData ...pointer to pass back to the callback
+ * @return bool false, errno ECANCELED at process exit
+ */
+bool network::Resolver::resolveAsync( const std::string& a_strHost, const std::string& a_strPort, const int32_t a_nFamily, const int32_t a_nType,
+                                      const resolveCallback_t a_cbResolved, void* const a_pData )
+{
+   std::vector<address_t> vecAddresses;
+   int32_t                nError = 0;
+   if( true == isUnixPath( a_strHost ) )
+   {
+      if( nullptr != a_cbResolved )
+      {
+         nError = resolve( a_strHost, a_strPort, a_nFamily, a_nType, vecAddresses );
+         a_cbResolved( nError, vecAddresses, a_pData );
+      }
+      return true;
+   }
+   const std::string strKey = key_( a_strHost, a_strPort, a_nFamily, a_nType );
+   {
+      lock_guard<std::mutex> lock( s_state.mux );
+      if( true == s_state.bStop )
+      {
+         errno = ECANCELED;
+         return false;
+      }
+      entry_t& entry = s_state.mapEntries[strKey];
+      if( true == entry.bPending )
+      {
+         ++s_state.stats.nJoined;
+         if( nullptr != a_cbResolved )
+         {
+            entry.vecWaiters.push_back( waiter_t{ a_cbResolved, a_pData } );
+         }
+         return true;
+      }
+      if( Connector::now_ns() >= entry.nExpiry_ns )
+      {
+         if( true == s_state.vecThreads.empty() )
+         {
+            for( uint32_t nThread=0; nThread<s_state.nThreads; ++nThread )
+            {
+               s_state.vecThreads.emplace_back( &Resolver::work_ );
+            }
+         }
+         entry.bPending = true;
+         if( nullptr != a_cbResolved )
+         {
+            entry.vecWaiters.push_back( waiter_t{ a_cbResolved, a_pData } );
+         }
+         s_state.dqJobs.push_back( job_t{ strKey, a_strHost, a_strPort, a_nFamily, a_nType } );
+         ++s_state.stats.nMisses;
+         s_state.cvJobs.notify_one();
+         return true;
+      }
+      ++s_state.stats.nHits;
+      if( nullptr == a_cbResolved )
+      {
+         return true;
+      }
+      vecAddresses = entry.vecAddresses;
+      nError       = entry.nError;
+   }
+   a_cbResolved( nError, vecAddresses, a_pData );
+   return true;
+}
+
+
+
+/**
+ * @brief ...resolve in the background so the first connect finds the host cached
+ *
+ * @return bool see resolveAsync
+ */
+bool network::Resolver::prewarm( const std::string& a_strHost, const std::string& a_strPort, const int32_t a_nFamily, const int32_t a_nType )
+{
+   return resolveAsync( a_strHost, a_strPort, a_nFamily, a_nType, nullptr, nullptr );
+}
+
+
+
+/**
+ * @brief ...the addresses of a host if cached and not expired, never resolves
+ *
+ * @param a_vecAddresses ...
+ * @return bool false not cached, expired, being resolved or the cached lookup failed
+ */
+bool network::Resolver::cached( const std::string& a_strHost, const std::string& a_strPort, const int32_t a_nFamily, const int32_t a_nType, std::vector<address_t>& a_vecAddresses )
+{
+   if( true == isUnixPath( a_strHost ) )
+   {
+      return 0 == resolve( a_strHost, a_strPort, a_nFamily, a_nType, a_vecAddresses );
+   }
+   const std::string strKey = key_( a_strHost, a_strPort, a_nFamily, a_nType );
+   lock_guard<std::mutex> lock( s_state.mux );
+   const auto it = s_state.mapEntries.find( strKey );
+   if( (s_state.mapEntries.end() == it) || (true == it->second.bPending) || (0 != it->second.nError) || (Connector::now_ns() >= it->second.nExpiry_ns) )
+   {
+      return false;
+   }
+   ++s_state.stats.nHits;
+   a_vecAddresses = it->second.vecAddresses;
+   return true;
+}
+
+
+
+/**
+ * @brief ...how long lookups are cached, from the next lookup on
+ *
+ * @param a_nTtl_ms ...addresses, default 60 s.  0 no caching, only the lookups in flight are shared
+ * @param a_nNegativeTtl_ms ...failures, default 1 s
+ */
+void network::Resolver::setTtl( const uint32_t a_nTtl_ms, const uint32_t a_nNegativeTtl_ms )
+{
+   lock_guard<std::mutex> lock( s_state.mux );
+   s_state.nTtl_ms         = a_nTtl_ms;
+   s_state.nNegativeTtl_ms = a_nNegativeTtl_ms;
+}
+
+
+
+/**
+ * @brief ...size of the resolver pool, before the first resolveAsync or prewarm
+ *
+ * @param a_nCount ...at least 1
+ */
+void network::Resolver::setThreads( const uint32_t a_nCount )
+{
+   lock_guard<std::mutex> lock( s_state.mux );
+   s_state.nThreads = (a_nCount > 0) ? a_nCount : 1;
+}
+
+
+
+/**
+ * @brief ...forget the cached hosts, the lookups in flight are kept
+ *
+ */
+void network::Resolver::clear()
+{
+   lock_guard<std::mutex> lock( s_state.mux );
+   for( auto it = s_state.mapEntries.begin(); it != s_state.mapEntries.end(); )
+   {
+      it = (true == it->second.bPending) ? std::next( it ) : s_state.mapEntries.erase( it );
+   }
+}
+
+
+
+/**
+ * @brief ...
+ *
+ * @return network::resolverStats_t
+ */
+network::resolverStats_t network::Resolver::stats()
+{
+   lock_guard<std::mutex> lock( s_state.mux );
+   resolverStats_t stats = s_state.stats;
+   stats.nEntries = s_state.mapEntries.size();
+   return stats;
+}
+
+
+
+/**
+ * @brief ...the host is the path of an AF_UNIX socket: "/path", "./path", "../path" or "@name" in the abstract namespace
+ *
+ * @param a_strHost ...
+ * @return bool
+ */
+bool network::Resolver::isUnixPath( const std::string& a_strHost )
+{
+   return (false == a_strHost.empty()) &&
+          (('/' == a_strHost[0]) || ('@' == a_strHost[0]) || (0 == a_strHost.compare( 0, 2, "./" )) || (0 == a_strHost.compare( 0, 3, "../" )));
+}
+
+
+
+/**
+ * @brief ...the AF_UNIX address of a path-style host, "@name" is name in the abstract namespace (sun_path starts with a
+ * nul, the length counts only the bytes of the name, no file is created)
+ *
+ * @param a_strHost ...see isUnixPath
+ * @param a_nType ...SOCK_STREAM or SOCK_SEQPACKET
+ * @param a_address ...
+ * @return int32_t 0, ENAMETOOLONG when the path does not fit sun_path
+ */
+int32_t network::Resolver::unixAddress( const std::string& a_strHost, const int32_t a_nType, address_t& a_address )
+{
+   a_address = address_t();
+   struct sockaddr_un* pAddress  = reinterpret_cast<struct sockaddr_un*>( &a_address.addr );
+   const bool          bAbstract = ('@' == a_strHost[0]);
+   if( a_strHost.size() >= sizeof( pAddress->sun_path ) )
+   {
+      return ENAMETOOLONG;
+   }
+   pAddress->sun_family = AF_UNIX;
+   memcpy( pAddress->sun_path, a_strHost.c_str(), a_strHost.size() + 1 );
+   if( true == bAbstract )
+   {
+      pAddress->sun_path[0] = '\0';
+      a_address.nLength = static_cast<socklen_t>( offsetof( struct sockaddr_un, sun_path ) + a_strHost.size() );
+   } else
+   {
+      a_address.nLength = static_cast<socklen_t>( offsetof( struct sockaddr_un, sun_path ) + a_strHost.size() + 1 );
+   }
+   a_address.nFamily   = AF_UNIX;
+   a_address.nType     = a_nType;
+   a_address.nProtocol = 0;
+   return 0;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <sys/socket.h>
+
+namespace gdlib {
+namespace network
+{
+   /**
+    * @brief one address of a resolved host, what getaddrinfo returned for it
+    */
+   struct address_t
+   {
+      struct sockaddr_storage addr           = sockaddr_storage();
+      socklen_t               nLength        = 0;
+      int32_t                 nFamily        = AF_UNSPEC;
+      int32_t                 nType          = 0;
+      int32_t                 nProtocol      = 0;
+   };
+
+   using resolveCallback_t = void( * )( const int32_t a_nError, const std::vector<address_t>& a_vecAddresses, void* const a_pData );  // a_nError 0, or the errno and no address
+
+   /**
+    * @brief usage of the resolver cache, see Resolver::stats
+    */
+   struct resolverStats_t
+   {
+      uint64_t    nHits          = 0;     // lookups answered from the cache
+      uint64_t    nMisses        = 0;     // lookups that called getaddrinfo
+      uint64_t    nJoined        = 0;     // lookups that waited for the same lookup in flight
+      uint64_t    nEntries       = 0;     // hosts cached, expired ones included until looked up again
+   };
+
+
+
+   /**
+    * @brief process wide hostname cache in front of getaddrinfo, shared by Sockets::open, ClientAsync::reconnect and the
+    * connects of MultiClientAsync (through Connector).  the addresses of host/port/family/type are kept for setTtl ms (a
+    * failure for setNegativeTtl ms), so a mass reconnect after a network blip resolves each host once instead of once per
+    * connection.  a lookup for a host already being resolved waits for that lookup instead of issuing its own
+    *
+    * resolve                blocking, from the cache or getaddrinfo on the calling thread
+    * resolveAsync           never blocks.  a cached host is called back at once on the calling thread, else the lookup
+    *    runs on a small pool of resolver threads (setThreads, default 2, started on first use) which call back
+    * prewarm                resolveAsync without a callback, fills the cache at startup so the first connect does not pay
+    *    for DNS
+    * cached                 the addresses if cached and not expired, never resolves
+    *
+    * a path-style host, "/path", "./path" or "@name" (abstract namespace), is the AF_UNIX address of a same host peer, see
+    * isUnixPath.  it is never looked up nor cached, every method answers at once on the calling thread, the port and family
+    * are not used
+    *
+    * all methods from any thread.  setThreads before the first resolveAsync
+    */
+   class Resolver
+   {
+      private:
+         struct waiter_t
+         {
+            resolveCallback_t cbResolved  = nullptr;
+            void*             pData       = nullptr;
+         };
+
+         struct entry_t
+         {
+            std::vector<address_t>  vecAddresses   = std::vector<address_t>();
+            int32_t                 nError         = 0;          // failed lookup, cached for the negative ttl
+            uint64_t                nExpiry_ns     = 0;          // 0 never resolved
+            bool                    bPending       = false;      // a lookup is running
+            std::vector<waiter_t>   vecWaiters     = std::vector<waiter_t>();   // resolveAsync callbacks waiting for it
+         };
+
+         struct job_t
+         {
+            std::string       strKey      = std::string();
+            std::string       strHost     = std::string();
+            std::string       strPort     = std::string();
+            int32_t           nFamily     = AF_UNSPEC;
+            int32_t           nType       = 0;
+         };
+
+         struct state_t
+         {
+            std::mutex                                mux            = {};
+            std::condition_variable                   cvDone         = {};      // a lookup finished, blocking resolves wait on it
+            std::condition_variable                   cvJobs         = {};
+            std::unordered_map<std::string, entry_t>  mapEntries     = {};
+            std::deque<job_t>                         dqJobs         = {};
+            std::vector<std::thread>                  vecThreads     = {};
+            uint32_t                                  nThreads       = 2;
+            uint32_t                                  nTtl_ms        = 60000;
+            uint32_t                                  nNegativeTtl_ms = 1000;
+            bool                                      bStop          = false;
+            resolverStats_t                           stats          = resolverStats_t();
+
+            state_t() = default;
+            state_t( const state_t& ) = delete;
+            ~state_t();
+
+            state_t& operator =( const state_t& ) = delete;
+         };
+
+         static state_t s_state;
+
+         static std::string   key_( const std::string& a_strHost, const std::string& a_strPort, const int32_t a_nFamily, const int32_t a_nType );
+         static int32_t       lookup_( const std::string& a_strHost, const std::string& a_strPort, const int32_t a_nFamily, const int32_t a_nType, std::vector<address_t>& a_vecAddresses );
+         static void          store_( const std::string& a_strKey, const int32_t a_nError, std::vector<address_t>&& a_vecAddresses );
+         static void          work_();
+
+      public:
+         Resolver() = delete;
+
+         static int32_t       resolve( const std::string& a_strHost, const std::string& a_strPort, const int32_t a_nFamily, const int32_t a_nType, std::vector<address_t>& a_vecAddresses );
+         static bool          resolveAsync( const std::string& a_strHost, const std::string& a_strPort, const int32_t a_nFamily, const int32_t a_nType,
+                                            const resolveCallback_t a_cbResolved, void* const a_pData );
+         static bool          prewarm( const std::string& a_strHost, const std::string& a_strPort, const int32_t a_nFamily = AF_INET, const int32_t a_nType = SOCK_STREAM );
+         static bool          cached( const std::string& a_strHost, const std::string& a_strPort, const int32_t a_nFamily, const int32_t a_nType, std::vector<address_t>& a_vecAddresses );
+         static void          setTtl( const uint32_t a_nTtl_ms, const uint32_t a_nNegativeTtl_ms = 1000 );
+         static void          setThreads( const uint32_t a_nCount );
+         static void          clear();
+         static resolverStats_t stats();
+
+         static bool          isUnixPath( const std::string& a_strHost );
+         static int32_t       unixAddress( const std::string& a_strHost, const int32_t a_nType, address_t& a_address );
+   };
+}
+}
@@ -0,0 +1,269 @@
+#include "sendqueue.h"
+#include "bufferpool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/socket.h>
+#include <utility>
+
+
+using namespace std;
+using namespace gdlib;
+
+
+
+/**
+ * @brief ...
+ *
+ */
+network::SendQueue::~SendQueue()
+{
+   release();
+}
+
+
+
+/**
+ * @brief ...return the buffer to the pool
+ *
+ */
+void network::SendQueue::release()
+{
+   if( nullptr != m_pBuffer )
+   {
+      BufferPool::release( m_pBuffer );
+      m_pBuffer = nullptr;
+   }
+   m_nCapacity = 0;
+   reset();
+}
+
+
+
+/**
+ * @brief ...exchange contents, used to hand the queued bytes to an in-flight send while new bytes go to an empty queue
+ *
+ * @param a_other ...
+ */
+void network::SendQueue::swap( SendQueue& a_other )
+{
+   std::swap( m_pBuffer,   a_other.m_pBuffer );
+   std::swap( m_nCapacity, a_other.m_nCapacity );
+   std::swap( m_nHead,     a_other.m_nHead );
+   std::swap( m_nTail,     a_other.m_nTail );
+}
+
+
+
+/**
+ * @brief ...queue bytes at the tail.  unsent bytes are moved to the front first, a larger buffer is taken from the pool
+ * if still short
+ *
+ * @param a_pBuffer ...data
+ * @param a_nSize ...bytes
+ * @return bool false if the buffer could not grow
+ */
+bool network::SendQueue::append( const void* a_pBuffer, const size_t a_nSize )
+{
+   if( m_nTail + a_nSize > m_nCapacity )
+   {
+      const size_t nUsed = m_nTail - m_nHead;
+      if( nUsed + a_nSize > m_nCapacity )
+      {
+         size_t nCapacity = (0 == m_nCapacity) ? 4096 : m_nCapacity;
+         while( nCapacity < nUsed + a_nSize )
+         {
+            nCapacity *= 2;
+         }
+         uint8_t* pBuffer = BufferPool::acquire( nCapacity, nCapacity );   // rounded up to the size class
+         if( nullptr == pBuffer )
+         {
+            return false;
+         }
+         if( nUsed > 0 )
+         {
+            memcpy( pBuffer, m_pBuffer + m_nHead, nUsed );
+         }
+         BufferPool::release( m_pBuffer );
+         m_pBuffer   = pBuffer;
+         m_nCapacity = nCapacity;
+      } else
+      {
+         memmove( m_pBuffer, m_pBuffer + m_nHead, nUsed );
+      }
+      m_nHead = 0;
+      m_nTail = nUsed;
+   }
+   memcpy( m_pBuffer + m_nTail, a_pBuffer, a_nSize );
+   m_nTail += a_nSize;
+   return true;
+}
+
+
+
+/**
+ * @brief ...send on a non-blocking socket, what the socket does not take now is queued.  If bytes are already queued
+ * everything is queued so the order is kept
+ *
+ * @param a_fd ...non-blocking socket
+ * @param a_pBuffer ...data
+ * @param a_nSize ...bytes
+ * @return ssize_t bytes queued, 0 when all was written.  -1 on a socket error or when the queue could not grow
+ */
+ssize_t network::SendQueue::write( const int32_t a_fd, const void* a_pBuffer, const size_t a_nSize )
+{
+   const uint8_t* pBuffer       = reinterpret_cast<const uint8_t*>( a_pBuffer );
+   size_t         nBytesWritten = 0;
+   if( true == empty() )
+   {
+      while( nBytesWritten < a_nSize )
+      {
+         ssize_t nBytesWrittenPerCall = ::send( a_fd, pBuffer + nBytesWritten, a_nSize - nBytesWritten, MSG_NOSIGNAL );
+         if( -1 == nBytesWrittenPerCall )
+         {
+            if( EINTR == errno )
+            {
+               continue;
+            }
+            if( EAGAIN == errno )
+            {
+               break;
+            }
+            return -1;
+         }
+         nBytesWritten += static_cast<size_t>( nBytesWrittenPerCall );
+      }
+   }
+   if( nBytesWritten < a_nSize )
+   {
+      if( false == append( pBuffer + nBytesWritten, a_nSize - nBytesWritten ) )
+      {
+         errno = ENOMEM;
+         return -1;
+      }
+   }
+   return static_cast<ssize_t>( a_nSize - nBytesWritten );
+}
+
+
+
+/**
+ * @brief ...vectored send on a non-blocking socket, one sendmsg per IOV_MAX entries.  What the socket does not take now
+ * is copied to the queue.  If bytes are already queued everything is queued so the order is kept
+ *
+ * @param a_fd ...non-blocking socket
+ * @param a_pIov ...buffers, ex header and payload, or many messages
+ * @param a_nCount ...number of entries in a_pIov
+ * @return ssize_t bytes queued, 0 when all was written.  -1 on a socket error or when the queue could not grow
+ */
+ssize_t network::SendQueue::writev( const int32_t a_fd, const struct iovec* a_pIov, const int32_t a_nCount )
+{
+   struct iovec   aIov[IOV_MAX];
+   bool           bBlocked    = (false == empty());
+   size_t         nQueued     = 0;
+   int32_t        nNext       = 0;     // next entry of a_pIov not yet handled
+   while( nNext < a_nCount )
+   {
+      int32_t nLeft = (a_nCount - nNext < IOV_MAX) ? (a_nCount - nNext) : IOV_MAX;
+      memcpy( aIov, a_pIov + nNext, static_cast<size_t>( nLeft ) * sizeof( struct iovec ) );
+      nNext += nLeft;
+
+      struct iovec* pIov = aIov;
+      while( (false == bBlocked) && (nLeft > 0) )
+      {
+         struct msghdr msg;
+         memset( &msg, 0, sizeof( msg ) );
+         msg.msg_iov    = pIov;
+         msg.msg_iovlen = static_cast<size_t>( nLeft );
+         ssize_t nBytesWritten = ::sendmsg( a_fd, &msg, MSG_NOSIGNAL );
+         if( -1 == nBytesWritten )
+         {
+            if( EINTR == errno )
+            {
+               continue;
+            }
+            if( EAGAIN == errno )
+            {
+               bBlocked = true;
+               break;
+            }
+            return -1;
+         }
+         advance( pIov, nLeft, static_cast<size_t>( nBytesWritten ) );
+      }
+
+      for( int32_t nIndex=0; nIndex<nLeft; ++nIndex )
+      {
+         if( false == append( pIov[nIndex].iov_base, pIov[nIndex].iov_len ) )
+         {
+            errno = ENOMEM;
+            return -1;
+         }
+         nQueued += pIov[nIndex].iov_len;
+      }
+   }
+   return static_cast<ssize_t>( nQueued );
+}
+
+
+
+/**
+ * @brief ...step over bytes written by writev/sendmsg, whole entries are dropped and a partly written entry is trimmed
+ *
+ * @param a_pIov ...in/out, first entry not fully written
+ * @param a_nCount ...in/out, entries left
+ * @param a_nBytes ...bytes written
+ */
+void network::SendQueue::advance( struct iovec*& a_pIov, int32_t& a_nCount, size_t a_nBytes )
+{
+   while( (a_nCount > 0) && (a_nBytes >= a_pIov->iov_len) )
+   {
+      a_nBytes -= a_pIov->iov_len;
+      ++a_pIov;
+      --a_nCount;
+   }
+   if( a_nCount > 0 )
+   {
+      a_pIov->iov_base = reinterpret_cast<uint8_t*>( a_pIov->iov_base ) + a_nBytes;
+      a_pIov->iov_len -= a_nBytes;
+   }
+}
+
+
+
+/**
+ * @brief ...write queued bytes to a non-blocking socket until the queue is empty or the socket is full
+ *
+ * @param a_fd ...non-blocking socket
+ * @param a_nMax ...write at most this many bytes, ex the bytes queued ahead of a file transfer
+ * @return ssize_t bytes written, -1 on a socket error other than EAGAIN
+ */
+ssize_t network::SendQueue::flush( const int32_t a_fd, const size_t a_nMax )
+{
+   ssize_t nBytesWritten = 0;
+   const size_t nEnd     = (m_nTail - m_nHead > a_nMax) ? (m_nHead + a_nMax) : m_nTail;
+   while( m_nHead < nEnd )
+   {
+      ssize_t nBytesWrittenPerCall = ::send( a_fd, m_pBuffer + m_nHead, nEnd - m_nHead, MSG_NOSIGNAL );
+      if( -1 == nBytesWrittenPerCall )
+      {
+         if( EINTR == errno )
+         {
+            continue;
+         }
+         if( EAGAIN == errno )
+         {
+            break;
+         }
+         return -1;
+      }
+      m_nHead       += static_cast<size_t>( nBytesWrittenPerCall );
+      nBytesWritten += nBytesWrittenPerCall;
+   }
+   if( m_nHead == m_nTail )
+   {
+      reset();
+   }
+   return nBytesWritten;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+namespace gdlib {
+namespace network
+{
+   /**
+    * @brief per connection outbound queue.  Bytes the socket could not take are appended here and written when
+    * epoll reports the socket writable, so the reactor never spins on EAGAIN.
+    * The buffer comes from the BufferPool, grows as needed and is kept for reuse when it drains
+    *
+    * not thread safe, the owner serializes access
+    */
+   class SendQueue
+   {
+      private:
+         uint8_t*    m_pBuffer      = nullptr;
+         size_t      m_nCapacity    = 0;
+         size_t      m_nHead        = 0;     // first unsent byte
+         size_t      m_nTail        = 0;     // first free byte
+
+      public:
+         SendQueue() = default;
+         SendQueue( const SendQueue& ) = delete;
+         ~SendQueue();
+
+         SendQueue& operator =( const SendQueue& ) = delete;
+
+         bool        append( const void* a_pBuffer, const size_t a_nSize );
+         ssize_t     write( const int32_t a_fd, const void* a_pBuffer, const size_t a_nSize );
+         ssize_t     writev( const int32_t a_fd, const struct iovec* a_pIov, const int32_t a_nCount );
+         ssize_t     flush( const int32_t a_fd, const size_t a_nMax = SIZE_MAX );
+         void        reset()                 { m_nHead = m_nTail = 0; }
+         void        swap( SendQueue& a_other );
+         void        consume( const size_t a_nSize ) { m_nHead += a_nSize; if( m_nHead >= m_nTail ) { reset(); } }
+         const uint8_t* data() const         { return m_pBuffer + m_nHead; }
+         void        release();
+         bool        empty() const           { return m_nHead == m_nTail; }
+         size_t      size() const            { return m_nTail - m_nHead; }
+
+         static void advance( struct iovec*& a_pIov, int32_t& a_nCount, size_t a_nBytes );
+   };
+}
+}
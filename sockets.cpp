@@ -1,10 +1,19 @@
 #include "sockets.h"
+#include "asynclog.h"
 #include <sstream>
 #include <string.h>
 #include <fcntl.h>
 #include <netinet/tcp.h>
 #include <errno.h>
 #include <unistd.h>
+#include <sys/resource.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+#include <linux/io_uring.h>
 
 
 using namespace std;
@@ -153,13 +162,14 @@ bool network::Sockets::setLocalSocketProperties( const int32_t a_nFlags, const i
 /**
  * @brief open a server or a client
  *    server: open local port , bind and listen
- *    client open  local port and connect to foreign port
+ *    client open  local port and connect to foreign port, non-blocking connects within the deadlines of
+ *       setConnectTimeout (see Connector), the connected socket is blocking
  * 
  * @param a_nType ...CLIENT or SERVER
- * @param a_strHostname ...hostname or IP
- * @param a_strPort ...port as a string, ex "5000"
- * @param a_nProtocol ...TCP, only option
- * @return bool
+ * @param a_strHostname ...hostname or IP, or the path of an AF_UNIX socket, see Resolver::isUnixPath
+ * @param a_strPort ...port as a string, ex "5000", not used for a path
+ * @param a_nProtocol ...TCP or UDP, UDP uses a datagram socket.  SEQPACKET a path only
+ * @return bool false, errno EPROTONOSUPPORT UDP on a path or SEQPACKET on a host
  */
 bool network::Sockets::open( const sockType_t a_nType, const protocol_t a_nProtocol, const string a_strHostname, const string a_strPort )
 {
@@ -168,6 +178,12 @@ bool network::Sockets::open( const sockType_t a_nType, const protocol_t a_nProto
       // error port string more than 2^16 - 1
       return false;
    }
+   const bool bUnix = Resolver::isUnixPath( a_strHostname );
+   if( (true == bUnix) ? (protocol_t::UDP == a_nProtocol) : (protocol_t::SEQPACKET == a_nProtocol) )
+   {
+      errno = EPROTONOSUPPORT;
+      return false;
+   }
    strcpy( m_szPort, a_strPort.c_str() );
    m_protocol  = a_nProtocol;
    m_pszHostname = new char[a_strHostname.length() + 1];
@@ -178,6 +194,30 @@ bool network::Sockets::open( const sockType_t a_nType, const protocol_t a_nProto
    }
    strcpy( m_pszHostname, a_strHostname.c_str() );
    m_type = a_nType;
+   if( protocol_t::UDP == a_nProtocol )
+   {
+      m_nSocketType = SOCK_DGRAM;
+   } else if( protocol_t::SEQPACKET == a_nProtocol )
+   {
+      m_nSocketType = SOCK_SEQPACKET;
+   }
+
+   if( sockType_t::CLIENT == a_nType )
+   {
+      const socketfd_t fdConnected = Connector::connect( m_pszHostname, m_szPort, m_nSocketFamily, m_nSocketType, m_nConnectAttempt_ms, m_nConnectTimeout_ms );
+      if( -1 == fdConnected )
+      {
+         AsyncLog::write( LogLevel::EERR, "connect to %s:%s failed: %m", m_pszHostname, m_szPort );
+         return false;
+      }
+      fcntl( fdConnected, F_SETFL, fcntl( fdConnected, F_GETFL, 0 ) & ~O_NONBLOCK );
+      m_fdSocket = fdConnected;
+      return true;
+   }
+   if( (sockType_t::SERVER == a_nType) && (true == bUnix) )
+   {
+      return listenUnix_();
+   }
    
    
    struct addrinfo   hints;
@@ -189,13 +229,9 @@ bool network::Sockets::open( const sockType_t a_nType, const protocol_t a_nProto
    hints.ai_socktype    = m_nSocketType;
    hints.ai_family      = m_nSocketFamily;
 
-   // set for client or server -> listener or active connector
+   // the listener, the client connected above
    switch( a_nType )
    {
-      case sockType_t::CLIENT:
-         hints.ai_flags = AI_NUMERICSERV;
-         break;
-         
       case sockType_t::SERVER:
          hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
          break;
@@ -225,40 +261,33 @@ bool network::Sockets::open( const sockType_t a_nType, const protocol_t a_nProto
 
       switch( a_nType )
       {
-         case sockType_t::CLIENT:
-            if( ::connect( fdLocalSock, pLocalAddess->ai_addr, pLocalAddess->ai_addrlen ) == 0 )
-            {
-               // we have conection to server
-               m_fdSocket = fdLocalSock;
-               freeaddrinfo( pActualAddress );
-               pActualAddress = nullptr;
-               return true;
-            } else
-            {
-               std::cerr << "connect falilure:" <<  strerror( errno ) << std::endl;
-            }
-            break;
-
          case sockType_t::SERVER:
             setsockopt( fdLocalSock, SOL_SOCKET, SO_REUSEADDR, &nOptValue, sizeof(int) );
+            if( true == m_bReusePort )
+            {
+               setsockopt( fdLocalSock, SOL_SOCKET, SO_REUSEPORT, &nOptValue, sizeof(int) );
+            }
             if( ::bind( fdLocalSock, pLocalAddess->ai_addr, pLocalAddess->ai_addrlen ) == 0 )
             {
                // we have an active listener
                m_fdSocket = fdLocalSock;
                freeaddrinfo( pActualAddress );
                pActualAddress = nullptr;
-               listen( m_fdSocket, m_nBacklog );
+               if( SOCK_STREAM == m_nSocketType )
+               {
+                  listen( m_fdSocket, m_nBacklog );
+               }
                return true;
             } else
             {
-               std::cerr << "bind falilure:" <<  strerror( errno ) << std::endl;
+               AsyncLog::write( LogLevel::EERR, "bind to %s:%s failed: %m", m_pszHostname, m_szPort );
             }
             break;
      
          default:  
             break;
       }
-      // bind or connect failed, try next address
+      // bind failed, try next address
       ::close( fdLocalSock );
    }
    
@@ -268,6 +297,90 @@ bool network::Sockets::open( const sockType_t a_nType, const protocol_t a_nProto
 
 
 
+/**
+ * @brief ...server, bind and listen on the AF_UNIX path of the hostname.  a socket file nobody listens on any more (the
+ * connect is refused) is removed first, the file of a live server is left alone and bind fails with EADDRINUSE
+ *
+ * @return bool false, errno set
+ */
+bool network::Sockets::listenUnix_()
+{
+   address_t     address;
+   const int32_t nError = Resolver::unixAddress( m_pszHostname, m_nSocketType, address );
+   if( 0 != nError )
+   {
+      errno = nError;
+      return false;
+   }
+   const struct sockaddr* pAddress = reinterpret_cast<const struct sockaddr*>( &address.addr );
+   struct stat            fileStat;
+   if( ('@' != m_pszHostname[0]) && (0 == ::stat( m_pszHostname, &fileStat )) && (S_ISSOCK( fileStat.st_mode )) )
+   {
+      const socketfd_t fdProbe = ::socket( AF_UNIX, m_nSocketType | SOCK_NONBLOCK, 0 );   // a live server with a full backlog answers EAGAIN
+      if( (-1 != fdProbe) && (-1 == ::connect( fdProbe, pAddress, address.nLength )) && (ECONNREFUSED == errno) )
+      {
+         ::unlink( m_pszHostname );
+      }
+      if( -1 != fdProbe )
+      {
+         ::close( fdProbe );
+      }
+   }
+   const socketfd_t fdListener = ::socket( AF_UNIX, m_nSocketType, 0 );
+   if( -1 == fdListener )
+   {
+      return false;
+   }
+   if( (0 != ::bind( fdListener, pAddress, address.nLength )) || (0 != ::listen( fdListener, m_nBacklog )) )
+   {
+      const int nBindError = errno;
+      AsyncLog::write( LogLevel::EERR, "bind to %s failed: %m", m_pszHostname );
+      ::close( fdListener );
+      errno = nBindError;
+      return false;
+   }
+   m_fdSocket = fdListener;
+   m_bUnlink  = ('@' != m_pszHostname[0]);
+   return true;
+}
+
+
+
+/**
+ * @brief ...another socket bound to the address of the listener with SO_REUSEPORT (listening for a stream socket), so
+ * each reactor can have its own listener and the kernel spreads the connections or datagrams across them
+ * 
+ * @return socketfd_t -1 on error, errno set
+ */
+network::socketfd_t network::Sockets::reusePortListener_() const
+{
+   struct sockaddr_storage localAddress;
+   socklen_t               localAddressLength = sizeof( localAddress );
+   if( -1 == getsockname( m_fdSocket, reinterpret_cast<struct sockaddr*>( &localAddress ), &localAddressLength ) )
+   {
+      return -1;
+   }
+   socketfd_t fdListener = ::socket( localAddress.ss_family, m_nSocketType, 0 );
+   if( -1 == fdListener )
+   {
+      return -1;
+   }
+   int nOptValue = 1;
+   setsockopt( fdListener, SOL_SOCKET, SO_REUSEADDR, &nOptValue, sizeof(int) );
+   setsockopt( fdListener, SOL_SOCKET, SO_REUSEPORT, &nOptValue, sizeof(int) );
+   if( (0 == ::bind( fdListener, reinterpret_cast<struct sockaddr*>( &localAddress ), localAddressLength )) &&
+       ((SOCK_DGRAM == m_nSocketType) || (0 == ::listen( fdListener, m_nBacklog ))) )
+   {
+      return fdListener;
+   }
+   const int nError = errno;
+   ::close( fdListener );
+   errno = nError;
+   return -1;
+}
+
+
+
 /**
  * @brief ...non-blocking fd: read from fd, will return bytes count read and block if no bytes avail 
  *  nonblocking
@@ -398,6 +511,330 @@ ssize_t network::Sockets::send( const socketfd_t& a_fd, const void* a_pBuffer, c
 }
 
 
+/**
+ * @brief ...scatter-gather write, ex a header and a payload that lives elsewhere, without a staging copy or a second
+ * write call.  Partial writes continue from the first unsent byte.  More than IOV_MAX entries are sent in IOV_MAX batches,
+ * so many queued messages can be sent with one writev per batch.  can be used with blocking or non blocking
+ * 
+ * @param a_fd ...
+ * @param a_pIov ...buffers, not modified
+ * @param a_nCount ...number of entries
+ * @return ssize_t
+ * 0 <= n                     write  sucessfull, bytes written (sum of all iov_len)
+ * -1                         write failed
+ */
+ssize_t network::Sockets::sendv( const socketfd_t& a_fd, const struct iovec* a_pIov, const int32_t a_nCount )
+{
+   if( (nullptr == a_pIov) || (a_nCount <= 0) )
+   {
+      return -1;
+   }
+
+   struct iovec   aIov[IOV_MAX];
+   ssize_t        nBytesWritten( 0 );
+   int32_t        nNext = 0;       // next entry of a_pIov not yet copied
+   while( nNext < a_nCount )
+   {
+      int32_t nLeft = (a_nCount - nNext < IOV_MAX) ? (a_nCount - nNext) : IOV_MAX;
+      memcpy( aIov, a_pIov + nNext, static_cast<size_t>( nLeft ) * sizeof( struct iovec ) );
+      nNext += nLeft;
+
+      struct iovec* pIov = aIov;
+      while( nLeft > 0 )
+      {
+         ssize_t nBytesWrittenPerCall = ::writev( a_fd, pIov, nLeft );
+         switch( nBytesWrittenPerCall )
+         {
+            case -1:
+               switch( errno )
+               {
+                  case EAGAIN:
+                  case EINTR:
+                     continue;
+
+                  default:
+                     return -1;
+               }
+
+            default:
+               nBytesWritten += nBytesWrittenPerCall;
+               SendQueue::advance( pIov, nLeft, static_cast<size_t>( nBytesWrittenPerCall ) );
+         }
+      }
+   }
+   return nBytesWritten;
+}
+
+
+/**
+ * @brief ...stream part of a file to a socket without copying it through user space, sendfile for a regular file and
+ * splice when the file is a pipe.  Stops early at the end of the file.  can be used with blocking or non blocking
+ * 
+ * @param a_fd ...
+ * @param a_fdFile ...open for reading, its file offset is not changed (pipe excepted)
+ * @param a_nOffset ...first byte of the file, ignored for a pipe
+ * @param a_nLength ...bytes to send
+ * @return ssize_t
+ * 0 <= n <= a_nLength        write  sucessfull, bytes written, less than a_nLength at the end of the file
+ * -1                         write failed
+ */
+ssize_t network::Sockets::sendFile( const socketfd_t& a_fd, const int32_t a_fdFile, const off_t a_nOffset, const size_t a_nLength )
+{
+   struct stat fileStat;
+   if( (a_nOffset < 0) || (-1 == fstat( a_fdFile, &fileStat )) )
+   {
+      return -1;
+   }
+
+   const bool  bPipe = S_ISFIFO( fileStat.st_mode );
+   off_t       nOffset = a_nOffset;
+   size_t      nBytesWritten( 0 );
+   while( nBytesWritten < a_nLength )
+   {
+      ssize_t nBytesWrittenPerCall = (true == bPipe) ? ::splice( a_fdFile, nullptr, a_fd, nullptr, a_nLength - nBytesWritten, SPLICE_F_MOVE | SPLICE_F_MORE )
+                                                     : ::sendfile( a_fd, a_fdFile, &nOffset, a_nLength - nBytesWritten );
+      switch( nBytesWrittenPerCall )
+      {
+         case -1:
+            switch( errno )
+            {
+               case EAGAIN:
+               case EINTR:
+                  continue;
+
+               default:
+                  return -1;
+            }
+
+         case 0:
+            return static_cast<ssize_t>( nBytesWritten );   // end of file
+
+         default:
+            nBytesWritten += static_cast<size_t>( nBytesWrittenPerCall );
+      }
+   }
+   return static_cast<ssize_t>( nBytesWritten );
+}
+
+
+/**
+ * @brief ...UDP, receive up to a_nCount datagrams with one recvmmsg into the buffers of a_pDatagrams, at most
+ * s_nMaxBatch per call.  nLength, peer, nPeerLength and bTruncated of each received datagram are set
+ * 
+ * @param a_fd ...datagram socket
+ * @param a_pDatagrams ...pBuffer/nSize set by the caller
+ * @param a_nCount ...number of entries
+ * @param a_nFlags ...recvmmsg flags, ex MSG_DONTWAIT, MSG_WAITFORONE (block for the first datagram only)
+ * @return int32_t
+ * 0 < n <= a_nCount          datagrams received, the first n entries
+ * -1                         receive failed, EAGAIN when nothing is waiting on a non-blocking socket
+ */
+int32_t network::Sockets::receiveBatch( const socketfd_t& a_fd, datagram_t* a_pDatagrams, const uint32_t a_nCount, const int32_t a_nFlags )
+{
+   if( (nullptr == a_pDatagrams) || (0 == a_nCount) )
+   {
+      return -1;
+   }
+
+   struct mmsghdr aMessages[s_nMaxBatch];
+   struct iovec   aIov[s_nMaxBatch];
+   const uint32_t nCount = (a_nCount < s_nMaxBatch) ? a_nCount : s_nMaxBatch;
+   memset( aMessages, 0, nCount * sizeof( struct mmsghdr ) );
+   for( uint32_t nIndex=0; nIndex<nCount; ++nIndex )
+   {
+      aIov[nIndex].iov_base                  = a_pDatagrams[nIndex].pBuffer;
+      aIov[nIndex].iov_len                   = a_pDatagrams[nIndex].nSize;
+      aMessages[nIndex].msg_hdr.msg_iov      = &aIov[nIndex];
+      aMessages[nIndex].msg_hdr.msg_iovlen   = 1;
+      aMessages[nIndex].msg_hdr.msg_name     = &a_pDatagrams[nIndex].peer;
+      aMessages[nIndex].msg_hdr.msg_namelen  = sizeof( a_pDatagrams[nIndex].peer );
+   }
+
+   int32_t nReceived;
+   do
+   {
+      nReceived = ::recvmmsg( a_fd, aMessages, nCount, a_nFlags, nullptr );
+   } while( (-1 == nReceived) && (EINTR == errno) );
+
+   for( int32_t nIndex=0; nIndex<nReceived; ++nIndex )
+   {
+      a_pDatagrams[nIndex].nLength     = aMessages[nIndex].msg_len;
+      a_pDatagrams[nIndex].nPeerLength = aMessages[nIndex].msg_hdr.msg_namelen;
+      a_pDatagrams[nIndex].bTruncated  = (0 != (aMessages[nIndex].msg_hdr.msg_flags & MSG_TRUNC));
+   }
+   return nReceived;
+}
+
+
+/**
+ * @brief ...UDP, send a_nCount datagrams, one sendmmsg per s_nMaxBatch.  each datagram goes to its peer, or to the
+ * connected peer when nPeerLength is 0.  without MSG_DONTWAIT a full socket is retried as in send
+ * 
+ * @param a_fd ...datagram socket
+ * @param a_pDatagrams ...pBuffer/nSize and the destination, not modified
+ * @param a_nCount ...number of entries
+ * @param a_nFlags ...sendmmsg flags, MSG_DONTWAIT returns at a full socket buffer
+ * @return int32_t
+ * 0 <= n <= a_nCount         datagrams sent, the first n entries
+ * -1                         send failed before any datagram was sent
+ */
+int32_t network::Sockets::sendBatch( const socketfd_t& a_fd, const datagram_t* a_pDatagrams, const uint32_t a_nCount, const int32_t a_nFlags )
+{
+   if( (nullptr == a_pDatagrams) || (0 == a_nCount) )
+   {
+      return -1;
+   }
+
+   struct mmsghdr aMessages[s_nMaxBatch];
+   struct iovec   aIov[s_nMaxBatch];
+   uint32_t       nSent = 0;
+   while( nSent < a_nCount )
+   {
+      const uint32_t nCount = (a_nCount - nSent < s_nMaxBatch) ? (a_nCount - nSent) : s_nMaxBatch;
+      memset( aMessages, 0, nCount * sizeof( struct mmsghdr ) );
+      for( uint32_t nIndex=0; nIndex<nCount; ++nIndex )
+      {
+         const datagram_t& datagram = a_pDatagrams[nSent + nIndex];
+         aIov[nIndex].iov_base                  = datagram.pBuffer;
+         aIov[nIndex].iov_len                   = datagram.nSize;
+         aMessages[nIndex].msg_hdr.msg_iov      = &aIov[nIndex];
+         aMessages[nIndex].msg_hdr.msg_iovlen   = 1;
+         aMessages[nIndex].msg_hdr.msg_name     = (0 == datagram.nPeerLength) ? nullptr : const_cast<struct sockaddr_storage*>( &datagram.peer );
+         aMessages[nIndex].msg_hdr.msg_namelen  = datagram.nPeerLength;
+      }
+
+      int32_t nSentPerCall = ::sendmmsg( a_fd, aMessages, nCount, a_nFlags | MSG_NOSIGNAL );
+      if( -1 == nSentPerCall )
+      {
+         if( (EINTR == errno) || ((EAGAIN == errno) && (0 == (a_nFlags & MSG_DONTWAIT))) )
+         {
+            continue;
+         }
+         return (0 == nSent) ? -1 : static_cast<int32_t>( nSent );
+      }
+      nSent += static_cast<uint32_t>( nSentPerCall );
+   }
+   return static_cast<int32_t>( nSent );
+}
+
+
+
+/**
+ * @brief ...AF_UNIX, send a_fdPass to the peer (SCM_RIGHTS) with the bytes of the buffer, at least one.  the peer gets
+ * its own descriptor of the same open file, the caller can close a_fdPass when this returns.  one sendmsg, the bytes are
+ * not queued: a partial send returns the count sent and the descriptor went with the first byte
+ *
+ * @param a_fd ...connected AF_UNIX socket
+ * @param a_fdPass ...descriptor to pass
+ * @param a_pBuffer ...
+ * @param a_nBufferSize ...> 0
+ * @return ssize_t bytes sent, -1 errno set, EAGAIN a full non-blocking socket
+ */
+ssize_t network::Sockets::sendFd( const socketfd_t& a_fd, const int32_t a_fdPass, const void* a_pBuffer, const size_t a_nBufferSize )
+{
+   if( (nullptr == a_pBuffer) || (0 == a_nBufferSize) )
+   {
+      errno = EINVAL;
+      return -1;
+   }
+   union
+   {
+      struct cmsghdr header;
+      char           aSpace[CMSG_SPACE( sizeof( int32_t ) )];
+   } control;
+   memset( &control, 0, sizeof( control ) );
+   struct iovec  iov;
+   struct msghdr message;
+   memset( &message, 0, sizeof( message ) );
+   iov.iov_base               = const_cast<void*>( a_pBuffer );
+   iov.iov_len                = a_nBufferSize;
+   message.msg_iov            = &iov;
+   message.msg_iovlen         = 1;
+   message.msg_control        = control.aSpace;
+   message.msg_controllen     = sizeof( control.aSpace );
+   struct cmsghdr* pHeader    = CMSG_FIRSTHDR( &message );
+   pHeader->cmsg_level        = SOL_SOCKET;
+   pHeader->cmsg_type         = SCM_RIGHTS;
+   pHeader->cmsg_len          = CMSG_LEN( sizeof( int32_t ) );
+   memcpy( CMSG_DATA( pHeader ), &a_fdPass, sizeof( int32_t ) );
+
+   ssize_t nSent;
+   do
+   {
+      nSent = ::sendmsg( a_fd, &message, MSG_NOSIGNAL );
+   } while( (-1 == nSent) && (EINTR == errno) );
+   return nSent;
+}
+
+
+
+/**
+ * @brief ...AF_UNIX, read what is waiting and the descriptor passed with it (SCM_RIGHTS), close-on-exec.  the bytes of
+ * two sends can come in one read on a stream socket, a descriptor arrives with the first byte its send carried.  more
+ * than one descriptor in a read are closed but the first
+ *
+ * @param a_fd ...connected AF_UNIX socket
+ * @param a_pBuffer ...
+ * @param a_nBufferSize ...
+ * @param a_fdPassed ...the descriptor, now owned by the caller, -1 none came with the bytes
+ * @return ssize_t bytes read, 0 EOF, -1 errno set, EAGAIN nothing waiting on a non-blocking socket
+ */
+ssize_t network::Sockets::receiveFd( const socketfd_t& a_fd, void* a_pBuffer, const size_t a_nBufferSize, int32_t& a_fdPassed )
+{
+   a_fdPassed = -1;
+   if( (nullptr == a_pBuffer) || (0 == a_nBufferSize) )
+   {
+      errno = EINVAL;
+      return -1;
+   }
+   union
+   {
+      struct cmsghdr header;
+      char           aSpace[CMSG_SPACE( 8 * sizeof( int32_t ) )];
+   } control;
+   struct iovec  iov;
+   struct msghdr message;
+   memset( &message, 0, sizeof( message ) );
+   iov.iov_base           = a_pBuffer;
+   iov.iov_len            = a_nBufferSize;
+   message.msg_iov        = &iov;
+   message.msg_iovlen     = 1;
+   message.msg_control    = control.aSpace;
+   message.msg_controllen = sizeof( control.aSpace );
+
+   ssize_t nRead;
+   do
+   {
+      nRead = ::recvmsg( a_fd, &message, MSG_CMSG_CLOEXEC );
+   } while( (-1 == nRead) && (EINTR == errno) );
+   if( -1 == nRead )
+   {
+      return -1;
+   }
+   for( struct cmsghdr* pHeader = CMSG_FIRSTHDR( &message ); nullptr != pHeader; pHeader = CMSG_NXTHDR( &message, pHeader ) )
+   {
+      if( (SOL_SOCKET != pHeader->cmsg_level) || (SCM_RIGHTS != pHeader->cmsg_type) )
+      {
+         continue;
+      }
+      const size_t nCount = (pHeader->cmsg_len - CMSG_LEN( 0 )) / sizeof( int32_t );
+      for( size_t nIndex=0; nIndex<nCount; ++nIndex )
+      {
+         int32_t fdPassed;
+         memcpy( &fdPassed, CMSG_DATA( pHeader ) + nIndex * sizeof( int32_t ), sizeof( int32_t ) );
+         if( -1 == a_fdPassed )
+         {
+            a_fdPassed = fdPassed;
+         } else
+         {
+            ::close( fdPassed );
+         }
+      }
+   }
+   return nRead;
+}
+
+
 /**
  * @brief ...close the socket
  * 
@@ -410,6 +847,11 @@ bool network::Sockets::close()
       ::close( m_fdSocket );
       m_fdSocket = 0;
    }
+   if( true == m_bUnlink )
+   {
+      ::unlink( m_pszHostname );
+      m_bUnlink = false;
+   }
    return false;
 }
 
@@ -438,510 +880,4736 @@ ssize_t network::Client::send( const void* a_pBuffer, const ssize_t& a_nBufferSi
 
 
 /**
- * @brief ...blocking receive
+ * @brief ...blocking scatter-gather send, see Sockets::sendv
  * 
- * @param a_pBuffer ...
- * @param a_nBufferSize ...
+ * @param a_pIov ...
+ * @param a_nCount ...
  * @return ssize_t
  */
-ssize_t network::Client::receive( void* a_pBuffer, const ssize_t& a_nBufferSize )
+ssize_t network::Client::sendv( const struct iovec* a_pIov, const int32_t a_nCount )
 {
-   return network::Sockets::receive_blocking( m_fdSocket, a_pBuffer, a_nBufferSize );
+   return network::Sockets::sendv( m_fdSocket, a_pIov, a_nCount );
 }
 
 
-
-// non-blocking client
-//
+/**
+ * @brief ...blocking file send, see Sockets::sendFile
+ * 
+ * @param a_fdFile ...
+ * @param a_nOffset ...
+ * @param a_nLength ...
+ * @return ssize_t
+ */
+ssize_t network::Client::sendFile( const int32_t a_fdFile, const off_t a_nOffset, const size_t a_nLength )
+{
+   return network::Sockets::sendFile( m_fdSocket, a_fdFile, a_nOffset, a_nLength );
+}
 
 
 /**
- * @brief ...receive non-blockeding reply
+ * @brief ...blocking receive
  * 
  * @param a_pBuffer ...
  * @param a_nBufferSize ...
  * @return ssize_t
  */
-ssize_t network::ClientAsync::receive( void* a_pBuffer, const ssize_t& a_nBufferSize )
+ssize_t network::Client::receive( void* a_pBuffer, const ssize_t& a_nBufferSize )
 {
-   return network::Sockets::receive( m_fdSocket, a_pBuffer, a_nBufferSize );
+   return network::Sockets::receive_blocking( m_fdSocket, a_pBuffer, a_nBufferSize );
 }
 
 
-
-
 /**
- * @brief ...start async receiver for replies.  starts a thread with epolling to callback on events and errors
- * @example see testing/async/client.cpp
+ * @brief ...UDP, blocking batch receive.  waits for the first datagram then takes what else is waiting, see Sockets::receiveBatch
  * 
- * @param a_cbMessage ...call back on connect HUP, and data ready
- * @param a_pData ...void pointer that will be returned in call back
- * @param a_cbError ...call back on error, fn( errno, null terminaled string, a_pData )
- * @param a_bEdgeTrigger ...level or edge trigger (level default)
- *      edge  -> triggered once when data is present, must read all data on this event
- *      level -> triggeered whenever data is present, can  read some or all data per even
- * @return bool
+ * @param a_pDatagrams ...
+ * @param a_nCount ...
+ * @return int32_t datagrams received, -1 on error
  */
-bool network::ClientAsync::startAsync( const network::socketCallback_t a_cbMessage, void* const a_pData, const network::errorCallBack_t a_cbError, const bool a_bEdgeTrigger )
+int32_t network::Client::receiveBatch( datagram_t* a_pDatagrams, const uint32_t a_nCount )
 {
-   m_bEdgeTriggered = a_bEdgeTrigger;
-   thread thd( &ClientAsync::startAsync_, this, a_cbMessage, a_cbError, a_pData );
-   m_thdReceiver = std::move( thd );
-   return true;
+   return network::Sockets::receiveBatch( m_fdSocket, a_pDatagrams, a_nCount, MSG_WAITFORONE );
 }
 
 
 /**
- * @brief ...async private worker
+ * @brief ...UDP, batch send to the connected peer or the peer of each datagram, see Sockets::sendBatch
  * 
+ * @param a_pDatagrams ...
+ * @param a_nCount ...
+ * @return int32_t datagrams sent, -1 on error
+ */
+int32_t network::Client::sendBatch( const datagram_t* a_pDatagrams, const uint32_t a_nCount )
+{
+   return network::Sockets::sendBatch( m_fdSocket, a_pDatagrams, a_nCount );
+}
+
+
+
+// non-blocking client
+//
+
+
+/**
+ * @brief ...framing spec from the setFraming arguments
+ *
+ * @param a_type ...framing
+ * @param a_nValue ...LENGTH_PREFIX header size, DELIMITER delimiter byte, FIXED message size
+ * @return network::framingSpec_t
+ */
+static network::framingSpec_t makeFraming( const network::framing_t a_type, const uint32_t a_nValue )
+{
+   network::framingSpec_t spec;
+   spec.type = a_type;
+   switch( a_type )
+   {
+      case network::framing_t::LENGTH_PREFIX:
+         spec.nHeaderSize = ( (1 == a_nValue) || (2 == a_nValue) ) ? a_nValue : 4;
+         break;
+      case network::framing_t::DELIMITER:
+         spec.cDelimiter  = static_cast<uint8_t>( a_nValue );
+         break;
+      case network::framing_t::FIXED:
+         spec.nFixedSize  = a_nValue;
+         break;
+      default:
+         break;
+   }
+   return spec;
+}
+
+
+
+/**
+ * @brief ...CLOCK_REALTIME in ms
+ *
+ * @return int64_t
+ */
+static int64_t realtime_ms()
+{
+   struct timespec ts;
+   clock_gettime( CLOCK_REALTIME, &ts );
+   return static_cast<int64_t>( ts.tv_sec ) * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+
+// counters of the reactor (or ClientAsync receiver) running on this thread, nullptr on any other thread
+static thread_local network::Metrics* t_pMetrics = nullptr;
+
+
+
+/**
+ * @brief ...count on the reactor of the calling thread, nothing on other threads
+ *
+ * @param a_metric ...
+ * @param a_nValue ...
+ */
+static void count( const network::metric_t a_metric, const uint64_t a_nValue = 1 )
+{
+   if( nullptr != t_pMetrics )
+   {
+      t_pMetrics->add( a_metric, a_nValue );
+   }
+}
+
+
+
+// latency histograms of the reactor (or ClientAsync receiver) running on this thread, set in GSOCK_HISTOGRAMS builds only
+static thread_local network::latency_t* t_pLatency = nullptr;
+
+
+
+/**
+ * @brief ...records the time from its construction to the end of the scope, ex a callback or a send.  without
+ * GSOCK_HISTOGRAMS it is empty and compiles away, the clock is not read
+ */
+class LatencyTimer
+{
+#ifdef GSOCK_HISTOGRAMS
+   private:
+      network::Histogram*  m_pHistogram  = nullptr;
+      uint64_t             m_nStart_ns   = 0;
+
+   public:
+      explicit LatencyTimer( network::Histogram* a_pHistogram ) :
+         m_pHistogram( a_pHistogram ),
+         m_nStart_ns( (nullptr != a_pHistogram) ? network::BusyPoll::now_ns() : 0 )
+      {}
+      LatencyTimer( const LatencyTimer& ) = delete;
+      ~LatencyTimer()
+      {
+         if( nullptr != m_pHistogram )
+         {
+            m_pHistogram->record( network::BusyPoll::now_ns() - m_nStart_ns );
+         }
+      }
+
+      LatencyTimer& operator =( const LatencyTimer& ) = delete;
+#else
+   public:
+      explicit LatencyTimer( network::Histogram* ) {}
+#endif
+};
+
+static network::Histogram* callbackHistogram()   { return (nullptr != t_pLatency) ? &t_pLatency->callback : nullptr; }
+static network::Histogram* sendHistogram()       { return (nullptr != t_pLatency) ? &t_pLatency->send : nullptr; }
+
+
+
+/**
+ * @brief ...read from the socket into its receive buffer and call back once per complete message
+ *
+ * @param a_buffer ...receive buffer of the connection
+ * @param a_spec ...framing
+ * @param a_fd ...non-blocking socket
+ * @param a_bDrain ...read until no data is left (edge trigger or closing), else one read (level trigger)
+ * @param a_cbMessage ...message callback
+ * @param a_pMessageData ...pointer to pass back to the message callback
+ * @param a_error ...error callback
+ * @param a_pData ...pointer to pass back to callbacks
+ * @param a_pInfo ...server connection, bytes and messages are counted
+ * @return bool false when the connection should be closed, EOF, socket error or a message larger than the buffer
+ */
+static bool deliverMessages( network::RecvBuffer& a_buffer, const network::framingSpec_t& a_spec, const network::socketfd_t a_fd, const bool a_bDrain,
+                             const network::messageCallback_t a_cbMessage, void* a_pMessageData, const network::errorCallBack_t a_error, void* a_pData,
+                             network::connectionInfo_t* a_pInfo = nullptr )
+{
+   const uint8_t*          pMessage;
+   size_t                  nLength;
+   network::frameStatus_t  status;
+   do
+   {
+      ssize_t nBytesRead = a_buffer.fill( a_fd );
+      if( 0 == nBytesRead )
+      {
+         // EOF
+         return false;
+      }
+      if( -1 == nBytesRead )
+      {
+         if( EAGAIN == errno )
+         {
+            count( network::metric_t::READ_EAGAIN );
+            return true;
+         }
+         if( nullptr != a_error )
+         {
+            a_error( errno, strerror( errno ), a_pData );
+         }
+         return false;
+      }
+      count( network::metric_t::BYTES_IN, static_cast<uint64_t>( nBytesRead ) );
+      if( nullptr != a_pInfo )
+      {
+         a_pInfo->nBytesIn += static_cast<uint64_t>( nBytesRead );
+      }
+
+      while( network::frameStatus_t::FRAME == (status = a_buffer.nextFrame( a_spec, pMessage, nLength )) )
+      {
+         const LatencyTimer timer( callbackHistogram() );
+         a_cbMessage( a_fd, pMessage, nLength, a_pMessageData );
+         count( network::metric_t::MESSAGES_IN );
+         if( nullptr != a_pInfo )
+         {
+            ++a_pInfo->nMessagesIn;
+         }
+      }
+      if( network::frameStatus_t::OVERSIZE == status )
+      {
+         if( nullptr != a_error )
+         {
+            a_error( EMSGSIZE, "message larger than receive buffer, closing connection", a_pData );
+         }
+         return false;
+      }
+   } while( a_bDrain );
+   return true;
+}
+
+
+
+/**
+ * @brief ...io_uring, call back once per complete message in bytes the kernel received into a provided buffer.  With no
+ * framing the provided buffer is delivered as is, else the bytes are appended to the receive buffer and cut there
+ *
+ * @param a_buffer ...receive buffer of the connection
+ * @param a_spec ...framing
+ * @param a_fd ...socket
+ * @param a_pReceived ...provided buffer
+ * @param a_nReceived ...bytes in it
+ * @param a_cbMessage ...message callback
+ * @param a_pMessageData ...pointer to pass back to the message callback
+ * @param a_error ...error callback
+ * @param a_pData ...pointer to pass back to callbacks
+ * @param a_pInfo ...server connection, bytes and messages are counted
+ * @return bool false when the connection should be closed, a message larger than the buffer
+ */
+static bool deliverReceived( network::RecvBuffer& a_buffer, const network::framingSpec_t& a_spec, const network::socketfd_t a_fd, const uint8_t* a_pReceived, size_t a_nReceived,
+                             const network::messageCallback_t a_cbMessage, void* a_pMessageData, const network::errorCallBack_t a_error, void* a_pData,
+                             network::connectionInfo_t* a_pInfo = nullptr )
+{
+   count( network::metric_t::BYTES_IN, a_nReceived );
+   if( nullptr != a_pInfo )
+   {
+      a_pInfo->nBytesIn += a_nReceived;
+   }
+   if( network::framing_t::NONE == a_spec.type )
+   {
+      const LatencyTimer timer( callbackHistogram() );
+      a_cbMessage( a_fd, a_pReceived, a_nReceived, a_pMessageData );
+      count( network::metric_t::MESSAGES_IN );
+      if( nullptr != a_pInfo )
+      {
+         ++a_pInfo->nMessagesIn;
+      }
+      return true;
+   }
+
+   const uint8_t*          pMessage;
+   size_t                  nLength;
+   network::frameStatus_t  status;
+   while( a_nReceived > 0 )
+   {
+      const size_t nTaken = a_buffer.append( a_pReceived, a_nReceived );
+      a_pReceived += nTaken;
+      a_nReceived -= nTaken;
+      while( network::frameStatus_t::FRAME == (status = a_buffer.nextFrame( a_spec, pMessage, nLength )) )
+      {
+         const LatencyTimer timer( callbackHistogram() );
+         a_cbMessage( a_fd, pMessage, nLength, a_pMessageData );
+         count( network::metric_t::MESSAGES_IN );
+         if( nullptr != a_pInfo )
+         {
+            ++a_pInfo->nMessagesIn;
+         }
+      }
+      if( (network::frameStatus_t::OVERSIZE == status) || (0 == nTaken) )
+      {
+         if( nullptr != a_error )
+         {
+            a_error( EMSGSIZE, "message larger than receive buffer, closing connection", a_pData );
+         }
+         return false;
+      }
+   }
+   return true;
+}
+
+
+
+/**
+ * @brief ...UDP, one batch of datagrams for recvmmsg, a_nCount buffers of a_nSize carved from one allocation
+ *
+ * @param a_vecDatagrams ...out
+ * @param a_vecBuffer ...out, backing store of the buffers
+ * @param a_nCount ...datagrams per batch
+ * @param a_nSize ...largest datagram
+ */
+static void prepareDatagrams( std::vector<network::datagram_t>& a_vecDatagrams, std::vector<uint8_t>& a_vecBuffer, const uint32_t a_nCount, const uint32_t a_nSize )
+{
+   a_vecBuffer.resize( static_cast<size_t>( a_nCount ) * a_nSize );
+   a_vecDatagrams.resize( a_nCount );
+   for( uint32_t nIndex=0; nIndex<a_nCount; ++nIndex )
+   {
+      a_vecDatagrams[nIndex].pBuffer = a_vecBuffer.data() + static_cast<size_t>( nIndex ) * a_nSize;
+      a_vecDatagrams[nIndex].nSize   = a_nSize;
+   }
+}
+
+
+
+/**
+ * @brief ...UDP, read the waiting datagrams in batches with recvmmsg and call back once per datagram, with the sender to
+ * the datagram callback or else as a message
+ *
+ * @param a_fd ...non-blocking datagram socket
+ * @param a_vecDatagrams ...one batch, see prepareDatagrams
+ * @param a_bDrain ...read until no datagram is left (edge trigger), else one batch (level trigger)
+ * @param a_cbMessage ...message callback, used when a_cbDatagram is nullptr
+ * @param a_cbDatagram ...datagram callback
+ * @param a_error ...error callback
+ * @param a_pData ...pointer to pass back to callbacks
+ * @return bool false on socket error
+ */
+static bool deliverDatagrams( const network::socketfd_t a_fd, std::vector<network::datagram_t>& a_vecDatagrams, const bool a_bDrain, const network::messageCallback_t a_cbMessage,
+                              const network::datagramCallback_t a_cbDatagram, const network::errorCallBack_t a_error, void* a_pData )
+{
+   do
+   {
+      int32_t nCount = network::Sockets::receiveBatch( a_fd, a_vecDatagrams.data(), static_cast<uint32_t>( a_vecDatagrams.size() ), MSG_DONTWAIT );
+      if( -1 == nCount )
+      {
+         if( EAGAIN == errno )
+         {
+            count( network::metric_t::READ_EAGAIN );
+            return true;
+         }
+         if( nullptr != a_error )
+         {
+            a_error( errno, strerror( errno ), a_pData );
+         }
+         return false;
+      }
+      count( network::metric_t::MESSAGES_IN, static_cast<uint64_t>( nCount ) );
+      for( int32_t nIndex=0; nIndex<nCount; ++nIndex )
+      {
+         const network::datagram_t& datagram = a_vecDatagrams[static_cast<size_t>( nIndex )];
+         count( network::metric_t::BYTES_IN, datagram.nLength );
+         const LatencyTimer timer( callbackHistogram() );
+         if( nullptr != a_cbDatagram )
+         {
+            a_cbDatagram( a_fd, datagram, a_pData );
+         } else
+         {
+            a_cbMessage( a_fd, reinterpret_cast<const uint8_t*>( datagram.pBuffer ), datagram.nLength, a_pData );
+         }
+      }
+   } while( a_bDrain );
+   return true;
+}
+
+
+
+/**
+ * @brief ...UDP, an ICMP error for an earlier datagram (ex port unreachable) raised EPOLLERR.  read and report it, the
+ * socket stays usable
+ *
+ * @param a_fd ...datagram socket
+ * @param a_error ...error callback
+ * @param a_pData ...pointer to pass back to callbacks
+ */
+static void reportDatagramError( const network::socketfd_t a_fd, const network::errorCallBack_t a_error, void* a_pData )
+{
+   int       nError  = 0;
+   socklen_t nLength = sizeof( nError );
+   getsockopt( a_fd, SOL_SOCKET, SO_ERROR, &nError, &nLength );
+   if( (0 != nError) && (nullptr != a_error) )
+   {
+      a_error( nError, strerror( nError ), a_pData );
+   }
+}
+
+
+
+// io_uring request tags, user data is op:8 | generation:24 | fd:32
+enum struct uringOp_t: uint64_t { ACCEPT, RECV, POLL, SEND, WRITABLE, TIMEOUT, CANCEL, WAKE, TIMER, CONNECT };
+
+static constexpr uint32_t s_nUringEntries      = 1024;     // submission queue, the completion queue is 4 times larger
+static constexpr uint32_t s_nUringBufferCount  = 1024;     // provided buffers per ring, power of 2
+static constexpr uint32_t s_nUringBufferSize   = 16384;
+static constexpr uint32_t s_nUringMaxSend      = 1 << 30;  // bytes per send request
+static constexpr uint32_t s_nUringClientEntries      = 64;     // ClientAsync, one socket
+static constexpr uint32_t s_nUringClientBufferCount  = 256;
+
+static uint64_t uringData( const uringOp_t a_op, const uint32_t a_nGeneration, const network::socketfd_t a_fd )
+{
+   return (static_cast<uint64_t>( a_op ) << 56) | (static_cast<uint64_t>( a_nGeneration & 0xFFFFFF ) << 32) | static_cast<uint32_t>( a_fd );
+}
+
+static uringOp_t           uringOp( const uint64_t a_nUserData )         { return static_cast<uringOp_t>( a_nUserData >> 56 ); }
+static uint32_t            uringGeneration( const uint64_t a_nUserData ) { return static_cast<uint32_t>( (a_nUserData >> 32) & 0xFFFFFF ); }
+static network::socketfd_t uringFd( const uint64_t a_nUserData )         { return static_cast<network::socketfd_t>( a_nUserData & 0xFFFFFFFF ); }
+
+
+
+/**
+ * @brief ...a resolve still in flight calls back into nothing.  the receiver thread must be stopped and joined before
+ *
+ */
+network::ClientAsync::~ClientAsync()
+{
+   lock_guard<std::mutex> lock( m_pResolving->mux );
+   m_pResolving->pOwner = nullptr;
+}
+
+
+
+/**
+ * @brief ...receive non-blockeding reply
+ * 
+ * @param a_pBuffer ...
+ * @param a_nBufferSize ...
+ * @return ssize_t
+ */
+ssize_t network::ClientAsync::receive( void* a_pBuffer, const ssize_t& a_nBufferSize )
+{
+   return network::Sockets::receive( m_fdSocket, a_pBuffer, a_nBufferSize );
+}
+
+
+
+/**
+ * @brief ...how the stream is cut into messages for the message callback, see setMessageCallback
+ *
+ * @param a_type ...NONE, LENGTH_PREFIX, DELIMITER or FIXED
+ * @param a_nValue ...LENGTH_PREFIX header size 1,2,4 (default 4), DELIMITER delimiter byte, FIXED message size
+ */
+void network::ClientAsync::setFraming( const framing_t a_type, const uint32_t a_nValue )
+{
+   m_framing = makeFraming( a_type, a_nValue );
+}
+
+
+
+/**
+ * @brief ...epoll events for the socket
+ *
+ * @param a_bWrite ...include EPOLLOUT, bytes are queued
+ * @return uint32_t
+ */
+uint32_t network::ClientAsync::socketEvents_( const bool a_bWrite ) const
+{
+   uint32_t nEvents = EPOLLIN | EPOLLRDHUP;
+   if( true == m_bEdgeTriggered )
+   {
+      nEvents |= EPOLLET;
+   }
+   if( true == a_bWrite )
+   {
+      nEvents |= EPOLLOUT;
+   }
+   return nEvents;
+}
+
+
+
+/**
+ * @brief ...non-blocking send, thread safe.  Once the receiver thread is running what the socket does not take is queued
+ * and written on EPOLLOUT.  before startAsync this is a blocking send
+ *
+ * @param a_pBuffer ...
+ * @param a_nBufferSize ...
+ * @return ssize_t a_nBufferSize when written or queued, -1 on error
+ */
+ssize_t network::ClientAsync::send( const void* a_pBuffer, const ssize_t& a_nBufferSize )
+{
+   if( (nullptr == a_pBuffer) || (a_nBufferSize <= 0) )
+   {
+      return -1;
+   }
+
+   if( protocol_t::UDP == m_protocol )
+   {
+      // a datagram goes out whole or not at all, it is never queued
+      return sent_( network::Client::send( a_pBuffer, a_nBufferSize ) );
+   }
+
+   bool bHighWatermark = false;
+   {
+      unique_lock<std::mutex> lock( m_muxSend );
+      if( false == m_bSendQueueReady )
+      {
+         lock.unlock();
+         return sent_( network::Client::send( a_pBuffer, a_nBufferSize ) );
+      }
+      const LatencyTimer timer( (nullptr != m_pLatency) ? &m_pLatency->send : nullptr );   // recorded under the lock
+      if( -1 == m_sendQueue.write( m_fdSocket, a_pBuffer, static_cast<size_t>( a_nBufferSize ) ) )
+      {
+         return -1;
+      }
+      m_metrics.add( metric_t::BYTES_OUT, static_cast<uint64_t>( a_nBufferSize ) );
+      m_metrics.add( metric_t::MESSAGES_OUT );
+      if( false == m_sendQueue.empty() )
+      {
+         m_metrics.add( metric_t::SEND_EAGAIN );
+      }
+      bHighWatermark = armWrite_();
+   }
+   // callback outside the lock, the handler may send
+   if( (true == bHighWatermark) && (nullptr != m_cbSocketEvent) )
+   {
+      m_cbSocketEvent( m_fdSocket, network::callBack_t::WRITE_HIGH_WATERMARK, m_pCallbackData );
+   }
+   return a_nBufferSize;
+}
+
+
+
+/**
+ * @brief ...queue a copy of the message for the receiver thread, which sends it in post order.  does not lock and makes
+ * no syscall unless the receiver thread has to be woken
+ *
+ * @param a_pBuffer ...
+ * @param a_nSize ...
+ * @return bool false, errno EBADF if startAsync was not called or the connection is down, ENOMEM
+ */
+bool network::ClientAsync::post( const void* a_pBuffer, const size_t a_nSize )
+{
+   // the message belongs to the connection open now, the receiver thread drops it once that one is lost
+   const uint64_t nTag = m_nPostTag.load( std::memory_order_acquire );
+   if( 0 == nTag )
+   {
+      errno = EBADF;
+      return false;
+   }
+   return m_posted.post( -1, nTag, a_pBuffer, a_nSize );
+}
+
+
+
+/**
+ * @brief ...as post, the pool buffer is referenced instead of copied and released once sent
+ *
+ * @param a_buffer ...must not be changed until sent
+ * @param a_nLength ...bytes of the buffer to send
+ * @return bool false, errno EBADF if startAsync was not called or the connection is down, EINVAL, ENOMEM
+ */
+bool network::ClientAsync::post( const PoolBuffer& a_buffer, const size_t a_nLength )
+{
+   const uint64_t nTag = m_nPostTag.load( std::memory_order_acquire );
+   if( 0 == nTag )
+   {
+      errno = EBADF;
+      return false;
+   }
+   return m_posted.post( -1, nTag, a_buffer, a_nLength );
+}
+
+
+
+/**
+ * @brief ...start a timer, the callback runs on the receiver thread with fd -1
+ *
+ * @param a_nDelay_ms ...first expiry
+ * @param a_nInterval_ms ...repeat interval, 0 one shot
+ * @param a_cbTimer ...callback( -1, timer id, a_pData )
+ * @param a_pData ...pointer to pass back to the callback
+ * @return uint64_t timer id, 0 on error, errno EPERM when not called on the receiver thread
+ */
+uint64_t network::ClientAsync::setTimer( const uint32_t a_nDelay_ms, const uint32_t a_nInterval_ms, const timerCallback_t a_cbTimer, void* const a_pData )
+{
+   if( std::this_thread::get_id() != m_idReceiver )
+   {
+      errno = EPERM;
+      return 0;
+   }
+   return m_timers.add( -1, a_nDelay_ms, a_nInterval_ms, a_cbTimer, a_pData );
+}
+
+
+
+/**
+ * @brief ...stop a timer, on the receiver thread
+ *
+ * @param a_nTimer ...id from setTimer
+ * @return bool false if not a running timer
+ */
+bool network::ClientAsync::cancelTimer( const uint64_t a_nTimer )
+{
+   if( std::this_thread::get_id() != m_idReceiver )
+   {
+      errno = EPERM;
+      return false;
+   }
+   return m_timers.cancel( a_nTimer );
+}
+
+
+
+/**
+ * @brief ...timer of the receiver thread, log the rates since the last line, see setMetricsLog
+ *
+ * @param a_pData ...the client
+ */
+void network::ClientAsync::logMetrics_( const int32_t&, const uint64_t, void* const a_pData )
+{
+   ClientAsync*      pThis   = static_cast<ClientAsync*>( a_pData );
+   const metrics_t   now     = pThis->m_metrics.snapshot();
+   const uint64_t    nNow_ns = BusyPoll::now_ns();
+   const string      str     = Metrics::format( now, pThis->m_lastMetrics, static_cast<double>( nNow_ns - pThis->m_nLastMetrics_ns ) / 1e9 );
+   pThis->m_cbMetricsLog( LogLevel::EINF, str.c_str() );
+   pThis->m_lastMetrics     = now;
+   pThis->m_nLastMetrics_ns = nNow_ns;
+}
+
+
+
+/**
+ * @brief ...receiver thread, send the posted messages.  messages posted to a connection lost since are dropped, also
+ * when a reconnect has opened the next one.  picks up setReconnect and the addresses of the resolve of a reconnect
+ *
+ * @param a_error ...
+ * @param a_pThis ...
+ */
+void network::ClientAsync::drainPosted_( const errorCallBack_t a_error, void* const a_pThis )
+{
+   if( (true == m_bRetriesChanged.load( std::memory_order_relaxed )) && (true == m_bRetriesChanged.exchange( false )) )
+   {
+      applyRetries_();
+   }
+   if( 0 != m_nLookup )
+   {
+      resolved_();
+   }
+   m_posted.drain( [this, a_error, a_pThis]( const int32_t, const uint64_t a_nTag, const uint8_t* a_pMessage, const size_t a_nLength )
+   {
+      if( (-1 == m_fdSocket) || (a_nTag != m_nPostTag.load( std::memory_order_relaxed )) )
+      {
+         return;
+      }
+      if( (-1 == send( a_pMessage, static_cast<ssize_t>( a_nLength ) )) && (nullptr != a_error) )
+      {
+         a_error( errno, strerror( errno ), a_pThis );
+      }
+   } );
+}
+
+
+
+/**
+ * @brief ...non-blocking scatter-gather send, thread safe.  as send, what the socket does not take is queued
+ *
+ * @param a_pIov ...buffers
+ * @param a_nCount ...number of entries
+ * @return ssize_t total bytes written or queued, -1 on error
+ */
+ssize_t network::ClientAsync::sendv( const struct iovec* a_pIov, const int32_t a_nCount )
+{
+   if( (nullptr == a_pIov) || (a_nCount <= 0) )
+   {
+      return -1;
+   }
+   ssize_t nTotal = 0;
+   for( int32_t nIndex=0; nIndex<a_nCount; ++nIndex )
+   {
+      nTotal += static_cast<ssize_t>( a_pIov[nIndex].iov_len );
+   }
+
+   if( protocol_t::UDP == m_protocol )
+   {
+      // one datagram, never queued
+      return sent_( network::Client::sendv( a_pIov, a_nCount ) );
+   }
+
+   bool bHighWatermark = false;
+   {
+      unique_lock<std::mutex> lock( m_muxSend );
+      if( false == m_bSendQueueReady )
+      {
+         lock.unlock();
+         return sent_( network::Client::sendv( a_pIov, a_nCount ) );
+      }
+      const LatencyTimer timer( (nullptr != m_pLatency) ? &m_pLatency->send : nullptr );   // recorded under the lock
+      if( -1 == m_sendQueue.writev( m_fdSocket, a_pIov, a_nCount ) )
+      {
+         return -1;
+      }
+      m_metrics.add( metric_t::BYTES_OUT, static_cast<uint64_t>( nTotal ) );
+      m_metrics.add( metric_t::MESSAGES_OUT );
+      if( false == m_sendQueue.empty() )
+      {
+         m_metrics.add( metric_t::SEND_EAGAIN );
+      }
+      bHighWatermark = armWrite_();
+   }
+   if( (true == bHighWatermark) && (nullptr != m_cbSocketEvent) )
+   {
+      m_cbSocketEvent( m_fdSocket, network::callBack_t::WRITE_HIGH_WATERMARK, m_pCallbackData );
+   }
+   return nTotal;
+}
+
+
+
+/**
+ * @brief ...count a send that did not go through the queue, a datagram or a send before startAsync.  any thread, the send
+ * counters are kept under m_muxSend
+ *
+ * @param a_nBytes ...result of the send, -1 is not counted
+ * @return ssize_t a_nBytes
+ */
+ssize_t network::ClientAsync::sent_( const ssize_t a_nBytes )
+{
+   if( a_nBytes >= 0 )
+   {
+      lock_guard<std::mutex> lock( m_muxSend );
+      m_metrics.add( metric_t::BYTES_OUT, static_cast<uint64_t>( a_nBytes ) );
+      m_metrics.add( metric_t::MESSAGES_OUT );
+   }
+   return a_nBytes;
+}
+
+
+
+/**
+ * @brief ...after a write, register EPOLLOUT if bytes were queued.  called with m_muxSend held
+ *
+ * @return bool true when the queue just reached the high watermark, the caller calls back outside the lock
+ */
+bool network::ClientAsync::armWrite_()
+{
+   if( (false == m_sendQueue.empty()) && (false == m_bWritePending) )
+   {
+      if( engine_t::IO_URING == m_engine )
+      {
+         // one shot, the receiver thread may be waiting on the ring so submit now
+         m_ring.prepPoll( m_fdSocket, POLLOUT, uringData( uringOp_t::WRITABLE, m_nGeneration, m_fdSocket ) );
+         m_ring.submit();
+      } else
+      {
+         epoll_event epEvent;
+         epEvent.data.fd = m_fdSocket;
+         epEvent.events  = socketEvents_( true );
+         epoll_ctl( m_fdEpoll, EPOLL_CTL_MOD, m_fdSocket, &epEvent );
+      }
+      m_bWritePending = true;
+   }
+   if( (false == m_bHighWatermark) && (m_sendQueue.size() >= m_nHighWatermark) )
+   {
+      m_bHighWatermark = true;
+      return true;
+   }
+   return false;
+}
+
+
+
+/**
+ * @brief ...receiver thread, socket is writable, write the queued bytes.  EPOLLOUT is removed when the queue is empty
+ *
+ * @return bool false on socket error
+ */
+bool network::ClientAsync::flush_()
+{
+   bool bLowWatermark = false;
+   bool bResult       = true;
+   {
+      lock_guard<std::mutex> lock( m_muxSend );
+      m_metrics.add( metric_t::SEND_RETRIES );
+      if( -1 == m_sendQueue.flush( m_fdSocket ) )
+      {
+         bResult = false;
+      }
+      if( engine_t::IO_URING == m_engine )
+      {
+         // the POLLOUT that called this is used up, arm another one while bytes are left
+         m_bWritePending = false;
+         armWrite_();
+      } else if( (true == m_sendQueue.empty()) && (true == m_bWritePending) )
+      {
+         epoll_event epEvent;
+         epEvent.data.fd = m_fdSocket;
+         epEvent.events  = socketEvents_( false );
+         epoll_ctl( m_fdEpoll, EPOLL_CTL_MOD, m_fdSocket, &epEvent );
+         m_bWritePending = false;
+      }
+      if( (true == m_bHighWatermark) && (m_sendQueue.size() <= m_nLowWatermark) )
+      {
+         m_bHighWatermark = false;
+         bLowWatermark    = true;
+      }
+   }
+   if( (true == bLowWatermark) && (nullptr != m_cbSocketEvent) )
+   {
+      m_cbSocketEvent( m_fdSocket, network::callBack_t::WRITE_LOW_WATERMARK, m_pCallbackData );
+   }
+   return bResult;
+}
+
+
+
+/**
+ * @brief ...connection gone, drop queued bytes.  send is not queued again until a socket is back on epoll
+ *
+ */
+void network::ClientAsync::stopSendQueue_()
+{
+   lock_guard<std::mutex> lock( m_muxSend );
+   m_bSendQueueReady = false;
+   m_bWritePending   = false;
+   m_bHighWatermark  = false;
+   m_sendQueue.reset();
+}
+
+
+
+
+/**
+ * @brief ...start async receiver for replies.  starts a thread with epolling to callback on events and errors
+ * @example see testing/async/client.cpp
+ * 
+ * @param a_cbMessage ...call back on connect HUP, and data ready
+ * @param a_pData ...void pointer that will be returned in call back
+ * @param a_cbError ...call back on error, fn( errno, null terminaled string, a_pData )
+ * @param a_bEdgeTrigger ...level or edge trigger (level default)
+ *      edge  -> triggered once when data is present, must read all data on this event
+ *      level -> triggeered whenever data is present, can  read some or all data per even
+ * @return bool
+ */
+bool network::ClientAsync::startAsync( const network::socketCallback_t a_cbMessage, void* const a_pData, const network::errorCallBack_t a_cbError, const bool a_bEdgeTrigger )
+{
+   m_bEdgeTriggered = a_bEdgeTrigger;
+   m_cbSocketEvent  = a_cbMessage;
+   m_pCallbackData  = a_pData;
+   m_cbError        = a_cbError;
+   if( (false == m_posted.open()) || (false == m_timers.open( 1 )) )
+   {
+      if( nullptr != a_cbError )
+      {
+         a_cbError( errno, strerror( errno ), a_pData );
+      }
+      return false;
+   }
+#ifdef GSOCK_HISTOGRAMS
+   if( nullptr == m_pLatency )
+   {
+      m_pLatency.reset( new latency_t() );
+   }
+#endif
+   if( (nullptr != m_cbMetricsLog) && (0 != m_nMetricsInterval_ms) )
+   {
+      // the receiver thread has not started, the wheel can be used from here
+      m_lastMetrics     = m_metrics.snapshot();
+      m_nLastMetrics_ns = BusyPoll::now_ns();
+      m_timers.add( -1, m_nMetricsInterval_ms, m_nMetricsInterval_ms, &ClientAsync::logMetrics_, this );
+   }
+   m_nPostTag.store( (-1 != m_fdSocket) ? ++m_nConnections : 0, std::memory_order_release );
+   thread thd( &ClientAsync::startAsync_, this, a_cbMessage, a_cbError, a_pData );
+   m_thdReceiver = std::move( thd );
+   return true;
+}
+
+
+/**
+ * @brief ...async private worker
+ * 
+ * @param a_onSocketEvent ...
+ * @param a_error ...
+ * @param a_pThis ...
+ * @return bool
+ */
+bool network::ClientAsync::startAsync_( const network::socketCallback_t a_onSocketEvent, const errorCallBack_t a_error, void* const a_pThis )
+{
+   m_idReceiver = std::this_thread::get_id();   // setTimer checks it is called on this thread
+   {
+      lock_guard<std::mutex> lock( m_muxReady );   // used for conditional to signal async is ready
+   }
+   
+
+   if( (nullptr == a_onSocketEvent) && (nullptr == m_cbMessage) )
+   {
+      // error
+      return false;
+   }
+
+   // low latency, the receiver thread on its cpu and the socket busy polled
+   if( (false == BusyPoll::pin( m_nCpu )) && (nullptr != a_error) )
+   {
+      string str( "receiver not pinned to cpu " );
+      str.append( std::to_string( static_cast<int64_t>( m_nCpu ) ) );
+      str.append( ": " );
+      str.append( strerror( errno ) );
+      a_error( errno, str.c_str(), a_pThis );
+   }
+   if( (false == BusyPoll::tune( m_fdSocket, m_nBusyPoll_us )) && (nullptr != a_error) )
+   {
+      string str( "SO_BUSY_POLL not set: " );
+      str.append( strerror( errno ) );
+      a_error( errno, str.c_str(), a_pThis );
+   }
+   m_poll.configure( m_nSpin_us, m_nEpollTimeout_ms );
+   t_pMetrics = &m_metrics;    // the thread ends with this function
+   t_pLatency = m_pLatency.get();
+
+   if( protocol_t::UDP == m_protocol )
+   {
+      m_engine = engine_t::EPOLL;
+      if( nullptr != m_cbMessage )
+      {
+         prepareDatagrams( m_vecDatagrams, m_vecDatagramBuffer, m_nDatagramBatch, m_nReceiveBufferSize );
+      }
+   }
+   if( engine_t::IO_URING == m_engine )
+   {
+      return uringLoop_( a_onSocketEvent, a_error, a_pThis );
+   }
+   
+   // alloc on stack events for all connections
+   if( true == m_bUseMalloc )
+   {
+      m_pEvents = reinterpret_cast<epoll_event*>( malloc( static_cast<  decltype(sizeof(epoll_event))  >(m_nMaximumEpollEvents)*sizeof(epoll_event) ) );
+   } else
+   {
+      m_pEvents = reinterpret_cast<epoll_event*>( alloca( static_cast<  decltype(sizeof(epoll_event))  >(m_nMaximumEpollEvents)*sizeof(epoll_event) ) );
+   }
+   if( nullptr == m_pEvents )
+   {
+      // try malloc if stack alloc fails, but keep track of who did the alloc, for now. fail
+      if( nullptr != a_error )
+      {
+         a_error( errno, strerror( errno ), a_pThis );
+      }
+      return false;
+   }
+   if( (nullptr != m_cbMessage) && (protocol_t::UDP != m_protocol) && (false == m_recvBuffer.allocate( m_nReceiveBufferSize )) )
+   {
+      if( nullptr != a_error )
+      {
+         a_error( errno, strerror( errno ), a_pThis );
+      }
+      return false;
+   }
+   
+   m_fdEpoll = epoll_create1( 0 );
+   if( -1 == m_fdEpoll )
+   {
+      // log error
+      if( nullptr != a_error )
+      {
+         a_error( errno, strerror( errno ), a_pThis );
+      }
+      return false;
+   }
+
+   epoll_event epEventMainSocket;
+   epEventMainSocket.data.fd = m_fdSocket;
+   epEventMainSocket.events = socketEvents_( false );  // this is a socket from a connection, so listen for HUP
+   makeNonBlocking( m_fdSocket );
+
+   
+
+   if( -1 == epoll_ctl( m_fdEpoll, EPOLL_CTL_ADD, m_fdSocket, &epEventMainSocket ) )
+   {
+      // log error
+      if( nullptr != a_error )
+      {
+         a_error( errno, strerror( errno ), a_pThis );  // investigate if we needno use strerror_r
+      }
+      return false;
+   }
+   for( const int32_t fdReactor : { m_posted.fd(), m_timers.fd() } )
+   {
+      epoll_event epEventReactor;
+      epEventReactor.data.fd = fdReactor;
+      epEventReactor.events  = EPOLLIN;
+      if( -1 == epoll_ctl( m_fdEpoll, EPOLL_CTL_ADD, fdReactor, &epEventReactor ) )
+      {
+         if( nullptr != a_error )
+         {
+            a_error( errno, strerror( errno ), a_pThis );
+         }
+         return false;
+      }
+   }
+   {
+      lock_guard<std::mutex> lock( m_muxSend );
+      m_bSendQueueReady = true;
+   }
+   m_state = sessionState_t::OPEN;
+
+   int32_t fdCount;
+   int64_t lIndex;
+   
+   // listener side ready, the first wait returns at once to notify waitready
+   bool bNotified = false;
+   m_posted.wake();
+   
+   
+   while( m_bAsyncRunFlag )
+   {
+      m_metrics.waiting();
+      fdCount = m_poll.wait( m_fdEpoll, m_pEvents, m_nMaximumEpollEvents );
+      if( false == bNotified )
+      {
+         // notify that connection is ready
+         m_cvReady.notify_one();
+         bNotified = true;
+         //std::cout<<pthread_self()<<"notified"<<std::endl;
+      }
+      
+      switch( fdCount )
+      {
+         case 0:
+            // epoll timeout
+            continue;
+         case -1:
+            if( EINTR == errno )
+            {
+               continue;
+            } else
+            {
+               if( nullptr != a_error )
+               {
+                  string str( "epoll error: " );
+                  str.append( strerror( errno ) );
+                  a_error( errno, str.c_str(), nullptr );
+                  m_bAsyncRunFlag = false;
+                  continue;
+               }
+            }
+            continue;
+            
+         default:
+            m_metrics.wakeup( static_cast<uint64_t>( fdCount ) );
+            int32_t fd;
+            for( lIndex=0; lIndex<fdCount; ++lIndex )
+            {
+               fd = m_pEvents[lIndex].data.fd;
+               
+               if( m_posted.fd() == fd )
+               {
+                  drainPosted_( a_error, a_pThis );
+                  continue;
+               }
+               if( m_timers.fd() == fd )
+               {
+                  m_timers.expire();
+                  continue;
+               }
+               if( (sessionState_t::CONNECTING == m_state) && (m_connector.fd() == fd) )
+               {
+                  connecting_( m_connector.writable() );
+                  continue;
+               }
+               if( (-1 == m_fdSocket) || (m_fdSocket != fd) )
+               {
+                  // the socket was closed by an earlier event of this batch
+                  continue;
+               }
+               if( (protocol_t::UDP == m_protocol) && (m_pEvents[lIndex].events & EPOLLERR) )
+               {
+                  // no connection to lose, report the ICMP error and go on
+                  reportDatagramError( fd, a_error, a_pThis );
+                  m_pEvents[lIndex].events &= ~static_cast<uint32_t>( EPOLLERR );
+                  if( 0 == (m_pEvents[lIndex].events & EPOLLIN) )
+                  {
+                     continue;
+                  }
+               }
+               if( (m_pEvents[lIndex].events & EPOLLERR) || (m_pEvents[lIndex].events & EPOLLRDHUP) )
+               {
+                  // HUP: here
+                  int32_t   nError  = 0;
+                  socklen_t nLength = sizeof( nError );
+                  getsockopt( fd, SOL_SOCKET, SO_ERROR, &nError, &nLength );
+                  AsyncLog::writeError( LogLevel::EWRN, nError, "hup (server dropped connection) fd %d: %m", fd );
+                  if( m_pEvents[lIndex].events & EPOLLIN )
+                  {
+                     // deliver what the server sent before it closed
+                     if( nullptr != m_cbMessage )
+                     {
+                        deliverMessages( m_recvBuffer, m_framing, fd, true, m_cbMessage, a_pThis, a_error, a_pThis );
+                     } else if( nullptr != a_onSocketEvent )
+                     {
+                        const LatencyTimer timer( callbackHistogram() );
+                        a_onSocketEvent( fd, network::callBack_t::MESSAGE, a_pThis );
+                     }
+                  }
+                  // handle connection closed by either hangup or network error, reconnected if setReconnect
+                  closeSocket_( a_onSocketEvent, a_pThis, nError );
+                  continue;
+               } 
+               if( m_pEvents[lIndex].events & EPOLLOUT )
+               {
+                  // socket writable again, drain the outbound queue
+                  if( (false == flush_()) && (nullptr != a_error) )
+                  {
+                     a_error( errno, strerror( errno ), a_pThis );
+                  }
+               }
+               if( m_pEvents[lIndex].events & EPOLLIN )
+               {
+                  // data is ready on a fd
+                  m_poll.callback();
+                  if( (nullptr != m_cbMessage) && (protocol_t::UDP == m_protocol) )
+                  {
+                     deliverDatagrams( fd, m_vecDatagrams, m_bEdgeTriggered, m_cbMessage, nullptr, a_error, a_pThis );
+                  } else if( nullptr != m_cbMessage )
+                  {
+                     if( false == deliverMessages( m_recvBuffer, m_framing, fd, m_bEdgeTriggered, m_cbMessage, a_pThis, a_error, a_pThis ) )
+                     {
+                        // EOF or error, same as HUP
+                        closeSocket_( a_onSocketEvent, a_pThis, 0 );
+                     }
+                  } else if( nullptr != a_onSocketEvent )
+                  {
+                     const LatencyTimer timer( callbackHistogram() );
+                     a_onSocketEvent( fd, network::callBack_t::MESSAGE, a_pThis );
+                  } else
+                  {
+                     a_error( 0, "no callback event:", nullptr );
+                  }
+               } else if( 0 == (m_pEvents[lIndex].events & EPOLLOUT) )
+               {
+                  if( nullptr != a_error )
+                  {
+                     a_error( 0, "unhandled socket event", nullptr );
+                  }
+               }
+            }
+      }
+   }
+
+   stopSendQueue_();
+   m_connector.cancel();
+   ::close( m_fdSocket );
+   ::close( m_fdEpoll );
+   //sem_post( &m_semReconnect );
+   //cout << " end sock startAsync" << endl;
+   return true;
+}
+
+
+
+/**
+ * @brief ...IO_URING, arm the read of the socket: multishot recv with a message callback, else multishot poll.  called
+ * with m_muxSend held
+ *
+ */
+void network::ClientAsync::armRead_()
+{
+   if( nullptr != m_cbMessage )
+   {
+      m_ring.prepRecvMultishot( m_fdSocket, uringData( uringOp_t::RECV, m_nGeneration, m_fdSocket ) );
+   } else
+   {
+      m_ring.prepPollMultishot( m_fdSocket, POLLIN | POLLRDHUP, uringData( uringOp_t::POLL, m_nGeneration, m_fdSocket ) );
+   }
+}
+
+
+
+/**
+ * @brief ...receiver thread, connection gone.  end the armed requests (IO_URING), close, call back SESSION_CLOSE and
+ * schedule the reconnect
+ *
+ * @param a_onSocketEvent ...
+ * @param a_pThis ...
+ * @param a_nError ...errno of the lost connection, 0 closed by the server
+ */
+void network::ClientAsync::closeSocket_( const socketCallback_t a_onSocketEvent, void* const a_pThis, const int32_t a_nError )
+{
+   const socketfd_t fd = m_fdSocket;
+   stopSendQueue_();
+   {
+      lock_guard<std::mutex> lock( m_muxSend );
+      if( engine_t::IO_URING == m_engine )
+      {
+         m_ring.prepCancel( uringData( (nullptr != m_cbMessage) ? uringOp_t::RECV : uringOp_t::POLL, m_nGeneration, fd ), uringData( uringOp_t::CANCEL, 0, fd ) );
+         ++m_nGeneration;
+         m_ring.submit();
+      }
+      m_fdSocket = -1;    // send fails until reconnected instead of writing to a reused fd
+      m_nPostTag.store( 0, std::memory_order_release );
+   }
+   if( engine_t::IO_URING == m_engine )
+   {
+      ::shutdown( fd, SHUT_RDWR );
+   }
+   ::close( fd );
+   if( nullptr != a_onSocketEvent )
+   {
+      a_onSocketEvent( fd, network::callBack_t::SESSION_CLOSE, a_pThis );
+   }
+   m_recvBuffer.reset();
+   scheduleRetry_( a_nError );
+}
+
+
+
+/**
+ * @brief ...receiver thread with the IO_URING engine, same callbacks as the epoll loop in startAsync_.  the read stays
+ * armed in the kernel and received bytes arrive in the provided buffers of the ring
+ *
  * @param a_onSocketEvent ...
  * @param a_error ...
  * @param a_pThis ...
  * @return bool
  */
-bool network::ClientAsync::startAsync_( const network::socketCallback_t a_onSocketEvent, const errorCallBack_t a_error, void* const a_pThis )
+bool network::ClientAsync::uringLoop_( const socketCallback_t a_onSocketEvent, const errorCallBack_t a_error, void* const a_pThis )
+{
+   if( (false == m_ring.init( s_nUringClientEntries )) ||
+       ((nullptr != m_cbMessage) && ((false == m_ring.setupBuffers( 0, s_nUringClientBufferCount, s_nUringBufferSize )) || (false == m_recvBuffer.allocate( m_nReceiveBufferSize )))) )
+   {
+      if( nullptr != a_error )
+      {
+         a_error( errno, strerror( errno ), a_pThis );
+      }
+      m_ring.release();
+      return false;
+   }
+
+   makeNonBlocking( m_fdSocket );
+   {
+      lock_guard<std::mutex> lock( m_muxSend );
+      armRead_();
+      if( 0 <= m_nEpollTimeout_ms )
+      {
+         m_ring.prepTimeout( m_nEpollTimeout_ms, uringData( uringOp_t::TIMEOUT, 0, 0 ) );
+      }
+      m_ring.prepPollMultishot( m_posted.fd(), POLLIN, uringData( uringOp_t::WAKE, 0, m_posted.fd() ) );
+      m_ring.prepPollMultishot( m_timers.fd(), POLLIN, uringData( uringOp_t::TIMER, 0, m_timers.fd() ) );
+      m_ring.submit();
+      m_bSendQueueReady = true;
+   }
+   m_state = sessionState_t::OPEN;
+
+   bool bNotified = false;
+   m_posted.wake();    // the first wait returns at once to notify waitready
+   while( m_bAsyncRunFlag )
+   {
+      m_metrics.waiting();
+      const int32_t nWait = m_ring.wait();
+      if( false == bNotified )
+      {
+         // notify that connection is ready
+         m_cvReady.notify_one();
+         bNotified = true;
+      }
+      if( -1 == nWait )
+      {
+         if( (EINTR == errno) || (EAGAIN == errno) || (EBUSY == errno) )
+         {
+            continue;
+         }
+         if( nullptr != a_error )
+         {
+            string str( "io_uring error: " );
+            str.append( strerror( errno ) );
+            a_error( errno, str.c_str(), nullptr );
+         }
+         m_bAsyncRunFlag = false;
+         continue;
+      }
+
+      m_metrics.wakeup( 0 );
+      io_uring_cqe* pCqe;
+      while( nullptr != (pCqe = m_ring.peekCqe()) )
+      {
+         const uint64_t nUserData = pCqe->user_data;
+         const int32_t  nResult   = pCqe->res;
+         const uint32_t nFlags    = pCqe->flags;
+         m_ring.cqeSeen();
+         m_metrics.add( metric_t::EVENTS );
+
+         // completions of a socket closed since are dropped
+         bool bCurrent = ((m_nGeneration & 0xFFFFFF) == uringGeneration( nUserData ));
+         switch( uringOp( nUserData ) )
+         {
+            case uringOp_t::RECV:
+               if( nFlags & IORING_CQE_F_BUFFER )
+               {
+                  const uint16_t nBufferId = static_cast<uint16_t>( nFlags >> IORING_CQE_BUFFER_SHIFT );
+                  if( (true == bCurrent) && (nResult > 0) &&
+                      (false == deliverReceived( m_recvBuffer, m_framing, m_fdSocket, m_ring.buffer( nBufferId ), static_cast<size_t>( nResult ), m_cbMessage, a_pThis, a_error, a_pThis )) )
+                  {
+                     closeSocket_( a_onSocketEvent, a_pThis, 0 );
+                     bCurrent = false;
+                  }
+                  m_ring.recycleBuffer( nBufferId );
+               }
+               if( false == bCurrent )
+               {
+                  break;
+               }
+               if( (0 == nResult) || ((nResult < 0) && (-ENOBUFS != nResult)) )
+               {
+                  // HUP or error
+                  if( (nResult < 0) && (-ECANCELED != nResult) && (nullptr != a_error) )
+                  {
+                     a_error( -nResult, strerror( -nResult ), a_pThis );
+                  }
+                  closeSocket_( a_onSocketEvent, a_pThis, (nResult < 0) ? -nResult : 0 );
+               } else if( 0 == (nFlags & IORING_CQE_F_MORE) )
+               {
+                  lock_guard<std::mutex> lock( m_muxSend );
+                  armRead_();
+               }
+               break;
+
+            case uringOp_t::POLL:
+               if( false == bCurrent )
+               {
+                  break;
+               }
+               if( (nResult < 0) || (nResult & (POLLRDHUP | POLLHUP | POLLERR)) )
+               {
+                  closeSocket_( a_onSocketEvent, a_pThis, (nResult < 0) ? -nResult : 0 );
+                  break;
+               }
+               if( nResult & POLLIN )
+               {
+                  if( nullptr != a_onSocketEvent )
+                  {
+                     const LatencyTimer timer( callbackHistogram() );
+                     a_onSocketEvent( m_fdSocket, network::callBack_t::MESSAGE, a_pThis );
+                  } else if( nullptr != a_error )
+                  {
+                     a_error( 0, "no callback event:", nullptr );
+                  }
+               }
+               if( (0 == (nFlags & IORING_CQE_F_MORE)) && ((m_nGeneration & 0xFFFFFF) == uringGeneration( nUserData )) )
+               {
+                  lock_guard<std::mutex> lock( m_muxSend );
+                  armRead_();
+               }
+               break;
+
+            case uringOp_t::WRITABLE:
+               // socket writable again, drain the outbound queue
+               if( (true == bCurrent) && (false == flush_()) && (nullptr != a_error) )
+               {
+                  a_error( errno, strerror( errno ), a_pThis );
+               }
+               break;
+
+            case uringOp_t::CONNECT:
+               // a reconnect, the socket is writable or in error
+               if( (true == bCurrent) && (uringFd( nUserData ) == m_fdConnectPoll) )
+               {
+                  m_fdConnectPoll = -1;
+                  connecting_( m_connector.writable() );
+               }
+               break;
+
+            case uringOp_t::TIMEOUT:
+               if( true == m_bAsyncRunFlag )
+               {
+                  lock_guard<std::mutex> lock( m_muxSend );
+                  m_ring.prepTimeout( m_nEpollTimeout_ms, uringData( uringOp_t::TIMEOUT, 0, 0 ) );
+               }
+               break;
+
+            case uringOp_t::WAKE:
+               drainPosted_( a_error, a_pThis );
+               if( (0 == (nFlags & IORING_CQE_F_MORE)) && (true == m_bAsyncRunFlag) )
+               {
+                  lock_guard<std::mutex> lock( m_muxSend );
+                  m_ring.prepPollMultishot( m_posted.fd(), POLLIN, uringData( uringOp_t::WAKE, 0, m_posted.fd() ) );
+               }
+               break;
+
+            case uringOp_t::TIMER:
+               m_timers.expire();
+               if( (0 == (nFlags & IORING_CQE_F_MORE)) && (true == m_bAsyncRunFlag) )
+               {
+                  lock_guard<std::mutex> lock( m_muxSend );
+                  m_ring.prepPollMultishot( m_timers.fd(), POLLIN, uringData( uringOp_t::TIMER, 0, m_timers.fd() ) );
+               }
+               break;
+
+            default:
+               break;
+         }
+      }
+      {
+         lock_guard<std::mutex> lock( m_muxSend );
+         m_ring.submit();
+      }
+   }
+
+   stopSendQueue_();
+   m_connector.cancel();
+   ::close( m_fdSocket );
+   m_ring.release();
+   return true;
+}
+
+
+
+static thread_local uint64_t t_nRetrySeed = 0;     // xorshift state of the reconnect jitter
+
+/**
+ * @brief ...wait before a reconnect.  a_nWait_ms doubled per failed attempt up to a_nMaxWait_ms, of which a random part
+ * up to half is dropped (equal jitter): clients that lost the server together spread their attempts instead of coming
+ * back in lock step, and none retries sooner than half the backoff
+ *
+ * @param a_nAttempt ...failed attempts since the connection was lost
+ * @param a_nWait_ms ...
+ * @param a_nMaxWait_ms ...at least a_nWait_ms
+ * @return uint32_t ms
+ */
+static uint32_t retryWait( const uint32_t a_nAttempt, const uint32_t a_nWait_ms, const uint32_t a_nMaxWait_ms )
+{
+   const uint64_t nMaxWait_ms = (a_nMaxWait_ms > a_nWait_ms) ? a_nMaxWait_ms : a_nWait_ms;
+   uint64_t       nWait_ms    = a_nWait_ms;
+   for( uint32_t nAttempt=0; (nAttempt<a_nAttempt) && (nWait_ms < nMaxWait_ms); ++nAttempt )
+   {
+      nWait_ms <<= 1;
+   }
+   if( nWait_ms > nMaxWait_ms )
+   {
+      nWait_ms = nMaxWait_ms;
+   }
+   if( 0 == t_nRetrySeed )
+   {
+      t_nRetrySeed = network::Connector::now_ns() ^ reinterpret_cast<uintptr_t>( &t_nRetrySeed );
+      t_nRetrySeed |= 1;
+   }
+   t_nRetrySeed ^= t_nRetrySeed << 13;
+   t_nRetrySeed ^= t_nRetrySeed >> 7;
+   t_nRetrySeed ^= t_nRetrySeed << 17;
+   const uint64_t nHalf = nWait_ms / 2;
+   return static_cast<uint32_t>( nWait_ms - nHalf + t_nRetrySeed % (nHalf + 1) );
+}
+
+
+
+/**
+ * @brief ...reconnect the lost connection, see setReconnect.  never blocks, the receiver thread waits and connects.
+ * a_cbLog is called back on the receiver thread with a line per attempt
+ * 
+ * @param a_nRetryCount ...attempts, -1 without end
+ * @param a_nRetryWait ...s before the first attempt, doubled per failed one
+ * @param a_cbLog ...
+ * @return bool false if retry is disabled (a zero argument), else the reconnect is scheduled
+ */
+bool network::ClientAsync::reconnect( const int32_t a_nRetryCount, const int32_t a_nRetryWait, logCallBack_t a_cbLog )
+{
+   if( (a_nRetryCount == 0) || (a_nRetryWait <= 0) )
+   {
+      if( nullptr != a_cbLog )
+      {
+         stringstream sstr;
+         sstr << "retry disabled at least one retry var is zero. MddReconnectRetryCount:" << a_nRetryCount << ", MddReconnectWait:" << a_nRetryWait;
+         a_cbLog( network::LogLevel::EERR, sstr.str().c_str() );
+      }
+      return false;
+   }
+   m_cbReconnectLog = a_cbLog;
+   const uint32_t nWait_ms = static_cast<uint32_t>( a_nRetryWait ) * 1000;
+   setReconnect( a_nRetryCount, nWait_ms, (nWait_ms > 30000) ? nWait_ms : 30000 );
+   return true;
+}
+
+
+
+/**
+ * @brief ...any thread.  reconnect a lost connection from the receiver thread with capped exponential backoff and
+ * jitter.  if the connection is down already the reconnect starts
+ *
+ * @param a_nRetryCount ...attempts per loss, -1 without end, 0 no reconnect
+ * @param a_nWait_ms ...before the first attempt, doubled per failed one
+ * @param a_nMaxWait_ms ...cap of the doubling
+ */
+void network::ClientAsync::setReconnect( const int32_t a_nRetryCount, const uint32_t a_nWait_ms, const uint32_t a_nMaxWait_ms )
+{
+   {
+      lock_guard<std::mutex> lock( m_muxSend );
+      m_nRetryCount      = a_nRetryCount;
+      m_nRetryWait_ms    = (0 != a_nWait_ms) ? a_nWait_ms : 1;
+      m_nRetryMaxWait_ms = (a_nMaxWait_ms > m_nRetryWait_ms) ? a_nMaxWait_ms : m_nRetryWait_ms;
+   }
+   m_bRetriesChanged = true;
+   m_posted.wake();
+}
+
+
+
+/**
+ * @brief ...receiver thread, setReconnect was called.  the retries start over, a connection already down is reconnected
+ *
+ */
+void network::ClientAsync::applyRetries_()
+{
+   {
+      lock_guard<std::mutex> lock( m_muxSend );
+      m_nRetriesLeft = m_nRetryCount;
+   }
+   m_nRetryAttempt = 0;
+   if( sessionState_t::CLOSED == m_state )
+   {
+      scheduleRetry_( 0 );
+   }
+}
+
+
+
+/**
+ * @brief ...receiver thread, the connection is down or a connect failed.  with retries left the next attempt is
+ * scheduled after the backoff, else the connection stays CLOSED
+ *
+ * @param a_nError ...errno of the loss or the failed connect, 0 none
+ */
+void network::ClientAsync::scheduleRetry_( const int32_t a_nError )
+{
+   uint32_t nWait_ms    = 0;
+   uint32_t nMaxWait_ms = 0;
+   bool     bRetries    = false;
+   {
+      lock_guard<std::mutex> lock( m_muxSend );
+      nWait_ms    = m_nRetryWait_ms;
+      nMaxWait_ms = m_nRetryMaxWait_ms;
+      bRetries    = (0 != m_nRetryCount);
+   }
+   if( (0 == m_nRetriesLeft) || (protocol_t::UDP == m_protocol) || (nullptr == m_pszHostname) || (false == m_bAsyncRunFlag) )
+   {
+      if( (true == bRetries) && (true == m_bAsyncRunFlag) )
+      {
+         log_( network::LogLevel::EERR, "reconnect failed" );
+      }
+      setState_( sessionState_t::CLOSED, a_nError );
+      return;
+   }
+   if( m_nRetriesLeft > 0 )
+   {
+      --m_nRetriesLeft;
+   }
+   m_nRetryTimer = m_timers.add( -1, retryWait( m_nRetryAttempt++, nWait_ms, nMaxWait_ms ), 0, &ClientAsync::retry_, this );
+   if( 0 == m_nRetryTimer )
+   {
+      if( nullptr != m_cbError )
+      {
+         m_cbError( errno, strerror( errno ), m_pCallbackData );
+      }
+      setState_( sessionState_t::CLOSED, a_nError );
+      return;
+   }
+   // looked up in the background while waiting, the connect finds the host cached
+   Resolver::prewarm( m_pszHostname, m_szPort, m_nSocketFamily, m_nSocketType );
+   setState_( sessionState_t::RETRY_WAIT, a_nError );
+}
+
+
+
+/**
+ * @brief ...timer of the receiver thread, the wait before a reconnect is over
+ *
+ * @param a_pData ...the client
+ */
+void network::ClientAsync::retry_( const int32_t&, const uint64_t, void* const a_pData )
+{
+   ClientAsync* pThis = static_cast<ClientAsync*>( a_pData );
+   pThis->m_nRetryTimer = 0;
+   pThis->connect_();
+}
+
+
+
+/**
+ * @brief ...timer of the receiver thread, the deadline of the connect attempt passed
+ *
+ * @param a_pData ...the client
+ */
+void network::ClientAsync::expired_( const int32_t&, const uint64_t, void* const a_pData )
+{
+   ClientAsync* pThis = static_cast<ClientAsync*>( a_pData );
+   pThis->m_nRetryTimer = 0;
+   if( 0 != pThis->m_nLookup )
+   {
+      // the lookup hangs, its result is dropped when it comes
+      pThis->m_nLookup = 0;
+      pThis->failed_( ETIMEDOUT );
+      return;
+   }
+   pThis->connecting_( pThis->m_connector.expired() );
+}
+
+
+
+/**
+ * @brief ...receiver thread, start the non-blocking connect of a reconnect.  a host not cached is resolved by the
+ * Resolver pool first, the connect starts when drainPosted_ picks up the addresses
+ *
+ */
+void network::ClientAsync::connect_()
+{
+   setState_( sessionState_t::CONNECTING, 0 );
+   m_nConnect_ns = Connector::now_ns();
+   std::vector<address_t> vecAddresses;
+   if( true == Resolver::cached( m_pszHostname, m_szPort, m_nSocketFamily, m_nSocketType, vecAddresses ) )
+   {
+      connecting_( m_connector.start( vecAddresses, m_nConnectAttempt_ms, m_nConnectTimeout_ms ) );
+      return;
+   }
+   {
+      lock_guard<std::mutex> lock( m_pResolving->mux );
+      m_pResolving->pOwner = this;
+   }
+   lookup_t* pLookup   = new lookup_t();
+   pLookup->pResolving = m_pResolving;
+   pLookup->nLookup    = ++m_nLookups;
+   m_nLookup           = pLookup->nLookup;
+   if( false == Resolver::resolveAsync( m_pszHostname, m_szPort, m_nSocketFamily, m_nSocketType, &ClientAsync::lookedUp_, pLookup ) )
+   {
+      const int32_t nError = errno;
+      delete pLookup;
+      m_nLookup = 0;
+      failed_( nError );
+      return;
+   }
+   if( 0 != m_nConnectTimeout_ms )
+   {
+      // a lookup that hangs is given up at the deadline of the connect
+      m_nRetryTimer = m_timers.add( -1, m_nConnectTimeout_ms, 0, &ClientAsync::expired_, this );
+   }
+}
+
+
+
+/**
+ * @brief ...resolver thread (or the calling thread of a cached host), leave the addresses for the receiver thread and
+ * wake it
+ *
+ * @param a_nError ...0 or the errno of the lookup
+ * @param a_vecAddresses ...
+ * @param a_pData ...lookup_t, deleted here
+ */
+void network::ClientAsync::lookedUp_( const int32_t a_nError, const std::vector<address_t>& a_vecAddresses, void* const a_pData )
+{
+   lookup_t* pLookup = static_cast<lookup_t*>( a_pData );
+   {
+      lock_guard<std::mutex> lock( pLookup->pResolving->mux );
+      ClientAsync* pOwner = pLookup->pResolving->pOwner;
+      // a lookup given up may end after the next one, the ids grow
+      if( (nullptr != pOwner) && (pLookup->nLookup > pLookup->pResolving->nLookup) )
+      {
+         pLookup->pResolving->nLookup      = pLookup->nLookup;
+         pLookup->pResolving->nError       = a_nError;
+         pLookup->pResolving->vecAddresses = a_vecAddresses;
+         pOwner->m_posted.wake();
+      }
+   }
+   delete pLookup;
+}
+
+
+
+/**
+ * @brief ...receiver thread, the host of the reconnect is resolved, connect to it.  nothing yet, or the result of a
+ * lookup given up, is left alone
+ *
+ */
+void network::ClientAsync::resolved_()
+{
+   int32_t                nError = 0;
+   std::vector<address_t> vecAddresses;
+   {
+      lock_guard<std::mutex> lock( m_pResolving->mux );
+      if( m_nLookup != m_pResolving->nLookup )
+      {
+         return;
+      }
+      nError = m_pResolving->nError;
+      vecAddresses.swap( m_pResolving->vecAddresses );
+   }
+   m_nLookup = 0;
+   if( 0 != m_nRetryTimer )
+   {
+      m_timers.cancel( m_nRetryTimer );
+      m_nRetryTimer = 0;
+   }
+   if( 0 != nError )
+   {
+      failed_( nError );
+      return;
+   }
+   uint32_t nTimeout_ms = m_nConnectTimeout_ms;
+   if( 0 != nTimeout_ms )
+   {
+      const uint64_t nSpent_ms = (Connector::now_ns() - m_nConnect_ns) / 1000000;
+      if( nSpent_ms >= nTimeout_ms )
+      {
+         failed_( ETIMEDOUT );
+         return;
+      }
+      nTimeout_ms -= static_cast<uint32_t>( nSpent_ms );
+   }
+   connecting_( m_connector.start( vecAddresses, m_nConnectAttempt_ms, nTimeout_ms ) );
+}
+
+
+
+/**
+ * @brief ...receiver thread, a step of the connect.  in progress its socket waits for writable (EPOLLOUT or a POLLOUT on
+ * the ring) and the deadline is armed.  done, the socket replaces the lost one or the next attempt is scheduled
+ *
+ * @param a_status ...of the connector
+ */
+void network::ClientAsync::connecting_( const connectStatus_t a_status )
+{
+   if( 0 != m_nRetryTimer )
+   {
+      m_timers.cancel( m_nRetryTimer );
+      m_nRetryTimer = 0;
+   }
+   const socketfd_t fd = m_connector.fd();
+   if( -1 != m_fdConnectPoll )
+   {
+      // POLLOUT of an attempt given up, its socket is closed.  the generation keeps its completion from the next one
+      lock_guard<std::mutex> lock( m_muxSend );
+      m_ring.prepCancel( uringData( uringOp_t::CONNECT, m_nGeneration, m_fdConnectPoll ), uringData( uringOp_t::CANCEL, 0, m_fdConnectPoll ) );
+      ++m_nGeneration;
+      m_ring.submit();
+      m_fdConnectPoll = -1;
+   }
+   if( connectStatus_t::IN_PROGRESS == a_status )
+   {
+      if( engine_t::IO_URING == m_engine )
+      {
+         lock_guard<std::mutex> lock( m_muxSend );
+         m_ring.prepPoll( fd, POLLOUT, uringData( uringOp_t::CONNECT, m_nGeneration, fd ) );
+         m_ring.submit();
+         m_fdConnectPoll = fd;
+      } else
+      {
+         epoll_event epEvent;
+         epEvent.data.fd = fd;
+         epEvent.events  = EPOLLOUT;
+         if( (-1 == epoll_ctl( m_fdEpoll, EPOLL_CTL_ADD, fd, &epEvent )) && (EEXIST != errno) )
+         {
+            const int32_t nError = errno;
+            m_connector.cancel();
+            if( nullptr != m_cbError )
+            {
+               m_cbError( nError, strerror( nError ), m_pCallbackData );
+            }
+            scheduleRetry_( nError );
+            return;
+         }
+      }
+      if( 0 != m_connector.deadline_ns() )
+      {
+         const uint64_t nNow_ns  = Connector::now_ns();
+         const uint64_t nWait_ms = (m_connector.deadline_ns() > nNow_ns) ? (m_connector.deadline_ns() - nNow_ns + 999999) / 1000000 : 0;
+         m_nRetryTimer = m_timers.add( -1, static_cast<uint32_t>( nWait_ms ), 0, &ClientAsync::expired_, this );
+      }
+      return;
+   }
+   if( connectStatus_t::CONNECTED == a_status )
+   {
+      opened_( m_connector.release() );
+      return;
+   }
+   failed_( m_connector.error() );
+}
+
+
+
+/**
+ * @brief ...receiver thread, the connect or the lookup before it failed, report it and schedule the next attempt
+ *
+ * @param a_nError ...errno of the failure
+ */
+void network::ClientAsync::failed_( const int32_t a_nError )
+{
+   if( nullptr != m_cbError )
+   {
+      string str( "reconnect to " );
+      str.append( m_pszHostname ).append( ":" ).append( m_szPort ).append( " failed: " ).append( strerror( a_nError ) );
+      m_cbError( a_nError, str.c_str(), m_pCallbackData );
+   }
+   log_( network::LogLevel::EWRN, "connection failed" );
+   scheduleRetry_( a_nError );
+}
+
+
+
+/**
+ * @brief ...receiver thread, a reconnect connected.  the socket is read (epoll set or ring) and the send queue reopened
+ *
+ * @param a_fd ...connected socket, non-blocking
+ */
+void network::ClientAsync::opened_( const socketfd_t a_fd )
+{
+   if( engine_t::EPOLL == m_engine )
+   {
+      epoll_event epEvent;
+      epEvent.data.fd = a_fd;
+      epEvent.events  = socketEvents_( false );
+      // registered for EPOLLOUT while connecting, unless it connected at once
+      if( (-1 == epoll_ctl( m_fdEpoll, EPOLL_CTL_MOD, a_fd, &epEvent )) && ((ENOENT != errno) || (-1 == epoll_ctl( m_fdEpoll, EPOLL_CTL_ADD, a_fd, &epEvent ))) )
+      {
+         const int32_t nError = errno;
+         ::close( a_fd );
+         if( nullptr != m_cbError )
+         {
+            m_cbError( nError, strerror( nError ), m_pCallbackData );
+         }
+         scheduleRetry_( nError );
+         return;
+      }
+   }
+   if( (false == BusyPoll::tune( a_fd, m_nBusyPoll_us )) && (nullptr != m_cbError) )
+   {
+      string str( "SO_BUSY_POLL not set: " );
+      str.append( strerror( errno ) );
+      m_cbError( errno, str.c_str(), m_pCallbackData );
+   }
+   {
+      lock_guard<std::mutex> lock( m_muxSend );
+      m_fdSocket = a_fd;
+      m_nPostTag.store( ++m_nConnections, std::memory_order_release );
+      if( engine_t::IO_URING == m_engine )
+      {
+         armRead_();
+         m_ring.submit();
+      }
+      m_bSendQueueReady = true;
+      m_nRetriesLeft    = m_nRetryCount;
+   }
+   m_nRetryAttempt = 0;
+   log_( network::LogLevel::EINF, "connection succeeded" );
+   setState_( sessionState_t::OPEN, 0 );
+}
+
+
+
+/**
+ * @brief ...receiver thread, the connection changed state, call back
+ *
+ * @param a_state ...
+ * @param a_nError ...errno of the loss or the failed connect, 0 none
+ */
+void network::ClientAsync::setState_( const sessionState_t a_state, const int32_t a_nError )
+{
+   m_state = a_state;
+   if( nullptr != m_cbState )
+   {
+      const LatencyTimer timer( callbackHistogram() );
+      m_cbState( a_state, a_nError, m_pCallbackData );
+   }
+}
+
+
+
+/**
+ * @brief ...reconnect log line, to the log callback of reconnect if set, else to AsyncLog
+ *
+ * @param a_level ...
+ * @param a_pszLine ...a string literal
+ */
+void network::ClientAsync::log_( const LogLevel a_level, const char* a_pszLine ) const
+{
+   const logCallBack_t cbLog = m_cbReconnectLog;
+   if( nullptr != cbLog )
+   {
+      cbLog( a_level, a_pszLine );
+   } else
+   {
+      AsyncLog::writeError( a_level, 0, "%s:%s %s", m_pszHostname, m_szPort, a_pszLine );
+   }
+}
+
+
+
+
+
+// multi-connection async client
+//
+
+
+/**
+ * @brief ...stop the receiver thread, the open sessions get SESSION_CLOSE
+ *
+ */
+network::MultiClientAsync::~MultiClientAsync()
+{
+   {
+      // a resolve still in flight calls back into nothing
+      lock_guard<std::mutex> lock( m_pResolving->mux );
+      m_pResolving->pOwner = nullptr;
+   }
+   stop();
+   join();
+}
+
+
+
+/**
+ * @brief ...how the streams are cut into messages for the message callbacks
+ *
+ * @param a_type ...NONE, LENGTH_PREFIX, DELIMITER or FIXED
+ * @param a_nValue ...LENGTH_PREFIX header size 1,2,4 (default 4), DELIMITER delimiter byte, FIXED message size
+ */
+void network::MultiClientAsync::setFraming( const framing_t a_type, const uint32_t a_nValue )
+{
+   m_framing = makeFraming( a_type, a_nValue );
+}
+
+
+
+/**
+ * @brief ...queue a session for the receiver thread, which connects it.  any thread
+ *
+ * @param a_config ...host, port, callbacks, context and reconnect
+ * @return int32_t session id, -1 errno EINVAL without a callback, ENOSPC all slots in use
+ */
+int32_t network::MultiClientAsync::add( const sessionConfig_t& a_config )
+{
+   if( (nullptr == a_config.cbSocket) && (nullptr == a_config.cbMessage) )
+   {
+      errno = EINVAL;
+      return -1;
+   }
+   command_t command;
+   command.type   = commandType_t::ADD;
+   command.config = a_config;
+   {
+      lock_guard<std::mutex> lock( m_muxCommands );
+      if( false == m_vecFreeIds.empty() )
+      {
+         // the slot of a removed session under the next generation, the old id stays invalid
+         const int32_t nOld         = m_vecFreeIds.back();
+         const int32_t nGeneration  = ((nOld >> s_nSlotBits) + 1) & (INT32_MAX >> s_nSlotBits);
+         command.nSession = (nGeneration << s_nSlotBits) | (nOld & s_nSlotMask);
+         m_vecFreeIds.pop_back();
+      } else if( m_nNextId <= s_nSlotMask )
+      {
+         command.nSession = m_nNextId++;
+      } else
+      {
+         errno = ENOSPC;
+         return -1;
+      }
+      m_vecCommands.push_back( command );
+   }
+   m_posted.wake();
+   return command.nSession;
+}
+
+
+
+/**
+ * @brief ...queue the removal of a session, the receiver thread closes and drops it.  any thread
+ *
+ * @param a_nSession ...id from add
+ * @return bool false, errno EINVAL if the id was never returned by add
+ */
+bool network::MultiClientAsync::remove( const int32_t a_nSession )
+{
+   command_t command;
+   command.nSession = a_nSession;
+   {
+      lock_guard<std::mutex> lock( m_muxCommands );
+      if( (a_nSession < 0) || (slot_( a_nSession ) >= static_cast<size_t>( m_nNextId )) )
+      {
+         errno = EINVAL;
+         return false;
+      }
+      m_vecCommands.push_back( command );
+   }
+   m_posted.wake();
+   return true;
+}
+
+
+
+/**
+ * @brief ...receiver thread, the adds, removes and resolved hosts queued since the last call, in order
+ *
+ */
+void network::MultiClientAsync::applyCommands_()
+{
+   std::vector<command_t> vecCommands;
+   {
+      lock_guard<std::mutex> lock( m_muxCommands );
+      vecCommands.swap( m_vecCommands );
+   }
+   for( command_t& command : vecCommands )
+   {
+      if( commandType_t::REMOVE == command.type )
+      {
+         removeSession_( command.nSession );
+         continue;
+      }
+      if( commandType_t::RESOLVED == command.type )
+      {
+         resolved_( command );
+         continue;
+      }
+      const size_t nSession = slot_( command.nSession );
+      if( nSession >= m_vecSessions.size() )
+      {
+         m_vecSessions.resize( nSession + 1 );
+      }
+      m_vecSessions[nSession].reset( new session_t() );
+      session_t& session   = *m_vecSessions[nSession];
+      session.config       = std::move( command.config );
+      session.pOwner       = this;
+      session.nId          = command.nSession;
+      session.nRetriesLeft = session.config.nRetryCount;
+      connect_( session );
+   }
+}
+
+
+
+/**
+ * @brief ...receiver thread, close a session, cancel its reconnect and free the id
+ *
+ * @param a_nSession ...
+ */
+void network::MultiClientAsync::removeSession_( const int32_t a_nSession )
+{
+   session_t* pSession = find_( a_nSession );
+   if( nullptr == pSession )
+   {
+      return;     // removed already, the slot may hold a later session
+   }
+   close_( *pSession, false );
+   m_vecSessions[slot_( a_nSession )].reset();
+   lock_guard<std::mutex> lock( m_muxCommands );
+   m_vecFreeIds.push_back( a_nSession );
+}
+
+
+
+/**
+ * @brief ...receiver thread, start the non-blocking connect of a session.  a host not cached is resolved by the Resolver
+ * pool first, the connect starts when the RESOLVED command comes back
+ *
+ * @param a_session ...
+ */
+void network::MultiClientAsync::connect_( session_t& a_session )
+{
+   a_session.state       = sessionState_t::CONNECTING;
+   a_session.nConnect_ns = Connector::now_ns();
+   std::vector<address_t> vecAddresses;
+   if( true == Resolver::cached( a_session.config.strHost, a_session.config.strPort, a_session.config.nFamily, SOCK_STREAM, vecAddresses ) )
+   {
+      connecting_( a_session, a_session.connector.start( vecAddresses, a_session.config.nConnectAttempt_ms, a_session.config.nConnectTimeout_ms ) );
+      return;
+   }
+   lookup_t* pLookup   = new lookup_t();
+   pLookup->pResolving = m_pResolving;
+   pLookup->nSession   = a_session.nId;
+   pLookup->nLookup    = ++m_nLookup;
+   a_session.nLookup   = pLookup->nLookup;
+   if( false == Resolver::resolveAsync( a_session.config.strHost, a_session.config.strPort, a_session.config.nFamily, SOCK_STREAM, &MultiClientAsync::lookedUp_, pLookup ) )
+   {
+      const int32_t nError = errno;
+      delete pLookup;
+      a_session.nLookup = 0;
+      failed_( a_session, nError );
+      return;
+   }
+   if( 0 != a_session.config.nConnectTimeout_ms )
+   {
+      // a lookup that hangs is given up at the deadline of the connect
+      a_session.nTimer = m_timers.add( -1, a_session.config.nConnectTimeout_ms, 0, &MultiClientAsync::expired_, &a_session );
+   }
+}
+
+
+
+/**
+ * @brief ...resolver thread (or the calling thread of a cached host), hand the addresses to the receiver thread
+ *
+ * @param a_nError ...0 or the errno of the lookup
+ * @param a_vecAddresses ...
+ * @param a_pData ...lookup_t, deleted here
+ */
+void network::MultiClientAsync::lookedUp_( const int32_t a_nError, const std::vector<address_t>& a_vecAddresses, void* const a_pData )
+{
+   lookup_t* pLookup = static_cast<lookup_t*>( a_pData );
+   {
+      lock_guard<std::mutex> lock( pLookup->pResolving->mux );
+      MultiClientAsync* pOwner = pLookup->pResolving->pOwner;
+      if( nullptr != pOwner )
+      {
+         command_t command;
+         command.type         = commandType_t::RESOLVED;
+         command.nSession     = pLookup->nSession;
+         command.nLookup      = pLookup->nLookup;
+         command.nError       = a_nError;
+         command.vecAddresses = a_vecAddresses;
+         {
+            lock_guard<std::mutex> lockCommands( pOwner->m_muxCommands );
+            pOwner->m_vecCommands.push_back( std::move( command ) );
+         }
+         pOwner->m_posted.wake();
+      }
+   }
+   delete pLookup;
+}
+
+
+
+/**
+ * @brief ...receiver thread, the host of a session is resolved, connect to it.  dropped when the session was closed or
+ * removed meanwhile
+ *
+ * @param a_command ...RESOLVED
+ */
+void network::MultiClientAsync::resolved_( const command_t& a_command )
+{
+   session_t* pSession = find_( a_command.nSession );
+   if( nullptr == pSession )
+   {
+      return;
+   }
+   session_t& session = *pSession;
+   if( (sessionState_t::CONNECTING != session.state) || (a_command.nLookup != session.nLookup) )
+   {
+      return;
+   }
+   session.nLookup = 0;
+   if( 0 != a_command.nError )
+   {
+      failed_( session, a_command.nError );
+      return;
+   }
+   uint32_t nTimeout_ms = session.config.nConnectTimeout_ms;
+   if( 0 != nTimeout_ms )
+   {
+      const uint64_t nSpent_ms = (Connector::now_ns() - session.nConnect_ns) / 1000000;
+      if( nSpent_ms >= nTimeout_ms )
+      {
+         failed_( session, ETIMEDOUT );
+         return;
+      }
+      nTimeout_ms -= static_cast<uint32_t>( nSpent_ms );
+   }
+   connecting_( session, session.connector.start( a_command.vecAddresses, session.config.nConnectAttempt_ms, nTimeout_ms ) );
+}
+
+
+
+/**
+ * @brief ...receiver thread, a step of the connect of a session.  in progress its socket waits for EPOLLOUT and the
+ * deadline is armed, a new socket when the next address is tried.  done, cbConnect is called back and the session is
+ * opened, or closed to be retried
+ *
+ * @param a_session ...
+ * @param a_status ...of the connector
+ */
+void network::MultiClientAsync::connecting_( session_t& a_session, const connectStatus_t a_status )
+{
+   if( 0 != a_session.nTimer )
+   {
+      m_timers.cancel( a_session.nTimer );
+      a_session.nTimer = 0;
+   }
+   const socketfd_t fd = a_session.connector.fd();
+   if( (-1 != a_session.fd) && (fd != a_session.fd) )
+   {
+      // socket of a failed attempt, closed by the connector
+      m_vecFdSessions[static_cast<size_t>( a_session.fd )] = -1;
+      a_session.fd = -1;
+   }
+   if( connectStatus_t::IN_PROGRESS == a_status )
+   {
+      epoll_event epEvent;
+      epEvent.data.fd = fd;
+      epEvent.events  = EPOLLOUT;
+      if( (-1 == epoll_ctl( m_fdEpoll, EPOLL_CTL_ADD, fd, &epEvent )) && (EEXIST != errno) )
+      {
+         report_( errno, string( "epoll_ctl failed: " ) + strerror( errno ) );
+         a_session.connector.cancel();
+         connecting_( a_session, connectStatus_t::FAILED );
+         return;
+      }
+      if( static_cast<size_t>( fd ) >= m_vecFdSessions.size() )
+      {
+         m_vecFdSessions.resize( static_cast<size_t>( fd ) + 1, -1 );
+      }
+      m_vecFdSessions[static_cast<size_t>( fd )] = a_session.nId;
+      a_session.fd = fd;
+      if( 0 != a_session.connector.deadline_ns() )
+      {
+         const uint64_t nNow_ns = Connector::now_ns();
+         const uint64_t nWait_ms = (a_session.connector.deadline_ns() > nNow_ns) ? (a_session.connector.deadline_ns() - nNow_ns + 999999) / 1000000 : 0;
+         a_session.nTimer = m_timers.add( -1, static_cast<uint32_t>( nWait_ms ), 0, &MultiClientAsync::expired_, &a_session );
+      }
+      return;
+   }
+   if( connectStatus_t::CONNECTED == a_status )
+   {
+      const socketfd_t fdConnected = a_session.connector.release();
+      if( nullptr != a_session.config.cbConnect )
+      {
+         a_session.config.cbConnect( fdConnected, 0, a_session.config.pContext );
+      }
+      opened_( a_session, fdConnected );
+      return;
+   }
+   failed_( a_session, a_session.connector.error() );
+}
+
+
+
+/**
+ * @brief ...receiver thread, the connect of a session failed (or its host did not resolve).  cbConnect is called back and
+ * the session closed to be retried
+ *
+ * @param a_session ...
+ * @param a_nError ...errno
+ */
+void network::MultiClientAsync::failed_( session_t& a_session, const int32_t a_nError )
+{
+   if( nullptr != a_session.config.cbConnect )
+   {
+      a_session.config.cbConnect( -1, a_nError, a_session.config.pContext );
+   }
+   report_( a_nError, "connect to " + a_session.config.strHost + ":" + a_session.config.strPort + " failed: " + strerror( a_nError ) );
+   close_( a_session, true );
+}
+
+
+
+/**
+ * @brief ...receiver thread, a session connected.  its socket is read and SESION_OPEN called back
+ *
+ * @param a_session ...
+ * @param a_fd ...connected socket, non-blocking
+ */
+void network::MultiClientAsync::opened_( session_t& a_session, const socketfd_t a_fd )
+{
+   if( (nullptr != a_session.config.cbMessage) && (false == a_session.recvBuffer.allocate( m_nReceiveBufferSize )) )
+   {
+      report_( ENOMEM, "receive buffer allocation failed" );
+      ::close( a_fd );
+      a_session.fd = -1;
+      close_( a_session, false );
+      return;
+   }
+   epoll_event epEvent;
+   epEvent.data.fd = a_fd;
+   epEvent.events  = socketEvents_( false );
+   // registered for EPOLLOUT while connecting, unless it connected at once
+   if( (-1 == epoll_ctl( m_fdEpoll, EPOLL_CTL_MOD, a_fd, &epEvent )) && ((ENOENT != errno) || (-1 == epoll_ctl( m_fdEpoll, EPOLL_CTL_ADD, a_fd, &epEvent ))) )
+   {
+      report_( errno, string( "epoll_ctl failed: " ) + strerror( errno ) );
+      ::close( a_fd );
+      a_session.fd = -1;
+      close_( a_session, true );
+      return;
+   }
+   if( static_cast<size_t>( a_fd ) >= m_vecFdSessions.size() )
+   {
+      m_vecFdSessions.resize( static_cast<size_t>( a_fd ) + 1, -1 );
+   }
+   m_vecFdSessions[static_cast<size_t>( a_fd )] = a_session.nId;
+   a_session.fd             = a_fd;
+   a_session.state          = sessionState_t::OPEN;
+   a_session.bWritePending  = false;
+   a_session.bHighWatermark = false;
+   a_session.nRetriesLeft   = a_session.config.nRetryCount;
+   a_session.nRetryAttempt  = 0;
+   count( metric_t::ACCEPTS );
+   if( nullptr != a_session.config.cbSocket )
+   {
+      const LatencyTimer timer( callbackHistogram() );
+      a_session.config.cbSocket( a_fd, network::callBack_t::SESION_OPEN, a_session.config.pContext );
+   }
+}
+
+
+
+/**
+ * @brief ...receiver thread, call back SESSION_CLOSE and close the socket of an open session, a connect in progress
+ * is given up.  with a_bRetry and retries left the reconnect is scheduled, else the session is CLOSED
+ *
+ * @param a_session ...
+ * @param a_bRetry ...the connection was lost, not removed
+ */
+void network::MultiClientAsync::close_( session_t& a_session, const bool a_bRetry )
+{
+   const socketfd_t fd    = a_session.fd;
+   const bool       bOpen = (sessionState_t::OPEN == a_session.state);
+   a_session.state   = sessionState_t::CLOSED;
+   a_session.nLookup = 0;     // a resolve in flight is dropped when it comes back
+   if( 0 != a_session.nTimer )
+   {
+      m_timers.cancel( a_session.nTimer );
+      a_session.nTimer = 0;
+   }
+   if( (true == bOpen) && (nullptr != a_session.config.cbSocket) )
+   {
+      // no more sends from the callback, the fd is still valid in it
+      const LatencyTimer timer( callbackHistogram() );
+      a_session.config.cbSocket( fd, network::callBack_t::SESSION_CLOSE, a_session.config.pContext );
+   }
+   if( -1 != fd )
+   {
+      m_vecFdSessions[static_cast<size_t>( fd )] = -1;
+      a_session.fd = -1;
+   }
+   a_session.connector.cancel();
+   if( true == bOpen )
+   {
+      ::close( fd );
+      a_session.recvBuffer.release();
+      a_session.sendQueue.release();
+      count( metric_t::CLOSES );
+   }
+   if( (true == a_bRetry) && (0 != a_session.nRetriesLeft) && (true == m_bAsyncRunFlag) )
+   {
+      if( a_session.nRetriesLeft > 0 )
+      {
+         --a_session.nRetriesLeft;
+      }
+      const uint32_t nWait_ms = retryWait( a_session.nRetryAttempt++, a_session.config.nRetryWait_ms, a_session.config.nRetryMaxWait_ms );
+      a_session.nTimer = m_timers.add( -1, nWait_ms, 0, &MultiClientAsync::retry_, &a_session );
+      if( 0 != a_session.nTimer )
+      {
+         a_session.state = sessionState_t::RETRY_WAIT;
+      }
+   }
+}
+
+
+
+/**
+ * @brief ...timer of a session waiting to reconnect
+ *
+ * @param a_pData ...the session
+ */
+void network::MultiClientAsync::retry_( const int32_t&, const uint64_t, void* const a_pData )
+{
+   session_t* pSession = static_cast<session_t*>( a_pData );
+   pSession->nTimer = 0;
+   pSession->pOwner->connect_( *pSession );
+}
+
+
+
+/**
+ * @brief ...timer of a connecting session, the deadline of its attempt passed or its host is still being resolved at
+ * the deadline of the connect
+ *
+ * @param a_pData ...the session
+ */
+void network::MultiClientAsync::expired_( const int32_t&, const uint64_t, void* const a_pData )
+{
+   session_t* pSession = static_cast<session_t*>( a_pData );
+   pSession->nTimer = 0;
+   if( 0 != pSession->nLookup )
+   {
+      pSession->pOwner->failed_( *pSession, ETIMEDOUT );
+      return;
+   }
+   pSession->pOwner->connecting_( *pSession, pSession->connector.expired() );
+}
+
+
+
+/**
+ * @brief ...error callback, if set
+ *
+ * @param a_nError ...errno
+ * @param a_strError ...
+ */
+void network::MultiClientAsync::report_( const int32_t a_nError, const std::string& a_strError ) const
+{
+   if( nullptr != m_cbError )
+   {
+      m_cbError( a_nError, a_strError.c_str(), m_pCallbackData );
+   }
+}
+
+
+
+/**
+ * @brief ...open session of an id, on the receiver thread
+ *
+ * @param a_nSession ...
+ * @return network::MultiClientAsync::session_t* nullptr, errno EPERM when not called on the receiver thread, ENOTCONN when
+ * the session is not open
+ */
+network::MultiClientAsync::session_t* network::MultiClientAsync::session_( const int32_t a_nSession ) const
+{
+   if( std::this_thread::get_id() != m_idReceiver )
+   {
+      errno = EPERM;
+      return nullptr;
+   }
+   session_t* pSession = find_( a_nSession );
+   if( (nullptr == pSession) || (sessionState_t::OPEN != pSession->state) )
+   {
+      errno = ENOTCONN;
+      return nullptr;
+   }
+   return pSession;
+}
+
+
+
+/**
+ * @brief ...receiver thread, the session of an id in any state
+ *
+ * @param a_nSession ...
+ * @return network::MultiClientAsync::session_t* nullptr if the id is not the one of a session added and not removed
+ */
+network::MultiClientAsync::session_t* network::MultiClientAsync::find_( const int32_t a_nSession ) const
+{
+   if( (a_nSession < 0) || (slot_( a_nSession ) >= m_vecSessions.size()) )
+   {
+      return nullptr;
+   }
+   session_t* pSession = m_vecSessions[slot_( a_nSession )].get();
+   return ((nullptr != pSession) && (a_nSession == pSession->nId)) ? pSession : nullptr;
+}
+
+
+
+/**
+ * @brief ...state of a session, on the receiver thread
+ *
+ * @param a_nSession ...
+ * @return network::sessionState_t CLOSED if there is no such session
+ */
+network::sessionState_t network::MultiClientAsync::getState( const int32_t a_nSession ) const
+{
+   const session_t* pSession = (std::this_thread::get_id() == m_idReceiver) ? find_( a_nSession ) : nullptr;
+   return (nullptr != pSession) ? pSession->state : sessionState_t::CLOSED;
+}
+
+
+
+/**
+ * @brief ...socket of an open session, on the receiver thread
+ *
+ * @param a_nSession ...
+ * @return network::socketfd_t -1 if the session is not open
+ */
+network::socketfd_t network::MultiClientAsync::getfd( const int32_t a_nSession ) const
+{
+   const session_t* pSession = session_( a_nSession );
+   return (nullptr != pSession) ? pSession->fd : -1;
+}
+
+
+
+/**
+ * @brief ...session of a socket, ex the fd of a callback.  on the receiver thread
+ *
+ * @param a_fd ...
+ * @return int32_t session id, -1 if the fd is not an open session
+ */
+int32_t network::MultiClientAsync::sessionOf( const socketfd_t a_fd ) const
+{
+   if( (std::this_thread::get_id() != m_idReceiver) || (a_fd < 0) || (static_cast<size_t>( a_fd ) >= m_vecFdSessions.size()) )
+   {
+      return -1;
+   }
+   return m_vecFdSessions[static_cast<size_t>( a_fd )];
+}
+
+
+
+/**
+ * @brief ...epoll events for a session
+ *
+ * @param a_bWrite ...include EPOLLOUT, bytes are queued
+ * @return uint32_t
+ */
+uint32_t network::MultiClientAsync::socketEvents_( const bool a_bWrite ) const
+{
+   uint32_t nEvents = EPOLLIN | EPOLLRDHUP;
+   if( true == m_bEdgeTriggered )
+   {
+      nEvents |= EPOLLET;
+   }
+   if( true == a_bWrite )
+   {
+      nEvents |= EPOLLOUT;
+   }
+   return nEvents;
+}
+
+
+
+/**
+ * @brief ...non-blocking send on a session, call on the receiver thread.  what the socket does not take is queued and
+ * written on EPOLLOUT
+ *
+ * @param a_nSession ...id from add
+ * @param a_pBuffer ...
+ * @param a_nBufferSize ...
+ * @return ssize_t a_nBufferSize when written or queued, -1 on error, errno ENOTCONN when the session is not open
+ */
+ssize_t network::MultiClientAsync::send( const int32_t a_nSession, const void* a_pBuffer, const ssize_t& a_nBufferSize )
+{
+   const LatencyTimer timer( sendHistogram() );
+   if( (nullptr == a_pBuffer) || (a_nBufferSize <= 0) )
+   {
+      errno = EINVAL;
+      return -1;
+   }
+   session_t* pSession = session_( a_nSession );
+   if( (nullptr == pSession) || (-1 == pSession->sendQueue.write( pSession->fd, a_pBuffer, static_cast<size_t>( a_nBufferSize ) )) )
+   {
+      return -1;
+   }
+   count( metric_t::BYTES_OUT, static_cast<uint64_t>( a_nBufferSize ) );
+   count( metric_t::MESSAGES_OUT );
+   armWrite_( *pSession );
+   return a_nBufferSize;
+}
+
+
+
+/**
+ * @brief ...non-blocking scatter-gather send on a session, same rules as send
+ *
+ * @param a_nSession ...id from add
+ * @param a_pIov ...buffers
+ * @param a_nCount ...number of entries
+ * @return ssize_t total bytes written or queued, -1 on error
+ */
+ssize_t network::MultiClientAsync::sendv( const int32_t a_nSession, const struct iovec* a_pIov, const int32_t a_nCount )
+{
+   const LatencyTimer timer( sendHistogram() );
+   if( (nullptr == a_pIov) || (a_nCount <= 0) )
+   {
+      errno = EINVAL;
+      return -1;
+   }
+   session_t* pSession = session_( a_nSession );
+   if( nullptr == pSession )
+   {
+      return -1;
+   }
+   ssize_t nTotal = 0;
+   for( int32_t nIndex=0; nIndex<a_nCount; ++nIndex )
+   {
+      nTotal += static_cast<ssize_t>( a_pIov[nIndex].iov_len );
+   }
+   if( -1 == pSession->sendQueue.writev( pSession->fd, a_pIov, a_nCount ) )
+   {
+      return -1;
+   }
+   count( metric_t::BYTES_OUT, static_cast<uint64_t>( nTotal ) );
+   count( metric_t::MESSAGES_OUT );
+   armWrite_( *pSession );
+   return nTotal;
+}
+
+
+
+/**
+ * @brief ...after a write, register EPOLLOUT if bytes were queued and report the high watermark
+ *
+ * @param a_session ...
+ */
+void network::MultiClientAsync::armWrite_( session_t& a_session )
+{
+   if( false == a_session.sendQueue.empty() )
+   {
+      count( metric_t::SEND_EAGAIN );
+      if( false == a_session.bWritePending )
+      {
+         epoll_event epEvent;
+         epEvent.data.fd = a_session.fd;
+         epEvent.events  = socketEvents_( true );
+         epoll_ctl( m_fdEpoll, EPOLL_CTL_MOD, a_session.fd, &epEvent );
+         a_session.bWritePending = true;
+      }
+   }
+   if( (false == a_session.bHighWatermark) && (a_session.sendQueue.size() >= m_nHighWatermark) )
+   {
+      a_session.bHighWatermark = true;
+      if( nullptr != a_session.config.cbSocket )
+      {
+         a_session.config.cbSocket( a_session.fd, network::callBack_t::WRITE_HIGH_WATERMARK, a_session.config.pContext );
+      }
+   }
+}
+
+
+
+/**
+ * @brief ...socket of a session is writable, write the queued bytes.  EPOLLOUT is removed when the queue is empty
+ *
+ * @param a_session ...
+ * @return bool false on socket error
+ */
+bool network::MultiClientAsync::flush_( session_t& a_session )
+{
+   count( metric_t::SEND_RETRIES );
+   if( -1 == a_session.sendQueue.flush( a_session.fd ) )
+   {
+      return false;
+   }
+   if( (true == a_session.sendQueue.empty()) && (true == a_session.bWritePending) )
+   {
+      epoll_event epEvent;
+      epEvent.data.fd = a_session.fd;
+      epEvent.events  = socketEvents_( false );
+      epoll_ctl( m_fdEpoll, EPOLL_CTL_MOD, a_session.fd, &epEvent );
+      a_session.bWritePending = false;
+   }
+   if( (true == a_session.bHighWatermark) && (a_session.sendQueue.size() <= m_nLowWatermark) )
+   {
+      a_session.bHighWatermark = false;
+      if( nullptr != a_session.config.cbSocket )
+      {
+         a_session.config.cbSocket( a_session.fd, network::callBack_t::WRITE_LOW_WATERMARK, a_session.config.pContext );
+      }
+   }
+   return true;
+}
+
+
+
+/**
+ * @brief ...queue a copy of the message for the receiver thread, which sends it on the session.  any thread
+ *
+ * @param a_nSession ...id from add
+ * @param a_pBuffer ...
+ * @param a_nSize ...
+ * @return bool false, errno EBADF if startAsync was not called, ENOMEM
+ */
+bool network::MultiClientAsync::post( const int32_t a_nSession, const void* a_pBuffer, const size_t a_nSize )
+{
+   return m_posted.post( a_nSession, 0, a_pBuffer, a_nSize );
+}
+
+
+
+/**
+ * @brief ...as post, the pool buffer is referenced instead of copied and released once sent
+ *
+ * @param a_nSession ...id from add
+ * @param a_buffer ...must not be changed until sent
+ * @param a_nLength ...bytes of the buffer to send
+ * @return bool false, errno EBADF if startAsync was not called, EINVAL, ENOMEM
+ */
+bool network::MultiClientAsync::post( const int32_t a_nSession, const PoolBuffer& a_buffer, const size_t a_nLength )
+{
+   return m_posted.post( a_nSession, 0, a_buffer, a_nLength );
+}
+
+
+
+/**
+ * @brief ...receiver thread, send the posted messages.  messages for a session that is not open are dropped
+ *
+ */
+void network::MultiClientAsync::drainPosted_()
+{
+   m_posted.drain( [this]( const int32_t a_nSession, const uint64_t, const uint8_t* a_pMessage, const size_t a_nLength )
+   {
+      if( (-1 == send( a_nSession, a_pMessage, static_cast<ssize_t>( a_nLength ) )) && (ENOTCONN != errno) )
+      {
+         report_( errno, strerror( errno ) );
+      }
+   } );
+}
+
+
+
+/**
+ * @brief ...start a timer, the callback runs on the receiver thread with fd -1
+ *
+ * @param a_nDelay_ms ...first expiry
+ * @param a_nInterval_ms ...repeat interval, 0 one shot
+ * @param a_cbTimer ...callback( -1, timer id, a_pData )
+ * @param a_pData ...pointer to pass back to the callback
+ * @return uint64_t timer id, 0 on error, errno EPERM when not called on the receiver thread
+ */
+uint64_t network::MultiClientAsync::setTimer( const uint32_t a_nDelay_ms, const uint32_t a_nInterval_ms, const timerCallback_t a_cbTimer, void* const a_pData )
+{
+   if( std::this_thread::get_id() != m_idReceiver )
+   {
+      errno = EPERM;
+      return 0;
+   }
+   return m_timers.add( -1, a_nDelay_ms, a_nInterval_ms, a_cbTimer, a_pData );
+}
+
+
+
+/**
+ * @brief ...stop a timer, on the receiver thread
+ *
+ * @param a_nTimer ...id from setTimer
+ * @return bool false if not a running timer
+ */
+bool network::MultiClientAsync::cancelTimer( const uint64_t a_nTimer )
+{
+   if( std::this_thread::get_id() != m_idReceiver )
+   {
+      errno = EPERM;
+      return false;
+   }
+   return m_timers.cancel( a_nTimer );
+}
+
+
+
+/**
+ * @brief ...start the receiver thread, it connects the sessions added so far and the ones added later
+ *
+ * @param a_error ...call back on error, fn( errno, null terminaled string, a_pData )
+ * @param a_pData ...pointer to pass back to the error callback, the sessions have their own
+ * @param a_bEdgeTrigger ...level or edge trigger (level default)
+ * @return bool false if the epoll set, the wakeup or the timers could not be created
+ */
+bool network::MultiClientAsync::startAsync( const errorCallBack_t a_error, void* const a_pData, const bool a_bEdgeTrigger )
+{
+   m_cbError        = a_error;
+   m_pCallbackData  = a_pData;
+   m_bEdgeTriggered = a_bEdgeTrigger;
+   {
+      lock_guard<std::mutex> lock( m_pResolving->mux );
+      m_pResolving->pOwner = this;
+   }
+   m_fdEpoll        = epoll_create1( 0 );
+   if( (-1 == m_fdEpoll) || (false == m_posted.open()) || (false == m_timers.open( 1 )) )
+   {
+      report_( errno, strerror( errno ) );
+      return false;
+   }
+   for( const int32_t fdReactor : { m_posted.fd(), m_timers.fd() } )
+   {
+      epoll_event epEvent;
+      epEvent.data.fd = fdReactor;
+      epEvent.events  = EPOLLIN;
+      if( -1 == epoll_ctl( m_fdEpoll, EPOLL_CTL_ADD, fdReactor, &epEvent ) )
+      {
+         report_( errno, strerror( errno ) );
+         return false;
+      }
+   }
+#ifdef GSOCK_HISTOGRAMS
+   if( nullptr == m_pLatency )
+   {
+      m_pLatency.reset( new latency_t() );
+   }
+#endif
+   m_poll.configure( 0, m_nEpollTimeout_ms );
+   thread thd( &MultiClientAsync::run_, this );
+   m_thdReceiver = std::move( thd );
+   return true;
+}
+
+
+
+/**
+ * @brief ...receiver thread, epoll loop over the sessions, the wakeup of post and the commands, and the timers
+ *
+ * @return bool
+ */
+bool network::MultiClientAsync::run_()
+{
+   m_idReceiver = std::this_thread::get_id();
+   t_pMetrics   = &m_metrics;    // the thread ends with this function
+   t_pLatency   = m_pLatency.get();
+   std::vector<epoll_event> vecEvents( static_cast<size_t>( (m_nMaximumEpollEvents > 0) ? m_nMaximumEpollEvents : 1 ) );
+   applyCommands_();
+
+   while( true == m_bAsyncRunFlag )
+   {
+      m_metrics.waiting();
+      const int32_t fdCount = m_poll.wait( m_fdEpoll, vecEvents.data(), static_cast<int32_t>( vecEvents.size() ) );
+      if( fdCount <= 0 )
+      {
+         if( (-1 == fdCount) && (EINTR != errno) )
+         {
+            report_( errno, string( "epoll error: " ) + strerror( errno ) );
+            m_bAsyncRunFlag = false;
+         }
+         continue;
+      }
+      m_metrics.wakeup( static_cast<uint64_t>( fdCount ) );
+      for( int32_t nIndex=0; nIndex<fdCount; ++nIndex )
+      {
+         const int32_t  fd       = vecEvents[static_cast<size_t>( nIndex )].data.fd;
+         const uint32_t nEvents  = vecEvents[static_cast<size_t>( nIndex )].events;
+         if( m_posted.fd() == fd )
+         {
+            drainPosted_();
+            applyCommands_();
+            continue;
+         }
+         if( m_timers.fd() == fd )
+         {
+            m_timers.expire();
+            continue;
+         }
+         session_t* pSession = find_( sessionOf( fd ) );
+         if( nullptr == pSession )
+         {
+            continue;
+         }
+         session_t& session = *pSession;
+         if( sessionState_t::CONNECTING == session.state )
+         {
+            connecting_( session, session.connector.writable() );
+            continue;
+         }
+         if( (nEvents & EPOLLERR) || (nEvents & EPOLLRDHUP) )
+         {
+            // the server dropped the connection, hand over what it sent before
+            if( nEvents & EPOLLIN )
+            {
+               m_poll.callback();
+               if( nullptr != session.config.cbMessage )
+               {
+                  deliverMessages( session.recvBuffer, m_framing, fd, true, session.config.cbMessage, session.config.pContext, m_cbError, m_pCallbackData );
+               } else
+               {
+                  const LatencyTimer timer( callbackHistogram() );
+                  session.config.cbSocket( fd, network::callBack_t::MESSAGE, session.config.pContext );
+               }
+            }
+            close_( session, true );
+            continue;
+         }
+         if( (nEvents & EPOLLOUT) && (false == flush_( session )) )
+         {
+            report_( errno, strerror( errno ) );
+            close_( session, true );
+            continue;
+         }
+         if( (nEvents & EPOLLIN) && (sessionState_t::OPEN == session.state) )
+         {
+            m_poll.callback();
+            if( nullptr != session.config.cbMessage )
+            {
+               if( false == deliverMessages( session.recvBuffer, m_framing, fd, m_bEdgeTriggered, session.config.cbMessage, session.config.pContext, m_cbError, m_pCallbackData ) )
+               {
+                  // EOF or error, same as HUP
+                  close_( session, true );
+               }
+            } else
+            {
+               const LatencyTimer timer( callbackHistogram() );
+               session.config.cbSocket( fd, network::callBack_t::MESSAGE, session.config.pContext );
+            }
+         }
+      }
+   }
+
+   // the sessions end with the thread, no reconnects
+   for( auto& pSession : m_vecSessions )
+   {
+      if( nullptr != pSession )
+      {
+         close_( *pSession, false );
+      }
+   }
+   ::close( m_fdEpoll );
+   m_fdEpoll = -1;
+   return true;
+}
+
+
+
+
+
+// blocking server
+//
+
+
+/**
+ * @brief ...
+ * 
+ */
+network::Server::~Server()
+{
+   network::Sockets::close();
+}
+
+
+
+/**
+ * @brief ...return descriptor when there is a connections
+ * 
+ * @return falcon::core::network::socketfd_t
+ */
+network::socketfd_t network::Server::waitForConnection( )
+{
+   if( sockType_t::SERVER != m_type )
+   {
+      return -1;
+   }
+   return accept( m_fdSocket, nullptr, nullptr );
+}
+
+
+
+// non-blocking server
+//
+
+// reactor index of the thread running reactorLoop_, -1 on any other thread
+static thread_local int32_t t_nReactorId = -1;
+
+
+/**
+ * @brief ...
+ *
+ */
+network::ServerAsync::~ServerAsync()
+{
+   stop();
+   join();
+   network::Sockets::close();
+   for( auto pConnection : m_vecConnections )
+   {
+      delete pConnection;
+   }
+   m_vecConnections.clear();
+}
+
+
+
+/**
+ * @brief ...reactor index of the calling thread.  Call from a socket callback to find which reactor the connection is on
+ *
+ * @return int32_t 0..getReactorCount()-1, -1 when not called on a reactor thread
+ */
+int32_t network::ServerAsync::reactorId()
+{
+   return t_nReactorId;
+}
+
+
+
+/**
+ * @brief ...how the stream is cut into messages for the message callback, see setMessageCallback
+ *
+ * @param a_type ...NONE, LENGTH_PREFIX, DELIMITER or FIXED
+ * @param a_nValue ...LENGTH_PREFIX header size 1,2,4 (default 4), DELIMITER delimiter byte, FIXED message size
+ */
+void network::ServerAsync::setFraming( const framing_t a_type, const uint32_t a_nValue )
+{
+   m_framing = makeFraming( a_type, a_nValue );
+}
+
+
+
+/**
+ * @brief ...set up the per connection state of a new connection.  The table slot of a fd is only used by the reactor
+ * that accepted it, it is reset before the fd is closed so the next owner of the fd gets a clean slot
+ *
+ * @param a_fd ...accepted socket
+ * @param a_reactor ...reactor that accepted the connection
+ * @param a_error ...error callback handler
+ * @param a_pPeer ...address from accept, nullptr to ask the socket
+ * @param a_nPeerLength ...
+ * @return bool false if the connection can not be used and must be closed
+ */
+bool network::ServerAsync::openConnection_( const socketfd_t a_fd, const reactor_t& a_reactor, const errorCallBack_t a_error, const struct sockaddr_storage* a_pPeer, const socklen_t a_nPeerLength )
+{
+   if( static_cast<size_t>( a_fd ) >= m_vecConnections.size() )
+   {
+      if( nullptr != a_error )
+      {
+         a_error( EMFILE, "descriptor beyond connection table", nullptr );
+      }
+      return false;
+   }
+   connection_t*& pConnection = m_vecConnections[static_cast<size_t>( a_fd )];
+   if( nullptr == pConnection )
+   {
+      __atomic_store_n( &pConnection, new connection_t(), __ATOMIC_RELEASE );    // postTag reads the slot from other threads
+   }
+   pConnection->nReactor       = a_reactor.nId;
+   pConnection->info           = connectionInfo_t();
+   pConnection->info.nReactor  = a_reactor.nId;
+   pConnection->info.nOpened_ms = realtime_ms();
+   if( nullptr != a_pPeer )
+   {
+      pConnection->info.peer        = *a_pPeer;
+      pConnection->info.nPeerLength = a_nPeerLength;
+   } else
+   {
+      pConnection->info.nPeerLength = sizeof( pConnection->info.peer );
+      if( -1 == getpeername( a_fd, reinterpret_cast<struct sockaddr*>( &pConnection->info.peer ), &pConnection->info.nPeerLength ) )
+      {
+         pConnection->info.nPeerLength = 0;
+      }
+   }
+   pConnection->bWritePending  = false;
+   pConnection->bHighWatermark = false;
+   pConnection->bSendInFlight  = false;
+   ++pConnection->nGeneration;
+   pConnection->nZeroCopySeq   = 0;
+   pConnection->nZeroCopyDone  = 0;
+   pConnection->bZeroCopy      = (nullptr != m_cbRelease) && (engine_t::EPOLL == m_engine) && (true == setOption( a_fd, SOL_SOCKET, SO_ZEROCOPY, 1 ));
+   BusyPoll::tune( a_fd, m_nBusyPoll_us );    // a failure was reported for the listener
+   if( (nullptr != m_cbMessage) && (false == pConnection->recvBuffer.allocate( m_nReceiveBufferSize )) )
+   {
+      if( nullptr != a_error )
+      {
+         a_error( ENOMEM, "receive buffer allocation failed", nullptr );
+      }
+      return false;
+   }
+   // open only now, a slot that failed above stays closed for closeConnections_
+   pConnection->fdEpoll        = a_reactor.fdEpoll;
+   pConnection->nPostTag.store( (static_cast<uint64_t>( pConnection->nGeneration ) << 32) | static_cast<uint32_t>( a_reactor.nId + 1 ), std::memory_order_release );
+   count( metric_t::ACCEPTS );
+   return true;
+}
+
+
+
+/**
+ * @brief ...reactor ending, every connection it owns gets SESSION_CLOSE and is closed.  the connection table is walked,
+ * not the last epoll batch, so none is left open
+ *
+ * @param a_reactor ...
+ * @param a_socketEvent ...socket callback
+ * @param a_pData ...pointer to pass back to callbacks
+ */
+void network::ServerAsync::closeConnections_( const reactor_t& a_reactor, const socketCallback_t a_socketEvent, void* a_pData )
+{
+   for( size_t nFd=0; nFd<m_vecConnections.size(); ++nFd )
+   {
+      const connection_t* pConnection = m_vecConnections[nFd];
+      if( (nullptr != pConnection) && (-1 != pConnection->fdEpoll) && (a_reactor.nId == pConnection->nReactor) )
+      {
+         closeConnection_( static_cast<socketfd_t>( nFd ), a_socketEvent, a_pData );
+      }
+   }
+}
+
+
+
+/**
+ * @brief ...call back SESSION_CLOSE, reset the connection state and close the fd
+ *
+ * @param a_fd ...connection
+ * @param a_socketEvent ...socket callback
+ * @param a_pData ...pointer to pass back to callbacks
+ */
+void network::ServerAsync::closeConnection_( const socketfd_t a_fd, const socketCallback_t a_socketEvent, void* a_pData )
+{
+   if( nullptr != a_socketEvent )
+   {
+      a_socketEvent( a_fd, network::callBack_t::SESSION_CLOSE, a_pData );
+   }
+   if( static_cast<size_t>( a_fd ) < m_vecConnections.size() )
+   {
+      connection_t* pConnection = m_vecConnections[static_cast<size_t>( a_fd )];
+      if( nullptr != pConnection )
+      {
+         pConnection->nPostTag.store( 0, std::memory_order_release );
+         if( (-1 != pConnection->fdEpoll) && (nullptr != m_vecReactors[static_cast<size_t>( pConnection->nReactor )].pTimers) )
+         {
+            m_vecReactors[static_cast<size_t>( pConnection->nReactor )].pTimers->cancelAll( a_fd );
+         }
+         if( (engine_t::IO_URING == m_engine) && (-1 != pConnection->fdEpoll) )
+         {
+            // the ring holds a reference to the socket, end the armed requests or the close does not reach the peer
+            URing* pRing = m_vecReactors[static_cast<size_t>( pConnection->nReactor )].pRing;
+            pRing->prepCancel( uringData( (nullptr != m_cbMessage) ? uringOp_t::RECV : uringOp_t::POLL, pConnection->nGeneration, a_fd ), uringData( uringOp_t::CANCEL, 0, a_fd ) );
+            if( true == pConnection->bSendInFlight )
+            {
+               pRing->prepCancel( uringData( uringOp_t::SEND, pConnection->nGeneration, a_fd ), uringData( uringOp_t::CANCEL, 0, a_fd ) );
+            }
+            ::shutdown( a_fd, SHUT_RDWR );
+         }
+         releaseZeroCopy_( a_fd, pConnection, true );
+         for( const fileTransfer_t& file : pConnection->dqFiles )
+         {
+            ::close( file.fdFile );
+         }
+         pConnection->dqFiles.clear();
+         // back to the pool for the next connection of any reactor, the in flight bytes may still be read by the kernel
+         pConnection->recvBuffer.release();
+         pConnection->sendQueue.release();
+         pConnection->inflightQueue.reset();
+         pConnection->bSendInFlight = false;
+         pConnection->fdEpoll = -1;
+      }
+   }
+   count( metric_t::CLOSES );
+   ::close( a_fd );
+   //::shutdown( fd, SHUT_RDWR );
+}
+
+
+
+/**
+ * @brief ...epoll events for a connection
+ *
+ * @param a_bWrite ...include EPOLLOUT, bytes are queued
+ * @return uint32_t
+ */
+uint32_t network::ServerAsync::connectionEvents_( const bool a_bWrite ) const
+{
+   uint32_t nEvents = EPOLLIN | EPOLLRDHUP;
+   if( true == m_bEdgeTriggered )
+   {
+      nEvents |= EPOLLET;
+   }
+   if( true == a_bWrite )
+   {
+      nEvents |= EPOLLOUT;
+   }
+   return nEvents;
+}
+
+
+
+/**
+ * @brief ...non-blocking send on a connection.  Call on the reactor thread of the connection, ie from a callback.
+ * What the socket does not take now is queued and written when the socket becomes writable, the reactor never waits
+ * on a slow peer.  WRITE_HIGH_WATERMARK is called back when the queue of the connection reaches the high watermark
+ *
+ * @param a_fd ...connection
+ * @param a_pBuffer ...
+ * @param a_nBufferSize ...
+ * @return ssize_t a_nBufferSize when written or queued, -1 on error
+ */
+ssize_t network::ServerAsync::send( const socketfd_t& a_fd, const void* a_pBuffer, const ssize_t& a_nBufferSize )
+{
+   const LatencyTimer timer( sendHistogram() );
+   connection_t* pConnection = connection_( a_fd );
+   if( (nullptr == a_pBuffer) || (a_nBufferSize <= 0) || (nullptr == pConnection) )
+   {
+      return -1;
+   }
+
+   if( engine_t::IO_URING == m_engine )
+   {
+      if( false == pConnection->sendQueue.append( a_pBuffer, static_cast<size_t>( a_nBufferSize ) ) )
+      {
+         return -1;
+      }
+      queueSend_( a_fd, pConnection );
+      if( (nullptr != m_cbRelease) && (static_cast<size_t>( a_nBufferSize ) >= m_nZeroCopyThreshold) )
+      {
+         m_cbRelease( a_fd, a_pBuffer, m_pCallbackData );   // copied
+      }
+      return sent_( pConnection, a_nBufferSize );
+   }
+   if( (nullptr != m_cbRelease) && (static_cast<size_t>( a_nBufferSize ) >= m_nZeroCopyThreshold) )
+   {
+      return sent_( pConnection, sendZeroCopy_( a_fd, pConnection, a_pBuffer, static_cast<size_t>( a_nBufferSize ) ) );
+   }
+   if( true == writeBlocked_( pConnection ) )
+   {
+      // behind a zero copy buffer or a file that is not out yet
+      if( false == pConnection->sendQueue.append( a_pBuffer, static_cast<size_t>( a_nBufferSize ) ) )
+      {
+         return -1;
+      }
+   } else if( -1 == pConnection->sendQueue.write( a_fd, a_pBuffer, static_cast<size_t>( a_nBufferSize ) ) )
+   {
+      return -1;
+   }
+   armWrite_( a_fd, pConnection );
+   return sent_( pConnection, a_nBufferSize );
+}
+
+
+
+/**
+ * @brief ...non-blocking scatter-gather send on a connection, ex header + payload or a batch of messages, one sendmsg per
+ * IOV_MAX entries.  same rules as send, call on the reactor thread of the connection
+ *
+ * @param a_fd ...connection
+ * @param a_pIov ...buffers
+ * @param a_nCount ...number of entries
+ * @return ssize_t total bytes written or queued, -1 on error
+ */
+ssize_t network::ServerAsync::sendv( const socketfd_t& a_fd, const struct iovec* a_pIov, const int32_t a_nCount )
+{
+   const LatencyTimer timer( sendHistogram() );
+   connection_t* pConnection = connection_( a_fd );
+   if( (nullptr == a_pIov) || (a_nCount <= 0) || (nullptr == pConnection) )
+   {
+      return -1;
+   }
+
+   ssize_t nTotal = 0;
+   for( int32_t nIndex=0; nIndex<a_nCount; ++nIndex )
+   {
+      nTotal += static_cast<ssize_t>( a_pIov[nIndex].iov_len );
+   }
+   if( (engine_t::IO_URING == m_engine) || (true == writeBlocked_( pConnection )) )
+   {
+      // the kernel writes the queue, or queued behind a zero copy buffer or a file that is not out yet
+      for( int32_t nIndex=0; nIndex<a_nCount; ++nIndex )
+      {
+         if( false == pConnection->sendQueue.append( a_pIov[nIndex].iov_base, a_pIov[nIndex].iov_len ) )
+         {
+            return -1;
+         }
+      }
+      if( engine_t::IO_URING == m_engine )
+      {
+         queueSend_( a_fd, pConnection );
+         return sent_( pConnection, nTotal );
+      }
+   } else if( -1 == pConnection->sendQueue.writev( a_fd, a_pIov, a_nCount ) )
+   {
+      return -1;
+   }
+   armWrite_( a_fd, pConnection );
+   return sent_( pConnection, nTotal );
+}
+
+
+
+/**
+ * @brief ...non-blocking file send on a connection with sendfile, the file bytes do not pass through user space.  What the
+ * socket does not take now is sent from the file when the socket becomes writable, in order with send/sendv before and
+ * after.  a_fdFile is duplicated for a pending transfer, the caller can close it when sendFile returns.  IO_URING reads
+ * the file into the send queue.  same rules as send, call on the reactor thread of the connection
+ *
+ * @param a_fd ...connection
+ * @param a_fdFile ...regular file open for reading, its file offset is not changed
+ * @param a_nOffset ...first byte of the file
+ * @param a_nLength ...bytes to send, the transfer ends early at the end of the file
+ * @return ssize_t a_nLength when sent or queued, -1 on error
+ */
+ssize_t network::ServerAsync::sendFile( const socketfd_t& a_fd, const int32_t a_fdFile, const off_t a_nOffset, const size_t a_nLength )
+{
+   const LatencyTimer timer( sendHistogram() );
+   connection_t* pConnection = connection_( a_fd );
+   struct stat   fileStat;
+   if( (nullptr == pConnection) || (a_nOffset < 0) || (0 == a_nLength) || (-1 == fstat( a_fdFile, &fileStat )) )
+   {
+      return -1;
+   }
+   if( false == S_ISREG( fileStat.st_mode ) )
+   {
+      errno = EINVAL;      // a pipe can not be resumed from epoll on the socket
+      return -1;
+   }
+
+   if( engine_t::IO_URING == m_engine )
+   {
+      uint8_t  aChunk[65536];
+      off_t    nOffset     = a_nOffset;
+      size_t   nRemaining  = a_nLength;
+      while( nRemaining > 0 )
+      {
+         ssize_t nBytesRead = ::pread( a_fdFile, aChunk, (nRemaining < sizeof( aChunk )) ? nRemaining : sizeof( aChunk ), nOffset );
+         if( (-1 == nBytesRead) && (EINTR == errno) )
+         {
+            continue;
+         }
+         if( -1 == nBytesRead )
+         {
+            return -1;
+         }
+         if( 0 == nBytesRead )
+         {
+            break;   // end of file
+         }
+         if( false == pConnection->sendQueue.append( aChunk, static_cast<size_t>( nBytesRead ) ) )
+         {
+            return -1;
+         }
+         nOffset    += nBytesRead;
+         nRemaining -= static_cast<size_t>( nBytesRead );
+      }
+      queueSend_( a_fd, pConnection );
+      return sent_( pConnection, static_cast<ssize_t>( a_nLength ) );
+   }
+
+   fileTransfer_t file;
+   file.nOffset    = a_nOffset;
+   file.nRemaining = a_nLength;
+   if( (true == pConnection->sendQueue.empty()) && (false == writeBlocked_( pConnection )) )
+   {
+      // nothing ahead of the file, send what the socket takes now
+      while( file.nRemaining > 0 )
+      {
+         ssize_t nBytesWritten = ::sendfile( a_fd, a_fdFile, &file.nOffset, file.nRemaining );
+         if( (-1 == nBytesWritten) && (EINTR == errno) )
+         {
+            continue;
+         }
+         if( (-1 == nBytesWritten) && (EAGAIN == errno) )
+         {
+            break;
+         }
+         if( -1 == nBytesWritten )
+         {
+            return -1;
+         }
+         file.nRemaining = (0 == nBytesWritten) ? 0 : file.nRemaining - static_cast<size_t>( nBytesWritten );
+      }
+      if( 0 == file.nRemaining )
+      {
+         return sent_( pConnection, static_cast<ssize_t>( a_nLength ) );
+      }
+   } else
+   {
+      // the queued bytes not already ahead of an earlier file go out first
+      file.nBytesAhead = pConnection->sendQueue.size();
+      for( const fileTransfer_t& pending : pConnection->dqFiles )
+      {
+         file.nBytesAhead -= pending.nBytesAhead;
+      }
+   }
+   file.fdFile = ::dup( a_fdFile );
+   if( -1 == file.fdFile )
+   {
+      return -1;
+   }
+   pConnection->dqFiles.push_back( file );
+   armWrite_( a_fd, pConnection );
+   return sent_( pConnection, static_cast<ssize_t>( a_nLength ) );
+}
+
+
+
+/**
+ * @brief ...UDP, send one datagram to a peer, ex a reply to the sender of a datagram callback.  does not wait and is not
+ * queued, a full socket buffer fails with EAGAIN
+ *
+ * @param a_fd ...datagram socket, the fd of the callback
+ * @param a_pBuffer ...
+ * @param a_nBufferSize ...
+ * @param a_pPeer ...destination, ex &datagram.peer
+ * @param a_nPeerLength ...
+ * @return ssize_t bytes sent, -1 on error
+ */
+ssize_t network::ServerAsync::sendTo( const socketfd_t& a_fd, const void* a_pBuffer, const size_t a_nBufferSize, const struct sockaddr* a_pPeer, const socklen_t a_nPeerLength )
+{
+   if( (nullptr == a_pBuffer) || (nullptr == a_pPeer) )
+   {
+      return -1;
+   }
+   ssize_t nBytesWritten;
+   do
+   {
+      nBytesWritten = ::sendto( a_fd, a_pBuffer, a_nBufferSize, MSG_DONTWAIT | MSG_NOSIGNAL, a_pPeer, a_nPeerLength );
+   } while( (-1 == nBytesWritten) && (EINTR == errno) );
+   return nBytesWritten;
+}
+
+
+
+/**
+ * @brief ...UDP, send a batch of datagrams with sendmmsg, each to its peer.  does not wait, stops at a full socket buffer
+ *
+ * @param a_fd ...datagram socket, the fd of the callback
+ * @param a_pDatagrams ...
+ * @param a_nCount ...
+ * @return int32_t datagrams sent, the first n entries, -1 when none could be sent
+ */
+int32_t network::ServerAsync::sendBatch( const socketfd_t& a_fd, const datagram_t* a_pDatagrams, const uint32_t a_nCount )
+{
+   return network::Sockets::sendBatch( a_fd, a_pDatagrams, a_nCount, MSG_DONTWAIT );
+}
+
+
+
+/**
+ * @brief ...open connection of a fd
+ *
+ * @param a_fd ...
+ * @return network::ServerAsync::connection_t* nullptr if the fd is not an open connection
+ */
+network::ServerAsync::connection_t* network::ServerAsync::connection_( const socketfd_t a_fd ) const
+{
+   if( (a_fd < 0) || (static_cast<size_t>( a_fd ) >= m_vecConnections.size()) )
+   {
+      return nullptr;
+   }
+   connection_t* pConnection = m_vecConnections[static_cast<size_t>( a_fd )];
+   if( (nullptr == pConnection) || (-1 == pConnection->fdEpoll) )
+   {
+      return nullptr;
+   }
+   return pConnection;
+}
+
+
+
+/**
+ * @brief ...count a send that was written or queued
+ *
+ * @param a_pConnection ...
+ * @param a_nBytes ...result of the send, -1 is not counted
+ * @return ssize_t a_nBytes
+ */
+ssize_t network::ServerAsync::sent_( connection_t* a_pConnection, const ssize_t a_nBytes ) const
+{
+   if( a_nBytes >= 0 )
+   {
+      a_pConnection->info.nBytesOut += static_cast<uint64_t>( a_nBytes );
+      ++a_pConnection->info.nMessagesOut;
+      count( metric_t::BYTES_OUT, static_cast<uint64_t>( a_nBytes ) );
+      count( metric_t::MESSAGES_OUT );
+   }
+   return a_nBytes;
+}
+
+
+
+/**
+ * @brief ...attach the application's data to a connection, ex its session object, so a callback finds it from the fd
+ * without a map.  cleared when the connection closes.  call on the reactor thread of the connection
+ *
+ * @param a_fd ...connection
+ * @param a_pContext ...
+ * @return bool false, errno EBADF when a_fd is not an open connection
+ */
+bool network::ServerAsync::setContext( const socketfd_t& a_fd, void* const a_pContext )
+{
+   connection_t* pConnection = connection_( a_fd );
+   if( nullptr == pConnection )
+   {
+      errno = EBADF;
+      return false;
+   }
+   pConnection->info.pContext = a_pContext;
+   return true;
+}
+
+
+
+/**
+ * @brief ...data of setContext
+ *
+ * @param a_fd ...connection
+ * @return void* nullptr when not set or a_fd is not an open connection
+ */
+void* network::ServerAsync::getContext( const socketfd_t& a_fd ) const
+{
+   const connection_t* pConnection = connection_( a_fd );
+   return (nullptr != pConnection) ? pConnection->info.pContext : nullptr;
+}
+
+
+
+/**
+ * @brief ...peer, context, counters and open time of a connection.  call on the reactor thread of the connection
+ *
+ * @param a_fd ...connection
+ * @param a_info ...out
+ * @return bool false, errno EBADF when a_fd is not an open connection
+ */
+bool network::ServerAsync::getConnectionInfo( const socketfd_t& a_fd, connectionInfo_t& a_info ) const
+{
+   const connection_t* pConnection = connection_( a_fd );
+   if( nullptr == pConnection )
+   {
+      errno = EBADF;
+      return false;
+   }
+   a_info = pConnection->info;
+   return true;
+}
+
+
+
+/**
+ * @brief ...after a write, register EPOLLOUT if bytes were queued and report the high watermark
+ *
+ * @param a_fd ...connection
+ * @param a_pConnection ...its state
+ */
+void network::ServerAsync::armWrite_( const socketfd_t a_fd, connection_t* a_pConnection )
+{
+   const bool bQueued = (false == a_pConnection->sendQueue.empty()) || (true == writeBlocked_( a_pConnection ));
+   if( true == bQueued )
+   {
+      count( metric_t::SEND_EAGAIN );
+   }
+   if( (true == bQueued) && (false == a_pConnection->bWritePending) )
+   {
+      epoll_event epEvent;
+      epEvent.data.fd = a_fd;
+      epEvent.events  = connectionEvents_( true );
+      epoll_ctl( a_pConnection->fdEpoll, EPOLL_CTL_MOD, a_fd, &epEvent );
+      a_pConnection->bWritePending = true;
+   }
+   if( (false == a_pConnection->bHighWatermark) && (a_pConnection->sendQueue.size() >= m_nHighWatermark) )
+   {
+      a_pConnection->bHighWatermark = true;
+      if( nullptr != m_cbSocketEvent )
+      {
+         m_cbSocketEvent( a_fd, network::callBack_t::WRITE_HIGH_WATERMARK, m_pCallbackData );
+      }
+   }
+}
+
+
+
+/**
+ * @brief ...socket is writable, write the queued bytes.  EPOLLOUT is removed when the queue is empty
+ *
+ * @param a_fd ...connection
+ * @return bool false on socket error
+ */
+bool network::ServerAsync::flushConnection_( const socketfd_t a_fd )
+{
+   connection_t* pConnection = m_vecConnections[static_cast<size_t>( a_fd )];
+   count( metric_t::SEND_RETRIES );
+   if( 0 != pConnection->nZeroCopyUnsent )
+   {
+      // the zero copy buffer goes out before the bytes queued behind it
+      if( false == writeZeroCopy_( a_fd, pConnection ) )
+      {
+         return false;
+      }
+      if( 0 != pConnection->nZeroCopyUnsent )
+      {
+         return true;
+      }
+   }
+   if( false == pConnection->dqFiles.empty() )
+   {
+      if( false == writeFiles_( a_fd, pConnection ) )
+      {
+         return false;
+      }
+      if( false == pConnection->dqFiles.empty() )
+      {
+         return true;
+      }
+   }
+   if( -1 == pConnection->sendQueue.flush( a_fd ) )
+   {
+      return false;
+   }
+   if( (true == pConnection->sendQueue.empty()) && (true == pConnection->bWritePending) )
+   {
+      epoll_event epEvent;
+      epEvent.data.fd = a_fd;
+      epEvent.events  = connectionEvents_( false );
+      epoll_ctl( pConnection->fdEpoll, EPOLL_CTL_MOD, a_fd, &epEvent );
+      pConnection->bWritePending = false;
+   }
+   if( (true == pConnection->bHighWatermark) && (pConnection->sendQueue.size() <= m_nLowWatermark) )
+   {
+      pConnection->bHighWatermark = false;
+      if( nullptr != m_cbSocketEvent )
+      {
+         m_cbSocketEvent( a_fd, network::callBack_t::WRITE_LOW_WATERMARK, m_pCallbackData );
+      }
+   }
+   return true;
+}
+
+
+
+/**
+ * @brief ...send from the callers buffer with MSG_ZEROCOPY, the buffer is handed back through the release callback.
+ * when bytes are queued ahead of it the buffer is copied to the queue and released right away
+ *
+ * @param a_fd ...connection
+ * @param a_pConnection ...its state
+ * @param a_pBuffer ...
+ * @param a_nSize ...
+ * @return ssize_t a_nSize when sent or queued, -1 on error
+ */
+ssize_t network::ServerAsync::sendZeroCopy_( const socketfd_t a_fd, connection_t* a_pConnection, const void* a_pBuffer, const size_t a_nSize )
+{
+   if( (false == a_pConnection->bZeroCopy) || (false == a_pConnection->sendQueue.empty()) || (true == writeBlocked_( a_pConnection )) )
+   {
+      ssize_t nResult = (true == writeBlocked_( a_pConnection )) ? (a_pConnection->sendQueue.append( a_pBuffer, a_nSize ) ? 0 : -1)
+                                                                 : a_pConnection->sendQueue.write( a_fd, a_pBuffer, a_nSize );
+      m_cbRelease( a_fd, a_pBuffer, m_pCallbackData );
+      if( -1 == nResult )
+      {
+         return -1;
+      }
+      armWrite_( a_fd, a_pConnection );
+      return static_cast<ssize_t>( a_nSize );
+   }
+
+   zeroCopy_t zeroCopy;
+   zeroCopy.pBuffer = reinterpret_cast<const uint8_t*>( a_pBuffer );
+   zeroCopy.nLength = a_nSize;
+   a_pConnection->dqZeroCopy.push_back( zeroCopy );
+   a_pConnection->nZeroCopyUnsent = a_nSize;
+   if( false == writeZeroCopy_( a_fd, a_pConnection ) )
+   {
+      return -1;   // released when the connection is closed
+   }
+   armWrite_( a_fd, a_pConnection );
+   return static_cast<ssize_t>( a_nSize );
+}
+
+
+
+/**
+ * @brief ...write the unsent part of the newest zero copy buffer, MSG_ZEROCOPY each call.  falls back to a copying send
+ * when the kernel is out of memory for pinning (ENOBUFS)
+ *
+ * @param a_fd ...connection
+ * @param a_pConnection ...its state
+ * @return bool false on socket error
+ */
+bool network::ServerAsync::writeZeroCopy_( const socketfd_t a_fd, connection_t* a_pConnection )
+{
+   zeroCopy_t& zeroCopy = a_pConnection->dqZeroCopy.back();
+   while( zeroCopy.nSent < zeroCopy.nLength )
+   {
+      ssize_t nBytesSent = ::send( a_fd, zeroCopy.pBuffer + zeroCopy.nSent, zeroCopy.nLength - zeroCopy.nSent, MSG_NOSIGNAL | MSG_ZEROCOPY );
+      if( nBytesSent >= 0 )
+      {
+         zeroCopy.nLastSeq  = a_pConnection->nZeroCopySeq++;
+         zeroCopy.bInKernel = true;
+      } else if( ENOBUFS == errno )
+      {
+         nBytesSent = ::send( a_fd, zeroCopy.pBuffer + zeroCopy.nSent, zeroCopy.nLength - zeroCopy.nSent, MSG_NOSIGNAL );
+      }
+      if( -1 == nBytesSent )
+      {
+         if( EINTR == errno )
+         {
+            continue;
+         }
+         if( EAGAIN == errno )
+         {
+            break;
+         }
+         return false;
+      }
+      zeroCopy.nSent += static_cast<size_t>( nBytesSent );
+   }
+   a_pConnection->nZeroCopyUnsent = zeroCopy.nLength - zeroCopy.nSent;
+   releaseZeroCopy_( a_fd, a_pConnection, false );
+   return true;
+}
+
+
+
+/**
+ * @brief ...EPOLLERR on a zero copy connection, read the completions from the error queue and release the buffers
+ *
+ * @param a_fd ...connection
+ * @param a_pConnection ...its state
+ * @return bool false if the socket has a real error and must be closed
+ */
+bool network::ServerAsync::completeZeroCopy_( const socketfd_t a_fd, connection_t* a_pConnection )
+{
+   bool bResult = true;
+   char szControl[CMSG_SPACE( sizeof( struct sock_extended_err ) ) + 64];
+   struct msghdr msg;
+   for( ;; )
+   {
+      memset( &msg, 0, sizeof( msg ) );
+      msg.msg_control    = szControl;
+      msg.msg_controllen = sizeof( szControl );
+      if( -1 == recvmsg( a_fd, &msg, MSG_ERRQUEUE ) )
+      {
+         break;   // EAGAIN, queue empty
+      }
+      for( struct cmsghdr* pCmsg = CMSG_FIRSTHDR( &msg ); nullptr != pCmsg; pCmsg = CMSG_NXTHDR( &msg, pCmsg ) )
+      {
+         if( ((SOL_IP == pCmsg->cmsg_level) && (IP_RECVERR == pCmsg->cmsg_type)) || ((SOL_IPV6 == pCmsg->cmsg_level) && (IPV6_RECVERR == pCmsg->cmsg_type)) )
+         {
+            const struct sock_extended_err* pError = reinterpret_cast<const struct sock_extended_err*>( CMSG_DATA( pCmsg ) );
+            if( (SO_EE_ORIGIN_ZEROCOPY == pError->ee_origin) && (0 == pError->ee_errno) )
+            {
+               // sends ee_info..ee_data are done, in order on a stream socket
+               a_pConnection->nZeroCopyDone = pError->ee_data + 1;
+            } else
+            {
+               bResult = false;
+            }
+         }
+      }
+   }
+   releaseZeroCopy_( a_fd, a_pConnection, false );
+
+   int32_t   nError = 0;
+   socklen_t nLen   = sizeof( nError );
+   if( (0 == getsockopt( a_fd, SOL_SOCKET, SO_ERROR, &nError, &nLen )) && (0 != nError) )
+   {
+      errno   = nError;
+      bResult = false;
+   }
+   return bResult;
+}
+
+
+
+/**
+ * @brief ...call back the release of the zero copy buffers the kernel is done with, oldest first
+ *
+ * @param a_fd ...connection
+ * @param a_pConnection ...its state
+ * @param a_bAll ...connection closed, release all
+ */
+void network::ServerAsync::releaseZeroCopy_( const socketfd_t a_fd, connection_t* a_pConnection, const bool a_bAll )
+{
+   while( false == a_pConnection->dqZeroCopy.empty() )
+   {
+      const zeroCopy_t& zeroCopy = a_pConnection->dqZeroCopy.front();
+      if( (false == a_bAll) &&
+          ((zeroCopy.nSent < zeroCopy.nLength) || ((true == zeroCopy.bInKernel) && (static_cast<int32_t>( zeroCopy.nLastSeq - a_pConnection->nZeroCopyDone ) >= 0))) )
+      {
+         break;
+      }
+      const void* pBuffer = zeroCopy.pBuffer;
+      a_pConnection->dqZeroCopy.pop_front();
+      m_cbRelease( a_fd, pBuffer, m_pCallbackData );
+   }
+   if( true == a_bAll )
+   {
+      a_pConnection->nZeroCopyUnsent = 0;
+   }
+}
+
+
+
+/**
+ * @brief ...socket is writable, continue the pending file transfers in order, each after the queued bytes ahead of it.
+ * a transfer is done at a_nLength bytes or the end of the file, its fd is closed
+ *
+ * @param a_fd ...connection
+ * @param a_pConnection ...its state
+ * @return bool false on socket or file error
+ */
+bool network::ServerAsync::writeFiles_( const socketfd_t a_fd, connection_t* a_pConnection )
+{
+   while( false == a_pConnection->dqFiles.empty() )
+   {
+      fileTransfer_t& file = a_pConnection->dqFiles.front();
+      if( file.nBytesAhead > 0 )
+      {
+         ssize_t nBytesWritten = a_pConnection->sendQueue.flush( a_fd, file.nBytesAhead );
+         if( -1 == nBytesWritten )
+         {
+            return false;
+         }
+         file.nBytesAhead -= static_cast<size_t>( nBytesWritten );
+         if( file.nBytesAhead > 0 )
+         {
+            return true;
+         }
+      }
+      while( file.nRemaining > 0 )
+      {
+         ssize_t nBytesWritten = ::sendfile( a_fd, file.fdFile, &file.nOffset, file.nRemaining );
+         if( (-1 == nBytesWritten) && (EINTR == errno) )
+         {
+            continue;
+         }
+         if( (-1 == nBytesWritten) && (EAGAIN == errno) )
+         {
+            return true;
+         }
+         if( -1 == nBytesWritten )
+         {
+            return false;
+         }
+         file.nRemaining = (0 == nBytesWritten) ? 0 : file.nRemaining - static_cast<size_t>( nBytesWritten );
+      }
+      ::close( file.fdFile );
+      a_pConnection->dqFiles.pop_front();
+   }
+   return true;
+}
+
+
+
+/**
+ * @brief ...a zero copy buffer or a file is waiting for the socket, new bytes are queued behind it
+ *
+ * @param a_pConnection ...
+ * @return bool
+ */
+bool network::ServerAsync::writeBlocked_( const connection_t* a_pConnection ) const
+{
+   return (0 != a_pConnection->nZeroCopyUnsent) || (false == a_pConnection->dqFiles.empty());
+}
+
+
+
+/**
+ * @brief ...IO_URING, bytes were queued on a connection.  the reactor submits the send before its next wait so all sends
+ * of one loop iteration go to the kernel in one syscall
+ *
+ * @param a_fd ...connection
+ * @param a_pConnection ...its state
+ */
+void network::ServerAsync::queueSend_( const socketfd_t a_fd, connection_t* a_pConnection )
+{
+   if( false == a_pConnection->bWritePending )
+   {
+      a_pConnection->bWritePending = true;
+      m_vecReactors[static_cast<size_t>( a_pConnection->nReactor )].vecSendReady.push_back( a_fd );
+   }
+   if( (false == a_pConnection->bHighWatermark) && (a_pConnection->sendQueue.size() + a_pConnection->inflightQueue.size() >= m_nHighWatermark) )
+   {
+      a_pConnection->bHighWatermark = true;
+      if( nullptr != m_cbSocketEvent )
+      {
+         m_cbSocketEvent( a_fd, network::callBack_t::WRITE_HIGH_WATERMARK, m_pCallbackData );
+      }
+   }
+}
+
+
+
+/**
+ * @brief ...IO_URING, hand the queued bytes to the kernel.  the queue is swapped with the in flight queue so new sends
+ * keep appending while the kernel reads the in flight bytes, one send request per connection at a time keeps the order
+ *
+ * @param a_fd ...connection
+ * @param a_pConnection ...its state, no send in flight
+ * @param a_ring ...ring of the reactor owning the connection
+ */
+void network::ServerAsync::submitSend_( const socketfd_t a_fd, connection_t* a_pConnection, URing& a_ring )
+{
+   if( true == a_pConnection->sendQueue.empty() )
+   {
+      return;
+   }
+   a_pConnection->inflightQueue.reset();
+   a_pConnection->sendQueue.swap( a_pConnection->inflightQueue );
+   a_pConnection->bSendInFlight = true;
+   const size_t nSize = a_pConnection->inflightQueue.size();
+   a_ring.prepSend( a_fd, a_pConnection->inflightQueue.data(), (nSize < s_nUringMaxSend) ? nSize : s_nUringMaxSend, uringData( uringOp_t::SEND, a_pConnection->nGeneration, a_fd ) );
+}
+
+
+
+/**
+ * @brief ...check the callbacks and create one listener per reactor.  Reactor 0 uses the socket from open, the others
+ * bind a new SO_REUSEPORT socket to the same address so the kernel can spread the connections across them
+ *
+ * @param a_socketEvent ...callback on good socket events (conection, HUP and data ready
+ * @param a_bEdgeTrigger ...true if edge trigger
+ * @param a_error ...error callback handler
+ * @param a_pData ...pointer to pass back to callbacks
+ * @return bool
+ */
+bool network::ServerAsync::prepareReactors_( const socketCallback_t a_socketEvent, const bool a_bEdgeTrigger, const errorCallBack_t a_error, void* a_pData )
+{
+   if( (nullptr == a_socketEvent) && (nullptr == m_cbMessage) && (nullptr == m_cbDatagram) )
+   {
+      return false;
+   }
+   if( sockType_t::SERVER != m_type )
+   {
+      return false;
+   }
+   if( nullptr == a_error )
+   {
+      AsyncLog::write( LogLevel::EWRN, "server %s:%s started without an error handler", m_pszHostname, m_szPort );
+   }
+   if( false == m_vecReactorThreads.empty() )
+   {
+      // already running
+      return false;
+   }
+
+   m_bEdgeTriggered  = a_bEdgeTrigger;
+   m_cbSocketEvent   = a_socketEvent;
+   m_pCallbackData   = a_pData;
+   if( protocol_t::UDP == m_protocol )
+   {
+      m_engine = engine_t::EPOLL;   // datagrams are read with recvmmsg from epoll
+   }
+
+   // one slot per possible descriptor, the table is not resized while the reactors run
+   struct rlimit fileLimit;
+   size_t        nTableSize = 65536;
+   if( (0 == getrlimit( RLIMIT_NOFILE, &fileLimit )) && (RLIM_INFINITY != fileLimit.rlim_cur) )
+   {
+      nTableSize = static_cast<size_t>( fileLimit.rlim_cur );
+   }
+   if( m_vecConnections.size() < nTableSize )
+   {
+      m_vecConnections.resize( nTableSize, nullptr );
+   }
+
+   m_vecReactors.clear();
+   m_vecReactors.resize( static_cast<size_t>( m_nReactorCount ) );
+   for( size_t nIndex=0; nIndex<m_vecReactors.size(); ++nIndex )
+   {
+      reactor_t& reactor = m_vecReactors[nIndex];
+      reactor.pTimers.reset( new TimerWheel() );
+      reactor.pPosted.reset( new PostQueue() );
+      reactor.pPoll.reset( new BusyPoll() );
+      reactor.pPoll->configure( m_nSpin_us, m_nEpollTimeout_ms );
+      reactor.pMetrics.reset( new Metrics() );
+#ifdef GSOCK_HISTOGRAMS
+      reactor.pLatency.reset( new latency_t() );
+#endif
+      if( (false == reactor.pTimers->open( static_cast<uint32_t>( nIndex ) + 1, m_nTimerResolution_ms )) ||
+          (false == reactor.pPosted->open()) )
+      {
+         if( nullptr != a_error )
+         {
+            a_error( errno, strerror( errno ), nullptr );
+         }
+         m_vecReactors.clear();
+         return false;
+      }
+   }
+   if( (false == BusyPoll::tune( m_fdSocket, m_nBusyPoll_us )) && (nullptr != a_error) )
+   {
+      // the connections are tuned the same way, report it once here
+      string str( "SO_BUSY_POLL not set: " );
+      str.append( strerror( errno ) );
+      a_error( errno, str.c_str(), nullptr );
+   }
+   m_vecReactors[0].nId        = 0;
+   m_vecReactors[0].fdListener = m_fdSocket;
+   if( (nullptr != m_cbMetricsLog) && (0 != m_nMetricsInterval_ms) )
+   {
+      // the loops have not started, the wheel of reactor 0 can be used from here
+      m_lastMetrics     = metrics_t();
+      m_nLastMetrics_ns = BusyPoll::now_ns();
+      m_vecReactors[0].pTimers->add( -1, m_nMetricsInterval_ms, m_nMetricsInterval_ms, &ServerAsync::logMetrics_, this );
+   }
+   if( m_nReactorCount < 2 )
+   {
+      return true;
+   }
+
+   if( true == Resolver::isUnixPath( m_pszHostname ) )
+   {
+      if( nullptr != a_error )
+      {
+         a_error( EOPNOTSUPP, "no SO_REUSEPORT for an AF_UNIX listener, use one reactor", nullptr );
+      }
+      return false;
+   }
+   int nReusePort = 0;
+   socklen_t nLen = sizeof( nReusePort );
+   if( (false == getOption( m_fdSocket, SOL_SOCKET, SO_REUSEPORT, nReusePort, nLen )) || (0 == nReusePort) )
+   {
+      if( nullptr != a_error )
+      {
+         a_error( 0, "SO_REUSEPORT not set on listener, call setReactorCount before open", nullptr );
+      }
+      return false;
+   }
+
+   for( size_t nIndex=1; nIndex<m_vecReactors.size(); ++nIndex )
+   {
+      socketfd_t fdListener = reusePortListener_();
+      if( -1 != fdListener )
+      {
+         BusyPoll::tune( fdListener, m_nBusyPoll_us );
+         m_vecReactors[nIndex].nId        = static_cast<int32_t>( nIndex );
+         m_vecReactors[nIndex].fdListener = fdListener;
+         continue;
+      }
+
+      // could not create the listener, undo the ones already created
+      if( nullptr != a_error )
+      {
+         string str( "reactor listener failed: " );
+         str.append( strerror( errno ) );
+         a_error( errno, str.c_str(), nullptr );
+      }
+      for( size_t nUndo=1; nUndo<nIndex; ++nUndo )
+      {
+         ::close( m_vecReactors[nUndo].fdListener );
+      }
+      m_vecReactors.clear();
+      return false;
+   }
+   return true;
+}
+
+
+
+
+/**
+ * @brief ...listens and calls back on data ready connection or HUP.  Blocks until stop is called
+ * when setReactorCount > 1, reactors 1..n-1 are started on their own threads and reactor 0 runs on the calling thread
+ *
+ * edge trigger:  you must read data from socket while receive returns > 0, data available
+ * level trigger: you must make one receive call per callback and ten return
+ *
+ * @param a_socketEvent ...callback on good socket events (conection, HUP and data ready
+ * @param a_bEdgeTrigger ...true if edge trigger, you must consume all data on event, else level and make mult calls
+ * @param a_error ...error callback handler
+ * @param a_pData ...pointer to pass back to callbacks
+ *
+ *      edge  -> triggered once when data is present, must read all data on this event
+ *      level -> triggeered whenever data is present, can  read some or all data per even
+ *
+ *
+ *
+ * @return bool
+ */
+bool network::ServerAsync::nonblockingListener( const socketCallback_t a_socketEvent, const bool a_bEdgeTrigger, const errorCallBack_t a_error, void *a_pData )
+{
+   if( false == prepareReactors_( a_socketEvent, a_bEdgeTrigger, a_error, a_pData ) )
+   {
+      return false;
+   }
+   startWorkers_( a_error, a_pData );
+
+   for( size_t nIndex=1; nIndex<m_vecReactors.size(); ++nIndex )
+   {
+      m_vecReactorThreads.emplace_back( &ServerAsync::reactorLoop_, this, std::ref( m_vecReactors[nIndex] ), a_socketEvent, a_error, a_pData );
+   }
+   bool bResult = reactorLoop_( m_vecReactors[0], a_socketEvent, a_error, a_pData );
+   if( false == bResult )
+   {
+      // reactor 0 failed to start, do not leave the others running
+      stop();
+   }
+   join();
+   return bResult;
+}
+
+
+
+/**
+ * @brief ...start all reactors on their own threads and return.  stop ends the reactors, join waits for them
+ * @example see testing/async/server.cpp
+ *
+ * @param a_socketEvent ...callback on conection, HUP and data ready
+ * @param a_pData ...void pointer that will be returned in call back
+ * @param a_error ...call back on error, fn( errno, null terminaled string, a_pData )
+ * @param a_bEdgeTrigger ...level or edge trigger (level default)
+ * @return bool
+ */
+bool network::ServerAsync::startAsync( const socketCallback_t a_socketEvent, void* const a_pData, const errorCallBack_t a_error, const bool a_bEdgeTrigger )
+{
+   if( false == prepareReactors_( a_socketEvent, a_bEdgeTrigger, a_error, a_pData ) )
+   {
+      return false;
+   }
+   startWorkers_( a_error, a_pData );
+
+   for( auto& reactor : m_vecReactors )
+   {
+      m_vecReactorThreads.emplace_back( &ServerAsync::reactorLoop_, this, std::ref( reactor ), a_socketEvent, a_error, a_pData );
+   }
+   return true;
+}
+
+
+
+/**
+ * @brief ...queue of the reactor a tag was taken on, from any thread.  the connection table is not read
+ *
+ * @param a_fd ...
+ * @param a_nTag ...of postTag
+ * @return network::PostQueue* nullptr, errno EBADF if the tag is not the one of an open connection, ECANCELED stopped
+ */
+network::PostQueue* network::ServerAsync::postQueue_( const socketfd_t a_fd, const uint64_t a_nTag ) const
+{
+   if( false == m_bAsyncRunFlag )
+   {
+      errno = ECANCELED;   // the reactors do not send any more
+      return nullptr;
+   }
+   const size_t nReactor = static_cast<size_t>( a_nTag & 0xFFFFFFFF ) - 1;
+   if( (a_fd < 0) || (0 == a_nTag) || (nReactor >= m_vecReactors.size()) || (nullptr == m_vecReactors[nReactor].pPosted) )
+   {
+      errno = EBADF;
+      return nullptr;
+   }
+   return m_vecReactors[nReactor].pPosted.get();
+}
+
+
+
+/**
+ * @brief ...tag of the connection on a fd, identifies this use of the fd for post.  on a worker handling a message of
+ * the fd it is the tag the message was read with, so a reply posted after the connection closed and the fd was reused
+ * is dropped.  elsewhere the tag of the connection open now, take it in SESION_OPEN to post from other threads
+ *
+ * @param a_fd ...
+ * @return uint64_t 0 if a_fd is not an open connection
+ */
+uint64_t network::ServerAsync::postTag( const socketfd_t& a_fd ) const
+{
+   const uint64_t nTag = WorkerPool::currentTag( a_fd );
+   if( 0 != nTag )
+   {
+      return nTag;
+   }
+   if( (a_fd < 0) || (static_cast<size_t>( a_fd ) >= m_vecConnections.size()) )
+   {
+      return 0;
+   }
+   // the table is not resized while the reactors run, the reactor publishes a new slot with a release store
+   const connection_t* pConnection = __atomic_load_n( &m_vecConnections[static_cast<size_t>( a_fd )], __ATOMIC_ACQUIRE );
+   return (nullptr != pConnection) ? pConnection->nPostTag.load( std::memory_order_acquire ) : 0;
+}
+
+
+
+/**
+ * @brief ...send from a thread that is not the reactor of the connection.  the message is copied and queued to the
+ * reactor, which sends it in post order with send.  does not block and makes no syscall unless the reactor has to be
+ * woken.  post( a_fd, postTag( a_fd ), ... )
+ *
+ * @param a_fd ...open connection
+ * @param a_pBuffer ...
+ * @param a_nSize ...
+ * @return bool false, errno EBADF if a_fd is not an open connection, ECANCELED the server has stopped, ENOMEM
+ */
+bool network::ServerAsync::post( const socketfd_t& a_fd, const void* a_pBuffer, const size_t a_nSize )
+{
+   return post( a_fd, postTag( a_fd ), a_pBuffer, a_nSize );
+}
+
+
+
+/**
+ * @brief ...as post, the pool buffer is referenced instead of copied and released once sent
+ *
+ * @param a_fd ...open connection
+ * @param a_buffer ...must not be changed until sent
+ * @param a_nLength ...bytes of the buffer to send
+ * @return bool false, errno EBADF if a_fd is not an open connection, ECANCELED the server has stopped, EINVAL, ENOMEM
+ */
+bool network::ServerAsync::post( const socketfd_t& a_fd, const PoolBuffer& a_buffer, const size_t a_nLength )
+{
+   return post( a_fd, postTag( a_fd ), a_buffer, a_nLength );
+}
+
+
+
+/**
+ * @brief ...as post, for the connection a_nTag was taken on.  the message is dropped by the reactor if that connection
+ * has closed, also when the fd is open again for another one
+ *
+ * @param a_fd ...
+ * @param a_nTag ...postTag of the connection
+ * @param a_pBuffer ...
+ * @param a_nSize ...
+ * @return bool false, errno EBADF if the tag is 0 (the connection was not open), ECANCELED the server has stopped, ENOMEM
+ */
+bool network::ServerAsync::post( const socketfd_t& a_fd, const uint64_t a_nTag, const void* a_pBuffer, const size_t a_nSize )
+{
+   PostQueue* pPosted = postQueue_( a_fd, a_nTag );
+   if( nullptr == pPosted )
+   {
+      return false;
+   }
+   return pPosted->post( a_fd, a_nTag, a_pBuffer, a_nSize );
+}
+
+
+
+/**
+ * @brief ...as post with a tag, the pool buffer is referenced instead of copied and released once sent or dropped
+ *
+ * @param a_fd ...
+ * @param a_nTag ...postTag of the connection
+ * @param a_buffer ...must not be changed until sent
+ * @param a_nLength ...bytes of the buffer to send
+ * @return bool false, errno EBADF if the tag is 0, ECANCELED the server has stopped, EINVAL, ENOMEM
+ */
+bool network::ServerAsync::post( const socketfd_t& a_fd, const uint64_t a_nTag, const PoolBuffer& a_buffer, const size_t a_nLength )
+{
+   PostQueue* pPosted = postQueue_( a_fd, a_nTag );
+   if( nullptr == pPosted )
+   {
+      return false;
+   }
+   return pPosted->post( a_fd, a_nTag, a_buffer, a_nLength );
+}
+
+
+
+/**
+ * @brief ...reactor, send the posted messages.  a message for a connection closed since it was posted, or for a new
+ * connection on the same fd, is dropped
+ *
+ * @param a_reactor ...
+ * @param a_error ...error callback handler
+ */
+void network::ServerAsync::drainPosted_( reactor_t& a_reactor, const errorCallBack_t a_error )
+{
+   a_reactor.pPosted->drain( [this, a_error]( const int32_t a_fd, const uint64_t a_nTag, const uint8_t* a_pMessage, const size_t a_nLength )
+   {
+      connection_t* pConnection = connection_( a_fd );
+      if( (nullptr == pConnection) || (a_nTag != pConnection->nPostTag.load( std::memory_order_relaxed )) )
+      {
+         return;
+      }
+      // sendv copies what the socket does not take, never zero copy: the node of the message is freed once this returns
+      struct iovec iov;
+      iov.iov_base = const_cast<uint8_t*>( a_pMessage );
+      iov.iov_len  = a_nLength;
+      if( (-1 == sendv( a_fd, &iov, 1 )) && (nullptr != a_error) )
+      {
+         a_error( errno, strerror( errno ), nullptr );
+      }
+   } );
+}
+
+
+
+/**
+ * @brief ...start a timer on the reactor of the calling thread, the callback runs on that reactor
+ *
+ * @param a_fd ...connection of this reactor, its timers are cancelled when it closes.  -1 for a reactor timer
+ * @param a_nDelay_ms ...first expiry
+ * @param a_nInterval_ms ...repeat interval, 0 one shot
+ * @param a_cbTimer ...callback( fd, timer id, a_pData )
+ * @param a_pData ...pointer to pass back to the callback
+ * @return uint64_t timer id, 0 on error, errno EPERM when not called on a reactor thread, EBADF if a_fd is not a
+ * connection of this reactor
+ */
+uint64_t network::ServerAsync::setTimer( const socketfd_t& a_fd, const uint32_t a_nDelay_ms, const uint32_t a_nInterval_ms, const timerCallback_t a_cbTimer, void* const a_pData )
+{
+   if( (t_nReactorId < 0) || (static_cast<size_t>( t_nReactorId ) >= m_vecReactors.size()) || (nullptr == m_vecReactors[static_cast<size_t>( t_nReactorId )].pTimers) )
+   {
+      errno = EPERM;
+      return 0;
+   }
+   if( -1 != a_fd )
+   {
+      const connection_t* pConnection = connection_( a_fd );
+      if( (nullptr == pConnection) || (t_nReactorId != pConnection->nReactor) )
+      {
+         errno = EBADF;
+         return 0;
+      }
+   }
+   return m_vecReactors[static_cast<size_t>( t_nReactorId )].pTimers->add( a_fd, a_nDelay_ms, a_nInterval_ms, a_cbTimer, a_pData );
+}
+
+
+
+/**
+ * @brief ...stop a timer, on the reactor that started it
+ *
+ * @param a_nTimer ...id from setTimer
+ * @return bool false if not a running timer of the calling reactor
+ */
+bool network::ServerAsync::cancelTimer( const uint64_t a_nTimer )
+{
+   if( (t_nReactorId < 0) || (static_cast<size_t>( t_nReactorId ) >= m_vecReactors.size()) || (nullptr == m_vecReactors[static_cast<size_t>( t_nReactorId )].pTimers) )
+   {
+      errno = EPERM;
+      return false;
+   }
+   return m_vecReactors[static_cast<size_t>( t_nReactorId )].pTimers->cancel( a_nTimer );
+}
+
+
+
+/**
+ * @brief ...start the worker pool when setWorkerCount is set, the message callback then runs on the workers.  without
+ * workers, or when they cannot be started, the reactors call it
+ *
+ * @param a_error ...error callback handler
+ * @param a_pData ...pointer to pass back to the message callback
+ */
+void network::ServerAsync::startWorkers_( const errorCallBack_t a_error, void* a_pData )
+{
+   if( (0 == m_nWorkerCount) || (nullptr == m_cbMessage) || (protocol_t::UDP == m_protocol) )
+   {
+      return;
+   }
+   m_cbWorkerError = a_error;
+   m_pWorkerData   = a_pData;
+   if( (false == m_workers.start( m_nWorkerCount, m_cbMessage, a_pData )) && (nullptr != a_error) )
+   {
+      a_error( 0, "worker pool not started, messages are handled on the reactors", a_pData );
+   }
+}
+
+
+
+/**
+ * @brief ...reactor thread, messageCallback_t of the reactors while the workers run: queue the message to its worker.
+ * a message the pool refuses (queue at its limit, no buffer) is dropped, counted and reported with the errno of dispatch
+ *
+ * @param a_fd ...
+ * @param a_pMessage ...
+ * @param a_nLength ...
+ * @param a_pServer ...the ServerAsync
+ */
+void network::ServerAsync::dispatch_( const socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pServer )
 {
+   ServerAsync*        pServer     = reinterpret_cast<ServerAsync*>( a_pServer );
+   const connection_t* pConnection = pServer->connection_( a_fd );
+   // the tag of the connection the message was read from, a reply posted by the worker never reaches a later one
+   const uint64_t      nTag        = (nullptr != pConnection) ? pConnection->nPostTag.load( std::memory_order_relaxed ) : 0;
+   if( true == pServer->m_workers.dispatch( a_fd, a_pMessage, a_nLength, nTag ) )
    {
-      lock_guard<std::mutex> lock( m_muxReady );   // used for conditional to signal async is ready
+      return;
    }
-   
-
-   if( nullptr == a_onSocketEvent )
+   count( metric_t::DISPATCH_DROPS );
+   if( nullptr != pServer->m_cbWorkerError )
    {
-      // error
-      return false;
+      pServer->m_cbWorkerError( errno, "message dropped, the worker pool refused it", pServer->m_pWorkerData );
    }
-   
-   // alloc on stack events for all connections
-   if( true == m_bUseMalloc )
+}
+
+
+
+/**
+ * @brief ...pin the reactor thread to its cpu of setReactorCpus, reactor n gets entry n % size
+ *
+ * @param a_reactor ...
+ * @param a_error ...error callback handler
+ */
+void network::ServerAsync::pinReactor_( const reactor_t& a_reactor, const errorCallBack_t a_error )
+{
+   if( true == m_vecCpus.empty() )
    {
-      m_pEvents = reinterpret_cast<epoll_event*>( malloc( static_cast<  decltype(sizeof(epoll_event))  >(m_nMaximumEpollEvents)*sizeof(epoll_event) ) );
-   } else
+      return;
+   }
+   const int32_t nCpu = m_vecCpus[static_cast<size_t>( a_reactor.nId ) % m_vecCpus.size()];
+   if( (false == BusyPoll::pin( nCpu )) && (nullptr != a_error) )
    {
-      m_pEvents = reinterpret_cast<epoll_event*>( alloca( static_cast<  decltype(sizeof(epoll_event))  >(m_nMaximumEpollEvents)*sizeof(epoll_event) ) );
+      string str( "reactor not pinned to cpu " );
+      str.append( std::to_string( static_cast<int64_t>( nCpu ) ) );
+      str.append( ": " );
+      str.append( strerror( errno ) );
+      a_error( errno, str.c_str(), nullptr );
    }
-   if( nullptr == m_pEvents )
+}
+
+
+
+/**
+ * @brief ...wait statistics of one reactor, see BusyPoll
+ *
+ * @param a_nReactor ...0..getReactorCount()-1
+ * @return network::pollStats_t zeroed when the reactor does not exist
+ */
+network::pollStats_t network::ServerAsync::getPollStats( const int32_t a_nReactor ) const
+{
+   if( (0 > a_nReactor) || (static_cast<size_t>( a_nReactor ) >= m_vecReactors.size()) || (nullptr == m_vecReactors[static_cast<size_t>( a_nReactor )].pPoll) )
    {
-      // try malloc if stack alloc fails, but keep track of who did the alloc, for now. fail
-      if( nullptr != a_error )
-      {
-         a_error( errno, strerror( errno ), a_pThis );
-      }
-      return false;
+      return pollStats_t();
    }
-   
-   m_fdEpoll = epoll_create1( 0 );
-   if( -1 == m_fdEpoll )
+   return m_vecReactors[static_cast<size_t>( a_nReactor )].pPoll->stats();
+}
+
+
+
+/**
+ * @brief ...counters of all reactors added up, read while the reactors run
+ *
+ * @return network::metrics_t zeroed when not running
+ */
+network::metrics_t network::ServerAsync::getMetrics() const
+{
+   metrics_t metrics;
+   for( const auto& reactor : m_vecReactors )
    {
-      // log error
-      if( nullptr != a_error )
+      if( nullptr != reactor.pMetrics )
       {
-         a_error( errno, strerror( errno ), a_pThis );
+         metrics += reactor.pMetrics->snapshot();
       }
-      return false;
    }
+   return metrics;
+}
 
-   epoll_event epEventMainSocket;
-   epEventMainSocket.data.fd = m_fdSocket;
-   epEventMainSocket.events = EPOLLIN | EPOLLRDHUP;  // this is a socket from a connection, so listen for HUP
-   if( true == m_bEdgeTriggered )
-   {
-      epEventMainSocket.events |= EPOLLET;
-   }
-   makeNonBlocking( m_fdSocket );
 
-   
 
-   if( -1 == epoll_ctl( m_fdEpoll, EPOLL_CTL_ADD, m_fdSocket, &epEventMainSocket ) )
+/**
+ * @brief ...counters of one reactor, see getMetrics
+ *
+ * @param a_nReactor ...0..getReactorCount()-1
+ * @return network::metrics_t zeroed when the reactor does not exist
+ */
+network::metrics_t network::ServerAsync::getMetrics( const int32_t a_nReactor ) const
+{
+   if( (0 > a_nReactor) || (static_cast<size_t>( a_nReactor ) >= m_vecReactors.size()) || (nullptr == m_vecReactors[static_cast<size_t>( a_nReactor )].pMetrics) )
    {
-      // log error
-      if( nullptr != a_error )
-      {
-         a_error( errno, strerror( errno ), a_pThis );  // investigate if we needno use strerror_r
-      }
-      return false;
+      return metrics_t();
    }
+   return m_vecReactors[static_cast<size_t>( a_nReactor )].pMetrics->snapshot();
+}
 
-   int32_t fdCount;
-   int64_t lIndex;
-   
-   // listener side ready
-   bool bNotified = false;
-   
-   
-   while( m_bAsyncRunFlag )
+
+
+/**
+ * @brief ...latency histograms of all reactors merged, read while the reactors run
+ *
+ * @return network::latency_t empty when not running or not built with GSOCK_HISTOGRAMS
+ */
+network::latency_t network::ServerAsync::getLatency() const
+{
+   latency_t latency;
+   for( const auto& reactor : m_vecReactors )
    {
-      fdCount = epoll_wait( m_fdEpoll, m_pEvents, m_nMaximumEpollEvents, m_nEpollTimeout_ms );
-      if( false == bNotified )
-      {
-         // notify that connection is ready
-         m_cvReady.notify_one();
-         bNotified = true;
-         //std::cout<<pthread_self()<<"notified"<<std::endl;
-      }
-      
-      switch( fdCount )
+      if( nullptr != reactor.pLatency )
       {
-         case 0:
-            // epoll timeout
-            continue;
-         case -1:
-            if( EINTR == errno )
-            {
-               continue;
-            } else
-            {
-               if( nullptr != a_error )
-               {
-                  string str( "epoll error: " );
-                  str.append( strerror( errno ) );
-                  a_error( errno, str.c_str(), nullptr );
-                  m_bAsyncRunFlag = false;
-                  continue;
-               }
-            }
-            continue;
-            
-         default:
-            int32_t fd;
-            for( lIndex=0; lIndex<fdCount; ++lIndex )
-            {
-               fd = m_pEvents[lIndex].data.fd;
-               
-               if( (m_pEvents[lIndex].events & EPOLLERR) || (m_pEvents[lIndex].events & EPOLLRDHUP) )
-               {
-                  // HUP: here
-                  std::cerr << "hup (server dropped connection):" << strerror( errno ) << std::endl;
-                  // handle connection closed by either hangup or network error
-                  //m_bAsyncRunFlag = false;
-                  ::close( fd );  
-                  if( nullptr != a_onSocketEvent )
-                  {
-                     a_onSocketEvent( fd, network::callBack_t::SESSION_CLOSE, a_pThis );
-                     //m_bAsyncRunFlag = false;
-                  }
-               } 
-               if( m_pEvents[lIndex].events & EPOLLIN )
-               {
-                  // data is ready on a fd
-                  if( nullptr != a_onSocketEvent )
-                  {
-                     a_onSocketEvent( fd, network::callBack_t::MESSAGE, a_pThis );
-                  } else
-                  {
-                     a_error( 0, "no callback event:", nullptr );
-                  }
-               } else
-               {
-                  if( nullptr != a_error )
-                  {
-                     a_error( 0, "unhandled socket event", nullptr );
-                  }
-               }
-            }
+         latency.callback.merge( reactor.pLatency->callback );
+         latency.send.merge( reactor.pLatency->send );
       }
    }
-
-   ::close( m_fdSocket );
-   ::close( m_fdEpoll );
-   //sem_post( &m_semReconnect );
-   //cout << " end sock startAsync" << endl;
-   return true;
+   return latency;
 }
 
 
 
 /**
- * @brief ...see TWPriceFeed for details
- * 
- * @param a_nRetryCount ...
- * @param a_nRetryWait ...
- * @param a_cbLog ...
- * @return bool
+ * @brief ...latency histograms of one reactor, see getLatency
+ *
+ * @param a_nReactor ...0..getReactorCount()-1
+ * @return network::latency_t empty when the reactor does not exist
  */
-bool network::ClientAsync::reconnect( const int32_t a_nRetryCount, const int32_t a_nRetryWait, logCallBack_t a_cbLog )
+network::latency_t network::ServerAsync::getLatency( const int32_t a_nReactor ) const
 {
-   std::cout << "m_thdReceiver:" << m_thdReceiver.native_handle() << std::endl;
-   cout << "waiting for Client::startAsync to end" << endl;
-   cout << "Client::startAsync ended" << endl;
-   
-   
-   cout << "network::Client::reconnect" << endl;
-   if( (a_nRetryCount == 0) || (a_nRetryWait == 0) )
+   if( (0 > a_nReactor) || (static_cast<size_t>( a_nReactor ) >= m_vecReactors.size()) || (nullptr == m_vecReactors[static_cast<size_t>( a_nReactor )].pLatency) )
    {
-      if( nullptr != a_cbLog )
-      {
-         stringstream sstr;
-         sstr << "retry disabled at least one retry var is zero. MddReconnectRetryCount:" << a_nRetryCount << ", MddReconnectWait:" << a_nRetryWait;
-         a_cbLog( network::LogLevel::EERR, sstr.str().c_str() );
-      }
-      return false;
+      return latency_t();
    }
-   int32_t nRetryCount = a_nRetryCount;
-   
-   
-   while( nRetryCount-- > 0 )
+   return *m_vecReactors[static_cast<size_t>( a_nReactor )].pLatency;
+}
+
+
+
+/**
+ * @brief ...empty the histograms of all reactors, each reactor clears its own before it records the next value
+ *
+ */
+void network::ServerAsync::resetLatency()
+{
+   for( auto& reactor : m_vecReactors )
    {
-      if( false == m_bAsyncRunFlag )
-      {
-         if( nullptr != a_cbLog )
-         {
-            a_cbLog( network::LogLevel::EINF, "retry, stop issued:" );
-         }
-         cout << "stop issued" << endl;
-         break;
-      }
-      usleep( static_cast<__useconds_t>(a_nRetryWait)* 1000000 );
-      
-      if( true == open( sockType_t::CLIENT, m_protocol, m_pszHostname, m_szPort ) )  // dev-idb27.nyoffice.tradeweb.com.
-      {
-         if( nullptr != a_cbLog )
-         {
-            a_cbLog( network::LogLevel::EINF, "connection suceeded" );
-         }
-         
-         epoll_event epEventMainSocket;
-         epEventMainSocket.data.fd = m_fdSocket;
-         epEventMainSocket.events = EPOLLIN | EPOLLRDHUP;  // this is a socket from a connection, so listen for HUP
-         if( true == m_bEdgeTriggered )
-         {
-            epEventMainSocket.events |= EPOLLET;
-         }
-         makeNonBlocking( m_fdSocket );
-         if( -1 == epoll_ctl( m_fdEpoll, EPOLL_CTL_ADD, m_fdSocket, &epEventMainSocket ) )
-         {
-            if( nullptr != a_cbLog )
-            {
-               stringstream sstr;
-               sstr << "failed to add connection to poll,  no data will be received";
-               a_cbLog( network::LogLevel::EERR, sstr.str().c_str() );
-            }
-            return false;
-         }
-         
-         
-         return true;
-      } else
+      if( nullptr != reactor.pLatency )
       {
-         if( nullptr != a_cbLog )
-         {
-            a_cbLog( network::LogLevel::EWRN, "connection failed" );
-         }
-         cout <<  "retry failed" << endl;
+         reactor.pLatency->callback.reset();
+         reactor.pLatency->send.reset();
       }
-      
-   }
-   if( nullptr != a_cbLog )
-   {
-      stringstream sstr;   
-      a_cbLog( network::LogLevel::EERR, "mdd reconnect failed" );
    }
-   cout << "mdd reconnect failed nRetryCount:" << a_nRetryCount << ", nRetryWait:" << a_nRetryWait << endl;
-   return false;
 }
 
 
 
+/**
+ * @brief ...timer of reactor 0, log the rates of all reactors since the last line, see setMetricsLog
+ *
+ * @param a_pData ...the server
+ */
+void network::ServerAsync::logMetrics_( const int32_t&, const uint64_t, void* const a_pData )
+{
+   ServerAsync*      pThis   = static_cast<ServerAsync*>( a_pData );
+   const metrics_t   now     = pThis->getMetrics();
+   const uint64_t    nNow_ns = BusyPoll::now_ns();
+   const string      str     = Metrics::format( now, pThis->m_lastMetrics, static_cast<double>( nNow_ns - pThis->m_nLastMetrics_ns ) / 1e9 );
+   pThis->m_cbMetricsLog( LogLevel::EINF, str.c_str() );
+   pThis->m_lastMetrics     = now;
+   pThis->m_nLastMetrics_ns = nNow_ns;
+}
 
 
-// blocking server
-//
-
 
 /**
- * @brief ...
- * 
+ * @brief ...end the reactors, each is woken through its eventfd and leaves its loop without waiting for a timeout
+ *
  */
-network::Server::~Server()
+void network::ServerAsync::stop()
 {
-   network::Sockets::close();
+   m_bAsyncRunFlag = false;
+   wakeup();
 }
 
 
 
 /**
- * @brief ...return descriptor when there is a connections
- * 
- * @return falcon::core::network::socketfd_t
+ * @brief ...make every reactor return from epoll_wait (or the ring) and re-check its state
+ *
  */
-network::socketfd_t network::Server::waitForConnection( )
+void network::ServerAsync::wakeup()
 {
-   if( sockType_t::SERVER != m_type )
+   for( auto& reactor : m_vecReactors )
    {
-      return -1;
+      if( nullptr != reactor.pPosted )
+      {
+         reactor.pPosted->wake();
+      }
    }
-   return accept( m_fdSocket, nullptr, nullptr );
 }
 
 
 
-// non-blocking server
-//
-
 /**
- * @brief ...
- * 
+ * @brief ...wait for the reactor threads to end, let the workers finish the queued messages then close the listener.
+ * the reactors are kept until the destructor, wakeup and post from other threads may still reach them
+ *
  */
-network::ServerAsync::~ServerAsync()
+void network::ServerAsync::join()
 {
-   network::Sockets::close();
-   if( (true == m_bUseMalloc) && (m_pEvents != nullptr ) )
+   for( auto& thd : m_vecReactorThreads )
+   {
+      if( thd.joinable() )
+      {
+         thd.join();
+      }
+   }
+   m_vecReactorThreads.clear();
+   m_workers.stop();
+   if( false == m_vecReactors.empty() )
    {
-      free( m_pEvents );
-      m_pEvents = nullptr;
+      for( auto& reactor : m_vecReactors )
+      {
+         if( (-1 != reactor.fdListener) && (m_fdSocket != reactor.fdListener) )
+         {
+            ::close( reactor.fdListener );   // reactor ended before its loop started
+         }
+         reactor.fdListener = -1;
+      }
+      close();   // close listener
    }
 }
 
 
 
-
 /**
- * @brief ...listens and calls back on data ready connection or HUP.
- * 
- * edge trigger:  you must read data from socket while receive returns > 0, data available
- * level trigger: you must make one receive call per callback and ten return
- * 
- * @param a_socketEvent ...callback on good socket events (conection, HUP and data ready
- * @param a_bEdgeTrigger ...true if edge trigger, you must consume all data on event, else level and make mult calls
- * @param a_error ...error callback handler
- * @param a_pData ...pointer to pass back to callbacks
- *
- *      edge  -> triggered once when data is present, must read all data on this event
- *      level -> triggeered whenever data is present, can  read some or all data per even
+ * @brief ...epoll loop for one reactor.  accepts on the reactors listener and calls back on data ready connection or HUP.
  *
- * 
- * 
+ * @param a_reactor ...listener and epoll of this reactor
+ * @param a_socketEvent ...callback on good socket events (conection, HUP and data ready
+ * @param a_error ...error callback handler
+ * @param a_pData ...pointer to pass back to callbacks
  * @return bool
  */
-bool network::ServerAsync::nonblockingListener( const socketCallback_t a_socketEvent, const bool a_bEdgeTrigger, const errorCallBack_t a_error, void *a_pData )
+bool network::ServerAsync::reactorLoop_( reactor_t& a_reactor, const socketCallback_t a_socketEvent, const errorCallBack_t a_error, void* a_pData )
 {
-   if( nullptr == a_socketEvent )
-   {
-      return false;
-   }
-   if( sockType_t::SERVER != m_type )
-   {
-      return false;
-   }
-   if( nullptr == a_error )
+   if( engine_t::IO_URING == m_engine )
    {
-      cerr << "Error handler not set" << endl;
+      return uringLoop_( a_reactor, a_socketEvent, a_error, a_pData );
    }
+   t_nReactorId = a_reactor.nId;
+   t_pMetrics   = a_reactor.pMetrics.get();
+   t_pLatency   = a_reactor.pLatency.get();
+   pinReactor_( a_reactor, a_error );
 
    // alloc on stack events for all connections
+   epoll_event* pEvents = nullptr;
    if( true == m_bUseMalloc )
    {
-      m_pEvents = reinterpret_cast<epoll_event*>( malloc( static_cast<  decltype(sizeof(epoll_event))  >(m_nMaximumEpollEvents)*sizeof(epoll_event) ) );
+      pEvents = reinterpret_cast<epoll_event*>( malloc( static_cast<  decltype(sizeof(epoll_event))  >(m_nMaximumEpollEvents)*sizeof(epoll_event) ) );
    } else
    {
-      m_pEvents = reinterpret_cast<epoll_event*>( alloca( static_cast<  decltype(sizeof(epoll_event))  >(m_nMaximumEpollEvents)*sizeof(epoll_event) ) );
-   }
-   for( int32_t nIndex=0; nIndex<m_nMaximumEpollEvents; nIndex++ )
-   {
-      (m_pEvents+nIndex)->data.fd = 0;
+      pEvents = reinterpret_cast<epoll_event*>( alloca( static_cast<  decltype(sizeof(epoll_event))  >(m_nMaximumEpollEvents)*sizeof(epoll_event) ) );
    }
-   if( nullptr == m_pEvents )
+   if( nullptr == pEvents )
    {
       // try malloc if stack alloc fails, but keep track of who did the alloc, for now. fail
       if( nullptr != a_error )
       {
          a_error( errno, strerror( errno ), nullptr );
       }
+      t_nReactorId = -1;
+      t_pMetrics   = nullptr;
+      t_pLatency   = nullptr;
       return false;
    }
-
-   m_fdEpoll = epoll_create1( 0 );
-   if( -1 == m_fdEpoll )
+   a_reactor.fdEpoll = epoll_create1( 0 );
+   if( -1 == a_reactor.fdEpoll )
    {
       // log error
       if( nullptr != a_error )
       {
          a_error( errno, strerror( errno ), nullptr );
       }
+      if( true == m_bUseMalloc )
+      {
+         free( pEvents );
+      }
+      t_nReactorId = -1;
+      t_pMetrics   = nullptr;
+      t_pLatency   = nullptr;
       return false;
    }
-   
+
    epoll_event epEventMainSocket;
-   epEventMainSocket.data.fd = m_fdSocket;
+   epEventMainSocket.data.fd = a_reactor.fdListener;
    epEventMainSocket.events = EPOLLIN;
    // in above case we are watching READ events for fd
    // here is snippet
    // available events
    //        EPOLLIN
    //               The associated file is available for read(2) operations.
-   // 
+   //
    //        EPOLLOUT
    //               The associated file is available for write(2) operations.
-   // 
+   //
    //        EPOLLRDHUP (since Linux 2.6.17)
    //               Stream socket peer closed connection, or shut down writing half of  connection.
    //               (This flag is especially useful for writing simple code to detect peer shutdown
    //               when using Edge Triggered monitoring.)
-   // 
+   //
    //        EPOLLPRI
    //               There is urgent data available for read(2) operations.
-   // 
+   //
    //        EPOLLERR
    //               Error condition happened on the associated file descriptor.  epoll_wait(2) will
    //               always wait for this event; it is not necessary to set it in events.
-   // 
+   //
    //        EPOLLHUP
    //               Hang  up happened on the associated file descriptor.  epoll_wait(2) will always
    //               wait for this event; it is not necessary to set it in events.
-   // 
+   //
    //        EPOLLET
    //               Sets the Edge Triggered behavior  for  the  associated  file  descriptor.   The
    //               default  behavior for epoll is Level Triggered.  See epoll(7) for more detailed
    //               information about Edge and Level Triggered event distribution architectures.
-   // 
+   //
    //        EPOLLONESHOT (since Linux 2.6.2)
    //               Sets the one-shot behavior for the associated file descriptor.  This means that
    //               after  an event is pulled out with epoll_wait(2) the associated file descriptor
    //               is internally disabled and no other events will be reported by the epoll inter-
    //               face.   The  user  must  call epoll_ctl() with EPOLL_CTL_MOD to re-arm the file
    //               descriptor with a new event mask.
-   
+
    // add listener socket to events watched by epoll
-   if( -1 == epoll_ctl( m_fdEpoll, EPOLL_CTL_ADD, m_fdSocket, &epEventMainSocket ) )
+   if( -1 == epoll_ctl( a_reactor.fdEpoll, EPOLL_CTL_ADD, a_reactor.fdListener, &epEventMainSocket ) )
    {
       // log error
       if( nullptr != a_error )
       {
          a_error( errno, strerror( errno ), nullptr );  // investigate if we needno use strerror_r
       }
+      ::close( a_reactor.fdEpoll );
+      if( true == m_bUseMalloc )
+      {
+         free( pEvents );
+      }
+      t_nReactorId = -1;
+      t_pMetrics   = nullptr;
+      t_pLatency   = nullptr;
       return false;
    }
-   
+
+   // wakeup, messages posted by other threads and the timers of the reactor
+   for( const int32_t fdReactor : { a_reactor.pPosted->fd(), a_reactor.pTimers->fd() } )
+   {
+      epoll_event epEventReactor;
+      epEventReactor.data.fd = fdReactor;
+      epEventReactor.events  = EPOLLIN;
+      if( -1 == epoll_ctl( a_reactor.fdEpoll, EPOLL_CTL_ADD, fdReactor, &epEventReactor ) )
+      {
+         if( nullptr != a_error )
+         {
+            a_error( errno, strerror( errno ), nullptr );
+         }
+         ::close( a_reactor.fdEpoll );
+         if( true == m_bUseMalloc )
+         {
+            free( pEvents );
+         }
+         t_nReactorId = -1;
+         t_pMetrics   = nullptr;
+         t_pLatency   = nullptr;
+         return false;
+      }
+   }
+
    // connection vars
-   struct sockaddr remoteAddress;
-   socklen_t       remoteAddressLength = sizeof( remoteAddress );
-   
-   
-   ::listen( m_fdSocket, m_nBacklog );  
+   struct sockaddr_storage remoteAddress;
+   socklen_t               remoteAddressLength;
+
+
+   const bool bDatagram = (protocol_t::UDP == m_protocol);
+   if( true == bDatagram )
+   {
+      prepareDatagrams( a_reactor.vecDatagrams, a_reactor.vecDatagramBuffer, m_nDatagramBatch, m_nReceiveBufferSize );
+   } else
+   {
+      ::listen( a_reactor.fdListener, m_nBacklog );
+   }
    int32_t fdCount;
    int64_t lIndex;
    while( m_bAsyncRunFlag )
    {
-      fdCount = epoll_wait( m_fdEpoll, m_pEvents, m_nMaximumEpollEvents, m_nEpollTimeout_ms );
-      
+      a_reactor.pMetrics->waiting();
+      fdCount = a_reactor.pPoll->wait( a_reactor.fdEpoll, pEvents, m_nMaximumEpollEvents );
+
       switch( fdCount )
       {
          //cerr << "fd:" << fdCount << endl;
          case 0:
-            
+
             continue;
          case -1:
             // epoll error
             //       EBADF  epfd is not a valid file descriptor.
-            // 
+            //
             //       EFAULT The memory area pointed to by events is not accessible with write  permissions.
-            // 
+            //
             //       EINTR  The call was interrupted by a signal handler before any of the requested events
             //               occurred or the timeout expired; see signal(7).
-            // 
+            //
             //       EINVAL epfd is not an epoll file descriptor, or maxevents is less  than  or  equal  to
             //               zero.
-            
+
             if( EINTR == errno )
             {
                continue;
@@ -957,36 +5625,88 @@ bool network::ServerAsync::nonblockingListener( const socketCallback_t a_socketE
                }
             }
             continue;
-            
+
          default:
             // process all descripters
-            
+            a_reactor.pMetrics->wakeup( static_cast<uint64_t>( fdCount ) );
+
             int32_t fd;
             for( lIndex=0; lIndex<fdCount; ++lIndex )
             {
-               fd = m_pEvents[lIndex].data.fd;
-               
+               fd = pEvents[lIndex].data.fd;
+
+               // datagrams, the socket is shared by all peers and is never closed here
+               // ---------------------------
+               if( (true == bDatagram) && (a_reactor.fdListener == fd) )
+               {
+                  if( pEvents[lIndex].events & EPOLLERR )
+                  {
+                     reportDatagramError( fd, a_error, a_pData );
+                  }
+                  if( pEvents[lIndex].events & EPOLLIN )
+                  {
+                     a_reactor.pPoll->callback();
+                     if( (nullptr != m_cbDatagram) || (nullptr != m_cbMessage) )
+                     {
+                        deliverDatagrams( fd, a_reactor.vecDatagrams, m_bEdgeTriggered, m_cbMessage, m_cbDatagram, a_error, a_pData );
+                     } else
+                     {
+                        const LatencyTimer timer( callbackHistogram() );
+                        a_socketEvent( fd, network::callBack_t::MESSAGE, a_pData );
+                     }
+                  }
+                  continue;
+               }
+
+               // wakeup, messages posted by other threads
+               // ---------------------------
+               if( a_reactor.pPosted->fd() == fd )
+               {
+                  drainPosted_( a_reactor, a_error );
+                  continue;
+               }
+
+               // timers
+               // ---------------------------
+               if( a_reactor.pTimers->fd() == fd )
+               {
+                  a_reactor.pTimers->expire();
+                  continue;
+               }
+
+               // zero copy completions are reported as EPOLLERR
+               // ---------------------------
+               if( (pEvents[lIndex].events & EPOLLERR) && (nullptr != m_cbRelease) && (a_reactor.fdListener != fd) &&
+                   (true == m_vecConnections[static_cast<size_t>( fd )]->bZeroCopy) &&
+                   (true == completeZeroCopy_( fd, m_vecConnections[static_cast<size_t>( fd )] )) )
+               {
+                  pEvents[lIndex].events &= ~static_cast<uint32_t>( EPOLLERR );
+                  if( 0 == (pEvents[lIndex].events & (EPOLLIN | EPOLLOUT | EPOLLRDHUP)) )
+                  {
+                     continue;
+                  }
+               }
+
                // socket error or close
                // ---------------------------
-               if( (m_pEvents[lIndex].events & EPOLLERR) || (m_pEvents[lIndex].events & EPOLLRDHUP) )
+               if( (pEvents[lIndex].events & EPOLLERR) || (pEvents[lIndex].events & EPOLLRDHUP) )
                {
                   // handle connection closed by either hangup or network error
-                  
-                  if( nullptr != a_socketEvent )
+                  if( (nullptr != m_cbMessage) && (pEvents[lIndex].events & EPOLLIN) )
                   {
-                     a_socketEvent( fd, network::callBack_t::SESSION_CLOSE, a_pData );
+                     // deliver what the peer sent before it closed
+                     deliverMessages( m_vecConnections[static_cast<size_t>( fd )]->recvBuffer, m_framing, fd, true, deliverCallback_(), deliverData_( a_pData ), a_error, a_pData, &m_vecConnections[static_cast<size_t>( fd )]->info );
                   }
-                  ::close( fd );
-                  //::shutdown( fd, SHUT_RDWR );
-                  m_pEvents[lIndex].data.fd = 0;
-                  
+                  closeConnection_( fd, a_socketEvent, a_pData );
+
                // new connection
                // ---------------------------
-               } else if( m_fdSocket == fd )
+               } else if( a_reactor.fdListener == fd )
                {
                   // if a valid descriptor, then we have a new connection
                   //makeNonBlocking( fd );
-                  socketfd_t fdRemote = accept( m_fdSocket, dynamic_cast<struct sockaddr*>( &remoteAddress ), &remoteAddressLength );
+                  remoteAddressLength = sizeof( remoteAddress );
+                  socketfd_t fdRemote = accept( a_reactor.fdListener, reinterpret_cast<struct sockaddr*>( &remoteAddress ), &remoteAddressLength );
                   if( -1 == fdRemote )
                   {
                      // log failue
@@ -996,22 +5716,29 @@ bool network::ServerAsync::nonblockingListener( const socketCallback_t a_socketE
                      }
                      continue;
                   } else
-                  {                     
+                  {
                      makeNonBlocking( fdRemote );
-                     epoll_event epEventNewConnection;
-                     
-                     epEventNewConnection.events = EPOLLIN | EPOLLRDHUP;
-                     if( true == a_bEdgeTrigger )
+                     if( false == openConnection_( fdRemote, a_reactor, a_error, &remoteAddress, remoteAddressLength ) )
                      {
-                        epEventNewConnection.events |= EPOLLET;
+                        ::close( fdRemote );
+                        continue;
                      }
-                     epEventNewConnection.data.fd = fdRemote;  //!! not sure if this is neeeded
-                     if( -1 == epoll_ctl( m_fdEpoll, EPOLL_CTL_ADD, fdRemote, &epEventNewConnection ) )
+                     epoll_event epEventNewConnection;
+
+                     epEventNewConnection.events = connectionEvents_( false );
+                     epEventNewConnection.data.fd = fdRemote;  // index of the connection table
+                     if( -1 == epoll_ctl( a_reactor.fdEpoll, EPOLL_CTL_ADD, fdRemote, &epEventNewConnection ) )
                      {
                         // may have to check for EAGAIN
-                        string str( "error adding descriper to epoll" );
-                        str.append( strerror( errno ) );
-                        a_error( errno, str.c_str(), nullptr );
+                        const int32_t nError = errno;
+                        if( nullptr != a_error )
+                        {
+                           string str( "error adding descriper to epoll " );
+                           str.append( strerror( nError ) );
+                           a_error( nError, str.c_str(), nullptr );
+                        }
+                        // never opened for the socket callback, no SESSION_CLOSE, the slot is reset and the fd closed
+                        closeConnection_( fdRemote, nullptr, a_pData );
                         continue;
                      }
                      if( nullptr != a_socketEvent )
@@ -1021,53 +5748,357 @@ bool network::ServerAsync::nonblockingListener( const socketCallback_t a_socketE
                      // get the host name that connected
                   }
                } else
-                  
-               // data ready
-               // ---------------------------
-               if( m_pEvents[lIndex].events & EPOLLIN )
                {
-                  if( nullptr != a_socketEvent )
+                  // socket writable, drain queued bytes
+                  // ---------------------------
+                  if( pEvents[lIndex].events & EPOLLOUT )
                   {
-                     a_socketEvent( fd, network::callBack_t::MESSAGE, a_pData );
-                  } else
+                     if( false == flushConnection_( fd ) )
+                     {
+                        if( nullptr != a_error )
+                        {
+                           a_error( errno, strerror( errno ), nullptr );
+                        }
+                        closeConnection_( fd, a_socketEvent, a_pData );
+                        continue;
+                     }
+                  }
+
+                  // data ready
+                  // ---------------------------
+                  if( pEvents[lIndex].events & EPOLLIN )
                   {
-                     a_error( 0, "no socket callback set to read data", nullptr );
+                     a_reactor.pPoll->callback();
+                     if( nullptr != m_cbMessage )
+                     {
+                        if( false == deliverMessages( m_vecConnections[static_cast<size_t>( fd )]->recvBuffer, m_framing, fd, m_bEdgeTriggered, deliverCallback_(), deliverData_( a_pData ), a_error, a_pData, &m_vecConnections[static_cast<size_t>( fd )]->info ) )
+                        {
+                           // EOF or error, same as HUP
+                           closeConnection_( fd, a_socketEvent, a_pData );
+                        }
+                     } else if( nullptr != a_socketEvent )
+                     {
+                        const LatencyTimer timer( callbackHistogram() );
+                        a_socketEvent( fd, network::callBack_t::MESSAGE, a_pData );
+                     } else
+                     {
+                        a_error( 0, "no socket callback set to read data", nullptr );
+                     }
+                  }
+                  else if( 0 == (pEvents[lIndex].events & EPOLLOUT) )
+                  {
+                     string str( "unhandled socket event:" );
+                     str.append( std::to_string( static_cast<int64_t>( fd ) ) );  // gcc 4.4 does not have an overload for int
+                     a_error( 0, str.c_str(), nullptr );
                   }
-               }                   
-               else 
-               {
-                  string str( "unhandled socket event:" );
-                  str.append( std::to_string( static_cast<int64_t>( fd ) ) );  // gcc 4.4 does not have an overload for int
-                  a_error( 0, str.c_str(), nullptr );
                }
             }
       }
-      
+
+   }
+   closeConnections_( a_reactor, a_socketEvent, a_pData );
+   if( a_reactor.fdListener != m_fdSocket )
+   {
+      ::close( a_reactor.fdListener );   // reactor owned listener, the main listener is closed in join
+   }
+   a_reactor.fdListener = -1;
+   ::close( a_reactor.fdEpoll );
+   a_reactor.fdEpoll = -1;
+   if( true == m_bUseMalloc )
+   {
+      free( pEvents );
+   }
+   t_nReactorId = -1;
+   t_pMetrics   = nullptr;
+   t_pLatency   = nullptr;
+
+   return true;
+}
+
+
+
+/**
+ * @brief ...io_uring loop for one reactor, same callbacks as reactorLoop_.  Accept and receive stay armed in the kernel
+ * (multishot), received bytes arrive in the provided buffers of the ring, and the sends queued by the callbacks are
+ * submitted together with the wait for the next completions, so a busy reactor makes about one syscall per batch
+ *
+ * @param a_reactor ...listener of this reactor, fdEpoll is set to the ring
+ * @param a_socketEvent ...callback on good socket events (conection, HUP and data ready
+ * @param a_error ...error callback handler
+ * @param a_pData ...pointer to pass back to callbacks
+ * @return bool
+ */
+bool network::ServerAsync::uringLoop_( reactor_t& a_reactor, const socketCallback_t a_socketEvent, const errorCallBack_t a_error, void* a_pData )
+{
+   t_nReactorId = a_reactor.nId;
+   t_pMetrics   = a_reactor.pMetrics.get();
+   t_pLatency   = a_reactor.pLatency.get();
+   pinReactor_( a_reactor, a_error );
+
+   URing ring;
+   if( (false == ring.init( s_nUringEntries )) || ((nullptr != m_cbMessage) && (false == ring.setupBuffers( 0, s_nUringBufferCount, s_nUringBufferSize ))) )
+   {
+      if( nullptr != a_error )
+      {
+         string str( "io_uring setup failed: " );
+         str.append( strerror( errno ) );
+         a_error( errno, str.c_str(), nullptr );
+      }
+      t_nReactorId = -1;
+      t_pMetrics   = nullptr;
+      t_pLatency   = nullptr;
+      return false;
+   }
+   a_reactor.pRing   = &ring;
+   a_reactor.fdEpoll = ring.getfd();
+
+   const uringOp_t readOp = (nullptr != m_cbMessage) ? uringOp_t::RECV : uringOp_t::POLL;
+   auto armRead = [&]( const socketfd_t a_fd, const uint32_t a_nGeneration )
+   {
+      if( uringOp_t::RECV == readOp )
+      {
+         ring.prepRecvMultishot( a_fd, uringData( uringOp_t::RECV, a_nGeneration, a_fd ) );
+      } else
+      {
+         ring.prepPollMultishot( a_fd, POLLIN | POLLRDHUP, uringData( uringOp_t::POLL, a_nGeneration, a_fd ) );
+      }
+   };
+
+   ::listen( a_reactor.fdListener, m_nBacklog );
+   ring.prepAcceptMultishot( a_reactor.fdListener, uringData( uringOp_t::ACCEPT, 0, a_reactor.fdListener ) );
+   ring.prepPollMultishot( a_reactor.pPosted->fd(), POLLIN, uringData( uringOp_t::WAKE, 0, a_reactor.pPosted->fd() ) );
+   ring.prepPollMultishot( a_reactor.pTimers->fd(), POLLIN, uringData( uringOp_t::TIMER, 0, a_reactor.pTimers->fd() ) );
+   if( 0 <= m_nEpollTimeout_ms )
+   {
+      ring.prepTimeout( m_nEpollTimeout_ms, uringData( uringOp_t::TIMEOUT, 0, 0 ) );
    }
-   for( int32_t nIndex=0; nIndex<m_nMaximumEpollEvents; nIndex++ )
+
+   while( m_bAsyncRunFlag )
    {
-      if( (m_pEvents+nIndex)->data.fd > 0 )
+      // sends queued by the callbacks go out with the wait
+      for( auto fd : a_reactor.vecSendReady )
       {
-         if( -1 == ::shutdown( (m_pEvents+nIndex)->data.fd, SHUT_RDWR ) )
+         connection_t* pConnection = connection_( fd );
+         if( nullptr != pConnection )
          {
-            cout << "shutdown fail fd:" << (m_pEvents+nIndex)->data.fd << endl;
-         } else
+            pConnection->bWritePending = false;
+            if( false == pConnection->bSendInFlight )
+            {
+               submitSend_( fd, pConnection, ring );
+            }
+         }
+      }
+      a_reactor.vecSendReady.clear();
+
+      a_reactor.pMetrics->waiting();
+      if( -1 == ring.submitAndWait() )
+      {
+         if( (EINTR == errno) || (EAGAIN == errno) || (EBUSY == errno) )
+         {
+            continue;
+         }
+         if( nullptr != a_error )
+         {
+            string str( "io_uring error: " );
+            str.append( strerror( errno ) );
+            a_error( errno, str.c_str(), nullptr );
+         }
+         m_bAsyncRunFlag = false;
+         continue;
+      }
+
+      // the completions are counted as they are reaped
+      a_reactor.pMetrics->wakeup( 0 );
+      io_uring_cqe* pCqe;
+      while( nullptr != (pCqe = ring.peekCqe()) )
+      {
+         const uint64_t    nUserData = pCqe->user_data;
+         const int32_t     nResult   = pCqe->res;
+         const uint32_t    nFlags    = pCqe->flags;
+         const socketfd_t  fd        = uringFd( nUserData );
+         ring.cqeSeen();
+         a_reactor.pMetrics->add( metric_t::EVENTS );
+
+         // completions of a closed connection, or of a previous connection on the same fd, are dropped
+         connection_t* pConnection = connection_( fd );
+         if( (nullptr != pConnection) && ((pConnection->nGeneration & 0xFFFFFF) != uringGeneration( nUserData )) )
+         {
+            pConnection = nullptr;
+         }
+
+         switch( uringOp( nUserData ) )
          {
-            cout << "shutdown ok fd:" << (m_pEvents+nIndex)->data.fd << endl;
+            // new connection
+            // ---------------------------
+            case uringOp_t::ACCEPT:
+               if( nResult >= 0 )
+               {
+                  // accepted non-blocking
+                  if( false == openConnection_( nResult, a_reactor, a_error, nullptr, 0 ) )
+                  {
+                     ::close( nResult );
+                  } else
+                  {
+                     armRead( nResult, m_vecConnections[static_cast<size_t>( nResult )]->nGeneration );
+                     if( nullptr != a_socketEvent )
+                     {
+                        a_socketEvent( nResult, network::callBack_t::SESION_OPEN, a_pData );
+                     }
+                  }
+               } else if( (-ECANCELED != nResult) && (nullptr != a_error) )
+               {
+                  a_error( -nResult, strerror( -nResult ), nullptr );
+               }
+               if( (0 == (nFlags & IORING_CQE_F_MORE)) && (true == m_bAsyncRunFlag) )
+               {
+                  ring.prepAcceptMultishot( a_reactor.fdListener, uringData( uringOp_t::ACCEPT, 0, a_reactor.fdListener ) );
+               }
+               break;
+
+            // data received into a provided buffer
+            // ---------------------------
+            case uringOp_t::RECV:
+               if( nFlags & IORING_CQE_F_BUFFER )
+               {
+                  const uint16_t nBufferId = static_cast<uint16_t>( nFlags >> IORING_CQE_BUFFER_SHIFT );
+                  if( (nullptr != pConnection) && (nResult > 0) &&
+                      (false == deliverReceived( pConnection->recvBuffer, m_framing, fd, ring.buffer( nBufferId ), static_cast<size_t>( nResult ), deliverCallback_(), deliverData_( a_pData ), a_error, a_pData, &pConnection->info )) )
+                  {
+                     closeConnection_( fd, a_socketEvent, a_pData );
+                     pConnection = nullptr;
+                  }
+                  ring.recycleBuffer( nBufferId );
+               }
+               if( nullptr == pConnection )
+               {
+                  break;
+               }
+               if( (0 == nResult) || ((nResult < 0) && (-ENOBUFS != nResult)) )
+               {
+                  // EOF or error, same as HUP
+                  if( (nResult < 0) && (-ECANCELED != nResult) && (nullptr != a_error) )
+                  {
+                     a_error( -nResult, strerror( -nResult ), nullptr );
+                  }
+                  closeConnection_( fd, a_socketEvent, a_pData );
+               } else if( 0 == (nFlags & IORING_CQE_F_MORE) )
+               {
+                  // ran out of provided buffers or the kernel ended the multishot, arm again
+                  armRead( fd, pConnection->nGeneration );
+               }
+               break;
+
+            // data ready, the application reads
+            // ---------------------------
+            case uringOp_t::POLL:
+               if( nullptr == pConnection )
+               {
+                  break;
+               }
+               if( (nResult < 0) || (nResult & (POLLRDHUP | POLLHUP | POLLERR)) )
+               {
+                  closeConnection_( fd, a_socketEvent, a_pData );
+                  break;
+               }
+               if( nResult & POLLIN )
+               {
+                  if( nullptr != a_socketEvent )
+                  {
+                     const LatencyTimer timer( callbackHistogram() );
+                     a_socketEvent( fd, network::callBack_t::MESSAGE, a_pData );
+                  } else if( nullptr != a_error )
+                  {
+                     a_error( 0, "no socket callback set to read data", nullptr );
+                  }
+               }
+               if( (0 == (nFlags & IORING_CQE_F_MORE)) && (nullptr != connection_( fd )) )
+               {
+                  armRead( fd, pConnection->nGeneration );
+               }
+               break;
+
+            // send completed, continue with the rest of the in flight bytes or the bytes queued meanwhile
+            // ---------------------------
+            case uringOp_t::SEND:
+               if( nullptr == pConnection )
+               {
+                  break;
+               }
+               if( nResult < 0 )
+               {
+                  if( nullptr != a_error )
+                  {
+                     a_error( -nResult, strerror( -nResult ), nullptr );
+                  }
+                  closeConnection_( fd, a_socketEvent, a_pData );
+                  break;
+               }
+               pConnection->inflightQueue.consume( static_cast<size_t>( nResult ) );
+               if( false == pConnection->inflightQueue.empty() )
+               {
+                  const size_t nSize = pConnection->inflightQueue.size();
+                  ring.prepSend( fd, pConnection->inflightQueue.data(), (nSize < s_nUringMaxSend) ? nSize : s_nUringMaxSend, uringData( uringOp_t::SEND, pConnection->nGeneration, fd ) );
+               } else
+               {
+                  pConnection->bSendInFlight = false;
+                  submitSend_( fd, pConnection, ring );
+               }
+               if( (true == pConnection->bHighWatermark) && (pConnection->sendQueue.size() + pConnection->inflightQueue.size() <= m_nLowWatermark) )
+               {
+                  pConnection->bHighWatermark = false;
+                  if( nullptr != m_cbSocketEvent )
+                  {
+                     m_cbSocketEvent( fd, network::callBack_t::WRITE_LOW_WATERMARK, m_pCallbackData );
+                  }
+               }
+               break;
+
+            // wakes the loop to check the run flag
+            // ---------------------------
+            case uringOp_t::TIMEOUT:
+               if( true == m_bAsyncRunFlag )
+               {
+                  ring.prepTimeout( m_nEpollTimeout_ms, uringData( uringOp_t::TIMEOUT, 0, 0 ) );
+               }
+               break;
+
+            // messages posted by other threads
+            // ---------------------------
+            case uringOp_t::WAKE:
+               drainPosted_( a_reactor, a_error );
+               if( (0 == (nFlags & IORING_CQE_F_MORE)) && (true == m_bAsyncRunFlag) )
+               {
+                  ring.prepPollMultishot( a_reactor.pPosted->fd(), POLLIN, uringData( uringOp_t::WAKE, 0, a_reactor.pPosted->fd() ) );
+               }
+               break;
+
+            // timers
+            // ---------------------------
+            case uringOp_t::TIMER:
+               a_reactor.pTimers->expire();
+               if( (0 == (nFlags & IORING_CQE_F_MORE)) && (true == m_bAsyncRunFlag) )
+               {
+                  ring.prepPollMultishot( a_reactor.pTimers->fd(), POLLIN, uringData( uringOp_t::TIMER, 0, a_reactor.pTimers->fd() ) );
+               }
+               break;
+
+            default:
+               break;
          }
       }
    }
-   close();   // close listener
-   ::close( m_fdEpoll );
-   if( true == m_bUseMalloc )
+
+   closeConnections_( a_reactor, a_socketEvent, a_pData );
+   if( a_reactor.fdListener != m_fdSocket )
    {
-      free( m_pEvents );
-      m_pEvents = nullptr;
+      ::close( a_reactor.fdListener );   // reactor owned listener, the main listener is closed in join
    }
-   
-   
+   a_reactor.fdListener = -1;
+   a_reactor.fdEpoll    = -1;
+   a_reactor.pRing      = nullptr;
+   t_nReactorId = -1;
+   t_pMetrics   = nullptr;
+   t_pLatency   = nullptr;
+
    return true;
 }
-
-
-
@@ -6,32 +6,90 @@
 #include <condition_variable>
 #include <cstddef>
 #include <cstdint>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
 #include <limits.h> 
 #include <sys/socket.h>
 #include <sys/epoll.h>
+#include <sys/uio.h>
 #include <netdb.h>
 
 #include <iostream>
 #include <exception>
 
+#include "bufferpool.h"
+#include "workerpool.h"
+#include "postqueue.h"
+#include "timerwheel.h"
+#include "busypoll.h"
+#include "metrics.h"
+#include "histogram.h"
+#include "framing.h"
+#include "sendqueue.h"
+#include "uring.h"
+#include "connector.h"
+
 namespace gdlib {
 namespace network
 {
-   enum struct protocol_t: int32_t { TCP };
+   enum struct protocol_t: int32_t { TCP, UDP, SEQPACKET };    // SEQPACKET, AF_UNIX only, a stream that keeps the message boundaries
    enum struct sockType_t: int32_t { CLIENT, SERVER, UNSPEC };
-   enum struct callBack_t: int32_t { MESSAGE, SESION_OPEN, SESSION_CLOSE, UNDEFINED };
+   enum struct callBack_t: int32_t { MESSAGE, SESION_OPEN, SESSION_CLOSE, WRITE_HIGH_WATERMARK, WRITE_LOW_WATERMARK, UNDEFINED };
+   enum struct engine_t: int32_t   { EPOLL, IO_URING };     // event engine of the async classes, IO_URING falls back to EPOLL if the kernel lacks support
    enum struct LogLevel: int32_t   { EERRALERT, EERR, EWRNALERT, EWRN, EINF, EOK };  // do not include LogFileHandler.h, too much bagage
+   enum struct sessionState_t: int32_t { CONNECTING, OPEN, RETRY_WAIT, CLOSED };    // of a client connection, see ClientAsync::setReconnect
    
    using socketfd_t = int32_t;
    //typedef void( *socketCallback_t     )( const socketfd_t& a_fd, const callBack_t& a_type, void* const a_pData );
    using socketCallback_t = void( * )( const socketfd_t& a_fd, const callBack_t& a_type, void* const a_pData );
    using errorCallBack_t  = void( * )( const int32_t a_nerrno, const char* a_pszError, void* const a_pData );
    using logCallBack_t    = void( * )( const LogLevel a_nLevel, const char* a_pszError );
+   using messageCallback_t= void( * )( const socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData );  // complete message, view into the connections receive buffer
+   using releaseCallback_t= void( * )( const socketfd_t& a_fd, const void* a_pBuffer, void* const a_pData );  // zero copy send done with the buffer, it can be reused
+   using stateCallback_t  = void( * )( const sessionState_t a_state, const int32_t a_nError, void* const a_pData );  // a_nError errno of the lost connection or failed connect, 0 none
    #define PORT_DIGIT_COUNT_INT32 5
+
+   /**
+    * @brief one datagram of a batch receive or send, see Sockets::receiveBatch and sendBatch
+    * the buffer is owned by the caller (or a pool), the library fills in the length and the peer
+    */
+   struct datagram_t
+   {
+      void*                   pBuffer        = nullptr;
+      size_t                  nSize          = 0;                    // receive: capacity of pBuffer.  send: bytes to send
+      size_t                  nLength        = 0;                    // receive: bytes received
+      struct sockaddr_storage peer           = sockaddr_storage();   // receive: sender.  send: destination
+      socklen_t               nPeerLength    = 0;                    // send: 0 for a connected socket
+      bool                    bTruncated     = false;                // receive: datagram larger than nSize, the rest is lost
+   };
+   using datagramCallback_t = void( * )( const socketfd_t& a_fd, const datagram_t& a_datagram, void* const a_pData );  // UDP, one datagram, buffer valid until the callback returns
+
+   /**
+    * @brief one connection of ServerAsync, see getConnectionInfo.  the counters are kept by the reactor, bytes in and
+    * messages in only with a message callback (else the application reads the socket itself)
+    */
+   struct connectionInfo_t
+   {
+      struct sockaddr_storage peer           = sockaddr_storage();
+      socklen_t               nPeerLength    = 0;
+      void*                   pContext       = nullptr;     // setContext
+      int32_t                 nReactor       = -1;
+      uint64_t                nBytesIn       = 0;
+      uint64_t                nBytesOut      = 0;           // taken by send, sendv, sendFile and post, written or queued
+      uint64_t                nMessagesIn    = 0;           // message callbacks
+      uint64_t                nMessagesOut   = 0;           // sends
+      int64_t                 nOpened_ms     = 0;           // CLOCK_REALTIME of the accept
+   };
    
    /**
     * @brief base class for socket libary.  use the parent classes
-    * currenly only handles TCP
+    * TCP, or UDP when open is called with protocol_t::UDP (the server binds without listen, the client connects to set the peer)
+    * a path-style hostname, "/path", "./path" or "@name" (abstract namespace, no file), opens an AF_UNIX socket instead, SOCK_STREAM
+    * for TCP or SOCK_SEQPACKET for protocol_t::SEQPACKET, and the port is not used.  same host peers skip the TCP/IP stack, the
+    * classes and callbacks are the same.  the server removes a stale socket file left by a server that is gone before bind and
+    * its own file on close.  sendFd/receiveFd pass a file descriptor along with the bytes (SCM_RIGHTS)
     * These libraies should not be derirved, esp as virtual as no virtuals are defined here
     */
    class Sockets
@@ -44,17 +102,25 @@ namespace network
          int32_t     m_nSocketType              = SOCK_STREAM;           // specify stream for std net
          int32_t     m_nSocketFamily            = AF_INET;               // specify inet for IPV4 or IPV6
          int32_t     m_nSocketFlags             = 0;                     // flags to specify server or client
+         bool        m_bReusePort               = false;                 // server side, set SO_REUSEPORT before bind so several listeners can share the port
+         uint32_t    m_nConnectTimeout_ms       = 0;                     // client side, deadline of the connect, 0 none (the kernel SYN timeout)
+         uint32_t    m_nConnectAttempt_ms       = 0;                     // client side, deadline per address of the host, 0 none
          sockType_t  m_type                     = sockType_t::UNSPEC;    // client -> publisher. server -> subscriber
-         protocol_t  m_protocol                 = protocol_t::TCP;       // spec protocol.  TCP, UDP.  Only TCP implimented
+         protocol_t  m_protocol                 = protocol_t::TCP;       // spec protocol.  TCP, UDP, SEQPACKET
          char*       m_pszHostname              = nullptr;               // for client, hostname to connect, for server, localhost or name
          char        m_szPort[PORT_DIGIT_COUNT_INT32+1];                 // port number 1..xFFFF as a string
+         bool        m_bUnlink                  = false;                 // server bound an AF_UNIX path, removed on close
 
          
       protected:
          bool makeNonBlocking( socketfd_t& a_fd );
          bool isNonBlocking( socketfd_t& a_fd );
+         socketfd_t reusePortListener_() const;
+         bool       listenUnix_();
          
       public:
+         static constexpr uint32_t s_nMaxBatch = 256;   // datagrams per recvmmsg/sendmmsg call
+
          Sockets( ) = default;
          Sockets( const Sockets& ) = delete;
          ~Sockets();
@@ -67,14 +133,22 @@ namespace network
          
          bool           setNoDelay(); // bypass nagle
          void           setListenerBacklog( int32_t a_nBacklog ) { m_nBacklog = a_nBacklog; }    // must be called before bind or default will be used, sets number of connection queuedon listener
+         void           setReusePort( bool a_bReusePort )       { m_bReusePort = a_bReusePort; }  // must be called before open, allows more than one listener bound to the port
+         void           setConnectTimeout( uint32_t a_nTimeout_ms, uint32_t a_nAttempt_ms = 0 ) { m_nConnectTimeout_ms = a_nTimeout_ms; m_nConnectAttempt_ms = a_nAttempt_ms; }  // client, before open, see Connector
          int32_t        getfd() { return m_fdSocket; }
 
 
          static bool    setOption( const socketfd_t a_fd, const int a_level, const int a_optName, const int a_nValue );
          static int     getOption( const socketfd_t a_fd, const int a_level, const int a_optName, int& a_nValue, socklen_t& a_len );
          static ssize_t send            ( const socketfd_t& a_fd, const void* a_pBuffer, const ssize_t& a_nBufferSzie );
+         static ssize_t sendv           ( const socketfd_t& a_fd, const struct iovec* a_pIov, const int32_t a_nCount );   // scatter-gather, any count, one writev per IOV_MAX entries
+         static ssize_t sendFile        ( const socketfd_t& a_fd, const int32_t a_fdFile, const off_t a_nOffset, const size_t a_nLength );  // sendfile, splice when the file is a pipe
          static ssize_t receive         ( const socketfd_t& a_fd, void* a_pBuffer, const ssize_t& a_nBufferSize );
          static ssize_t receive_blocking( const socketfd_t& a_fd, void* a_pBuffer, const ssize_t& a_nBufferSize );
+         static int32_t receiveBatch    ( const socketfd_t& a_fd, datagram_t* a_pDatagrams, const uint32_t a_nCount, const int32_t a_nFlags = 0 );  // UDP, recvmmsg
+         static int32_t sendBatch       ( const socketfd_t& a_fd, const datagram_t* a_pDatagrams, const uint32_t a_nCount, const int32_t a_nFlags = 0 );  // UDP, sendmmsg
+         static ssize_t sendFd          ( const socketfd_t& a_fd, const int32_t a_fdPass, const void* a_pBuffer, const size_t a_nBufferSize );  // AF_UNIX, SCM_RIGHTS
+         static ssize_t receiveFd       ( const socketfd_t& a_fd, void* a_pBuffer, const size_t a_nBufferSize, int32_t& a_fdPassed );           // AF_UNIX, SCM_RIGHTS
          static int32_t getDefaultServerSocketFlags() { return AI_PASSIVE | AI_NUMERICSERV; }
          static int32_t getDefaultClientSocketFlags() { return AI_NUMERICSERV; }
    };
@@ -91,7 +165,13 @@ namespace network
          Client() = default;
          bool     connect( const std::string& a_strHostname, std::string a_strPort, protocol_t a_proto = protocol_t::TCP );
          ssize_t  send   ( const void* a_pBuffer, const ssize_t& a_nBufferSize );
+         ssize_t  sendv  ( const struct iovec* a_pIov, const int32_t a_nCount );
+         ssize_t  sendFile( const int32_t a_fdFile, const off_t a_nOffset, const size_t a_nLength );
          ssize_t  receive( void* a_pBuffer, const ssize_t& a_nBufferSize );
+         int32_t  receiveBatch( datagram_t* a_pDatagrams, const uint32_t a_nCount );
+         int32_t  sendBatch( const datagram_t* a_pDatagrams, const uint32_t a_nCount );
+         ssize_t  sendFd( const int32_t a_fdPass, const void* a_pBuffer, const size_t a_nBufferSize )      { return Sockets::sendFd( m_fdSocket, a_fdPass, a_pBuffer, a_nBufferSize ); }
+         ssize_t  receiveFd( void* a_pBuffer, const size_t a_nBufferSize, int32_t& a_fdPassed )          { return Sockets::receiveFd( m_fdSocket, a_pBuffer, a_nBufferSize, a_fdPassed ); }
    };
 
 
@@ -100,51 +180,413 @@ namespace network
     * @brief async (non-blocking) client
     * @example see testing/async/client.cpp
     * 
+    * @details setMessageCallback, setFraming and setReceiveBufferSize work as in ServerAsync
+    * 
+    * setConnectTimeout      connect and each reconnect attempt connect non-blocking and give up after a_nTimeout_ms, or an
+    *    address of the host after a_nAttempt_ms, with ETIMEDOUT instead of waiting for the kernel SYN timeout.  0 none.  the
+    *    host is resolved through the Resolver cache, a reconnect after a network blip does not wait for DNS again (see
+    *    Resolver::setTtl, Resolver::prewarm)
+    * setReconnect           a connection lost (EOF, socket error or HUP) is connected again by the receiver thread itself, up to
+    *    a_nRetryCount times (-1 without end, 0 none, the default).  the wait before each attempt is a_nWait_ms doubled per
+    *    failed attempt up to a_nMaxWait_ms, and a random half of it is dropped (jitter) so that clients which lost the server
+    *    at the same time do not come back at the same time.  the connect is non-blocking (setConnectTimeout bounds it), the
+    *    host is looked up again in the background while waiting, a host not cached by then is resolved on a resolver thread
+    *    and the receiver thread goes on meanwhile.  the count and the wait are restored once connected.  send
+    *    and post fail (EBADF) while the connection is down, posted messages not sent when it was lost are dropped, never sent
+    *    on the next connection.  SESSION_CLOSE is called back for the lost socket
+    * setStateCallback       CONNECTING, OPEN, RETRY_WAIT and CLOSED of the connection, on the receiver thread with the errno of
+    *    the lost connection or failed connect, getState.  before startAsync
+    * reconnect              any thread, never blocks.  sets the retries (a_nRetryWait in s) and starts reconnecting if the
+    *    connection is down, a_cbLog gets a line per attempt
+    * send                   thread safe.  once startAsync is running, what the socket does not take is queued and written by the
+    *    receiver thread on EPOLLOUT, the caller never spins on a full socket.  setWriteWatermarks as in ServerAsync
+    * sendv                  as send, scatter-gather from iovecs
+    * post                   send without taking the send lock, for threads that must not block.  the message is copied (or a
+    *    PoolBuffer referenced) into a lock-free queue and sent by the receiver thread, see ServerAsync post.  needs startAsync
+    * setTimer               timer on the receiver thread as ServerAsync setTimer (a_fd is -1 in the callback), call from a callback
+    * setBusyPoll            as in ServerAsync for the receiver thread, setReceiverCpu pins it, getPollStats
+    * getMetrics             as in ServerAsync for the receiver thread.  send and sendv are counted from any thread, under the send
+    *    lock they take anyway (a datagram or a send before startAsync takes it for the count).  setMetricsLog
+    * getLatency             as in ServerAsync for the callbacks of the receiver thread and the sends through the queue, the wait
+    *    for the send lock is not included.  resetLatency
+    * stop, wakeup           as in ServerAsync, the receiver thread blocks until an event (epoll timeout -1) and is woken through
+    *    the eventfd of post
+    * 
+    * engine_t::IO_URING     see ServerAsync.  send still writes on the calling thread, a remainder is written when a POLLOUT
+    *    submitted to the ring completes.  a reconnect waits for its connect with a POLLOUT on the ring
+    * 
+    * protocol_t::UDP        connect sets the peer.  send/sendv/sendBatch send whole datagrams and are never queued.  with a message
+    *    callback the datagrams are read in batches of setDatagramBatch with recvmmsg and each is one message, framing is not used
+    *    and setReceiveBufferSize is the largest datagram.  ICMP errors are reported to the error callback, the socket stays open.
+    *    always runs on EPOLL
+    * 
+    * AF_UNIX                a path-style host, see Sockets.  reconnect and setConnectTimeout as for TCP (a listener with a full
+    *    backlog fails the attempt with EAGAIN).  sendFd/receiveFd of Client run on the calling thread, not through the send queue,
+    *    and a message callback reads the socket itself, the kernel closes the descriptors passed with what it read.  receive
+    *    them with the socket callback: MESSAGE, then receiveFd until EAGAIN
     */
    class ClientAsync : public Client
    {
       private:
+         // a resolve outlives the client, its callback finds the client through this and leaves the addresses for the
+         // receiver thread
+         struct resolving_t
+         {
+            std::mutex        mux            = std::mutex();
+            ClientAsync*      pOwner         = nullptr;        // nullptr once the client is gone
+            uint64_t          nLookup        = 0;              // lookup of the result below, 0 none
+            int32_t           nError         = 0;
+            std::vector<address_t> vecAddresses = std::vector<address_t>();
+         };
+
+         struct lookup_t
+         {
+            std::shared_ptr<resolving_t> pResolving = nullptr;
+            uint64_t          nLookup        = 0;
+         };
+
          int32_t                       m_fdEpoll                = 0;            // server side epolling
          int32_t                       m_nMaximumEpollEvents    = 100;          // server side epolling
-         int32_t                       m_nEpollTimeout_ms       = 1000;         // number of ms for epoll_wait timeout
+         int32_t                       m_nEpollTimeout_ms       = -1;           // number of ms for epoll_wait timeout, -1 blocks until an event or wakeup
          int32_t                       m_nPollingErrorCount     = 1;            // max number of consecuritve errors before epoll fails
-         bool                          m_bAsyncRunFlag          = true;
+         std::atomic<bool>             m_bAsyncRunFlag          = {true};
          bool                          m_bUseMalloc             = true;
          bool                          m_bEdgeTriggered         = true;
          epoll_event*                  m_pEvents                = nullptr;
          std::thread                   m_thdReceiver            = std::thread();
+         std::thread::id               m_idReceiver             = std::thread::id();
+         messageCallback_t             m_cbMessage              = nullptr;      // if set, data is read by the library and delivered as complete messages
+         framingSpec_t                 m_framing                = framingSpec_t();
+         uint32_t                      m_nReceiveBufferSize     = 65536;
+         RecvBuffer                    m_recvBuffer             = RecvBuffer();
+         socketCallback_t              m_cbSocketEvent          = nullptr;
+         void*                         m_pCallbackData          = nullptr;
+
+         // outbound queue, send is called from application threads, the reactor drains on EPOLLOUT
+         SendQueue                     m_sendQueue              = SendQueue();
+         std::mutex                    m_muxSend                = std::mutex();
+         size_t                        m_nHighWatermark         = 1024*1024;    // queued bytes to report WRITE_HIGH_WATERMARK
+         size_t                        m_nLowWatermark          = 256*1024;     // queued bytes to report WRITE_LOW_WATERMARK after a high
+         bool                          m_bSendQueueReady        = false;        // reactor is running, sends are queued
+         bool                          m_bWritePending          = false;        // EPOLLOUT registered
+         bool                          m_bHighWatermark         = false;
+         PostQueue                     m_posted                 = {};           // post, drained by the receiver thread
+         std::atomic<uint64_t>         m_nPostTag               = {0};          // connection the posts are for, 0 while down
+         uint64_t                      m_nConnections           = 0;            // connections opened, the tag of the last
+         TimerWheel                    m_timers                 = {};           // setTimer, expired by the receiver thread
+         BusyPoll                      m_poll                   = {};           // epoll_wait of the receiver thread, blocking or spinning
+         uint32_t                      m_nSpin_us               = 0;            // busy poll after an event, 0 blocks
+         uint32_t                      m_nBusyPoll_us           = 0;            // SO_BUSY_POLL on the socket, 0 not set
+         int32_t                       m_nCpu                   = -1;           // receiver thread pinned to it, -1 not pinned
+         Metrics                       m_metrics                = {};           // counters of the receiver thread, the send counters under m_muxSend
+         logCallBack_t                 m_cbMetricsLog           = nullptr;      // periodic metrics line, on the receiver thread
+         uint32_t                      m_nMetricsInterval_ms    = 0;
+         metrics_t                     m_lastMetrics            = metrics_t();
+         uint64_t                      m_nLastMetrics_ns        = 0;
+         std::unique_ptr<latency_t>    m_pLatency               = nullptr;      // GSOCK_HISTOGRAMS builds, callbacks on the receiver thread, sends under m_muxSend
+
+         // IO_URING engine, m_muxSend also serializes submissions to the ring
+         engine_t                      m_engine                 = engine_t::EPOLL;
+         URing                         m_ring                   = URing();
+         uint32_t                      m_nGeneration            = 0;            // bumped per connection, completions of an older socket are dropped
+
+         // reconnect, run by the receiver thread.  the retries are set under m_muxSend and picked up on the next wakeup
+         errorCallBack_t               m_cbError                = nullptr;
+         stateCallback_t               m_cbState                = nullptr;
+         std::atomic<logCallBack_t>    m_cbReconnectLog         = {nullptr};     // reconnect, set from any thread
+         int32_t                       m_nRetryCount            = 0;            // -1 without end, 0 none
+         uint32_t                      m_nRetryWait_ms          = 100;          // before the first attempt, doubled per failed one
+         uint32_t                      m_nRetryMaxWait_ms       = 30000;
+         std::atomic<bool>             m_bRetriesChanged        = {false};      // setReconnect since the receiver thread last looked
+         std::atomic<sessionState_t>   m_state                  = {sessionState_t::CLOSED};
+         int32_t                       m_nRetriesLeft           = 0;
+         uint32_t                      m_nRetryAttempt          = 0;            // failed attempts since the last open, the backoff exponent
+         uint64_t                      m_nRetryTimer            = 0;            // reconnect or connect deadline scheduled, 0 none
+         socketfd_t                    m_fdConnectPoll          = -1;           // IO_URING, socket of the connect with a POLLOUT on the ring
+         Connector                     m_connector              = {};           // CONNECTING
+         uint64_t                      m_nLookup                = 0;            // resolve in flight, 0 none
+         uint64_t                      m_nLookups               = 0;            // last resolve id
+         uint64_t                      m_nConnect_ns            = 0;            // start of the connect, the lookup counts against its deadline
+         std::shared_ptr<resolving_t>  m_pResolving             = std::make_shared<resolving_t>();
+
+         // UDP, one batch of datagrams for recvmmsg
+         uint32_t                      m_nDatagramBatch         = 64;
+         std::vector<datagram_t>       m_vecDatagrams           = std::vector<datagram_t>();
+         std::vector<uint8_t>          m_vecDatagramBuffer      = std::vector<uint8_t>();
 
          mutable std::condition_variable       m_cvReady        = std::condition_variable();                               // used to signal when the unblockedListener is ready
          mutable std::mutex                    m_muxReady       = std::mutex();
          
          // reconmnect thread params
          bool startAsync_( const socketCallback_t a_message, const errorCallBack_t a_error = nullptr, void* const a_pThis = nullptr );
+         uint32_t socketEvents_( const bool a_bWrite ) const;
+         bool     flush_();
+         ssize_t  sent_( const ssize_t a_nBytes );
+         void     stopSendQueue_();
+         bool     armWrite_();
+         bool     uringLoop_( const socketCallback_t a_onSocketEvent, const errorCallBack_t a_error, void* const a_pThis );
+         void     armRead_();
+         void     closeSocket_( const socketCallback_t a_onSocketEvent, void* const a_pThis, const int32_t a_nError );
+         void     drainPosted_( const errorCallBack_t a_error, void* const a_pThis );
+         void     applyRetries_();
+         void     scheduleRetry_( const int32_t a_nError );
+         void     connect_();
+         void     resolved_();
+         void     connecting_( const connectStatus_t a_status );
+         void     failed_( const int32_t a_nError );
+         void     opened_( const socketfd_t a_fd );
+         void     setState_( const sessionState_t a_state, const int32_t a_nError );
+         void     log_( const LogLevel a_level, const char* a_pszLine ) const;
+         static void logMetrics_( const int32_t& a_fd, const uint64_t a_nTimer, void* const a_pData );
+         static void retry_( const int32_t& a_fd, const uint64_t a_nTimer, void* const a_pData );
+         static void expired_( const int32_t& a_fd, const uint64_t a_nTimer, void* const a_pData );
+         static void lookedUp_( const int32_t a_nError, const std::vector<address_t>& a_vecAddresses, void* const a_pData );
        
       public:
-         ClientAsync( int32_t a_nMaxEpollEvents = 100, int32_t a_nEpollTimeout_ms = 1000, int32_t a_nPollingErrorCount = 1 ) :
+         ClientAsync( int32_t a_nMaxEpollEvents = 100, int32_t a_nEpollTimeout_ms = -1, int32_t a_nPollingErrorCount = 1, const engine_t a_engine = engine_t::EPOLL ) :
              m_nMaximumEpollEvents( a_nMaxEpollEvents ),
              m_nEpollTimeout_ms( a_nEpollTimeout_ms ),
-             m_nPollingErrorCount( a_nPollingErrorCount )
+             m_nPollingErrorCount( a_nPollingErrorCount ),
+             m_engine( ((engine_t::IO_URING == a_engine) && (true == URing::isSupported())) ? engine_t::IO_URING : engine_t::EPOLL )
          {}
 
+         ~ClientAsync();
          ClientAsync( const ClientAsync& ) = delete;
          ClientAsync& operator =( const ClientAsync& ) = delete;
 
          ssize_t  receive( void* a_pBuffer, const ssize_t& a_nBufferSize );
+         ssize_t  send( const void* a_pBuffer, const ssize_t& a_nBufferSize );
+         ssize_t  sendv( const struct iovec* a_pIov, const int32_t a_nCount );
+         bool     post( const void* a_pBuffer, const size_t a_nSize );
+         bool     post( const PoolBuffer& a_buffer, const size_t a_nLength );
+         uint64_t setTimer( const uint32_t a_nDelay_ms, const uint32_t a_nInterval_ms, const timerCallback_t a_cbTimer, void* const a_pData = nullptr );
+         bool     cancelTimer( const uint64_t a_nTimer );
          bool     startAsync( const socketCallback_t a_message,  void* const a_pData = nullptr, const errorCallBack_t a_error = nullptr, const bool a_bEdgeTrigger = false );
          bool     reconnect( const int32_t a_nRetryCount, const int32_t a_nRetryWait, logCallBack_t a_cbLog );
+         void     setReconnect( const int32_t a_nRetryCount, const uint32_t a_nWait_ms = 100, const uint32_t a_nMaxWait_ms = 30000 );
+         void     setStateCallback( stateCallback_t a_cbState )        { m_cbState = a_cbState; }    // before startAsync
+         sessionState_t getState() const                                 { return m_state.load( std::memory_order_relaxed ); }
 
          bool     unblockedListener( socketCallback_t a_message, errorCallBack_t a_error = nullptr );
          void     setMaximumPollEvents( int32_t a_nMaxCons )          { m_nMaximumEpollEvents = a_nMaxCons; }
          void     setEpollWaitTimeout( int32_t a_nEpollTimeout_ms )   { m_nEpollTimeout_ms = a_nEpollTimeout_ms; }
          void     setEpollErrorMax( int32_t a_nCount ) { m_nPollingErrorCount = a_nCount; }
+         void     setMessageCallback( messageCallback_t a_cbMessage )     { m_cbMessage = a_cbMessage; }    // must be called before startAsync
+         void     setFraming( const framing_t a_type, const uint32_t a_nValue = 0 );
+         void     setReceiveBufferSize( uint32_t a_nSize )               { m_nReceiveBufferSize = a_nSize; }
+         void     setWriteWatermarks( size_t a_nHigh, size_t a_nLow )    { m_nHighWatermark = a_nHigh; m_nLowWatermark = a_nLow; }
+         void     setDatagramBatch( uint32_t a_nCount )                  { m_nDatagramBatch = a_nCount > 0 ? a_nCount : 1; }    // UDP, must be called before startAsync
+         void     setBusyPoll( uint32_t a_nSpin_us, uint32_t a_nBusyPoll_us = 0 ) { m_nSpin_us = a_nSpin_us; m_nBusyPoll_us = a_nBusyPoll_us; }   // before startAsync
+         void     setReceiverCpu( int32_t a_nCpu )                       { m_nCpu = a_nCpu; }    // before startAsync
+         pollStats_t getPollStats() const                                { return m_poll.stats(); }
+         metrics_t getMetrics() const                                    { return m_metrics.snapshot(); }
+         void     setMetricsLog( logCallBack_t a_cbLog, uint32_t a_nInterval_ms ) { m_cbMetricsLog = a_cbLog; m_nMetricsInterval_ms = a_nInterval_ms; }   // before startAsync
+         latency_t getLatency() const                                    { return (nullptr != m_pLatency) ? *m_pLatency : latency_t(); }
+         void     resetLatency()                                         { if( nullptr != m_pLatency ) { m_pLatency->callback.reset(); m_pLatency->send.reset(); } }
          void     useStackAlloc()                      { m_bUseMalloc = false; }  // if stack space is ~1M then only about 4600 events can be stored, see setMaximumConnections
          void     useHeapAlloc()                       { m_bUseMalloc = true; }
-         void     stop()                               { m_bAsyncRunFlag = false; }
+         void     stop()                               { m_bAsyncRunFlag = false; m_posted.wake(); }
+         void     wakeup()                             { m_posted.wake(); }    // the receiver thread returns from its wait and re-checks its state
          void     join()                               { m_thdReceiver.join(); }               
          void     waitready() const                    { std::unique_lock<std::mutex> lock( m_muxReady ); m_cvReady.wait( lock ); }
+         engine_t getEngine() const                    { return m_engine; }
+   };
+
+
+
+   /**
+    * @brief one outbound connection of MultiClientAsync, see add
+    */
+   struct sessionConfig_t
+   {
+      std::string             strHost              = std::string( "localhost" );
+      std::string             strPort              = std::string( "5000" );
+      int32_t                 nFamily              = AF_INET;
+      socketCallback_t        cbSocket             = nullptr;     // SESION_OPEN, SESSION_CLOSE, watermarks, MESSAGE when there is no message callback
+      messageCallback_t       cbMessage            = nullptr;     // if set, data is read by the library and delivered as complete messages
+      connectCallback_t       cbConnect            = nullptr;     // each connect done, the fd or -1 and the errno
+      void*                   pContext             = nullptr;     // a_pData of the session callbacks
+      uint32_t                nConnectTimeout_ms   = 0;           // deadline of a connect, 0 none
+      uint32_t                nConnectAttempt_ms   = 0;           // deadline per address of the host, 0 none
+      int32_t                 nRetryCount          = 0;           // reconnects after the connection is lost, -1 without end, 0 none
+      uint32_t                nRetryWait_ms        = 1000;        // before the first reconnect, doubled after each failed one
+      uint32_t                nRetryMaxWait_ms     = 30000;       // cap of the doubling
    };
-   
+
+
+
+   /**
+    * @brief ...async client for many outbound connections (sessions) on one receiver thread and one epoll set, a few of them
+    * drive thousands of sessions where ClientAsync needs a thread per connection
+    *
+    * @details a session is named by the id add returns, it stays the same across reconnects while the fd changes.  each
+    * session has its own callbacks and context (sessionConfig_t), receive buffer, send queue and reconnect state.  the
+    * session table is indexed by the slot of the id and a second one by fd, an event finds its session in O(1)
+    *
+    * add                    from any thread, before or after startAsync.  the session is queued for the receiver thread which
+    *    connects it and calls back SESION_OPEN.  returns the id, -1 on error
+    * connect                non-blocking, the receiver thread issues the connects of all sessions at once and completes each
+    *    on EPOLLOUT with its SO_ERROR, see Connector.  nConnectAttempt_ms bounds each address of the host and nConnectTimeout_ms
+    *    the connect, a timer of the receiver thread gives up the attempt that runs out of time.  cbConnect is called back when
+    *    a connect is done, connected (before SESION_OPEN) or failed with its errno (ETIMEDOUT for a deadline).  CONNECTING
+    *    meanwhile.  the host is taken from the Resolver cache, a host not cached is resolved on a resolver thread and the
+    *    connect issued once it is back, the receiver thread never waits for DNS.  the lookup counts against nConnectTimeout_ms
+    * remove                 from any thread.  the receiver thread closes the session (SESSION_CLOSE if it was open), cancels
+    *    its reconnect and drops it.  its slot is reused by a later add under a new id (the slot in the low 20 bits, a
+    *    generation above), so a post, remove or call with the id of a removed session never reaches the one that took the slot
+    * send, sendv            non-blocking on a session as ServerAsync send, call on the receiver thread (from a callback or a timer).
+    *    what the socket does not take is queued and written on EPOLLOUT.  -1 with errno ENOTCONN when the session is not open
+    * post                   send from any other thread, see ClientAsync post.  dropped when the session is not open by then
+    * reconnect              a session lost (EOF, socket error or HUP) with nRetryCount left is connected again by a timer of the
+    *    receiver thread, after nRetryWait_ms doubled per failed connect up to nRetryMaxWait_ms, with jitter (see
+    *    ClientAsync::setReconnect).  a failed connect uses up one retry.  SESSION_CLOSE is called back for the old fd, SESION_OPEN
+    *    for the new one.  the count and the wait are restored once connected, when the count is used up the session stays
+    *    CLOSED until removed
+    * getState, getfd        of a session, sessionOf the session of a fd.  on the receiver thread
+    * setTimer               as ClientAsync setTimer
+    * setFraming, setReceiveBufferSize, setWriteWatermarks   as in ServerAsync, for every session, before startAsync
+    * getMetrics, getLatency as ClientAsync, accepts counts the connects
+    * stop, join, wakeup     as ClientAsync.  when the receiver thread ends every open session gets SESSION_CLOSE
+    *
+    * TCP and the EPOLL engine only
+    */
+   class MultiClientAsync
+   {
+      private:
+         struct session_t
+         {
+            sessionConfig_t   config         = sessionConfig_t();
+            MultiClientAsync* pOwner         = nullptr;
+            int32_t           nId            = -1;
+            socketfd_t        fd             = -1;
+            sessionState_t    state          = sessionState_t::CLOSED;
+            RecvBuffer        recvBuffer     = RecvBuffer();
+            SendQueue         sendQueue      = SendQueue();
+            bool              bWritePending  = false;          // EPOLLOUT registered
+            bool              bHighWatermark = false;          // WRITE_HIGH_WATERMARK reported, waiting for low
+            int32_t           nRetriesLeft   = 0;
+            uint32_t          nRetryAttempt  = 0;              // failed connects since the last open, the backoff exponent
+            uint64_t          nTimer         = 0;              // reconnect or connect deadline scheduled, 0 none
+            uint64_t          nLookup        = 0;              // resolve in flight, 0 none
+            uint64_t          nConnect_ns    = 0;              // start of the connect, the lookup counts against its deadline
+            Connector         connector      = {};             // CONNECTING
+         };
+
+         enum struct commandType_t: int32_t { ADD, REMOVE, RESOLVED };
+
+         static const int32_t s_nSlotBits = 20;                            // id: generation << s_nSlotBits | slot
+         static const int32_t s_nSlotMask = (1 << s_nSlotBits) - 1;
+
+         struct command_t
+         {
+            int32_t           nSession       = -1;
+            commandType_t     type           = commandType_t::REMOVE;
+            sessionConfig_t   config         = sessionConfig_t();            // ADD
+            uint64_t          nLookup        = 0;                            // RESOLVED
+            int32_t           nError         = 0;
+            std::vector<address_t> vecAddresses = std::vector<address_t>();
+         };
+
+         // a resolve outlives a session and can outlive the client, its callback finds the client through this
+         struct resolving_t
+         {
+            std::mutex        mux            = std::mutex();
+            MultiClientAsync* pOwner         = nullptr;        // nullptr once the client is gone
+         };
+
+         struct lookup_t
+         {
+            std::shared_ptr<resolving_t> pResolving = nullptr;
+            int32_t           nSession       = -1;
+            uint64_t          nLookup        = 0;
+         };
+
+         int32_t                       m_fdEpoll                = -1;
+         int32_t                       m_nMaximumEpollEvents    = 512;
+         int32_t                       m_nEpollTimeout_ms       = -1;           // -1 blocks until an event or wakeup
+         std::atomic<bool>             m_bAsyncRunFlag          = {true};
+         bool                          m_bEdgeTriggered         = false;
+         std::thread                   m_thdReceiver            = std::thread();
+         std::thread::id               m_idReceiver             = std::thread::id();
+         errorCallBack_t               m_cbError                = nullptr;
+         void*                         m_pCallbackData          = nullptr;      // a_pData of the error callback
+         framingSpec_t                 m_framing                = framingSpec_t();
+         uint32_t                      m_nReceiveBufferSize     = 65536;
+         size_t                        m_nHighWatermark         = 1024*1024;    // queued bytes per session to report WRITE_HIGH_WATERMARK
+         size_t                        m_nLowWatermark          = 256*1024;     // queued bytes per session to report WRITE_LOW_WATERMARK after a high
+
+         // receiver thread only
+         std::vector<std::unique_ptr<session_t>> m_vecSessions  = std::vector<std::unique_ptr<session_t>>();   // indexed by id
+         std::vector<int32_t>          m_vecFdSessions          = std::vector<int32_t>();     // session id indexed by fd, -1 none
+
+         // add and remove, applied by the receiver thread
+         std::mutex                    m_muxCommands            = std::mutex();
+         std::vector<command_t>        m_vecCommands            = std::vector<command_t>();
+         std::vector<int32_t>          m_vecFreeIds             = std::vector<int32_t>();     // ids of removed sessions, their slots are free
+         int32_t                       m_nNextId                = 0;            // next slot never used
+         uint64_t                      m_nLookup                = 0;            // last resolve id, receiver thread
+         std::shared_ptr<resolving_t>  m_pResolving             = std::make_shared<resolving_t>();
+
+         PostQueue                     m_posted                 = {};           // post and the commands, drained by the receiver thread
+         TimerWheel                    m_timers                 = {};           // setTimer and the reconnects
+         BusyPoll                      m_poll                   = {};
+         Metrics                       m_metrics                = {};
+         std::unique_ptr<latency_t>    m_pLatency               = nullptr;      // GSOCK_HISTOGRAMS builds
+
+         bool        run_();
+         void        applyCommands_();
+         void        drainPosted_();
+         void        connect_( session_t& a_session );
+         void        resolved_( const command_t& a_command );
+         void        connecting_( session_t& a_session, const connectStatus_t a_status );
+         void        failed_( session_t& a_session, const int32_t a_nError );
+         void        opened_( session_t& a_session, const socketfd_t a_fd );
+         void        close_( session_t& a_session, const bool a_bRetry );
+         void        removeSession_( const int32_t a_nSession );
+         bool        flush_( session_t& a_session );
+         void        armWrite_( session_t& a_session );
+         uint32_t    socketEvents_( const bool a_bWrite ) const;
+         session_t*  session_( const int32_t a_nSession ) const;
+         session_t*  find_( const int32_t a_nSession ) const;
+         void        report_( const int32_t a_nError, const std::string& a_strError ) const;
+         static void retry_( const int32_t& a_fd, const uint64_t a_nTimer, void* const a_pData );
+         static void expired_( const int32_t& a_fd, const uint64_t a_nTimer, void* const a_pData );
+         static size_t slot_( const int32_t a_nSession )                 { return static_cast<size_t>( a_nSession & s_nSlotMask ); }
+         static void lookedUp_( const int32_t a_nError, const std::vector<address_t>& a_vecAddresses, void* const a_pData );
+
+      public:
+         MultiClientAsync() = default;
+         MultiClientAsync( const MultiClientAsync& ) = delete;
+         ~MultiClientAsync();
+
+         MultiClientAsync& operator =( const MultiClientAsync& ) = delete;
+
+         int32_t  add( const sessionConfig_t& a_config );
+         bool     remove( const int32_t a_nSession );
+         ssize_t  send( const int32_t a_nSession, const void* a_pBuffer, const ssize_t& a_nBufferSize );
+         ssize_t  sendv( const int32_t a_nSession, const struct iovec* a_pIov, const int32_t a_nCount );
+         bool     post( const int32_t a_nSession, const void* a_pBuffer, const size_t a_nSize );
+         bool     post( const int32_t a_nSession, const PoolBuffer& a_buffer, const size_t a_nLength );
+         uint64_t setTimer( const uint32_t a_nDelay_ms, const uint32_t a_nInterval_ms, const timerCallback_t a_cbTimer, void* const a_pData = nullptr );
+         bool     cancelTimer( const uint64_t a_nTimer );
+         sessionState_t getState( const int32_t a_nSession ) const;
+         socketfd_t getfd( const int32_t a_nSession ) const;
+         int32_t  sessionOf( const socketfd_t a_fd ) const;
+         bool     startAsync( const errorCallBack_t a_error = nullptr, void* const a_pData = nullptr, const bool a_bEdgeTrigger = false );
+
+         void     setMaximumPollEvents( int32_t a_nMaxEvents )          { m_nMaximumEpollEvents = a_nMaxEvents; }
+         void     setEpollWaitTimeout( int32_t a_nEpollTimeout_ms )     { m_nEpollTimeout_ms = a_nEpollTimeout_ms; }
+         void     setFraming( const framing_t a_type, const uint32_t a_nValue = 0 );
+         void     setReceiveBufferSize( uint32_t a_nSize )               { m_nReceiveBufferSize = a_nSize; }
+         void     setWriteWatermarks( size_t a_nHigh, size_t a_nLow )    { m_nHighWatermark = a_nHigh; m_nLowWatermark = a_nLow; }
+         metrics_t getMetrics() const                                    { return m_metrics.snapshot(); }
+         latency_t getLatency() const                                    { return (nullptr != m_pLatency) ? *m_pLatency : latency_t(); }
+         void     resetLatency()                                         { if( nullptr != m_pLatency ) { m_pLatency->callback.reset(); m_pLatency->send.reset(); } }
+         void     stop()                               { m_bAsyncRunFlag = false; m_posted.wake(); }
+         void     wakeup()                             { m_posted.wake(); }
+         void     join()                               { if( true == m_thdReceiver.joinable() ) { m_thdReceiver.join(); } }
+   };
+
 
 
 
@@ -177,15 +619,17 @@ namespace network
     * @example see testing/async/server.cpp
     * 
     * @details the non blocking server will do a callback anytime data is ready from a connection. The data handler can be done in the 
-    * callback thread (if it is not time consuming) or use a pool of threads to handle the data read.
+    * callback thread (if it is not time consuming) or use a pool of threads to handle the data read, see setWorkerCount.
+    * BasicServerAsync (reactor.h) is the same reactor with the handler and the trigger mode fixed at compile time.
     * 
     * setMaximumPollEvents   number of events available per epoll return.  This value should be set
     *    to thee max concurrent active data connections.  If there are 10 connections and three are very active, where epoll returns three fd's
     *    with data, then you do not need more than three.  If there load changed and there were now four active, you would not loose data
     *    just will loose efficiency because another kernel calll would be needed to get data for that fd
     * 
-    * setEpollWaitTimeout  ms to wait untill epoll_wait returns with no data. a low value will cause excessive cpu usage with no 
-    *    data, a high value will make shutting down, slower.  This does not effect the response when data is available.  1000 ms is good
+    * setEpollWaitTimeout  ms to wait untill epoll_wait returns with no data.  default -1, an idle reactor blocks and costs no cpu,
+    *    stop and wakeup write an eventfd in its epoll set (or ring) so it does not need a timeout to see them.  a value >= 0 only
+    *    makes the loop come around without events
     * 
     * setEpollErrorMax  number of errors before epoll calls the error cdallback.  There should be no errors
     * 
@@ -194,34 +638,284 @@ namespace network
     * 
     * useHeapAlloc           use heap for epoll events
     * 
-    * stop                   stop unblockedListener
+    * setReactorCount        number of reactors (epoll loops), each on its own thread with its own SO_REUSEPORT listener and epoll fd.
+    *    the kernel spreads new connections across the listeners, a connection stays on the reactor that accepted it.  Must be called before open
+    *    so the first listener is bound with SO_REUSEPORT.  Callbacks for different connections run concurrently when the count is > 1, use
+    *    reactorId() in the callback to find the reactor (0..count-1) the connection is on
+    * 
+    * setMessageCallback     the library reads the data into a per connection receive buffer and calls back with each complete message
+    *    (pointer/length into the buffer, valid until the callback returns).  the socket callback still gets SESION_OPEN and SESSION_CLOSE
+    * setFraming             how messages are cut from the stream, see framingSpec_t
+    *    LENGTH_PREFIX  a_nValue header size 1, 2 or 4 (default 4)
+    *    DELIMITER      a_nValue delimiter byte (default 0)
+    *    FIXED          a_nValue message size
+    * setReceiveBufferSize   per connection receive buffer, the largest frame that can be received (a LENGTH_PREFIX header included)
+    * setWorkerCount         run the message callback on a pool of a_nCount worker threads instead of the reactor.  the reactor
+    *    copies each message and queues it to worker fd % count, the messages of a connection stay in order on one worker.  the
+    *    message is valid until the callback returns.  SESSION_CLOSE can be reported while a worker still has messages of the
+    *    connection, reply with post.  getWorkerPool().stats( n ) gives queue depth and utilization per worker.  a worker queue
+    *    has no limit by default.  setWorkerQueueLimit caps it, a message beyond is then dropped, reported to the error callback
+    *    with EAGAIN and counted in the metrics as a dispatch drop, which loses data of the stream: opt in only where that is fine.  TCP only, UDP datagrams stay on the reactor
+    * 
+    * buffers                the receive buffer and send queue of a connection come from the BufferPool and go back to it when the
+    *    connection closes, see BufferPool::stats to size it
+    * connections            a table indexed by fd holds the state of each connection, the epoll event carries the fd as the index
+    *    so an event finds its connection in O(1).  setContext attaches the application's data to a connection (getContext in the
+    *    callbacks instead of a map), getConnectionInfo gives the peer address, byte and message counters and the open time, on
+    *    the reactor thread.  when a reactor ends every connection it owns gets SESSION_CLOSE and is closed
+    * 
+    * send                   non-blocking send on a connection, call on the reactor thread of the connection (from a callback).
+    *    what the socket does not take is queued and written when epoll reports the socket writable
+    * sendv                  as send for a header + payload or a batch of messages given as iovecs, one sendmsg per IOV_MAX entries
+    * sendFile               stream a_nLength bytes of a regular file from a_nOffset with sendfile, the bytes never reach user space.
+    *    what the socket does not take is sent when epoll reports the socket writable, in order with send/sendv.  the fd is duplicated
+    *    for the transfer, the caller can close it when sendFile returns.  the IO_URING engine reads the file into the send queue
+    * post                   send from any other thread (workers, application).  the message is copied (or a PoolBuffer referenced)
+    *    into a lock-free queue of the reactor owning the connection and the reactor is woken through an eventfd in its epoll set
+    *    (or ring), once per batch.  the reactor drains the queue and sends each message as sendv does (copied, never zero
+    *    copy), so the writes to a connection are never interleaved and never race its close.  each message carries the tag of the
+    *    connection it is meant for (postTag), a message for a connection closed meanwhile is dropped, never sent to a later
+    *    connection on the same fd.  a worker posting for the message it handles gets the tag the message was read with, other
+    *    threads take postTag in SESION_OPEN and post with it.  false with EBADF when the fd is not an open connection, ECANCELED once the server has stopped.  TCP only
+    * setTimer               call back after a_nDelay_ms, then every a_nInterval_ms if not 0, on the reactor thread.  each reactor has
+    *    a hierarchical timer wheel driven by a timerfd in its epoll set (or ring), schedule and cancel are O(1) and one timerfd
+    *    serves all timers of the reactor, so 100k idle timeouts or heartbeats cost no threads and no sorted container.  call on a
+    *    reactor thread (from a callback), a_fd -1 is a timer of the calling reactor, else a connection of it whose timers are
+    *    cancelled when it closes.  returns the id for cancelTimer, 0 with errno EPERM when not called on the reactor
+    * setTimerResolution     ms per tick of the wheels, default 1, before start
+    * setBusyPoll            low latency, trades a core per reactor for microseconds.  after an event the reactor polls with a zero
+    *    epoll timeout for a_nSpin_us before it blocks again (spin then block), BusyPoll::s_nSpinForever never blocks.  a message
+    *    arriving while it spins is seen without waking a sleeping thread.  a_nBusyPoll_us sets SO_BUSY_POLL (and
+    *    SO_PREFER_BUSY_POLL) on the listeners and connections, above net.core.busy_read it needs CAP_NET_ADMIN.  the spin is
+    *    EPOLL only, the IO_URING engine blocks in the ring.  before start
+    * setReactorCpus         pin reactor n to cpu a_vecCpus[n % size], give a spinning reactor a core of its own.  before start
+    * getPollStats           per reactor, while running: wakeups, blocking waits, empty polls and the time from the wakeup to the
+    *    first callback.  testing/busypoll measures the round trip in each mode
+    * getMetrics             counters of all reactors added up, or of one: wakeups, events, accepts, closes, bytes and messages in
+    *    and out, reads that ended on EAGAIN, sends the socket did not take at once, writes on EPOLLOUT and the busy time.  each
+    *    reactor keeps its own cache line aligned counters and bumps them with plain relaxed stores, nothing is shared between
+    *    the reactors and nothing is locked, the snapshot reads them from any thread while the loops run.  sends are counted on
+    *    the reactor that made them (call send from its callbacks), bytes in with a message callback only
+    * setMetricsLog          every a_nInterval_ms reactor 0 calls a_cbLog( LogLevel::EINF, line ) with the rates since the last
+    *    line, see Metrics::format.  before start
+    * getLatency             histograms of how long each socket or message callback held the reactor and how long send, sendv and
+    *    sendFile took, per reactor or merged, see Histogram for the percentiles, toText and toCsv.  opt in at build time, the
+    *    library built with make HISTOGRAMS=1 (GSOCK_HISTOGRAMS) reads the clock around each callback and send, other builds
+    *    compile the timing out and return empty histograms.  resetLatency empties them from any thread while running
+    * setWriteWatermarks     when the queued bytes of a connection reach high the socket callback gets WRITE_HIGH_WATERMARK, once
+    *    the queue drains to low it gets WRITE_LOW_WATERMARK.  use it to stop producing for a slow peer
+    * 
+    * engine_t::IO_URING     constructor argument.  each reactor runs an io_uring instead of epoll: multishot accept, multishot recv
+    *    into a ring of provided buffers (message callback) or multishot poll (MESSAGE callback, behaves as edge trigger), and the
+    *    sends of one loop iteration are submitted together with the wait in one syscall.  send/sendv copy into the queue of the
+    *    connection, the kernel writes it.  falls back to EPOLL when the kernel lacks support, see getEngine
+    * 
+    * setZeroCopy            opt in, SO_ZEROCOPY on the connections and send uses MSG_ZEROCOPY for buffers of a_nThreshold bytes or
+    *    more.  the kernel sends from the callers buffer, it must not be changed or freed until the release callback is called with
+    *    it, exactly once per such send (right away if the bytes had to be copied, ex data queued ahead of it, or the connection closed).
+    *    completions are read from the socket error queue by the reactor.  smaller sends and sendv copy as before.  zero copy pays
+    *    off for sends of ~10K and more, the IO_URING engine copies and releases right away
+    * 
+    * protocol_t::UDP        open binds the datagram socket, each reactor gets its own SO_REUSEPORT socket.  readable sockets are
+    *    read in batches of setDatagramBatch with recvmmsg into per reactor buffers of setReceiveBufferSize (the largest datagram)
+    *    and setDatagramCallback is called once per datagram with the sender, or without it the socket callback gets MESSAGE with
+    *    the socket to read itself.  reply with sendTo or sendBatch (sendmmsg) on the fd of the callback, they do not wait and do
+    *    not queue, a full socket buffer fails with EAGAIN.  no SESION_OPEN/SESSION_CLOSE, UDP always runs on EPOLL
+    * 
+    * AF_UNIX                open with a path-style host, see Sockets.  stream or protocol_t::SEQPACKET connections run as TCP
+    *    ones on both engines, with SEQPACKET each read takes at most one message of the peer.  there is no SO_REUSEPORT for a
+    *    path, one reactor only.  Sockets::sendFd/receiveFd on the fd of the callback pass descriptors, as for ClientAsync the
+    *    message callback does not receive them
+    * 
+    * nonblockingListener    blocking run, reactor 0 runs on the calling thread, returns when stopped
+    * startAsync             start all reactors on their own threads and return, use stop and join to end
+    * 
+    * stop                   stop the reactors, each is woken and returns from its wait at once.  any thread
+    * wakeup                 make every reactor return from its wait and re-check its state.  any thread, while running
     */
    class ServerAsync : public Server
    {
       private:
-         int32_t     m_fdEpoll               = -1;        // server side epolling
+         struct reactor_t
+         {
+            int32_t     nId                  = 0;         // index of this reactor, returned by reactorId() in callbacks
+            socketfd_t  fdListener           = -1;        // SO_REUSEPORT listener owned by this reactor
+            int32_t     fdEpoll              = -1;        // epoll set for the listener and all connections accepted on it, the ring fd with IO_URING
+            URing*      pRing                = nullptr;   // IO_URING, owned by the reactor loop
+            std::vector<socketfd_t> vecSendReady = std::vector<socketfd_t>();   // IO_URING, connections with queued bytes to submit
+            std::vector<datagram_t> vecDatagrams = std::vector<datagram_t>();   // UDP, one batch for recvmmsg
+            std::vector<uint8_t>    vecDatagramBuffer = std::vector<uint8_t>();
+            std::unique_ptr<BusyPoll>  pPoll   = nullptr;     // epoll_wait, blocking or spinning
+            std::unique_ptr<PostQueue> pPosted = nullptr;     // wakeup and stop, TCP also messages posted by other threads for the connections of this reactor
+            std::unique_ptr<TimerWheel> pTimers = nullptr;    // setTimer on this reactor
+            std::unique_ptr<Metrics>   pMetrics = nullptr;    // counters, written by the reactor thread only
+            std::unique_ptr<latency_t> pLatency = nullptr;    // GSOCK_HISTOGRAMS builds, written by the reactor thread only
+         };
+
+         struct zeroCopy_t
+         {
+            const uint8_t* pBuffer      = nullptr;      // callers buffer, handed back by the release callback
+            size_t      nLength         = 0;
+            size_t      nSent           = 0;            // bytes the kernel took
+            uint32_t    nLastSeq        = 0;            // MSG_ZEROCOPY sequence of the last send from this buffer
+            bool        bInKernel       = false;        // at least one MSG_ZEROCOPY send, wait for its completion
+         };
+
+         struct fileTransfer_t
+         {
+            int32_t     fdFile          = -1;           // duplicate of the callers fd, closed when the transfer is done
+            off_t       nOffset         = 0;            // next byte of the file
+            size_t      nRemaining      = 0;
+            size_t      nBytesAhead     = 0;            // bytes of sendQueue to write before the file
+         };
+
+         struct connection_t
+         {
+            RecvBuffer  recvBuffer      = RecvBuffer();  // used when a message callback is set
+            SendQueue   sendQueue       = SendQueue();   // bytes waiting for EPOLLOUT
+            int32_t     fdEpoll         = -1;            // epoll set of the reactor owning the connection
+            bool        bWritePending   = false;         // EPOLLOUT registered
+            bool        bHighWatermark  = false;         // WRITE_HIGH_WATERMARK reported, waiting for low
+            // IO_URING
+            SendQueue   inflightQueue   = SendQueue();   // bytes of the send in flight, untouched until its completion
+            int32_t     nReactor        = 0;
+            uint32_t    nGeneration     = 0;             // tags the requests of this use of the fd, completions of a previous use are dropped
+            bool        bSendInFlight   = false;
+            // zero copy, sent ahead of sendQueue
+            std::deque<zeroCopy_t> dqZeroCopy = std::deque<zeroCopy_t>();   // buffers lent to the kernel, oldest first
+            size_t      nZeroCopyUnsent = 0;             // bytes of the last buffer not sent yet
+            uint32_t    nZeroCopySeq    = 0;             // sequence of the next MSG_ZEROCOPY send, counted by the kernel per socket
+            uint32_t    nZeroCopyDone   = 0;             // sends below this sequence are completed
+            bool        bZeroCopy       = false;         // SO_ZEROCOPY set
+            std::deque<fileTransfer_t> dqFiles = std::deque<fileTransfer_t>();   // sendFile transfers waiting for EPOLLOUT, in order
+            std::atomic<uint64_t> nPostTag = {0};         // generation << 32 | reactor + 1 while open, 0 closed, read by post
+            connectionInfo_t info       = connectionInfo_t();   // peer, context and counters, reset on accept
+         };
+
          int32_t     m_nMaximumEpollEvents   = 512;       // server side epolling
-         int32_t     m_nEpollTimeout_ms      = 1000;      // number of ms for epoll_wait timeout
+         int32_t     m_nEpollTimeout_ms      = -1;        // number of ms for epoll_wait timeout, -1 blocks until an event or wakeup
          int32_t     m_nPollingErrorCount    = 100;       // max number of consecuritve errors before epoll fails
-         bool        m_bAsyncRunFlag         = true;
-         epoll_event*m_pEvents               = nullptr;
+         int32_t     m_nReactorCount         = 1;         // number of epoll loops / threads
+         std::atomic<bool> m_bAsyncRunFlag   = {true};
          bool        m_bUseMalloc            = true;
+         bool        m_bEdgeTriggered        = false;
+         engine_t    m_engine                = engine_t::EPOLL;
+         std::vector<reactor_t>     m_vecReactors        = std::vector<reactor_t>();        // filled on start and kept until the destructor, wakeup and post read it from any thread
+         std::vector<std::thread>   m_vecReactorThreads  = std::vector<std::thread>();
+         std::vector<connection_t*> m_vecConnections     = std::vector<connection_t*>();   // indexed by fd, sized to RLIMIT_NOFILE on start
+         messageCallback_t          m_cbMessage          = nullptr;
+         framingSpec_t              m_framing            = framingSpec_t();
+         uint32_t                   m_nReceiveBufferSize = 65536;
+         size_t                     m_nHighWatermark     = 1024*1024;    // queued bytes per connection to report WRITE_HIGH_WATERMARK
+         size_t                     m_nLowWatermark      = 256*1024;     // queued bytes per connection to report WRITE_LOW_WATERMARK after a high
+         socketCallback_t           m_cbSocketEvent      = nullptr;
+         void*                      m_pCallbackData      = nullptr;
+         releaseCallback_t          m_cbRelease          = nullptr;      // zero copy enabled when set
+         size_t                     m_nZeroCopyThreshold = 65536;
+         datagramCallback_t         m_cbDatagram         = nullptr;      // UDP
+         uint32_t                   m_nDatagramBatch     = 64;           // UDP, datagrams per recvmmsg
+         uint32_t                   m_nWorkerCount       = 0;            // message callback on the reactors when 0
+         uint32_t                   m_nTimerResolution_ms = 1;
+         uint32_t                   m_nSpin_us           = 0;            // busy poll after an event, 0 blocks
+         uint32_t                   m_nBusyPoll_us       = 0;            // SO_BUSY_POLL on the sockets, 0 not set
+         std::vector<int32_t>       m_vecCpus            = std::vector<int32_t>();   // reactor n pinned to entry n % size, empty not pinned
+         logCallBack_t              m_cbMetricsLog       = nullptr;      // periodic metrics line, on reactor 0
+         uint32_t                   m_nMetricsInterval_ms = 0;
+         metrics_t                  m_lastMetrics        = metrics_t();  // reactor 0, last logged
+         uint64_t                   m_nLastMetrics_ns    = 0;
+         WorkerPool                 m_workers            = {};
+         errorCallBack_t            m_cbWorkerError      = nullptr;      // dispatch failures, set with the workers
+         void*                      m_pWorkerData        = nullptr;
+
+         bool prepareReactors_( const socketCallback_t a_socketEvent, const bool a_bEdgeTrigger, const errorCallBack_t a_error, void* a_pData );
+         bool reactorLoop_( reactor_t& a_reactor, const socketCallback_t a_socketEvent, const errorCallBack_t a_error, void* a_pData );
+         bool uringLoop_( reactor_t& a_reactor, const socketCallback_t a_socketEvent, const errorCallBack_t a_error, void* a_pData );
+         bool openConnection_( const socketfd_t a_fd, const reactor_t& a_reactor, const errorCallBack_t a_error, const struct sockaddr_storage* a_pPeer, const socklen_t a_nPeerLength );
+         void queueSend_( const socketfd_t a_fd, connection_t* a_pConnection );
+         void submitSend_( const socketfd_t a_fd, connection_t* a_pConnection, URing& a_ring );
+         bool flushConnection_( const socketfd_t a_fd );
+         void armWrite_( const socketfd_t a_fd, connection_t* a_pConnection );
+         connection_t* connection_( const socketfd_t a_fd ) const;
+         uint32_t connectionEvents_( const bool a_bWrite ) const;
+         void closeConnection_( const socketfd_t a_fd, const socketCallback_t a_socketEvent, void* a_pData );
+         void closeConnections_( const reactor_t& a_reactor, const socketCallback_t a_socketEvent, void* a_pData );
+         ssize_t sent_( connection_t* a_pConnection, const ssize_t a_nBytes ) const;
+         ssize_t sendZeroCopy_( const socketfd_t a_fd, connection_t* a_pConnection, const void* a_pBuffer, const size_t a_nSize );
+         bool writeZeroCopy_( const socketfd_t a_fd, connection_t* a_pConnection );
+         bool completeZeroCopy_( const socketfd_t a_fd, connection_t* a_pConnection );
+         void releaseZeroCopy_( const socketfd_t a_fd, connection_t* a_pConnection, const bool a_bAll );
+         bool writeFiles_( const socketfd_t a_fd, connection_t* a_pConnection );
+         bool writeBlocked_( const connection_t* a_pConnection ) const;
+         void startWorkers_( const errorCallBack_t a_error, void* a_pData );
+         void drainPosted_( reactor_t& a_reactor, const errorCallBack_t a_error );
+         void pinReactor_( const reactor_t& a_reactor, const errorCallBack_t a_error );
+         PostQueue* postQueue_( const socketfd_t a_fd, const uint64_t a_nTag ) const;
+         static void logMetrics_( const int32_t& a_fd, const uint64_t a_nTimer, void* const a_pData );
+         static void dispatch_( const socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pServer );
+         messageCallback_t deliverCallback_() const            { return (true == m_workers.running()) ? &ServerAsync::dispatch_ : m_cbMessage; }
+         void* deliverData_( void* a_pData )                   { return (true == m_workers.running()) ? this : a_pData; }
             
       public:
          ServerAsync() = default;
+         explicit ServerAsync( const engine_t a_engine ) :
+             m_engine( ((engine_t::IO_URING == a_engine) && (true == URing::isSupported())) ? engine_t::IO_URING : engine_t::EPOLL )
+         {}
          ServerAsync( const ServerAsync& ) = delete;
          ~ServerAsync();
 
          ServerAsync& operator =( const ServerAsync& ) = delete;
 
          bool nonblockingListener( const socketCallback_t a_dataReady, const bool a_bEdgeTrigger = false, const errorCallBack_t a_error = nullptr, void *a_pData = nullptr );
+         bool startAsync( const socketCallback_t a_dataReady, void* const a_pData = nullptr, const errorCallBack_t a_error = nullptr, const bool a_bEdgeTrigger = false );
+         void join();
+         ssize_t send( const socketfd_t& a_fd, const void* a_pBuffer, const ssize_t& a_nBufferSize );
+         ssize_t sendv( const socketfd_t& a_fd, const struct iovec* a_pIov, const int32_t a_nCount );
+         ssize_t sendFile( const socketfd_t& a_fd, const int32_t a_fdFile, const off_t a_nOffset, const size_t a_nLength );
+         ssize_t sendTo( const socketfd_t& a_fd, const void* a_pBuffer, const size_t a_nBufferSize, const struct sockaddr* a_pPeer, const socklen_t a_nPeerLength );
+         int32_t sendBatch( const socketfd_t& a_fd, const datagram_t* a_pDatagrams, const uint32_t a_nCount );
+         bool post( const socketfd_t& a_fd, const void* a_pBuffer, const size_t a_nSize );
+         bool post( const socketfd_t& a_fd, const PoolBuffer& a_buffer, const size_t a_nLength );
+         bool post( const socketfd_t& a_fd, const uint64_t a_nTag, const void* a_pBuffer, const size_t a_nSize );
+         bool post( const socketfd_t& a_fd, const uint64_t a_nTag, const PoolBuffer& a_buffer, const size_t a_nLength );
+         uint64_t postTag( const socketfd_t& a_fd ) const;
+         uint64_t setTimer( const socketfd_t& a_fd, const uint32_t a_nDelay_ms, const uint32_t a_nInterval_ms, const timerCallback_t a_cbTimer, void* const a_pData = nullptr );
+         bool cancelTimer( const uint64_t a_nTimer );
+         bool setContext( const socketfd_t& a_fd, void* const a_pContext );
+         void* getContext( const socketfd_t& a_fd ) const;
+         bool getConnectionInfo( const socketfd_t& a_fd, connectionInfo_t& a_info ) const;
          
          void setMaximumPollEvents( int32_t a_nMaxCons )       { m_nMaximumEpollEvents = a_nMaxCons; }
          void setEpollWaitTimeout( int32_t a_nEpollTimeout_ms ){ m_nEpollTimeout_ms    = a_nEpollTimeout_ms; }
          void setEpollErrorMax( int32_t a_nCount )             { m_nPollingErrorCount  = a_nCount; }
+         void setReactorCount( int32_t a_nCount )              { m_nReactorCount       = a_nCount > 0 ? a_nCount : 1; setReusePort( m_nReactorCount > 1 ); }
+         void setMessageCallback( messageCallback_t a_cbMessage ){ m_cbMessage         = a_cbMessage; }     // must be called before the listener is started
+         void setFraming( const framing_t a_type, const uint32_t a_nValue = 0 );
+         void setReceiveBufferSize( uint32_t a_nSize )         { m_nReceiveBufferSize  = a_nSize; }
+         void setWriteWatermarks( size_t a_nHigh, size_t a_nLow ){ m_nHighWatermark     = a_nHigh; m_nLowWatermark = a_nLow; }
+         void setZeroCopy( size_t a_nThreshold, releaseCallback_t a_cbRelease ){ m_nZeroCopyThreshold = a_nThreshold; m_cbRelease = a_cbRelease; }  // before start, nullptr disables
+         void setDatagramCallback( datagramCallback_t a_cbDatagram ){ m_cbDatagram     = a_cbDatagram; }    // UDP, must be called before the listener is started
+         void setDatagramBatch( uint32_t a_nCount )            { m_nDatagramBatch      = a_nCount > 0 ? a_nCount : 1; }
+         void setWorkerCount( uint32_t a_nCount )              { m_nWorkerCount        = a_nCount; }    // before start, 0 runs the message callback on the reactors
+         void setWorkerQueueLimit( uint64_t a_nLimit )         { m_workers.setQueueLimit( a_nLimit ); }   // before start, messages per worker, 0 no limit
+         void setTimerResolution( uint32_t a_nResolution_ms )  { m_nTimerResolution_ms = a_nResolution_ms > 0 ? a_nResolution_ms : 1; }  // before start
+         void setBusyPoll( uint32_t a_nSpin_us, uint32_t a_nBusyPoll_us = 0 ){ m_nSpin_us = a_nSpin_us; m_nBusyPoll_us = a_nBusyPoll_us; }   // before start
+         void setReactorCpus( const std::vector<int32_t>& a_vecCpus ){ m_vecCpus       = a_vecCpus; }     // before start
+         const WorkerPool& getWorkerPool() const               { return m_workers; }
+         pollStats_t getPollStats( const int32_t a_nReactor ) const;
+         metrics_t getMetrics() const;
+         metrics_t getMetrics( const int32_t a_nReactor ) const;
+         latency_t getLatency() const;
+         latency_t getLatency( const int32_t a_nReactor ) const;
+         void resetLatency();
+         void setMetricsLog( logCallBack_t a_cbLog, uint32_t a_nInterval_ms ){ m_cbMetricsLog = a_cbLog; m_nMetricsInterval_ms = a_nInterval_ms; }   // before start, nullptr or 0 disables
          void useStackAlloc()                                  { m_bUseMalloc          = false; }  // if stack space is ~1M then only about 4600 events can be stored, see setMaximumConnections
          void useHeapAlloc()                                   { m_bUseMalloc          = true;  }
-         void stop()                                           { m_bAsyncRunFlag       = false; }
+         void stop();
+         void wakeup();
+         int32_t getReactorCount() const                       { return m_nReactorCount; }
+         engine_t getEngine() const                            { return m_engine; }
+
+         static int32_t reactorId();    // reactor index of the calling thread, -1 if not called from a reactor
    };
    
    
@@ -12,6 +12,7 @@ static int32_t g_nReplyies = 0;
 
 void dataCallbackHandler  ( const network::socketfd_t& a_fd, const network::callBack_t& a_type, void* const a_pData = nullptr );
 void errorCallbackHandler ( const int32_t a_nerrno, const char* a_pszError, void* const a_pData );
+void messageCallbackHandler( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData );
 
 int main( int, char** )
 {
@@ -27,6 +28,9 @@ int main( int, char** )
    sender.useStackAlloc();
    // sender.useHeapAlloc();
    sender.setNoDelay();
+   // replies are null terminated strings, the library reassembles them
+   sender.setMessageCallback( messageCallbackHandler );
+   sender.setFraming( network::framing_t::DELIMITER, '\0' );
 
    sender.startAsync( dataCallbackHandler, nullptr, errorCallbackHandler, true );  // this param is param for callbacks void* param
    sender.waitready();
@@ -66,33 +70,20 @@ int main( int, char** )
 
 
 
-void dataCallbackHandler( const network::socketfd_t& a_fd, const network::callBack_t& a_type, void* const  )
+void messageCallbackHandler( const network::socketfd_t&, const uint8_t* a_pMessage, const size_t a_nLength, void* const )
 {
-   static char ucSocketBuffer[MAX_SOCKET_BUFFER];
+   cout << "rec[" << a_nLength << "]:" << string( reinterpret_cast<const char*>( a_pMessage ), a_nLength ) << endl;
+   __sync_fetch_and_add( &g_nReplyies, 1 );
+}
+
 
+
+void dataCallbackHandler( const network::socketfd_t& a_fd, const network::callBack_t& a_type, void* const  )
+{
    try
    {
      switch( a_type )
      {
-        case network::callBack_t::MESSAGE:
-           {
-            int32_t nRecSize;
-                while( (nRecSize = static_cast<int32_t>(network::Sockets::receive( a_fd, ucSocketBuffer, MAX_SOCKET_BUFFER )) > 0 ) )
-              {
-               char* pszCurrentMsg = ucSocketBuffer;
-                  for( int32_t nIndex=0; nIndex<nRecSize; ++nIndex )
-                  {
-                     if( ucSocketBuffer[nIndex] == 0 )
-                     {
-                        cout << "rec[" << nRecSize << "]:" << pszCurrentMsg << endl;
-                        pszCurrentMsg = ucSocketBuffer + nIndex + 1;
-                        __sync_fetch_and_add( &g_nReplyies, 1 );
-                     }
-                  }
-              }
-          }
-           break;
-           
            case network::callBack_t::SESSION_CLOSE:
               std::cout << "session closed by remote:" << a_fd << std::endl;
               break;
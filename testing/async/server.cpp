@@ -6,9 +6,8 @@
 using namespace std;
 using namespace gdlib;
 
-#define MAX_SOCKET_BUFFER 64
-
 void listener_socketCallbackHandler       ( const network::socketfd_t& a_fd, const network::callBack_t& a_type, void* const a_pData = nullptr );
+void listener_messageCallbackHandler      ( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData );
 void listener_socketErrorCallbackHandler  ( const int32_t a_nerrno, const char* a_pszError, void* const a_pData );
 
 
@@ -31,6 +30,9 @@ int main( int, char** )
       server.useStackAlloc();
       // server.useHeapAlloc();
       server.setNoDelay();
+      // messages are null terminated strings, the library reassembles them
+      server.setMessageCallback( listener_messageCallbackHandler );
+      server.setFraming( network::framing_t::DELIMITER, '\0' );
 
       if( false == server.nonblockingListener( listener_socketCallbackHandler, false, listener_socketErrorCallbackHandler, reinterpret_cast<void*>(&server) ) )
       {
@@ -42,33 +44,21 @@ int main( int, char** )
 
 
 
-void listener_socketCallbackHandler( const network::socketfd_t& a_fd, const network::callBack_t& a_type, void* const a_pData )
+void listener_messageCallbackHandler( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData )
 {
-   int32_t nRecSize;
-   static char ucSocketBuffer[MAX_SOCKET_BUFFER];
-
    network::ServerAsync* pServer = reinterpret_cast<network::ServerAsync*>(a_pData);
-   
-   
+
+   // the message is followed by its null delimiter in the receive buffer, echo both
+   auto res = pServer->send( a_fd, a_pMessage, static_cast<ssize_t>( a_nLength + 1 ) );
+   cout << "reply[" << res << "]:" << reinterpret_cast<const char*>( a_pMessage ) << endl;
+}
+
+
+
+void listener_socketCallbackHandler( const network::socketfd_t& a_fd, const network::callBack_t& a_type, void* const )
+{
    switch( a_type )
    {
-      case network::callBack_t::MESSAGE:
-         while( (nRecSize = static_cast<int32_t>( network::Sockets::receive( a_fd, ucSocketBuffer, MAX_SOCKET_BUFFER )) ) > 0 )
-         {
-            // count how many messages.  since each msg is null term, count them
-            char* pszCurrentMsg = ucSocketBuffer;
-            for( int32_t nIndex=0; nIndex<nRecSize; ++nIndex )
-            {
-                if( ucSocketBuffer[nIndex] == 0 )
-                {
-                   auto res = pServer->send( a_fd, pszCurrentMsg, static_cast<ssize_t>(strlen( pszCurrentMsg ) + 1 ));
-                   cout << "reply[" << res << "]:" << ucSocketBuffer << endl;
-                   pszCurrentMsg = ucSocketBuffer + nIndex + 1;
-                }
-            }
-         }
-         break;
-         
       case network::callBack_t::SESSION_CLOSE:
          std::cout << "hup:" << a_fd << std::endl;
          break;
@@ -0,0 +1,170 @@
+#include "sockets.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <unistd.h>
+#include "string.h"
+
+using namespace std;
+using namespace gdlib;
+
+// ping-pong round trip latency of ServerAsync and ClientAsync blocking in epoll_wait, spinning for a while after each
+// message and spinning all the time.  the client sends the next message from its message callback, so each round trip
+// is two wakeups of a reactor
+// latency [round trips] [server cpu] [client cpu] [SO_BUSY_POLL us]
+
+struct ping_t
+{
+   network::ClientAsync*   pClient     = nullptr;
+   vector<uint64_t>        vecRtt_ns   = vector<uint64_t>();
+   size_t                  nTrips      = 0;
+   atomic<bool>            bDone       = {false};
+};
+
+void latency_serverMessageHandler  ( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData );
+void latency_clientMessageHandler  ( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData );
+void latency_socketCallbackHandler ( const network::socketfd_t& a_fd, const network::callBack_t& a_type, void* const a_pData );
+void latency_errorCallbackHandler  ( const int32_t a_nerrno, const char* a_pszError, void* const a_pData );
+void runMode( const char* a_pszMode, const uint32_t a_nSpin_us, const string& a_strPort, const size_t a_nTrips, const int32_t a_nServerCpu, const int32_t a_nClientCpu, const uint32_t a_nBusyPoll_us );
+void sendPing( ping_t& a_ping );
+
+
+int main( int argc, char** argv )
+{
+   const size_t   nTrips      = (argc > 1) ? static_cast<size_t>( atoi( argv[1] ) ) : 20000;
+   const int32_t  nServerCpu  = (argc > 2) ? atoi( argv[2] ) : -1;
+   const int32_t  nClientCpu  = (argc > 3) ? atoi( argv[3] ) : -1;
+   const uint32_t nBusyPoll   = (argc > 4) ? static_cast<uint32_t>( atoi( argv[4] ) ) : 0;
+
+   cout << "round trips:" << nTrips << ", server cpu:" << nServerCpu << ", client cpu:" << nClientCpu << ", SO_BUSY_POLL us:" << nBusyPoll << endl;
+   if( sysconf( _SC_NPROCESSORS_ONLN ) < 2 )
+   {
+      cout << "one cpu, the spinning modes compete with each other for it" << endl;
+   }
+
+   runMode( "block",          0,                                      "5230", nTrips, nServerCpu, nClientCpu, nBusyPoll );
+   runMode( "spin 100us",     100,                                    "5231", nTrips, nServerCpu, nClientCpu, nBusyPoll );
+   runMode( "spin forever",   network::BusyPoll::s_nSpinForever,      "5232", nTrips, nServerCpu, nClientCpu, nBusyPoll );
+   return 0;
+}
+
+
+
+void runMode( const char* a_pszMode, const uint32_t a_nSpin_us, const string& a_strPort, const size_t a_nTrips, const int32_t a_nServerCpu, const int32_t a_nClientCpu, const uint32_t a_nBusyPoll_us )
+{
+   network::ServerAsync server;
+   server.setLocalSocketProperties( network::Sockets::getDefaultServerSocketFlags() );
+   if( false == server.open( network::sockType_t::SERVER, network::protocol_t::TCP, "localhost", a_strPort ) )
+   {
+      cout << a_pszMode << ": open failed" << endl;
+      return;
+   }
+   server.setNoDelay();
+   server.setMessageCallback( latency_serverMessageHandler );
+   server.setFraming( network::framing_t::FIXED, sizeof( uint64_t ) );
+   server.setBusyPoll( a_nSpin_us, a_nBusyPoll_us );
+   if( -1 != a_nServerCpu )
+   {
+      server.setReactorCpus( { a_nServerCpu } );
+   }
+   if( false == server.startAsync( latency_socketCallbackHandler, reinterpret_cast<void*>( &server ), latency_errorCallbackHandler ) )
+   {
+      cout << a_pszMode << ": start failed" << endl;
+      return;
+   }
+   usleep( 100000 );
+
+   network::ClientAsync client;
+   ping_t ping;
+   ping.pClient = &client;
+   ping.nTrips  = a_nTrips;
+   ping.vecRtt_ns.reserve( a_nTrips );
+   client.setLocalSocketProperties( network::Sockets::getDefaultClientSocketFlags() );
+   if( false == client.connect( "localhost", a_strPort ) )
+   {
+      cout << a_pszMode << ": connect failed" << endl;
+      server.stop();
+      server.join();
+      return;
+   }
+   client.setNoDelay();
+   client.setMessageCallback( latency_clientMessageHandler );
+   client.setFraming( network::framing_t::FIXED, sizeof( uint64_t ) );
+   client.setBusyPoll( a_nSpin_us, a_nBusyPoll_us );
+   client.setReceiverCpu( a_nClientCpu );
+   client.startAsync( latency_socketCallbackHandler, reinterpret_cast<void*>( &ping ), latency_errorCallbackHandler );
+   usleep( 100000 );
+
+   sendPing( ping );
+   while( false == ping.bDone )
+   {
+      usleep( 10000 );
+   }
+   client.stop();
+   client.join();
+   const network::pollStats_t serverStats = server.getPollStats( 0 );   // the reactors are gone after join
+   const network::pollStats_t clientStats = client.getPollStats();
+   server.stop();
+   server.join();
+
+   vector<uint64_t>& vecRtt = ping.vecRtt_ns;
+   sort( vecRtt.begin(), vecRtt.end() );
+   cout << a_pszMode << ": rtt us p50 " << vecRtt[vecRtt.size() / 2] / 1000.0 << ", p99 " << vecRtt[vecRtt.size() * 99 / 100] / 1000.0
+        << ", max " << vecRtt.back() / 1000.0 << endl;
+   for( const auto& side : { make_pair( "   server", serverStats ), make_pair( "   client", clientStats ) } )
+   {
+      cout << side.first << " wakeups " << side.second.nWakeups << ", blocks " << side.second.nBlocks << ", empty polls " << side.second.nEmptyPolls
+           << ", wakeup to callback ns avg " << side.second.nCallbackAvg_ns << ", max " << side.second.nCallbackMax_ns << endl;
+   }
+}
+
+
+
+void sendPing( ping_t& a_ping )
+{
+   const uint64_t nStamp = network::BusyPoll::now_ns();
+   a_ping.pClient->send( &nStamp, sizeof( nStamp ) );
+}
+
+
+
+void latency_serverMessageHandler( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData )
+{
+   network::ServerAsync* pServer = reinterpret_cast<network::ServerAsync*>(a_pData);
+   pServer->send( a_fd, a_pMessage, static_cast<ssize_t>( a_nLength ) );
+}
+
+
+
+void latency_clientMessageHandler( const network::socketfd_t&, const uint8_t* a_pMessage, const size_t, void* const a_pData )
+{
+   ping_t& ping = *reinterpret_cast<ping_t*>(a_pData);
+   uint64_t nStamp;
+   memcpy( &nStamp, a_pMessage, sizeof( nStamp ) );
+   ping.vecRtt_ns.push_back( network::BusyPoll::now_ns() - nStamp );
+   if( ping.vecRtt_ns.size() < ping.nTrips )
+   {
+      sendPing( ping );
+   } else
+   {
+      ping.bDone = true;
+   }
+}
+
+
+
+void latency_socketCallbackHandler( const network::socketfd_t&, const network::callBack_t&, void* const )
+{
+}
+
+
+
+void latency_errorCallbackHandler( const int32_t a_nerrno, const char* a_pszError, void* const )
+{
+   if( nullptr != a_pszError )
+   {
+      cerr << "socket: " << a_nerrno << ", " << a_pszError << endl;
+   }
+}
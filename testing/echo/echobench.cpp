@@ -0,0 +1,382 @@
+#include "sockets.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <unistd.h>
+#include "string.h"
+
+using namespace std;
+using namespace gdlib;
+
+// echo benchmark over loopback.  each connection keeps a_nDepth messages in flight, a message carries its send time and
+// the next one is sent when its echo arrives, for a_nSeconds.  modes
+//    blocking   Server, a thread per connection, and blocking Client threads
+//    level      ServerAsync and ClientAsync, level trigger
+//    edge       ServerAsync and ClientAsync, edge trigger
+// one CSV line per mode on stdout, the latency is the round trip of a message, from send to its echo
+// echobench [connections] [message size] [depth] [seconds] [modes, ex blocking,level,edge] [label]
+
+struct connection_t
+{
+   network::Client*        pClient     = nullptr;
+   network::ClientAsync*   pAsync      = nullptr;
+   size_t                  nSize       = 0;
+   network::Histogram      latency     = network::Histogram();     // written by the receiving thread only
+   uint64_t                nMessages   = 0;
+   atomic<size_t>          nInFlight   = {0};                      // async, the first messages are sent by the main thread
+   atomic<bool>            bDone       = {false};
+};
+
+struct result_t
+{
+   double                  dSeconds    = 0;
+   uint64_t                nMessages   = 0;
+   network::Histogram      latency     = network::Histogram();
+};
+
+static atomic<bool> g_bRunning = {false};
+
+void echo_serverMessageHandler     ( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData );
+void echo_clientMessageHandler     ( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData );
+void echo_socketCallbackHandler    ( const network::socketfd_t& a_fd, const network::callBack_t& a_type, void* const a_pData );
+void echo_errorCallbackHandler     ( const int32_t a_nerrno, const char* a_pszError, void* const a_pData );
+bool runBlocking( const string& a_strPort, const size_t a_nConnections, const size_t a_nSize, const size_t a_nDepth, const uint32_t a_nSeconds, result_t& a_result );
+bool runAsync( const bool a_bEdgeTrigger, const string& a_strPort, const size_t a_nConnections, const size_t a_nSize, const size_t a_nDepth, const uint32_t a_nSeconds, result_t& a_result );
+void serveBlocking( network::Server* a_pServer, const network::socketfd_t a_fd );
+void clientBlocking( connection_t* a_pConnection, const size_t a_nDepth );
+void sendMessage( connection_t& a_connection );
+void printResult( const string& a_strLabel, const string& a_strMode, const size_t a_nConnections, const size_t a_nSize, const size_t a_nDepth, const result_t& a_result );
+
+
+int main( int argc, char** argv )
+{
+   const size_t   nConnections = (argc > 1) ? static_cast<size_t>( atoi( argv[1] ) ) : 16;
+   const size_t   nSize        = max( static_cast<size_t>( (argc > 2) ? atoi( argv[2] ) : 64 ), sizeof( uint64_t ) );
+   const size_t   nDepth       = max( static_cast<size_t>( (argc > 3) ? atoi( argv[3] ) : 8 ), static_cast<size_t>( 1 ) );
+   const uint32_t nSeconds     = (argc > 4) ? static_cast<uint32_t>( atoi( argv[4] ) ) : 5;
+   const string   strModes     = (argc > 5) ? argv[5] : "blocking,level,edge";
+   const string   strLabel     = (argc > 6) ? argv[6] : "";
+
+   cout << "label,mode,connections,message_size,depth,seconds,messages,msgs_per_sec,mb_per_sec,p50_us,p90_us,p99_us,p999_us,max_us" << endl;
+   size_t nStart = 0;
+   int32_t nPort = 5240;
+   while( nStart <= strModes.size() )
+   {
+      size_t nEnd = strModes.find( ',', nStart );
+      if( string::npos == nEnd )
+      {
+         nEnd = strModes.size();
+      }
+      const string strMode = strModes.substr( nStart, nEnd - nStart );
+      nStart = nEnd + 1;
+
+      result_t result;
+      bool     bOk = false;
+      if( "blocking" == strMode )
+      {
+         bOk = runBlocking( to_string( nPort++ ), nConnections, nSize, nDepth, nSeconds, result );
+      } else if( ("level" == strMode) || ("edge" == strMode) )
+      {
+         bOk = runAsync( "edge" == strMode, to_string( nPort++ ), nConnections, nSize, nDepth, nSeconds, result );
+      } else
+      {
+         cerr << "unknown mode: " << strMode << endl;
+         continue;
+      }
+      if( true == bOk )
+      {
+         printResult( strLabel, strMode, nConnections, nSize, nDepth, result );
+      }
+   }
+   return 0;
+}
+
+
+
+bool runBlocking( const string& a_strPort, const size_t a_nConnections, const size_t a_nSize, const size_t a_nDepth, const uint32_t a_nSeconds, result_t& a_result )
+{
+   network::Server server;
+   server.setLocalSocketProperties( network::Sockets::getDefaultServerSocketFlags() );
+   server.setListenerBacklog( static_cast<int32_t>( a_nConnections ) );
+   if( false == server.open( network::sockType_t::SERVER, network::protocol_t::TCP, "localhost", a_strPort ) )
+   {
+      cerr << "blocking: open failed" << endl;
+      return false;
+   }
+   server.setNoDelay();
+
+   vector<thread> vecServers;
+   thread thdAccept( [&]()
+   {
+      for( size_t nIndex=0; nIndex<a_nConnections; ++nIndex )
+      {
+         const network::socketfd_t fd = server.waitForConnection();
+         if( -1 == fd )
+         {
+            break;
+         }
+         vecServers.emplace_back( serveBlocking, &server, fd );
+      }
+   } );
+
+   vector<unique_ptr<network::Client>> vecClients;
+   vector<unique_ptr<connection_t>>    vecConnections;
+   for( size_t nIndex=0; nIndex<a_nConnections; ++nIndex )
+   {
+      vecClients.emplace_back( new network::Client() );
+      vecConnections.emplace_back( new connection_t() );
+      network::Client& client = *vecClients.back();
+      client.setLocalSocketProperties( network::Sockets::getDefaultClientSocketFlags() );
+      if( false == client.connect( "localhost", a_strPort ) )
+      {
+         cerr << "blocking: connect failed" << endl;
+         vecClients.pop_back();
+         vecConnections.pop_back();
+         break;
+      }
+      client.setNoDelay();
+      vecConnections.back()->pClient = &client;
+      vecConnections.back()->nSize   = a_nSize;
+   }
+
+   g_bRunning = true;
+   const uint64_t nStart_ns = network::BusyPoll::now_ns();
+   vector<thread> vecThreads;
+   for( auto& pConnection : vecConnections )
+   {
+      vecThreads.emplace_back( clientBlocking, pConnection.get(), a_nDepth );
+   }
+   sleep( a_nSeconds );
+   g_bRunning = false;
+   for( auto& thd : vecThreads )
+   {
+      thd.join();
+   }
+   a_result.dSeconds = static_cast<double>( network::BusyPoll::now_ns() - nStart_ns ) / 1e9;
+
+   for( auto& pClient : vecClients )
+   {
+      pClient->close();
+   }
+   ::shutdown( server.getfd(), SHUT_RDWR );    // ends the accept when a connect failed
+   thdAccept.join();
+   for( auto& thd : vecServers )
+   {
+      thd.join();
+   }
+   server.close();
+
+   for( const auto& pConnection : vecConnections )
+   {
+      a_result.nMessages += pConnection->nMessages;
+      a_result.latency.merge( pConnection->latency );
+   }
+   return false == vecConnections.empty();
+}
+
+
+
+void serveBlocking( network::Server* a_pServer, const network::socketfd_t a_fd )
+{
+   vector<uint8_t> vecBuffer( 65536 );
+   while( true )
+   {
+      const ssize_t nBytes = a_pServer->receive( a_fd, vecBuffer.data(), static_cast<ssize_t>( vecBuffer.size() ) );
+      if( (nBytes <= 0) || (nBytes != a_pServer->send( a_fd, vecBuffer.data(), nBytes )) )
+      {
+         break;
+      }
+   }
+   ::close( a_fd );
+}
+
+
+
+void clientBlocking( connection_t* a_pConnection, const size_t a_nDepth )
+{
+   connection_t&     connection = *a_pConnection;
+   vector<uint8_t>   vecReceive( connection.nSize );
+   for( size_t nIndex=0; nIndex<a_nDepth; ++nIndex )
+   {
+      sendMessage( connection );
+   }
+   while( 0 != connection.nInFlight )
+   {
+      size_t nReceived = 0;
+      while( nReceived < vecReceive.size() )
+      {
+         const ssize_t nBytes = connection.pClient->receive( vecReceive.data() + nReceived, static_cast<ssize_t>( vecReceive.size() - nReceived ) );
+         if( nBytes <= 0 )
+         {
+            cerr << "blocking: receive failed" << endl;
+            return;
+         }
+         nReceived += static_cast<size_t>( nBytes );
+      }
+      echo_clientMessageHandler( -1, vecReceive.data(), vecReceive.size(), a_pConnection );
+   }
+}
+
+
+
+bool runAsync( const bool a_bEdgeTrigger, const string& a_strPort, const size_t a_nConnections, const size_t a_nSize, const size_t a_nDepth, const uint32_t a_nSeconds, result_t& a_result )
+{
+   const char* pszMode = (true == a_bEdgeTrigger) ? "edge" : "level";
+   network::ServerAsync server;
+   server.setLocalSocketProperties( network::Sockets::getDefaultServerSocketFlags() );
+   server.setListenerBacklog( static_cast<int32_t>( a_nConnections ) );
+   if( false == server.open( network::sockType_t::SERVER, network::protocol_t::TCP, "localhost", a_strPort ) )
+   {
+      cerr << pszMode << ": open failed" << endl;
+      return false;
+   }
+   server.setNoDelay();
+   server.setMessageCallback( echo_serverMessageHandler );
+   server.setFraming( network::framing_t::FIXED, static_cast<uint32_t>( a_nSize ) );
+   if( false == server.startAsync( echo_socketCallbackHandler, reinterpret_cast<void*>( &server ), echo_errorCallbackHandler, a_bEdgeTrigger ) )
+   {
+      cerr << pszMode << ": start failed" << endl;
+      return false;
+   }
+   usleep( 100000 );
+
+   vector<unique_ptr<network::ClientAsync>> vecClients;
+   vector<unique_ptr<connection_t>>         vecConnections;
+   for( size_t nIndex=0; nIndex<a_nConnections; ++nIndex )
+   {
+      vecClients.emplace_back( new network::ClientAsync() );
+      vecConnections.emplace_back( new connection_t() );
+      network::ClientAsync& client     = *vecClients.back();
+      connection_t&         connection = *vecConnections.back();
+      connection.pAsync = &client;
+      connection.nSize  = a_nSize;
+      client.setLocalSocketProperties( network::Sockets::getDefaultClientSocketFlags() );
+      if( false == client.connect( "localhost", a_strPort ) )
+      {
+         cerr << pszMode << ": connect failed" << endl;
+         vecClients.pop_back();
+         vecConnections.pop_back();
+         break;
+      }
+      client.setNoDelay();
+      client.setMessageCallback( echo_clientMessageHandler );
+      client.setFraming( network::framing_t::FIXED, static_cast<uint32_t>( a_nSize ) );
+      client.startAsync( echo_socketCallbackHandler, reinterpret_cast<void*>( &connection ), echo_errorCallbackHandler, a_bEdgeTrigger );
+   }
+   usleep( 100000 );
+
+   g_bRunning = true;
+   const uint64_t nStart_ns = network::BusyPoll::now_ns();
+   for( auto& pConnection : vecConnections )
+   {
+      for( size_t nIndex=0; nIndex<a_nDepth; ++nIndex )
+      {
+         sendMessage( *pConnection );
+      }
+   }
+   sleep( a_nSeconds );
+   g_bRunning = false;
+   for( auto& pConnection : vecConnections )
+   {
+      // the messages in flight come back, give up on a lost one after a second
+      for( int32_t nWait=0; (false == pConnection->bDone) && (nWait<1000); ++nWait )
+      {
+         usleep( 1000 );
+      }
+   }
+   a_result.dSeconds = static_cast<double>( network::BusyPoll::now_ns() - nStart_ns ) / 1e9;
+
+   for( auto& pClient : vecClients )
+   {
+      pClient->stop();
+      pClient->join();
+   }
+   server.stop();
+   server.join();
+
+   for( const auto& pConnection : vecConnections )
+   {
+      a_result.nMessages += pConnection->nMessages;
+      a_result.latency.merge( pConnection->latency );
+   }
+   return false == vecConnections.empty();
+}
+
+
+
+void sendMessage( connection_t& a_connection )
+{
+   static thread_local vector<uint8_t> t_vecMessage;
+   t_vecMessage.resize( a_connection.nSize, 'x' );
+   const uint64_t nStamp = network::BusyPoll::now_ns();
+   memcpy( t_vecMessage.data(), &nStamp, sizeof( nStamp ) );
+   ++a_connection.nInFlight;
+   const ssize_t nSize = static_cast<ssize_t>( a_connection.nSize );
+   if( nSize != ((nullptr != a_connection.pAsync) ? a_connection.pAsync->send( t_vecMessage.data(), nSize )
+                                                  : a_connection.pClient->send( t_vecMessage.data(), nSize )) )
+   {
+      --a_connection.nInFlight;
+   }
+}
+
+
+
+void printResult( const string& a_strLabel, const string& a_strMode, const size_t a_nConnections, const size_t a_nSize, const size_t a_nDepth, const result_t& a_result )
+{
+   const double dSeconds = (a_result.dSeconds > 0) ? a_result.dSeconds : 1;
+   char szLine[512];
+   snprintf( szLine, sizeof( szLine ), "%s,%s,%zu,%zu,%zu,%.3f,%lu,%.0f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f",
+             a_strLabel.c_str(), a_strMode.c_str(), a_nConnections, a_nSize, a_nDepth, dSeconds, a_result.nMessages,
+             static_cast<double>( a_result.nMessages ) / dSeconds,
+             static_cast<double>( a_result.nMessages * a_nSize ) / dSeconds / 1e6,
+             static_cast<double>( a_result.latency.percentile( 50 ) ) / 1e3, static_cast<double>( a_result.latency.percentile( 90 ) ) / 1e3,
+             static_cast<double>( a_result.latency.percentile( 99 ) ) / 1e3, static_cast<double>( a_result.latency.percentile( 99.9 ) ) / 1e3,
+             static_cast<double>( a_result.latency.max() ) / 1e3 );
+   cout << szLine << endl;
+}
+
+
+
+void echo_serverMessageHandler( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData )
+{
+   network::ServerAsync* pServer = reinterpret_cast<network::ServerAsync*>(a_pData);
+   pServer->send( a_fd, a_pMessage, static_cast<ssize_t>( a_nLength ) );
+}
+
+
+
+void echo_clientMessageHandler( const network::socketfd_t&, const uint8_t* a_pMessage, const size_t, void* const a_pData )
+{
+   connection_t& connection = *reinterpret_cast<connection_t*>(a_pData);
+   uint64_t nStamp;
+   memcpy( &nStamp, a_pMessage, sizeof( nStamp ) );
+   connection.latency.record( network::BusyPoll::now_ns() - nStamp );
+   ++connection.nMessages;
+   if( true == g_bRunning )
+   {
+      --connection.nInFlight;
+      sendMessage( connection );
+   } else if( 1 == connection.nInFlight-- )
+   {
+      connection.bDone = true;
+   }
+}
+
+
+
+void echo_socketCallbackHandler( const network::socketfd_t&, const network::callBack_t&, void* const )
+{
+}
+
+
+
+void echo_errorCallbackHandler( const int32_t a_nerrno, const char* a_pszError, void* const )
+{
+   if( nullptr != a_pszError )
+   {
+      cerr << "socket: " << a_nerrno << ", " << a_pszError << endl;
+   }
+}
@@ -0,0 +1,212 @@
+#include "sockets.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <unistd.h>
+#include "string.h"
+
+using namespace std;
+using namespace gdlib;
+
+// many sessions of one MultiClientAsync against an echo server.  messages posted from this thread to every session
+// must come back to that session, in order.  then a session is removed and the next add takes its slot: the new id
+// must differ from the old one, and messages posted with the old id must not reach the new session
+// sessions [sessions] [messages per session]
+
+struct session_t
+{
+   atomic<bool>            bOpen          = {false};
+   atomic<uint64_t>        nReceived      = {0};
+   atomic<uint64_t>        nOutOfOrder    = {0};
+   atomic<uint64_t>        nLast          = {0};
+};
+
+void sessions_serverMessageHandler  ( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData );
+void sessions_serverSocketHandler   ( const network::socketfd_t& a_fd, const network::callBack_t& a_type, void* const a_pData );
+void sessions_clientMessageHandler  ( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData );
+void sessions_clientSocketHandler   ( const network::socketfd_t& a_fd, const network::callBack_t& a_type, void* const a_pData );
+void sessions_errorCallbackHandler  ( const int32_t a_nerrno, const char* a_pszError, void* const a_pData );
+int32_t addSession( network::MultiClientAsync& a_client, session_t& a_session, const string& a_strPort );
+bool waitFor( const atomic<uint64_t>& a_nValue, const uint64_t a_nExpected );
+
+
+int main( int argc, char** argv )
+{
+   const size_t   nSessions = (argc > 1) ? static_cast<size_t>( atoi( argv[1] ) ) : 200;
+   const uint64_t nMessages = (argc > 2) ? static_cast<uint64_t>( atoi( argv[2] ) ) : 500;
+   const string   strPort   = "5280";
+
+   network::ServerAsync server;
+   server.setLocalSocketProperties( network::Sockets::getDefaultServerSocketFlags() );
+   server.setListenerBacklog( 4096 );     // all sessions connect at once
+   if( false == server.open( network::sockType_t::SERVER, network::protocol_t::TCP, "localhost", strPort ) )
+   {
+      cout << "open failed, " << strerror( errno ) << endl;
+      return 1;
+   }
+   server.setMessageCallback( sessions_serverMessageHandler );
+   server.setFraming( network::framing_t::FIXED, sizeof( uint64_t ) );
+   if( false == server.startAsync( sessions_serverSocketHandler, reinterpret_cast<void*>( &server ), sessions_errorCallbackHandler ) )
+   {
+      cout << "start failed" << endl;
+      return 1;
+   }
+   usleep( 100000 );
+
+   network::MultiClientAsync client;
+   client.setFraming( network::framing_t::FIXED, sizeof( uint64_t ) );
+   if( false == client.startAsync( sessions_errorCallbackHandler ) )
+   {
+      cout << "client start failed, " << strerror( errno ) << endl;
+      return 1;
+   }
+   vector<unique_ptr<session_t>> vecSessions;
+   vector<int32_t>               vecIds;
+   for( size_t nIndex=0; nIndex<nSessions; ++nIndex )
+   {
+      vecSessions.emplace_back( new session_t() );
+      vecIds.push_back( addSession( client, *vecSessions.back(), strPort ) );
+   }
+   size_t nOpen = 0;
+   for( uint32_t nWait=0; (nWait<500) && (nOpen < nSessions); ++nWait )
+   {
+      usleep( 10000 );
+      nOpen = 0;
+      for( const auto& pSession : vecSessions )
+      {
+         nOpen += (true == pSession->bOpen) ? 1 : 0;
+      }
+   }
+
+   // every session echoes what was posted for it
+   for( uint64_t nSequence=1; nSequence<=nMessages; ++nSequence )
+   {
+      for( const int32_t nId : vecIds )
+      {
+         client.post( nId, &nSequence, sizeof( nSequence ) );
+      }
+   }
+   bool     bPassed     = (nOpen == nSessions);
+   uint64_t nReceived   = 0;
+   uint64_t nOutOfOrder = 0;
+   for( const auto& pSession : vecSessions )
+   {
+      bPassed      = (true == waitFor( pSession->nReceived, nMessages )) && (true == bPassed);
+      nReceived   += pSession->nReceived;
+      nOutOfOrder += pSession->nOutOfOrder;
+   }
+   bPassed = bPassed && (0 == nOutOfOrder);
+   cout << "sessions open " << nOpen << " of " << nSessions << ", echoed " << nReceived << " of " << nSessions * nMessages
+        << ", out of order " << nOutOfOrder << (true == bPassed ? "" : "  FAILED") << endl;
+
+   // remove the first session, the next add takes its slot
+   const int32_t nOldId = vecIds[0];
+   client.remove( nOldId );
+   usleep( 100000 );     // the receiver thread frees the slot
+   session_t     reused;
+   const int32_t nNewId = addSession( client, reused, strPort );
+   for( uint32_t nWait=0; (nWait<500) && (false == reused.bOpen); ++nWait )
+   {
+      usleep( 10000 );
+   }
+   const uint64_t nStale = 1000;
+   for( uint32_t nIndex=0; nIndex<10; ++nIndex )
+   {
+      client.post( nOldId, &nStale, sizeof( nStale ) );
+   }
+   const uint64_t nFresh = 1;
+   client.post( nNewId, &nFresh, sizeof( nFresh ) );
+   waitFor( reused.nReceived, 1 );
+   usleep( 100000 );
+   const bool bReused = (true == reused.bOpen) && (nOldId != nNewId) && ((nOldId & 0xFFFFF) == (nNewId & 0xFFFFF)) &&
+                        (1 == reused.nReceived) && (nFresh == reused.nLast);
+   cout << "slot reuse: old id " << hex << nOldId << ", new id " << nNewId << dec << ", new session received " << reused.nReceived
+        << " message(s), last " << reused.nLast << (true == bReused ? "" : "  FAILED") << endl;
+   bPassed = bPassed && (true == bReused);
+
+   client.stop();
+   client.join();
+   server.stop();
+   server.join();
+   cout << (true == bPassed ? "passed" : "FAILED") << endl;
+   return (true == bPassed) ? 0 : 1;
+}
+
+
+
+int32_t addSession( network::MultiClientAsync& a_client, session_t& a_session, const string& a_strPort )
+{
+   network::sessionConfig_t config;
+   config.strHost   = "localhost";
+   config.strPort   = a_strPort;
+   config.cbSocket  = sessions_clientSocketHandler;
+   config.cbMessage = sessions_clientMessageHandler;
+   config.pContext  = &a_session;
+   return a_client.add( config );
+}
+
+
+
+bool waitFor( const atomic<uint64_t>& a_nValue, const uint64_t a_nExpected )
+{
+   for( uint32_t nWait=0; (nWait<1000) && (a_nValue < a_nExpected); ++nWait )
+   {
+      usleep( 10000 );
+   }
+   return a_nValue >= a_nExpected;
+}
+
+
+
+void sessions_serverMessageHandler( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData )
+{
+   network::ServerAsync* pServer = reinterpret_cast<network::ServerAsync*>(a_pData);
+   pServer->send( a_fd, a_pMessage, static_cast<ssize_t>( a_nLength ) );
+}
+
+
+
+void sessions_serverSocketHandler( const network::socketfd_t&, const network::callBack_t&, void* const )
+{
+}
+
+
+
+void sessions_clientMessageHandler( const network::socketfd_t&, const uint8_t* a_pMessage, const size_t, void* const a_pData )
+{
+   session_t& session = *reinterpret_cast<session_t*>(a_pData);
+   uint64_t   nSequence;
+   memcpy( &nSequence, a_pMessage, sizeof( nSequence ) );
+   if( nSequence != session.nLast + 1 )
+   {
+      ++session.nOutOfOrder;
+   }
+   session.nLast = nSequence;
+   ++session.nReceived;
+}
+
+
+
+void sessions_clientSocketHandler( const network::socketfd_t&, const network::callBack_t& a_type, void* const a_pData )
+{
+   session_t& session = *reinterpret_cast<session_t*>(a_pData);
+   if( network::callBack_t::SESION_OPEN == a_type )
+   {
+      session.bOpen = true;
+   } else if( network::callBack_t::SESSION_CLOSE == a_type )
+   {
+      session.bOpen = false;
+   }
+}
+
+
+
+void sessions_errorCallbackHandler( const int32_t a_nerrno, const char* a_pszError, void* const )
+{
+   if( nullptr != a_pszError )
+   {
+      cerr << "socket: " << a_nerrno << ", " << a_pszError << endl;
+   }
+}
@@ -0,0 +1,296 @@
+#include "sockets.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <unistd.h>
+#include "string.h"
+
+using namespace std;
+using namespace gdlib;
+
+// ServerAsync::post from the workers and from the application thread.  the workers reply to each message with post,
+// the client checks every reply arrives in order.  then a connection closes while a worker still holds a message of it
+// and a new connection takes the same fd: the late reply and a post with the tag of the closed connection must be
+// dropped, the new connection must only get what was posted for it.  last a thread posts while the server stops and
+// joins, post must then fail with ECANCELED instead of reaching the reactors
+// post [messages]
+
+static const uint64_t s_nSlow = ~0ULL;     // the worker waits before it replies
+
+struct server_t
+{
+   network::ServerAsync*   pServer        = nullptr;
+   atomic<int32_t>         fdOpened       = {-1};     // last SESION_OPEN
+   atomic<uint64_t>        nOpenedTag     = {0};      // its postTag, taken on the reactor
+   atomic<uint64_t>        nLateReplies   = {0};      // posts of the slow message that were queued
+};
+
+struct client_t
+{
+   atomic<uint64_t>        nReceived      = {0};
+   atomic<uint64_t>        nOutOfOrder    = {0};
+   atomic<uint64_t>        nLast          = {0};
+};
+
+void post_serverMessageHandler  ( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData );
+void post_serverSocketHandler   ( const network::socketfd_t& a_fd, const network::callBack_t& a_type, void* const a_pData );
+void post_clientMessageHandler  ( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData );
+void post_socketCallbackHandler ( const network::socketfd_t& a_fd, const network::callBack_t& a_type, void* const a_pData );
+void post_errorCallbackHandler  ( const int32_t a_nerrno, const char* a_pszError, void* const a_pData );
+bool connectClient( network::ClientAsync& a_client, client_t& a_state, const string& a_strPort );
+bool waitFor( const atomic<uint64_t>& a_nValue, const uint64_t a_nExpected );
+
+
+int main( int argc, char** argv )
+{
+   const uint64_t nMessages = (argc > 1) ? static_cast<uint64_t>( atoi( argv[1] ) ) : 100000;
+   const string   strPort   = "5260";
+
+   network::ServerAsync server;
+   server_t             state;
+   state.pServer = &server;
+   server.setLocalSocketProperties( network::Sockets::getDefaultServerSocketFlags() );
+   if( false == server.open( network::sockType_t::SERVER, network::protocol_t::TCP, "localhost", strPort ) )
+   {
+      cout << "open failed, " << strerror( errno ) << endl;
+      return 1;
+   }
+   server.setMessageCallback( post_serverMessageHandler );
+   server.setFraming( network::framing_t::FIXED, sizeof( uint64_t ) );
+   server.setWorkerCount( 2 );
+   if( false == server.startAsync( post_serverSocketHandler, reinterpret_cast<void*>( &state ), post_errorCallbackHandler ) )
+   {
+      cout << "start failed" << endl;
+      return 1;
+   }
+   usleep( 100000 );
+
+   // replies posted by the workers
+   bool bPassed = true;
+   {
+      network::ClientAsync client;
+      client_t             received;
+      if( false == connectClient( client, received, strPort ) )
+      {
+         return 1;
+      }
+      for( uint64_t nSequence=1; nSequence<=nMessages; ++nSequence )
+      {
+         client.send( &nSequence, sizeof( nSequence ) );
+      }
+      const bool bAll = waitFor( received.nReceived, nMessages );
+      cout << "worker replies: " << received.nReceived << " of " << nMessages << ", out of order " << received.nOutOfOrder
+           << ((true == bAll) && (0 == received.nOutOfOrder) ? "" : "  FAILED") << endl;
+      bPassed = bPassed && (true == bAll) && (0 == received.nOutOfOrder);
+      client.stop();
+      client.join();
+   }
+   usleep( 100000 );
+
+   // the connection closes while its message is on a worker, the fd is reused by the next one
+   {
+      network::ClientAsync first;
+      client_t             firstReceived;
+      if( false == connectClient( first, firstReceived, strPort ) )
+      {
+         return 1;
+      }
+      usleep( 50000 );
+      const int32_t  fdFirst  = state.fdOpened;
+      const uint64_t nTagFirst = state.nOpenedTag;
+      first.send( &s_nSlow, sizeof( s_nSlow ) );
+      usleep( 50000 );
+      first.stop();
+      first.join();
+      usleep( 50000 );
+
+      // the free descriptors below the one of the first connection are held but one, which the socket of the client
+      // takes, a blocking client opens no other, so the accept gets the fd of the first connection
+      vector<int32_t> vecHeld;
+      int32_t fdHeld;
+      while( (-1 != (fdHeld = dup( STDIN_FILENO ))) && (fdHeld < fdFirst) )
+      {
+         vecHeld.push_back( fdHeld );
+      }
+      if( -1 != fdHeld )
+      {
+         ::close( fdHeld );     // the fd of the first connection
+      }
+      if( false == vecHeld.empty() )
+      {
+         ::close( vecHeld.back() );
+         vecHeld.pop_back();
+      }
+      network::Client second;
+      second.setLocalSocketProperties( network::Sockets::getDefaultClientSocketFlags() );
+      if( false == second.connect( "localhost", strPort ) )
+      {
+         cout << "connect failed, " << strerror( errno ) << endl;
+         return 1;
+      }
+      usleep( 50000 );
+      for( const int32_t fd : vecHeld )
+      {
+         ::close( fd );
+      }
+      const int32_t  fdSecond  = state.fdOpened;
+      const uint64_t nTagSecond = server.postTag( fdSecond );
+
+      // the tag of the closed connection, from this thread
+      const uint64_t nStale = 7;
+      server.post( fdFirst, nTagFirst, &nStale, sizeof( nStale ) );
+      // the worker replies to the slow message after 300 ms
+      usleep( 500000 );
+      const uint64_t nFresh = 1;
+      const bool     bPosted = server.post( fdSecond, nTagSecond, &nFresh, sizeof( nFresh ) );
+      // posted last, anything that leaked to the new connection would arrive before it
+      uint64_t nFirst    = 0;
+      ssize_t  nReceived = 0;
+      while( nReceived < static_cast<ssize_t>( sizeof( nFirst ) ) )
+      {
+         const ssize_t nRead = second.receive( reinterpret_cast<uint8_t*>( &nFirst ) + nReceived, static_cast<ssize_t>( sizeof( nFirst ) ) - nReceived );
+         if( nRead <= 0 )
+         {
+            break;
+         }
+         nReceived += nRead;
+      }
+
+      const bool bDropped = (true == bPosted) && (nFresh == nFirst);
+      cout << "post after close: fd " << fdFirst << " then " << fdSecond << (fdFirst == fdSecond ? " (reused)" : " (not reused, the check is weaker)")
+           << ", tags " << hex << nTagFirst << " " << nTagSecond << dec << ", late worker reply queued " << state.nLateReplies
+           << ", new connection received first " << nFirst << (true == bDropped ? "" : "  FAILED") << endl;
+      bPassed = bPassed && (true == bDropped) && (nTagFirst != nTagSecond) && (1 == state.nLateReplies);
+
+      second.close();
+      usleep( 100000 );
+      // closed, there is no tag and nothing to post to
+      const bool bClosed = (0 == server.postTag( fdSecond )) && (false == server.post( fdSecond, &nFresh, sizeof( nFresh ) )) && (EBADF == errno);
+      cout << "post to a closed fd: " << (true == bClosed ? "EBADF" : "accepted  FAILED") << endl;
+      bPassed = bPassed && (true == bClosed);
+   }
+
+   // posting from another thread while the server stops
+   network::Client last;
+   last.setLocalSocketProperties( network::Sockets::getDefaultClientSocketFlags() );
+   if( false == last.connect( "localhost", strPort ) )
+   {
+      cout << "connect failed, " << strerror( errno ) << endl;
+      return 1;
+   }
+   usleep( 50000 );
+   const int32_t  fdOpen   = state.fdOpened;
+   const uint64_t nTagOpen = state.nOpenedTag;
+   atomic<uint64_t> nPosted = {0};
+   thread thdPost( [&server, &nPosted, fdOpen, nTagOpen]()
+   {
+      const uint64_t nValue = 1;
+      while( true == server.post( fdOpen, nTagOpen, &nValue, sizeof( nValue ) ) )
+      {
+         ++nPosted;
+      }
+   } );
+   usleep( 50000 );
+   server.stop();
+   server.join();
+   thdPost.join();
+   const uint64_t nValue  = 1;
+   const bool     bStopped = (0 != nPosted) && (false == server.post( fdOpen, nTagOpen, &nValue, sizeof( nValue ) )) && (ECANCELED == errno);
+   cout << "post after stop and join: " << (true == bStopped ? "ECANCELED" : "accepted  FAILED") << ", " << nPosted << " posted before" << endl;
+   bPassed = bPassed && (true == bStopped);
+   last.close();
+   cout << (true == bPassed ? "passed" : "FAILED") << endl;
+   return (true == bPassed) ? 0 : 1;
+}
+
+
+
+bool connectClient( network::ClientAsync& a_client, client_t& a_state, const string& a_strPort )
+{
+   a_client.setLocalSocketProperties( network::Sockets::getDefaultClientSocketFlags() );
+   if( false == a_client.connect( "localhost", a_strPort ) )
+   {
+      cout << "connect failed, " << strerror( errno ) << endl;
+      return false;
+   }
+   a_client.setMessageCallback( post_clientMessageHandler );
+   a_client.setFraming( network::framing_t::FIXED, sizeof( uint64_t ) );
+   a_client.startAsync( post_socketCallbackHandler, reinterpret_cast<void*>( &a_state ), post_errorCallbackHandler );
+   return true;
+}
+
+
+
+bool waitFor( const atomic<uint64_t>& a_nValue, const uint64_t a_nExpected )
+{
+   for( uint32_t nWait=0; (nWait<1000) && (a_nValue < a_nExpected); ++nWait )
+   {
+      usleep( 10000 );
+   }
+   return a_nValue >= a_nExpected;
+}
+
+
+
+void post_serverMessageHandler( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData )
+{
+   server_t& state = *reinterpret_cast<server_t*>(a_pData);
+   uint64_t  nSequence;
+   memcpy( &nSequence, a_pMessage, sizeof( nSequence ) );
+   if( s_nSlow == nSequence )
+   {
+      // the connection closes and the fd is taken again meanwhile, the reply must not reach the new peer
+      usleep( 300000 );
+      if( true == state.pServer->post( a_fd, a_pMessage, a_nLength ) )
+      {
+         ++state.nLateReplies;
+      }
+      return;
+   }
+   state.pServer->post( a_fd, a_pMessage, a_nLength );
+}
+
+
+
+void post_serverSocketHandler( const network::socketfd_t& a_fd, const network::callBack_t& a_type, void* const a_pData )
+{
+   server_t& state = *reinterpret_cast<server_t*>(a_pData);
+   if( network::callBack_t::SESION_OPEN == a_type )
+   {
+      state.nOpenedTag = state.pServer->postTag( a_fd );
+      state.fdOpened   = a_fd;
+   }
+}
+
+
+
+void post_clientMessageHandler( const network::socketfd_t&, const uint8_t* a_pMessage, const size_t, void* const a_pData )
+{
+   client_t& state = *reinterpret_cast<client_t*>(a_pData);
+   uint64_t  nSequence;
+   memcpy( &nSequence, a_pMessage, sizeof( nSequence ) );
+   if( (nSequence != state.nLast + 1) && (1 != nSequence) )
+   {
+      ++state.nOutOfOrder;
+   }
+   state.nLast = nSequence;
+   ++state.nReceived;
+}
+
+
+
+void post_socketCallbackHandler( const network::socketfd_t&, const network::callBack_t&, void* const )
+{
+}
+
+
+
+void post_errorCallbackHandler( const int32_t a_nerrno, const char* a_pszError, void* const )
+{
+   if( nullptr != a_pszError )
+   {
+      cerr << "socket: " << a_nerrno << ", " << a_pszError << endl;
+   }
+}
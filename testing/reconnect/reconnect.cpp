@@ -0,0 +1,211 @@
+#include "sockets.h"
+#include <iostream>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <unistd.h>
+#include "string.h"
+
+using namespace std;
+using namespace gdlib;
+
+// ClientAsync with setReconnect while a thread posts without pause.  the server goes away and a new one is started on
+// the same port: the client must reconnect by itself, post must fail while the connection is down, and nothing posted
+// for the lost connection may reach the new server.  each message carries the time it was posted, the new server
+// counts the ones posted before the client saw the old connection close
+// reconnect [wait ms]
+
+struct server_t
+{
+   atomic<uint64_t>        nReceived      = {0};
+   atomic<uint64_t>        nStale         = {0};      // posted before the drop
+   const atomic<uint64_t>* pDown_ns       = nullptr;
+};
+
+struct client_t
+{
+   atomic<uint64_t>        nDown_ns       = {0};      // SESSION_CLOSE of the lost connection
+   atomic<uint32_t>        nOpened        = {0};      // OPEN of the state callback, the reconnects
+   atomic<uint32_t>        nRetryWaits    = {0};
+   atomic<bool>            bPosting       = {true};
+   atomic<uint64_t>        nPosted        = {0};
+   atomic<uint64_t>        nRefused       = {0};
+};
+
+void reconnect_serverMessageHandler  ( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData );
+void reconnect_serverSocketHandler   ( const network::socketfd_t& a_fd, const network::callBack_t& a_type, void* const a_pData );
+void reconnect_clientSocketHandler   ( const network::socketfd_t& a_fd, const network::callBack_t& a_type, void* const a_pData );
+void reconnect_stateHandler          ( const network::sessionState_t a_state, const int32_t a_nError, void* const a_pData );
+void reconnect_errorCallbackHandler  ( const int32_t a_nerrno, const char* a_pszError, void* const a_pData );
+bool startServer( network::ServerAsync& a_server, server_t& a_state, const string& a_strPort );
+void postLoop( network::ClientAsync* a_pClient, client_t* a_pState );
+
+
+int main( int argc, char** argv )
+{
+   const uint32_t nWait_ms = (argc > 1) ? static_cast<uint32_t>( atoi( argv[1] ) ) : 50;
+   const string   strPort  = "5270";
+
+   client_t                clientState;
+   server_t                firstState;
+   firstState.pDown_ns = &clientState.nDown_ns;
+   network::ServerAsync*   pFirst = new network::ServerAsync();
+   if( false == startServer( *pFirst, firstState, strPort ) )
+   {
+      return 1;
+   }
+
+   network::ClientAsync client;
+   client.setLocalSocketProperties( network::Sockets::getDefaultClientSocketFlags() );
+   if( false == client.connect( "localhost", strPort ) )
+   {
+      cout << "connect failed, " << strerror( errno ) << endl;
+      return 1;
+   }
+   client.setReconnect( -1, nWait_ms, nWait_ms * 4 );
+   client.setStateCallback( reconnect_stateHandler );
+   client.startAsync( reconnect_clientSocketHandler, reinterpret_cast<void*>( &clientState ), reconnect_errorCallbackHandler );
+   usleep( 100000 );
+
+   thread thdPost( postLoop, &client, &clientState );
+   usleep( 300000 );
+
+   // drop: the server closes its connections and goes away
+   pFirst->stop();
+   pFirst->join();
+   delete pFirst;
+   for( uint32_t nWait=0; (nWait<500) && (0 == clientState.nDown_ns); ++nWait )
+   {
+      usleep( 10000 );
+   }
+   const uint64_t nRefusedBefore = clientState.nRefused;
+   usleep( 200000 );
+   const uint64_t nRefusedDown   = clientState.nRefused - nRefusedBefore;
+
+   server_t             secondState;
+   secondState.pDown_ns = &clientState.nDown_ns;
+   network::ServerAsync second;
+   if( false == startServer( second, secondState, strPort ) )
+   {
+      clientState.bPosting = false;
+      thdPost.join();
+      return 1;
+   }
+   for( uint32_t nWait=0; (nWait<500) && (0 == clientState.nOpened); ++nWait )
+   {
+      usleep( 10000 );
+   }
+   usleep( 300000 );
+   clientState.bPosting = false;
+   thdPost.join();
+   usleep( 200000 );
+
+   const bool bReconnected = (1 == clientState.nOpened) && (network::sessionState_t::OPEN == client.getState());
+   const bool bPassed      = (true == bReconnected) && (0 != clientState.nDown_ns) && (0 != nRefusedDown) &&
+                             (0 != firstState.nReceived) && (0 != secondState.nReceived) && (0 == secondState.nStale);
+   cout << "posted " << clientState.nPosted << ", refused " << clientState.nRefused << " (" << nRefusedDown << " while down), retry waits "
+        << clientState.nRetryWaits << ", reconnected " << clientState.nOpened << endl;
+   cout << "first server received " << firstState.nReceived << ", second server received " << secondState.nReceived
+        << ", of them posted before the drop " << secondState.nStale << endl;
+   client.stop();
+   client.join();
+   second.stop();
+   second.join();
+   cout << (true == bPassed ? "passed" : "FAILED") << endl;
+   return (true == bPassed) ? 0 : 1;
+}
+
+
+
+bool startServer( network::ServerAsync& a_server, server_t& a_state, const string& a_strPort )
+{
+   a_server.setLocalSocketProperties( network::Sockets::getDefaultServerSocketFlags() );
+   if( false == a_server.open( network::sockType_t::SERVER, network::protocol_t::TCP, "localhost", a_strPort ) )
+   {
+      cout << "open failed, " << strerror( errno ) << endl;
+      return false;
+   }
+   a_server.setMessageCallback( reconnect_serverMessageHandler );
+   a_server.setFraming( network::framing_t::FIXED, sizeof( uint64_t ) );
+   if( false == a_server.startAsync( reconnect_serverSocketHandler, reinterpret_cast<void*>( &a_state ), reconnect_errorCallbackHandler ) )
+   {
+      cout << "start failed" << endl;
+      return false;
+   }
+   usleep( 100000 );
+   return true;
+}
+
+
+
+void postLoop( network::ClientAsync* a_pClient, client_t* a_pState )
+{
+   while( true == a_pState->bPosting )
+   {
+      const uint64_t nPosted_ns = network::BusyPoll::now_ns();
+      if( true == a_pClient->post( &nPosted_ns, sizeof( nPosted_ns ) ) )
+      {
+         ++a_pState->nPosted;
+      } else
+      {
+         ++a_pState->nRefused;
+      }
+      usleep( 20 );
+   }
+}
+
+
+
+void reconnect_serverMessageHandler( const network::socketfd_t&, const uint8_t* a_pMessage, const size_t, void* const a_pData )
+{
+   server_t& state = *reinterpret_cast<server_t*>(a_pData);
+   uint64_t  nPosted_ns;
+   memcpy( &nPosted_ns, a_pMessage, sizeof( nPosted_ns ) );
+   const uint64_t nDown_ns = state.pDown_ns->load();
+   if( (0 != nDown_ns) && (nPosted_ns < nDown_ns) )
+   {
+      ++state.nStale;
+   }
+   ++state.nReceived;
+}
+
+
+
+void reconnect_serverSocketHandler( const network::socketfd_t&, const network::callBack_t&, void* const )
+{
+}
+
+
+
+void reconnect_clientSocketHandler( const network::socketfd_t&, const network::callBack_t& a_type, void* const a_pData )
+{
+   client_t& state = *reinterpret_cast<client_t*>(a_pData);
+   if( (network::callBack_t::SESSION_CLOSE == a_type) && (0 == state.nDown_ns) )
+   {
+      state.nDown_ns = network::BusyPoll::now_ns();
+   }
+}
+
+
+
+void reconnect_stateHandler( const network::sessionState_t a_state, const int32_t, void* const a_pData )
+{
+   client_t& state = *reinterpret_cast<client_t*>(a_pData);
+   if( network::sessionState_t::RETRY_WAIT == a_state )
+   {
+      ++state.nRetryWaits;
+   } else if( network::sessionState_t::OPEN == a_state )
+   {
+      ++state.nOpened;
+   }
+}
+
+
+
+void reconnect_errorCallbackHandler( const int32_t a_nerrno, const char* a_pszError, void* const )
+{
+   if( nullptr != a_pszError )
+   {
+      cerr << "socket: " << a_nerrno << ", " << a_pszError << endl;
+   }
+}
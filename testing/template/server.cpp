@@ -0,0 +1,64 @@
+#include "reactor.h"
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace gdlib;
+
+
+/**
+ * @brief echo handler, the reactor calls the members directly
+ */
+class EchoHandler
+{
+   private:
+      network::BasicServerAsync<EchoHandler, network::edgeTriggered_t>* m_pServer = nullptr;
+
+   public:
+      void setServer( network::BasicServerAsync<EchoHandler, network::edgeTriggered_t>* a_pServer )   { m_pServer = a_pServer; }
+
+      void onOpen( const network::socketfd_t a_fd )
+      {
+         cout << "connection open fd:" << a_fd << endl;
+      }
+
+      void onMessage( const network::socketfd_t a_fd, const uint8_t* a_pMessage, const size_t a_nLength )
+      {
+         // the message is followed by its null delimiter in the receive buffer, echo both
+         auto res = m_pServer->send( a_fd, a_pMessage, a_nLength + 1 );
+         cout << "reply[" << res << "]:" << reinterpret_cast<const char*>( a_pMessage ) << endl;
+      }
+
+      void onClose( const network::socketfd_t a_fd )
+      {
+         cout << "connection closed fd:" << a_fd << endl;
+      }
+
+      void onError( const int32_t a_nErrno, const char* a_pszError )
+      {
+         cerr << "error " << a_nErrno << ":" << a_pszError << endl;
+      }
+};
+
+
+
+int main( int, char** )
+{
+   EchoHandler handler;
+   network::BasicServerAsync<EchoHandler, network::edgeTriggered_t> server( handler );
+   handler.setServer( &server );
+   string strHost = "localhost";
+   string strPort = "5200";
+
+   server.setLocalSocketProperties( network::Sockets::getDefaultServerSocketFlags() );
+   server.setReactorCount( 2 );
+   if( server.open( network::sockType_t::SERVER, network::protocol_t::TCP, strHost, strPort ) )
+   {
+      server.setFraming( network::framing_t::DELIMITER, '\0' );
+      if( false == server.nonblockingListener() )
+      {
+         std::cout << "error" << std::endl;
+      }
+   }
+   return 0;
+}
@@ -0,0 +1,260 @@
+#include "sockets.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <poll.h>
+#include <unistd.h>
+#include "string.h"
+
+using namespace std;
+using namespace gdlib;
+
+// the timer wheel driven from this thread, then the timers of a ServerAsync reactor.  one shot timers must fire at
+// their tick, not a tick later when moved down from a higher level, a cancelled timer must not fire, an interval timer
+// cancelled from its own callback must stop, cancelAll must drop the timers of a fd.  on the reactor the timers of a
+// connection go with it when it closes, setTimer off the reactor fails with EPERM
+// timers [resolution ms]
+
+struct shot_t
+{
+   const char*             pszName        = "";
+   uint32_t                nDelay_ms      = 0;
+   bool                    bExpected      = true;     // cancelled ones must not fire
+   uint64_t                nAdded_us      = 0;
+   int64_t                 nLate_us       = 0;
+   uint32_t                nFired         = 0;
+};
+
+struct repeat_t
+{
+   network::TimerWheel*    pWheel         = nullptr;
+   uint32_t                nFired         = 0;
+   uint32_t                nStopAfter     = 5;
+};
+
+struct server_t
+{
+   network::ServerAsync*   pServer        = nullptr;
+   atomic<uint32_t>        nTicks         = {0};      // interval timer of the connection
+   atomic<uint32_t>        nLong          = {0};      // one shot due after the close
+   atomic<uint32_t>        nReactor       = {0};      // timer of the reactor, survives the connection
+   atomic<bool>            bArmed         = {false};
+};
+
+uint64_t now_us();
+void shotHandler   ( const int32_t& a_fd, const uint64_t a_nTimer, void* const a_pData );
+void repeatHandler ( const int32_t& a_fd, const uint64_t a_nTimer, void* const a_pData );
+void ticksHandler  ( const int32_t& a_fd, const uint64_t a_nTimer, void* const a_pData );
+void longHandler   ( const int32_t& a_fd, const uint64_t a_nTimer, void* const a_pData );
+void reactorHandler( const int32_t& a_fd, const uint64_t a_nTimer, void* const a_pData );
+void timers_serverSocketHandler   ( const network::socketfd_t& a_fd, const network::callBack_t& a_type, void* const a_pData );
+void timers_clientSocketHandler   ( const network::socketfd_t& a_fd, const network::callBack_t& a_type, void* const a_pData );
+void timers_errorCallbackHandler  ( const int32_t a_nerrno, const char* a_pszError, void* const a_pData );
+bool runWheel( const uint32_t a_nResolution_ms );
+bool runReactor();
+
+
+int main( int argc, char** argv )
+{
+   const uint32_t nResolution_ms = (argc > 1) ? static_cast<uint32_t>( atoi( argv[1] ) ) : 10;
+
+   const bool bWheel   = runWheel( nResolution_ms );
+   const bool bReactor = runReactor();
+   cout << ((true == bWheel) && (true == bReactor) ? "passed" : "FAILED") << endl;
+   return ((true == bWheel) && (true == bReactor)) ? 0 : 1;
+}
+
+
+
+bool runWheel( const uint32_t a_nResolution_ms )
+{
+   network::TimerWheel wheel;
+   if( false == wheel.open( 1, a_nResolution_ms ) )
+   {
+      cout << "wheel open failed, " << strerror( errno ) << endl;
+      return false;
+   }
+   // 256 ticks is the first expiry moved down from level 1, it is due the tick it arrives in level 0
+   vector<shot_t> vecShots = { { "level 0",            5 * a_nResolution_ms,   true,  0, 0, 0 },
+                               { "256 ticks",          256 * a_nResolution_ms, true,  0, 0, 0 },
+                               { "300 ticks",          300 * a_nResolution_ms, true,  0, 0, 0 },
+                               { "cancelled",          100 * a_nResolution_ms, false, 0, 0, 0 },
+                               { "fd 7, cancelAll",    50 * a_nResolution_ms,  false, 0, 0, 0 },
+                               { "fd 7, cancelAll",    260 * a_nResolution_ms, false, 0, 0, 0 },
+                               { "fd 8",               50 * a_nResolution_ms,  true,  0, 0, 0 } };
+   const int32_t afd[] = { -1, -1, -1, -1, 7, 7, 8 };
+   vector<uint64_t> vecIds;
+   uint32_t         nLast_ms = 0;
+   for( size_t nShot=0; nShot<vecShots.size(); ++nShot )
+   {
+      vecShots[nShot].nAdded_us = now_us();
+      vecIds.push_back( wheel.add( afd[nShot], vecShots[nShot].nDelay_ms, 0, shotHandler, &vecShots[nShot] ) );
+      nLast_ms = max( nLast_ms, vecShots[nShot].nDelay_ms );
+   }
+   repeat_t repeat;
+   repeat.pWheel = &wheel;
+   wheel.add( -1, 2 * a_nResolution_ms, 2 * a_nResolution_ms, repeatHandler, &repeat );
+
+   const bool bCancelled = (true == wheel.cancel( vecIds[3] )) && (false == wheel.cancel( vecIds[3] ));
+   wheel.cancelAll( 7 );
+
+   // this thread is the reactor of the wheel
+   const uint64_t nUntil_us = now_us() + (nLast_ms + 20 * a_nResolution_ms) * 1000ULL;
+   while( now_us() < nUntil_us )
+   {
+      pollfd pfd = { wheel.fd(), POLLIN, 0 };
+      if( 1 == poll( &pfd, 1, 10 ) )
+      {
+         wheel.expire();
+      }
+   }
+
+   bool bPassed = (true == bCancelled) && (repeat.nFired == repeat.nStopAfter) && (0 == wheel.size());
+   for( const shot_t& shot : vecShots )
+   {
+      // never before the delay, a tick late is a wheel error, the rest is scheduling
+      const bool bOk = (true == shot.bExpected) ? ((1 == shot.nFired) && (shot.nLate_us >= 0) &&
+                                                   (shot.nLate_us < static_cast<int64_t>( a_nResolution_ms ) * 1500))
+                                                : (0 == shot.nFired);
+      cout << "wheel " << shot.pszName << ": delay " << shot.nDelay_ms << " ms, fired " << shot.nFired;
+      if( 0 != shot.nFired )
+      {
+         cout << ", late " << shot.nLate_us << " us";
+      }
+      cout << (true == bOk ? "" : "  FAILED") << endl;
+      bPassed = bPassed && (true == bOk);
+   }
+   cout << "wheel interval cancelled from its callback: fired " << repeat.nFired << " of " << repeat.nStopAfter
+        << ", cancel twice " << (true == bCancelled ? "true, false" : "FAILED") << ", left " << wheel.size()
+        << (true == bPassed ? "" : "  FAILED") << endl;
+   wheel.close();
+   return bPassed;
+}
+
+
+
+bool runReactor()
+{
+   const string         strPort = "5290";
+   network::ServerAsync server;
+   server_t             state;
+   state.pServer = &server;
+   server.setLocalSocketProperties( network::Sockets::getDefaultServerSocketFlags() );
+   if( false == server.open( network::sockType_t::SERVER, network::protocol_t::TCP, "localhost", strPort ) )
+   {
+      cout << "open failed, " << strerror( errno ) << endl;
+      return false;
+   }
+   if( false == server.startAsync( timers_serverSocketHandler, reinterpret_cast<void*>( &state ), timers_errorCallbackHandler ) )
+   {
+      cout << "start failed" << endl;
+      return false;
+   }
+   usleep( 100000 );
+   const bool bRefused = (0 == server.setTimer( -1, 10, 0, reactorHandler, &state )) && (EPERM == errno);
+
+   network::ClientAsync client;
+   client.setLocalSocketProperties( network::Sockets::getDefaultClientSocketFlags() );
+   if( false == client.connect( "localhost", strPort ) )
+   {
+      cout << "connect failed, " << strerror( errno ) << endl;
+      return false;
+   }
+   client.startAsync( timers_clientSocketHandler, nullptr, timers_errorCallbackHandler );
+   usleep( 350000 );
+   client.stop();
+   client.join();
+   usleep( 100000 );
+   const uint32_t nTicksClosed = state.nTicks;
+   usleep( 600000 );
+
+   // the interval ran about 3 times while open and stopped with the connection, the timer of the reactor did not
+   const bool bPassed = (true == bRefused) && (true == state.bArmed) && (nTicksClosed >= 2) && (nTicksClosed == state.nTicks) &&
+                        (0 == state.nLong) && (1 == state.nReactor);
+   cout << "reactor: setTimer off the reactor " << (true == bRefused ? "EPERM" : "accepted") << ", connection interval fired "
+        << nTicksClosed << " then " << state.nTicks - nTicksClosed << " after the close, one shot after the close fired " << state.nLong
+        << ", reactor timer fired " << state.nReactor << (true == bPassed ? "" : "  FAILED") << endl;
+   server.stop();
+   server.join();
+   return bPassed;
+}
+
+
+
+uint64_t now_us()
+{
+   return static_cast<uint64_t>( chrono::duration_cast<chrono::microseconds>( chrono::steady_clock::now().time_since_epoch() ).count() );
+}
+
+
+
+void shotHandler( const int32_t&, const uint64_t, void* const a_pData )
+{
+   shot_t& shot = *reinterpret_cast<shot_t*>(a_pData);
+   shot.nLate_us = static_cast<int64_t>( now_us() - shot.nAdded_us ) - static_cast<int64_t>( shot.nDelay_ms ) * 1000;
+   ++shot.nFired;
+}
+
+
+
+void repeatHandler( const int32_t&, const uint64_t a_nTimer, void* const a_pData )
+{
+   repeat_t& repeat = *reinterpret_cast<repeat_t*>(a_pData);
+   if( ++repeat.nFired == repeat.nStopAfter )
+   {
+      repeat.pWheel->cancel( a_nTimer );
+   }
+}
+
+
+
+void ticksHandler( const int32_t&, const uint64_t, void* const a_pData )
+{
+   ++reinterpret_cast<server_t*>(a_pData)->nTicks;
+}
+
+
+
+void longHandler( const int32_t&, const uint64_t, void* const a_pData )
+{
+   ++reinterpret_cast<server_t*>(a_pData)->nLong;
+}
+
+
+
+void reactorHandler( const int32_t&, const uint64_t, void* const a_pData )
+{
+   ++reinterpret_cast<server_t*>(a_pData)->nReactor;
+}
+
+
+
+void timers_serverSocketHandler( const network::socketfd_t& a_fd, const network::callBack_t& a_type, void* const a_pData )
+{
+   server_t& state = *reinterpret_cast<server_t*>(a_pData);
+   if( network::callBack_t::SESION_OPEN == a_type )
+   {
+      // on the reactor, the timers of the connection and one of the reactor due after the close
+      state.bArmed = (0 != state.pServer->setTimer( a_fd, 100, 100, ticksHandler, &state )) &&
+                     (0 != state.pServer->setTimer( a_fd, 700, 0, longHandler, &state )) &&
+                     (0 != state.pServer->setTimer( -1, 700, 0, reactorHandler, &state ));
+   }
+}
+
+
+
+void timers_clientSocketHandler( const network::socketfd_t&, const network::callBack_t&, void* const )
+{
+}
+
+
+
+void timers_errorCallbackHandler( const int32_t a_nerrno, const char* a_pszError, void* const )
+{
+   if( nullptr != a_pszError )
+   {
+      cerr << "socket: " << a_nerrno << ", " << a_pszError << endl;
+   }
+}
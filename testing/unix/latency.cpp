@@ -0,0 +1,182 @@
+#include "sockets.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <unistd.h>
+#include "string.h"
+
+using namespace std;
+using namespace gdlib;
+
+// ping-pong round trip latency of ServerAsync and ClientAsync over TCP loopback and over AF_UNIX (stream, seqpacket),
+// same classes, callbacks and framing, only the address differs.  the client sends the next message from its message
+// callback, the first 8 bytes carry the send time
+// latency [round trips] [message size] [spin us]
+
+struct ping_t
+{
+   network::ClientAsync*   pClient     = nullptr;
+   vector<uint64_t>        vecRtt_ns   = vector<uint64_t>();
+   vector<uint8_t>         vecMessage  = vector<uint8_t>();
+   size_t                  nTrips      = 0;
+   atomic<bool>            bDone       = {false};
+};
+
+void latency_serverMessageHandler  ( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData );
+void latency_clientMessageHandler  ( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData );
+void latency_socketCallbackHandler ( const network::socketfd_t& a_fd, const network::callBack_t& a_type, void* const a_pData );
+void latency_errorCallbackHandler  ( const int32_t a_nerrno, const char* a_pszError, void* const a_pData );
+uint64_t runTransport( const char* a_pszName, const network::protocol_t a_protocol, const string& a_strHost, const string& a_strPort, const size_t a_nTrips, const size_t a_nSize, const uint32_t a_nSpin_us );
+void sendPing( ping_t& a_ping );
+
+
+int main( int argc, char** argv )
+{
+   const size_t   nTrips   = (argc > 1) ? static_cast<size_t>( atoi( argv[1] ) ) : 50000;
+   const size_t   nSize    = (argc > 2) ? max( static_cast<size_t>( atoi( argv[2] ) ), sizeof( uint64_t ) ) : 64;
+   const uint32_t nSpin_us = (argc > 3) ? static_cast<uint32_t>( atoi( argv[3] ) ) : 0;
+
+   cout << "round trips:" << nTrips << ", message size:" << nSize << ", spin us:" << nSpin_us << endl;
+
+   const string   strPath    = "/tmp/gsock-latency-" + to_string( getpid() ) + ".sock";
+   const uint64_t nTcp       = runTransport( "tcp loopback",     network::protocol_t::TCP,       "localhost",              "5240", nTrips, nSize, nSpin_us );
+   const uint64_t nStream    = runTransport( "unix stream",      network::protocol_t::TCP,       strPath,                  "",     nTrips, nSize, nSpin_us );
+   const uint64_t nAbstract  = runTransport( "unix abstract",    network::protocol_t::TCP,       "@gsock-latency",         "",     nTrips, nSize, nSpin_us );
+   const uint64_t nSeqPacket = runTransport( "unix seqpacket",   network::protocol_t::SEQPACKET, "@gsock-latency-seq",     "",     nTrips, nSize, nSpin_us );
+   if( 0 != nTcp )
+   {
+      for( const auto& result : { make_pair( "unix stream", nStream ), make_pair( "unix abstract", nAbstract ), make_pair( "unix seqpacket", nSeqPacket ) } )
+      {
+         if( 0 != result.second )
+         {
+            cout << result.first << "/tcp loopback p50: " << static_cast<double>( result.second ) / static_cast<double>( nTcp ) << endl;
+         }
+      }
+   }
+   return 0;
+}
+
+
+
+uint64_t runTransport( const char* a_pszName, const network::protocol_t a_protocol, const string& a_strHost, const string& a_strPort, const size_t a_nTrips, const size_t a_nSize, const uint32_t a_nSpin_us )
+{
+   network::ServerAsync server;
+   server.setLocalSocketProperties( network::Sockets::getDefaultServerSocketFlags() );
+   if( false == server.open( network::sockType_t::SERVER, a_protocol, a_strHost, a_strPort ) )
+   {
+      cout << a_pszName << ": open failed, " << strerror( errno ) << endl;
+      return 0;
+   }
+   const bool bTcp = (false == network::Resolver::isUnixPath( a_strHost ));
+   if( true == bTcp )
+   {
+      server.setNoDelay();   // no Nagle on AF_UNIX
+   }
+   server.setMessageCallback( latency_serverMessageHandler );
+   server.setFraming( network::framing_t::FIXED, static_cast<uint32_t>( a_nSize ) );
+   server.setBusyPoll( a_nSpin_us );
+   if( false == server.startAsync( latency_socketCallbackHandler, reinterpret_cast<void*>( &server ), latency_errorCallbackHandler ) )
+   {
+      cout << a_pszName << ": start failed" << endl;
+      return 0;
+   }
+   usleep( 100000 );
+
+   network::ClientAsync client;
+   ping_t ping;
+   ping.pClient = &client;
+   ping.nTrips  = a_nTrips;
+   ping.vecRtt_ns.reserve( a_nTrips );
+   ping.vecMessage.resize( a_nSize, 'x' );
+   client.setLocalSocketProperties( network::Sockets::getDefaultClientSocketFlags() );
+   if( false == client.connect( a_strHost, a_strPort, a_protocol ) )
+   {
+      cout << a_pszName << ": connect failed, " << strerror( errno ) << endl;
+      server.stop();
+      server.join();
+      return 0;
+   }
+   if( true == bTcp )
+   {
+      client.setNoDelay();
+   }
+   client.setMessageCallback( latency_clientMessageHandler );
+   client.setFraming( network::framing_t::FIXED, static_cast<uint32_t>( a_nSize ) );
+   client.setBusyPoll( a_nSpin_us );
+   client.startAsync( latency_socketCallbackHandler, reinterpret_cast<void*>( &ping ), latency_errorCallbackHandler );
+   usleep( 100000 );
+
+   sendPing( ping );
+   while( false == ping.bDone )
+   {
+      usleep( 10000 );
+   }
+   client.stop();
+   client.join();
+   server.stop();
+   server.join();
+
+   vector<uint64_t>& vecRtt = ping.vecRtt_ns;
+   sort( vecRtt.begin(), vecRtt.end() );
+   uint64_t nTotal_ns = 0;
+   for( const uint64_t nRtt_ns : vecRtt )
+   {
+      nTotal_ns += nRtt_ns;
+   }
+   cout << a_pszName << ": rtt us p50 " << vecRtt[vecRtt.size() / 2] / 1000.0 << ", p99 " << vecRtt[vecRtt.size() * 99 / 100] / 1000.0
+        << ", p99.9 " << vecRtt[vecRtt.size() * 999 / 1000] / 1000.0 << ", max " << vecRtt.back() / 1000.0
+        << ", round trips/s " << static_cast<uint64_t>( 1e9 * static_cast<double>( vecRtt.size() ) / static_cast<double>( nTotal_ns ) ) << endl;
+   return vecRtt[vecRtt.size() / 2];
+}
+
+
+
+void sendPing( ping_t& a_ping )
+{
+   const uint64_t nStamp = network::BusyPoll::now_ns();
+   memcpy( a_ping.vecMessage.data(), &nStamp, sizeof( nStamp ) );
+   a_ping.pClient->send( a_ping.vecMessage.data(), static_cast<ssize_t>( a_ping.vecMessage.size() ) );
+}
+
+
+
+void latency_serverMessageHandler( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData )
+{
+   network::ServerAsync* pServer = reinterpret_cast<network::ServerAsync*>(a_pData);
+   pServer->send( a_fd, a_pMessage, static_cast<ssize_t>( a_nLength ) );
+}
+
+
+
+void latency_clientMessageHandler( const network::socketfd_t&, const uint8_t* a_pMessage, const size_t, void* const a_pData )
+{
+   ping_t& ping = *reinterpret_cast<ping_t*>(a_pData);
+   uint64_t nStamp;
+   memcpy( &nStamp, a_pMessage, sizeof( nStamp ) );
+   ping.vecRtt_ns.push_back( network::BusyPoll::now_ns() - nStamp );
+   if( ping.vecRtt_ns.size() < ping.nTrips )
+   {
+      sendPing( ping );
+   } else
+   {
+      ping.bDone = true;
+   }
+}
+
+
+
+void latency_socketCallbackHandler( const network::socketfd_t&, const network::callBack_t&, void* const )
+{
+}
+
+
+
+void latency_errorCallbackHandler( const int32_t a_nerrno, const char* a_pszError, void* const )
+{
+   if( nullptr != a_pszError )
+   {
+      cerr << "socket: " << a_nerrno << ", " << a_pszError << endl;
+   }
+}
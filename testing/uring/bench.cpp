@@ -0,0 +1,152 @@
+#include "sockets.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+#include "string.h"
+
+using namespace std;
+using namespace gdlib;
+
+// echo benchmark, same ServerAsync setup on the EPOLL and the IO_URING engine
+// bench [connections] [round trips per connection] [message size] [messages per round trip]
+
+void bench_messageCallbackHandler      ( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData );
+void bench_socketCallbackHandler       ( const network::socketfd_t& a_fd, const network::callBack_t& a_type, void* const a_pData );
+void bench_socketErrorCallbackHandler  ( const int32_t a_nerrno, const char* a_pszError, void* const a_pData );
+bool runClient( const string& a_strPort, const int32_t a_nRoundTrips, const int32_t a_nMessageSize, const int32_t a_nDepth );
+double runEngine( const network::engine_t a_engine, const string& a_strPort, const int32_t a_nConnections, const int32_t a_nRoundTrips, const int32_t a_nMessageSize, const int32_t a_nDepth );
+
+
+int main( int argc, char** argv )
+{
+   const int32_t nConnections  = (argc > 1) ? atoi( argv[1] ) : 16;
+   const int32_t nRoundTrips   = (argc > 2) ? atoi( argv[2] ) : 5000;
+   const int32_t nMessageSize  = (argc > 3) ? atoi( argv[3] ) : 64;
+   const int32_t nDepth        = (argc > 4) ? atoi( argv[4] ) : 8;
+
+   cout << "connections:" << nConnections << ", round trips:" << nRoundTrips << ", message size:" << nMessageSize << ", messages per round trip:" << nDepth << endl;
+
+   const double dEpoll = runEngine( network::engine_t::EPOLL,    "5210", nConnections, nRoundTrips, nMessageSize, nDepth );
+   const double dURing = runEngine( network::engine_t::IO_URING, "5211", nConnections, nRoundTrips, nMessageSize, nDepth );
+   if( (dEpoll > 0) && (dURing > 0) )
+   {
+      cout << "io_uring/epoll: " << dURing / dEpoll << endl;
+   }
+   return 0;
+}
+
+
+
+double runEngine( const network::engine_t a_engine, const string& a_strPort, const int32_t a_nConnections, const int32_t a_nRoundTrips, const int32_t a_nMessageSize, const int32_t a_nDepth )
+{
+   network::ServerAsync server( a_engine );
+   const char* pszEngine = (network::engine_t::IO_URING == a_engine) ? "io_uring" : "epoll";
+   if( a_engine != server.getEngine() )
+   {
+      cout << pszEngine << ": not supported by the kernel, skipped" << endl;
+      return 0;
+   }
+
+   server.setLocalSocketProperties( network::Sockets::getDefaultServerSocketFlags() );
+   server.setListenerBacklog( a_nConnections );
+   if( false == server.open( network::sockType_t::SERVER, network::protocol_t::TCP, "localhost", a_strPort ) )
+   {
+      cout << pszEngine << ": open failed" << endl;
+      return 0;
+   }
+   server.setNoDelay();
+   server.setEpollWaitTimeout( 100 );
+   server.setMessageCallback( bench_messageCallbackHandler );
+   server.setFraming( network::framing_t::FIXED, static_cast<uint32_t>( a_nMessageSize ) );
+   if( false == server.startAsync( bench_socketCallbackHandler, reinterpret_cast<void*>( &server ), bench_socketErrorCallbackHandler ) )
+   {
+      cout << pszEngine << ": start failed" << endl;
+      return 0;
+   }
+   usleep( 100000 );
+
+   auto start = chrono::steady_clock::now();
+   vector<thread> vecClients;
+   for( int32_t nIndex=0; nIndex<a_nConnections; ++nIndex )
+   {
+      vecClients.emplace_back( runClient, a_strPort, a_nRoundTrips, a_nMessageSize, a_nDepth );
+   }
+   for( auto& thd : vecClients )
+   {
+      thd.join();
+   }
+   const double dSeconds = chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+
+   server.stop();
+   server.join();
+
+   const double dMessages = static_cast<double>( a_nConnections ) * a_nRoundTrips * a_nDepth;
+   cout << pszEngine << ": " << dSeconds << " s, " << static_cast<int64_t>( dMessages / dSeconds ) << " msg/s" << endl;
+   return dMessages / dSeconds;
+}
+
+
+
+bool runClient( const string& a_strPort, const int32_t a_nRoundTrips, const int32_t a_nMessageSize, const int32_t a_nDepth )
+{
+   network::Client client;
+   client.setLocalSocketProperties( network::Sockets::getDefaultClientSocketFlags() );
+   if( false == client.connect( "localhost", a_strPort ) )
+   {
+      cerr << "connect failed" << endl;
+      return false;
+   }
+   client.setNoDelay();
+
+   const size_t   nBatch = static_cast<size_t>( a_nMessageSize ) * static_cast<size_t>( a_nDepth );
+   vector<uint8_t> vecSend( nBatch, 'x' );
+   vector<uint8_t> vecReceive( nBatch );
+   for( int32_t nTrip=0; nTrip<a_nRoundTrips; ++nTrip )
+   {
+      if( static_cast<ssize_t>( nBatch ) != client.send( vecSend.data(), static_cast<ssize_t>( nBatch ) ) )
+      {
+         cerr << "send failed" << endl;
+         return false;
+      }
+      size_t nReceived = 0;
+      while( nReceived < nBatch )
+      {
+         ssize_t nBytes = client.receive( vecReceive.data() + nReceived, static_cast<ssize_t>( nBatch - nReceived ) );
+         if( nBytes <= 0 )
+         {
+            cerr << "receive failed" << endl;
+            return false;
+         }
+         nReceived += static_cast<size_t>( nBytes );
+      }
+   }
+   client.close();
+   return true;
+}
+
+
+
+void bench_messageCallbackHandler( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData )
+{
+   network::ServerAsync* pServer = reinterpret_cast<network::ServerAsync*>(a_pData);
+   pServer->send( a_fd, a_pMessage, static_cast<ssize_t>( a_nLength ) );
+}
+
+
+
+void bench_socketCallbackHandler( const network::socketfd_t&, const network::callBack_t&, void* const )
+{
+}
+
+
+
+void bench_socketErrorCallbackHandler( const int32_t a_nerrno, const char* a_pszError, void* const )
+{
+   if( nullptr != a_pszError )
+   {
+      cerr << "socket: " << a_nerrno << ", " << a_pszError << endl;
+   }
+}
@@ -0,0 +1,174 @@
+#include "sockets.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <unistd.h>
+#include "string.h"
+
+using namespace std;
+using namespace gdlib;
+
+// messages of several clients handed to the worker pool of ServerAsync.  each message carries the sequence number of
+// its client, a worker checks that the messages of a connection arrive in order.  run once without a queue limit, every
+// message must be processed, and once with a small limit and a slow callback, the messages the pool refuses must be
+// reported to the error callback and counted in the metrics and the worker stats, processed + dropped = sent
+// dispatch [clients] [messages per client] [workers]
+
+struct server_t
+{
+   vector<uint64_t>        vecLast        = vector<uint64_t>( 65536, 0 );   // by fd, last sequence seen, one worker per fd
+   atomic<uint64_t>        nProcessed     = {0};
+   atomic<uint64_t>        nOutOfOrder    = {0};
+   atomic<uint64_t>        nReported      = {0};     // error callback, dispatch drops
+   uint32_t                nWork_us       = 0;       // time the callback takes
+};
+
+void dispatch_serverMessageHandler  ( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData );
+void dispatch_socketCallbackHandler ( const network::socketfd_t& a_fd, const network::callBack_t& a_type, void* const a_pData );
+void dispatch_errorCallbackHandler  ( const int32_t a_nerrno, const char* a_pszError, void* const a_pData );
+bool runCase( const char* a_pszCase, const string& a_strPort, const size_t a_nClients, const uint64_t a_nMessages, const uint32_t a_nWorkers, const uint64_t a_nLimit, const uint32_t a_nWork_us );
+
+
+int main( int argc, char** argv )
+{
+   const size_t   nClients  = (argc > 1) ? static_cast<size_t>( atoi( argv[1] ) ) : 8;
+   const uint64_t nMessages = (argc > 2) ? static_cast<uint64_t>( atoi( argv[2] ) ) : 20000;
+   const uint32_t nWorkers  = (argc > 3) ? static_cast<uint32_t>( atoi( argv[3] ) ) : 4;
+
+   cout << "clients:" << nClients << ", messages per client:" << nMessages << ", workers:" << nWorkers << endl;
+   const bool bUnlimited = runCase( "no limit",            "5250", nClients, nMessages, nWorkers, 0,  0 );
+   const bool bLimited   = runCase( "limit 32, slow work", "5251", nClients, nMessages, nWorkers, 32, 20 );
+   cout << ((true == bUnlimited) && (true == bLimited) ? "passed" : "FAILED") << endl;
+   return ((true == bUnlimited) && (true == bLimited)) ? 0 : 1;
+}
+
+
+
+bool runCase( const char* a_pszCase, const string& a_strPort, const size_t a_nClients, const uint64_t a_nMessages, const uint32_t a_nWorkers, const uint64_t a_nLimit, const uint32_t a_nWork_us )
+{
+   network::ServerAsync server;
+   server_t             state;
+   state.nWork_us = a_nWork_us;
+   server.setLocalSocketProperties( network::Sockets::getDefaultServerSocketFlags() );
+   if( false == server.open( network::sockType_t::SERVER, network::protocol_t::TCP, "localhost", a_strPort ) )
+   {
+      cout << a_pszCase << ": open failed, " << strerror( errno ) << endl;
+      return false;
+   }
+   server.setMessageCallback( dispatch_serverMessageHandler );
+   server.setFraming( network::framing_t::FIXED, sizeof( uint64_t ) );
+   server.setWorkerCount( a_nWorkers );
+   server.setWorkerQueueLimit( a_nLimit );
+   if( false == server.startAsync( dispatch_socketCallbackHandler, reinterpret_cast<void*>( &state ), dispatch_errorCallbackHandler ) )
+   {
+      cout << a_pszCase << ": start failed" << endl;
+      return false;
+   }
+   usleep( 100000 );
+
+   vector<network::ClientAsync> vecClients( a_nClients );
+   for( network::ClientAsync& client : vecClients )
+   {
+      client.setLocalSocketProperties( network::Sockets::getDefaultClientSocketFlags() );
+      if( false == client.connect( "localhost", a_strPort ) )
+      {
+         cout << a_pszCase << ": connect failed, " << strerror( errno ) << endl;
+         return false;
+      }
+      client.startAsync( dispatch_socketCallbackHandler, nullptr, dispatch_errorCallbackHandler );
+   }
+   usleep( 100000 );
+
+   // the clients interleaved, so every worker has queues filling at once
+   for( uint64_t nSequence=1; nSequence<=a_nMessages; ++nSequence )
+   {
+      for( network::ClientAsync& client : vecClients )
+      {
+         client.send( &nSequence, sizeof( nSequence ) );
+      }
+   }
+
+   const uint64_t nSent = a_nClients * a_nMessages;
+   uint64_t       nDropped = 0;
+   for( uint32_t nWait=0; nWait<3000; ++nWait )
+   {
+      nDropped = server.getMetrics().nDispatchDrops;
+      if( state.nProcessed + nDropped >= nSent )
+      {
+         break;
+      }
+      usleep( 10000 );
+   }
+   usleep( 100000 );
+
+   nDropped = server.getMetrics().nDispatchDrops;    // the reactors and their metrics go with stop
+   uint64_t nStatsDropped = 0;
+   uint64_t nHighWater    = 0;
+   for( uint32_t nWorker=0; nWorker<server.getWorkerPool().size(); ++nWorker )
+   {
+      const network::workerStats_t stats = server.getWorkerPool().stats( nWorker );
+      nStatsDropped += stats.nDropped;
+      nHighWater     = max( nHighWater, stats.nHighWater );
+   }
+   for( network::ClientAsync& client : vecClients )
+   {
+      client.stop();
+      client.join();
+   }
+   server.stop();
+   server.join();
+
+   const bool bPassed = (state.nProcessed + nDropped == nSent) && (0 == state.nOutOfOrder) && (nStatsDropped == nDropped) &&
+                        (state.nReported == nDropped) && ((0 == a_nLimit) ? (0 == nDropped) : (nHighWater <= a_nLimit));
+   cout << a_pszCase << ": sent " << nSent << ", processed " << state.nProcessed << ", dropped " << nDropped
+        << " (reported " << state.nReported << ", worker stats " << nStatsDropped << "), out of order " << state.nOutOfOrder
+        << ", queue high water " << nHighWater << (true == bPassed ? "" : "  FAILED") << endl;
+   return bPassed;
+}
+
+
+
+void dispatch_serverMessageHandler( const network::socketfd_t& a_fd, const uint8_t* a_pMessage, const size_t, void* const a_pData )
+{
+   server_t& state = *reinterpret_cast<server_t*>(a_pData);
+   uint64_t  nSequence;
+   memcpy( &nSequence, a_pMessage, sizeof( nSequence ) );
+   // drops leave gaps, never a step back
+   uint64_t& nLast = state.vecLast[static_cast<size_t>( a_fd ) % state.vecLast.size()];
+   if( nSequence <= nLast )
+   {
+      ++state.nOutOfOrder;
+   }
+   nLast = nSequence;
+   if( 0 != state.nWork_us )
+   {
+      const uint64_t nUntil_ns = network::BusyPoll::now_ns() + state.nWork_us * 1000ULL;
+      while( network::BusyPoll::now_ns() < nUntil_ns )
+      {
+      }
+   }
+   ++state.nProcessed;
+}
+
+
+
+void dispatch_socketCallbackHandler( const network::socketfd_t&, const network::callBack_t&, void* const )
+{
+}
+
+
+
+void dispatch_errorCallbackHandler( const int32_t a_nerrno, const char* a_pszError, void* const a_pData )
+{
+   if( (EAGAIN == a_nerrno) && (nullptr != a_pData) )
+   {
+      ++reinterpret_cast<server_t*>(a_pData)->nReported;
+      return;
+   }
+   if( nullptr != a_pszError )
+   {
+      cerr << "socket: " << a_nerrno << ", " << a_pszError << endl;
+   }
+}
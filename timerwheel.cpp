@@ -0,0 +1,506 @@
+#include "timerwheel.h"
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+
+using namespace std;
+using namespace gdlib;
+
+
+
+/**
+ * @brief ...CLOCK_MONOTONIC in ns
+ *
+ * @return uint64_t
+ */
+static uint64_t monotonic_ns()
+{
+   struct timespec ts;
+   clock_gettime( CLOCK_MONOTONIC, &ts );
+   return static_cast<uint64_t>( ts.tv_sec ) * 1000000000 + static_cast<uint64_t>( ts.tv_nsec );
+}
+
+
+
+/**
+ * @brief ...
+ *
+ */
+network::TimerWheel::TimerWheel()
+{
+   for( uint32_t nIndex=0; nIndex<s_nLevels * s_nSlots; ++nIndex )
+   {
+      m_anSlots[nIndex] = s_nNone;
+   }
+   for( uint32_t nLevel=0; nLevel<s_nLevels; ++nLevel )
+   {
+      m_anLevelCount[nLevel] = 0;
+   }
+}
+
+
+
+/**
+ * @brief ...
+ *
+ */
+network::TimerWheel::~TimerWheel()
+{
+   close();
+}
+
+
+
+/**
+ * @brief ...create the timerfd and start the clock, the reactor adds fd() to its epoll set
+ *
+ * @param a_nOwner ...1..255, put in the ids so a timer is only cancelled on the wheel that set it
+ * @param a_nResolution_ms ...ms per tick
+ * @return bool
+ */
+bool network::TimerWheel::open( const uint32_t a_nOwner, const uint32_t a_nResolution_ms )
+{
+   if( -1 != m_fdTimer )
+   {
+      return true;
+   }
+   m_fdTimer = timerfd_create( CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC );
+   if( -1 == m_fdTimer )
+   {
+      return false;
+   }
+   m_nOwner          = a_nOwner & 0xFF;
+   m_nResolution_ms  = (a_nResolution_ms > 0) ? a_nResolution_ms : 1;
+   m_nStart_ns       = monotonic_ns();
+   m_nNow            = 0;
+   m_nArmed          = 0;
+   return true;
+}
+
+
+
+/**
+ * @brief ...drop all timers and close the timerfd
+ *
+ */
+void network::TimerWheel::close()
+{
+   if( -1 != m_fdTimer )
+   {
+      ::close( m_fdTimer );
+      m_fdTimer = -1;
+   }
+   m_vecTimers.clear();
+   m_vecFdTimers.clear();
+   for( uint32_t nIndex=0; nIndex<s_nLevels * s_nSlots; ++nIndex )
+   {
+      m_anSlots[nIndex] = s_nNone;
+   }
+   for( uint32_t nLevel=0; nLevel<s_nLevels; ++nLevel )
+   {
+      m_anLevelCount[nLevel] = 0;
+   }
+   m_nFree   = s_nNone;
+   m_nActive = 0;
+}
+
+
+
+/**
+ * @brief ...start a timer
+ *
+ * @param a_fd ...connection the timer belongs to, dropped by cancelAll( a_fd ).  -1 for a reactor timer
+ * @param a_nDelay_ms ...first expiry, never before it has passed, rounded up to the next tick and at least one tick
+ * @param a_nInterval_ms ...repeat every a_nInterval_ms after the first expiry, 0 one shot
+ * @param a_cbTimer ...called on expiry
+ * @param a_pData ...pointer to pass back to the callback
+ * @return uint64_t timer id, 0 on error (errno EBADF if the wheel is not open, EINVAL)
+ */
+uint64_t network::TimerWheel::add( const int32_t a_fd, const uint32_t a_nDelay_ms, const uint32_t a_nInterval_ms, const timerCallback_t a_cbTimer, void* const a_pData )
+{
+   if( -1 == m_fdTimer )
+   {
+      errno = EBADF;
+      return 0;
+   }
+   if( nullptr == a_cbTimer )
+   {
+      errno = EINVAL;
+      return 0;
+   }
+
+   uint32_t nIndex = m_nFree;
+   if( s_nNone != nIndex )
+   {
+      m_nFree = m_vecTimers[nIndex].nNext;
+   } else
+   {
+      nIndex = static_cast<uint32_t>( m_vecTimers.size() );
+      m_vecTimers.emplace_back();
+   }
+   entry_t& timer = m_vecTimers[nIndex];
+   // the first tick that starts a_nDelay_ms after now or later, never early however far into its tick now is
+   const uint64_t nResolution_ns = static_cast<uint64_t>( m_nResolution_ms ) * 1000000;
+   const uint64_t nDelay_ns      = (0 != a_nDelay_ms) ? static_cast<uint64_t>( a_nDelay_ms ) * 1000000 : nResolution_ns;
+   timer.nExpiry   = (monotonic_ns() - m_nStart_ns + nDelay_ns + nResolution_ns - 1) / nResolution_ns;
+   timer.nInterval = (a_nInterval_ms + m_nResolution_ms - 1) / m_nResolution_ms;
+   if( (a_nInterval_ms > 0) && (0 == timer.nInterval) )
+   {
+      timer.nInterval = 1;
+   }
+   timer.fd        = a_fd;
+   timer.cbTimer   = a_cbTimer;
+   timer.pData     = a_pData;
+   timer.nFdPrev   = s_nNone;
+   timer.nFdNext   = s_nNone;
+   if( a_fd >= 0 )
+   {
+      if( static_cast<size_t>( a_fd ) >= m_vecFdTimers.size() )
+      {
+         m_vecFdTimers.resize( static_cast<size_t>( a_fd ) + 1, s_nNone );
+      }
+      uint32_t& nFirst = m_vecFdTimers[static_cast<size_t>( a_fd )];
+      timer.nFdNext = nFirst;
+      if( s_nNone != nFirst )
+      {
+         m_vecTimers[nFirst].nFdPrev = nIndex;
+      }
+      nFirst = nIndex;
+   }
+   ++m_nActive;
+   insert_( nIndex );
+   arm_();
+   return id_( nIndex );
+}
+
+
+
+/**
+ * @brief ...stop a timer, can be called from its own callback
+ *
+ * @param a_nTimer ...id from add
+ * @return bool false if not a running timer of this wheel
+ */
+bool network::TimerWheel::cancel( const uint64_t a_nTimer )
+{
+   const uint32_t nIndex = index_( a_nTimer );
+   if( s_nNone == nIndex )
+   {
+      return false;
+   }
+   unlink_( nIndex );
+   release_( nIndex );
+   return true;
+}
+
+
+
+/**
+ * @brief ...stop the timers of a fd, called when the connection closes
+ *
+ * @param a_fd ...
+ */
+void network::TimerWheel::cancelAll( const int32_t a_fd )
+{
+   if( (a_fd < 0) || (static_cast<size_t>( a_fd ) >= m_vecFdTimers.size()) )
+   {
+      return;
+   }
+   uint32_t nIndex;
+   while( s_nNone != (nIndex = m_vecFdTimers[static_cast<size_t>( a_fd )]) )
+   {
+      unlink_( nIndex );
+      release_( nIndex );
+   }
+}
+
+
+
+/**
+ * @brief ...the timerfd is readable, move the wheel to now and call back the expired timers in expiry order.  a repeating
+ * timer late by more than its interval fires once, not once per missed interval
+ *
+ * @return uint32_t timers fired
+ */
+uint32_t network::TimerWheel::expire()
+{
+   uint64_t nExpirations;
+   while( (-1 == ::read( m_fdTimer, &nExpirations, sizeof( nExpirations ) )) && (EINTR == errno) )
+   {
+   }
+   m_nArmed = 0;
+
+   const uint64_t nTarget = tick_();
+   uint32_t       nFired  = 0;
+   while( m_nNow < nTarget )
+   {
+      if( 0 == m_nActive )
+      {
+         m_nNow = nTarget;
+         break;
+      }
+      if( 0 == m_anLevelCount[0] )
+      {
+         // nothing due before the next wrap of level 0
+         const uint64_t nLast = m_nNow | (s_nSlots - 1);
+         m_nNow = (nLast < nTarget) ? nLast : nTarget;
+         if( m_nNow == nTarget )
+         {
+            break;
+         }
+      }
+
+      ++m_nNow;
+      for( uint32_t nLevel=s_nLevels-1; nLevel>0; --nLevel )
+      {
+         if( 0 == (m_nNow & ((static_cast<uint64_t>( 1 ) << (s_nSlotBits * nLevel)) - 1)) )
+         {
+            cascade_( nLevel );
+         }
+      }
+
+      uint32_t& nHead = m_anSlots[m_nNow & (s_nSlots - 1)];
+      while( s_nNone != nHead )
+      {
+         const uint32_t  nIndex  = nHead;
+         entry_t&        timer   = m_vecTimers[nIndex];
+         const uint64_t  nTimer  = id_( nIndex );
+         const int32_t   fd      = timer.fd;
+         timerCallback_t cbTimer = timer.cbTimer;
+         void*           pData   = timer.pData;
+         unlink_( nIndex );
+         if( 0 != timer.nInterval )
+         {
+            timer.nExpiry = nTarget + timer.nInterval;
+            insert_( nIndex );
+         } else
+         {
+            release_( nIndex );
+         }
+         ++nFired;
+         cbTimer( fd, nTimer, pData );   // may add or cancel timers
+      }
+   }
+   arm_();
+   return nFired;
+}
+
+
+
+/**
+ * @brief ...ticks since open
+ *
+ * @return uint64_t
+ */
+uint64_t network::TimerWheel::tick_() const
+{
+   return (monotonic_ns() - m_nStart_ns) / (static_cast<uint64_t>( m_nResolution_ms ) * 1000000);
+}
+
+
+
+/**
+ * @brief ...put a timer in the slot of its expiry, the level is picked by how far away it is
+ *
+ * @param a_nIndex ...
+ */
+void network::TimerWheel::insert_( const uint32_t a_nIndex )
+{
+   static constexpr uint64_t s_nMaxDelta = (static_cast<uint64_t>( 1 ) << (s_nSlotBits * s_nLevels)) - 1;
+   entry_t& timer = m_vecTimers[a_nIndex];
+   if( timer.nExpiry < m_nNow )
+   {
+      // due now only when cascaded, its slot of level 0 is called back next.  add is always a tick ahead of m_nNow
+      timer.nExpiry = m_nNow;
+   } else if( timer.nExpiry - m_nNow > s_nMaxDelta )
+   {
+      timer.nExpiry = m_nNow + s_nMaxDelta;
+   }
+
+   const uint64_t nDelta = timer.nExpiry - m_nNow;
+   uint32_t       nLevel = 0;
+   while( (nLevel < s_nLevels - 1) && (nDelta >= (static_cast<uint64_t>( 1 ) << (s_nSlotBits * (nLevel + 1)))) )
+   {
+      ++nLevel;
+   }
+   const uint32_t nSlot = nLevel * s_nSlots + static_cast<uint32_t>( (timer.nExpiry >> (s_nSlotBits * nLevel)) & (s_nSlots - 1) );
+   timer.nSlot = nSlot;
+   timer.nPrev = s_nNone;
+   timer.nNext = m_anSlots[nSlot];
+   if( s_nNone != timer.nNext )
+   {
+      m_vecTimers[timer.nNext].nPrev = a_nIndex;
+   }
+   m_anSlots[nSlot] = a_nIndex;
+   ++m_anLevelCount[nLevel];
+}
+
+
+
+/**
+ * @brief ...take a timer out of its slot
+ *
+ * @param a_nIndex ...
+ */
+void network::TimerWheel::unlink_( const uint32_t a_nIndex )
+{
+   entry_t& timer = m_vecTimers[a_nIndex];
+   if( s_nNone == timer.nSlot )
+   {
+      return;
+   }
+   if( s_nNone != timer.nPrev )
+   {
+      m_vecTimers[timer.nPrev].nNext = timer.nNext;
+   } else
+   {
+      m_anSlots[timer.nSlot] = timer.nNext;
+   }
+   if( s_nNone != timer.nNext )
+   {
+      m_vecTimers[timer.nNext].nPrev = timer.nPrev;
+   }
+   --m_anLevelCount[timer.nSlot / s_nSlots];
+   timer.nSlot = s_nNone;
+   timer.nPrev = s_nNone;
+   timer.nNext = s_nNone;
+}
+
+
+
+/**
+ * @brief ...unlinked timer back to the free list, its id becomes stale
+ *
+ * @param a_nIndex ...
+ */
+void network::TimerWheel::release_( const uint32_t a_nIndex )
+{
+   entry_t& timer = m_vecTimers[a_nIndex];
+   if( timer.fd >= 0 )
+   {
+      if( s_nNone != timer.nFdPrev )
+      {
+         m_vecTimers[timer.nFdPrev].nFdNext = timer.nFdNext;
+      } else
+      {
+         m_vecFdTimers[static_cast<size_t>( timer.fd )] = timer.nFdNext;
+      }
+      if( s_nNone != timer.nFdNext )
+      {
+         m_vecTimers[timer.nFdNext].nFdPrev = timer.nFdPrev;
+      }
+   }
+   ++timer.nGeneration;
+   timer.fd      = -1;
+   timer.cbTimer = nullptr;
+   timer.pData   = nullptr;
+   timer.nFdPrev = s_nNone;
+   timer.nFdNext = m_nFree;
+   timer.nNext   = m_nFree;
+   m_nFree       = a_nIndex;
+   --m_nActive;
+}
+
+
+
+/**
+ * @brief ...the level below wrapped, move the slot of this level that is due now one level down
+ *
+ * @param a_nLevel ...1..s_nLevels-1
+ */
+void network::TimerWheel::cascade_( const uint32_t a_nLevel )
+{
+   const uint32_t nSlot  = a_nLevel * s_nSlots + static_cast<uint32_t>( (m_nNow >> (s_nSlotBits * a_nLevel)) & (s_nSlots - 1) );
+   uint32_t       nIndex = m_anSlots[nSlot];
+   m_anSlots[nSlot] = s_nNone;
+   while( s_nNone != nIndex )
+   {
+      const uint32_t nNext = m_vecTimers[nIndex].nNext;
+      --m_anLevelCount[a_nLevel];
+      insert_( nIndex );
+      nIndex = nNext;
+   }
+}
+
+
+
+/**
+ * @brief ...arm the timerfd for the next non empty slot of level 0, or the next wrap when the timers are further away.
+ * no syscall when it is already armed as early
+ *
+ */
+void network::TimerWheel::arm_()
+{
+   struct itimerspec spec;
+   memset( &spec, 0, sizeof( spec ) );
+   if( 0 == m_nActive )
+   {
+      if( 0 != m_nArmed )
+      {
+         timerfd_settime( m_fdTimer, TFD_TIMER_ABSTIME, &spec, nullptr );
+         m_nArmed = 0;
+      }
+      return;
+   }
+
+   uint64_t nDelta = s_nSlots - (m_nNow & (s_nSlots - 1));    // next wrap
+   if( 0 != m_anLevelCount[0] )
+   {
+      for( uint64_t nStep=1; nStep<s_nSlots; ++nStep )
+      {
+         if( s_nNone != m_anSlots[(m_nNow + nStep) & (s_nSlots - 1)] )
+         {
+            if( (nStep < nDelta) || (m_nActive == m_anLevelCount[0]) )
+            {
+               nDelta = nStep;
+            }
+            break;
+         }
+      }
+   }
+   const uint64_t nWake = m_nNow + nDelta;
+   if( (0 != m_nArmed) && (m_nArmed <= nWake) )
+   {
+      return;
+   }
+   const uint64_t nWake_ns = m_nStart_ns + nWake * m_nResolution_ms * 1000000;
+   spec.it_value.tv_sec  = static_cast<time_t>( nWake_ns / 1000000000 );
+   spec.it_value.tv_nsec = static_cast<long>( nWake_ns % 1000000000 );
+   timerfd_settime( m_fdTimer, TFD_TIMER_ABSTIME, &spec, nullptr );
+   m_nArmed = nWake;
+}
+
+
+
+/**
+ * @brief ...owner | generation | index
+ *
+ * @param a_nIndex ...
+ * @return uint64_t
+ */
+uint64_t network::TimerWheel::id_( const uint32_t a_nIndex ) const
+{
+   return (static_cast<uint64_t>( m_nOwner ) << 56) | (static_cast<uint64_t>( m_vecTimers[a_nIndex].nGeneration & 0xFFFFFF ) << 32) | a_nIndex;
+}
+
+
+
+/**
+ * @brief ...index of a running timer from its id
+ *
+ * @param a_nTimer ...
+ * @return uint32_t s_nNone if the id is not a running timer of this wheel
+ */
+uint32_t network::TimerWheel::index_( const uint64_t a_nTimer ) const
+{
+   const uint32_t nIndex = static_cast<uint32_t>( a_nTimer & 0xFFFFFFFF );
+   if( (false == owns( a_nTimer )) || (nIndex >= m_vecTimers.size()) ||
+       ((m_vecTimers[nIndex].nGeneration & 0xFFFFFF) != ((a_nTimer >> 32) & 0xFFFFFF)) || (nullptr == m_vecTimers[nIndex].cbTimer) )
+   {
+      return s_nNone;
+   }
+   return nIndex;
+}
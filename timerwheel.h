@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gdlib {
+namespace network
+{
+   using timerCallback_t = void( * )( const int32_t& a_fd, const uint64_t a_nTimer, void* const a_pData );   // a_fd -1 for a reactor timer
+
+
+
+   /**
+    * @brief hierarchical timer wheel of one reactor, driven by a timerfd in the reactor's epoll set (or ring).  4 levels of
+    * 256 slots at a tick of a_nResolution_ms (open, default 1): level 0 holds the timers due in the next 256 ticks, each level
+    * above covers 256 times more and is moved down a level when the one below wraps.  add and cancel are O(1) (an
+    * intrusive list per slot, timers are stored by index and reused), a timer belongs to a fd or to the reactor (-1) and
+    * cancelAll drops the timers of a fd when it closes.  the timerfd is armed one shot for the next non empty slot of level
+    * 0, or the next wrap, so an idle wheel does not tick
+    *
+    * not thread safe, add/cancel/expire on the reactor thread only.  the longest delay is 2^32 ticks
+    */
+   class TimerWheel
+   {
+      private:
+         static constexpr uint32_t s_nLevels    = 4;
+         static constexpr uint32_t s_nSlotBits  = 8;
+         static constexpr uint32_t s_nSlots     = 1 << s_nSlotBits;
+         static constexpr uint32_t s_nNone      = UINT32_MAX;
+
+         struct entry_t
+         {
+            uint64_t          nExpiry     = 0;          // tick
+            uint32_t          nInterval   = 0;          // ticks, 0 one shot
+            uint32_t          nGeneration = 0;          // bumped when the entry is reused, stale ids do not match
+            uint32_t          nPrev       = s_nNone;    // slot list
+            uint32_t          nNext       = s_nNone;
+            uint32_t          nFdPrev     = s_nNone;    // timers of the same fd
+            uint32_t          nFdNext     = s_nNone;
+            uint32_t          nSlot       = s_nNone;    // level * s_nSlots + slot, s_nNone when not scheduled
+            int32_t           fd          = -1;
+            timerCallback_t   cbTimer     = nullptr;
+            void*             pData       = nullptr;
+         };
+
+         std::vector<entry_t>    m_vecTimers       = std::vector<entry_t>();
+         std::vector<uint32_t>   m_vecFdTimers     = std::vector<uint32_t>();    // first timer per fd
+         uint32_t                m_anSlots[s_nLevels * s_nSlots]   = {};    // first timer per slot
+         uint32_t                m_anLevelCount[s_nLevels]         = {};
+         uint32_t                m_nFree           = s_nNone;    // free entries, linked by nNext
+         uint32_t                m_nActive         = 0;
+         uint64_t                m_nNow            = 0;          // tick processed
+         uint64_t                m_nArmed          = 0;          // tick the timerfd is armed for, 0 disarmed
+         uint64_t                m_nStart_ns       = 0;          // CLOCK_MONOTONIC of tick 0
+         uint32_t                m_nResolution_ms  = 1;
+         uint32_t                m_nOwner          = 0;          // in the ids, tells the wheels of the reactors apart
+         int32_t                 m_fdTimer         = -1;
+
+         uint64_t tick_() const;
+         void     insert_( const uint32_t a_nIndex );
+         void     unlink_( const uint32_t a_nIndex );
+         void     release_( const uint32_t a_nIndex );
+         void     cascade_( const uint32_t a_nLevel );
+         void     arm_();
+         uint64_t id_( const uint32_t a_nIndex ) const;
+         uint32_t index_( const uint64_t a_nTimer ) const;
+
+      public:
+         TimerWheel();
+         TimerWheel( const TimerWheel& ) = delete;
+         ~TimerWheel();
+
+         TimerWheel& operator =( const TimerWheel& ) = delete;
+
+         bool     open( const uint32_t a_nOwner, const uint32_t a_nResolution_ms = 1 );
+         void     close();
+         int32_t  fd() const                             { return m_fdTimer; }
+         uint32_t size() const                           { return m_nActive; }
+         uint64_t add( const int32_t a_fd, const uint32_t a_nDelay_ms, const uint32_t a_nInterval_ms, const timerCallback_t a_cbTimer, void* const a_pData );
+         bool     cancel( const uint64_t a_nTimer );
+         void     cancelAll( const int32_t a_fd );
+         uint32_t expire();
+         bool     owns( const uint64_t a_nTimer ) const  { return (a_nTimer >> 56) == m_nOwner; }
+   };
+}
+}
@@ -0,0 +1,533 @@
+#include "uring.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <linux/io_uring.h>
+
+
+using namespace std;
+using namespace gdlib;
+
+
+
+/**
+ * @brief ...
+ *
+ */
+network::URing::~URing()
+{
+   release();
+}
+
+
+
+/**
+ * @brief ...create the ring and map the submission and completion queues
+ *
+ * @param a_nEntries ...submission queue size, the completion queue is 4 times larger so multishot completions do not overflow
+ * @return bool false if io_uring is not available
+ */
+bool network::URing::init( const uint32_t a_nEntries )
+{
+   struct io_uring_params params;
+   memset( &params, 0, sizeof( params ) );
+   params.flags      = IORING_SETUP_CQSIZE;
+   params.cq_entries = a_nEntries * 4;
+
+   m_fdRing = static_cast<int32_t>( syscall( __NR_io_uring_setup, a_nEntries, &params ) );
+   if( m_fdRing < 0 )
+   {
+      m_fdRing = -1;
+      return false;
+   }
+
+   m_nSqRingSize = params.sq_off.array + params.sq_entries * sizeof( uint32_t );
+   m_nCqRingSize = params.cq_off.cqes  + params.cq_entries * sizeof( struct io_uring_cqe );
+   if( params.features & IORING_FEAT_SINGLE_MMAP )
+   {
+      m_nSqRingSize = m_nCqRingSize = (m_nSqRingSize > m_nCqRingSize) ? m_nSqRingSize : m_nCqRingSize;
+   }
+
+   m_pSqRing = mmap( nullptr, m_nSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fdRing, IORING_OFF_SQ_RING );
+   if( MAP_FAILED == m_pSqRing )
+   {
+      m_pSqRing = nullptr;
+      release();
+      return false;
+   }
+   if( params.features & IORING_FEAT_SINGLE_MMAP )
+   {
+      m_pCqRing = m_pSqRing;
+   } else
+   {
+      m_pCqRing = mmap( nullptr, m_nCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fdRing, IORING_OFF_CQ_RING );
+      if( MAP_FAILED == m_pCqRing )
+      {
+         m_pCqRing = nullptr;
+         release();
+         return false;
+      }
+   }
+   m_nSqesSize = params.sq_entries * sizeof( struct io_uring_sqe );
+   void* pSqes = mmap( nullptr, m_nSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fdRing, IORING_OFF_SQES );
+   if( MAP_FAILED == pSqes )
+   {
+      release();
+      return false;
+   }
+   m_pSqes = reinterpret_cast<io_uring_sqe*>( pSqes );
+
+   uint8_t* pSq = reinterpret_cast<uint8_t*>( m_pSqRing );
+   uint8_t* pCq = reinterpret_cast<uint8_t*>( m_pCqRing );
+   m_pSqHead    = reinterpret_cast<uint32_t*>( pSq + params.sq_off.head );
+   m_pSqTail    = reinterpret_cast<uint32_t*>( pSq + params.sq_off.tail );
+   m_nSqMask    = *reinterpret_cast<uint32_t*>( pSq + params.sq_off.ring_mask );
+   m_nSqEntries = params.sq_entries;
+   m_pSqArray   = reinterpret_cast<uint32_t*>( pSq + params.sq_off.array );
+   m_pCqHead    = reinterpret_cast<uint32_t*>( pCq + params.cq_off.head );
+   m_pCqTail    = reinterpret_cast<uint32_t*>( pCq + params.cq_off.tail );
+   m_nCqMask    = *reinterpret_cast<uint32_t*>( pCq + params.cq_off.ring_mask );
+   m_pCqes      = reinterpret_cast<io_uring_cqe*>( pCq + params.cq_off.cqes );
+   m_nSqTail    = *m_pSqTail;
+   m_nToSubmit  = 0;
+   return true;
+}
+
+
+
+/**
+ * @brief ...unmap and close, pending requests are cancelled by the kernel
+ *
+ */
+void network::URing::release()
+{
+   if( nullptr != m_pSqes )
+   {
+      munmap( m_pSqes, m_nSqesSize );
+      m_pSqes = nullptr;
+   }
+   if( (nullptr != m_pCqRing) && (m_pCqRing != m_pSqRing) )
+   {
+      munmap( m_pCqRing, m_nCqRingSize );
+   }
+   m_pCqRing = nullptr;
+   if( nullptr != m_pSqRing )
+   {
+      munmap( m_pSqRing, m_nSqRingSize );
+      m_pSqRing = nullptr;
+   }
+   if( -1 != m_fdRing )
+   {
+      ::close( m_fdRing );
+      m_fdRing = -1;
+   }
+   if( nullptr != m_pBufRing )
+   {
+      munmap( m_pBufRing, m_nBufRingSize );
+      m_pBufRing = nullptr;
+   }
+   if( nullptr != m_pBuffers )
+   {
+      free( m_pBuffers );
+      m_pBuffers = nullptr;
+   }
+}
+
+
+
+/**
+ * @brief ...register a provided buffer ring, multishot recv picks a buffer from it for every completion
+ *
+ * @param a_nGroup ...buffer group id used in recv
+ * @param a_nCount ...number of buffers, power of 2
+ * @param a_nSize ...bytes per buffer
+ * @return bool
+ */
+bool network::URing::setupBuffers( const uint16_t a_nGroup, const uint32_t a_nCount, const uint32_t a_nSize )
+{
+   m_nBufRingSize = a_nCount * sizeof( struct io_uring_buf );
+   m_pBufRing     = mmap( nullptr, m_nBufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+   if( MAP_FAILED == m_pBufRing )
+   {
+      m_pBufRing = nullptr;
+      return false;
+   }
+
+   struct io_uring_buf_reg reg;
+   memset( &reg, 0, sizeof( reg ) );
+   reg.ring_addr    = reinterpret_cast<uint64_t>( m_pBufRing );
+   reg.ring_entries = a_nCount;
+   reg.bgid         = a_nGroup;
+   if( 0 != syscall( __NR_io_uring_register, m_fdRing, IORING_REGISTER_PBUF_RING, &reg, 1 ) )
+   {
+      munmap( m_pBufRing, m_nBufRingSize );
+      m_pBufRing = nullptr;
+      return false;
+   }
+
+   void* pBuffers = nullptr;
+   if( 0 != posix_memalign( &pBuffers, 4096, static_cast<size_t>( a_nCount ) * a_nSize ) )
+   {
+      return false;
+   }
+   m_pBuffers  = reinterpret_cast<uint8_t*>( pBuffers );
+   m_nBufCount = a_nCount;
+   m_nBufSize  = a_nSize;
+   m_nBufGroup = a_nGroup;
+   m_nBufTail  = 0;
+   for( uint32_t nIndex=0; nIndex<a_nCount; ++nIndex )
+   {
+      recycleBuffer( static_cast<uint16_t>( nIndex ) );
+   }
+   return true;
+}
+
+
+
+/**
+ * @brief ...give a provided buffer back to the kernel once its data was consumed
+ *
+ * @param a_nId ...buffer id from the completion flags
+ */
+void network::URing::recycleBuffer( const uint16_t a_nId )
+{
+   // the ring is an array of io_uring_buf, the tail overlays resv of the first entry.  not indexed through
+   // io_uring_buf_ring::bufs, in C++ the flex array declaration of the header puts it 8 bytes off
+   struct io_uring_buf_ring* pRing = reinterpret_cast<struct io_uring_buf_ring*>( m_pBufRing );
+   struct io_uring_buf*      pBuf  = reinterpret_cast<struct io_uring_buf*>( m_pBufRing ) + (m_nBufTail & (m_nBufCount - 1));
+   pBuf->addr = reinterpret_cast<uint64_t>( m_pBuffers + static_cast<size_t>( a_nId ) * m_nBufSize );
+   pBuf->len  = m_nBufSize;
+   pBuf->bid  = a_nId;
+   ++m_nBufTail;
+   __atomic_store_n( &pRing->tail, m_nBufTail, __ATOMIC_RELEASE );
+}
+
+
+
+/**
+ * @brief ...next free submission entry, zeroed
+ *
+ * @return io_uring_sqe* nullptr if the submission queue is full, submit first
+ */
+io_uring_sqe* network::URing::getSqe()
+{
+   if( m_nSqTail - __atomic_load_n( m_pSqHead, __ATOMIC_ACQUIRE ) >= m_nSqEntries )
+   {
+      return nullptr;
+   }
+   const uint32_t nIndex = m_nSqTail & m_nSqMask;
+   io_uring_sqe*  pSqe   = &m_pSqes[nIndex];
+   memset( pSqe, 0, sizeof( struct io_uring_sqe ) );
+   m_pSqArray[nIndex] = nIndex;
+   ++m_nSqTail;
+   ++m_nToSubmit;
+   return pSqe;
+}
+
+
+
+// free sqe, submitting the queued ones if the queue is full
+static io_uring_sqe* nextSqe( network::URing& a_ring )
+{
+   io_uring_sqe* pSqe = a_ring.getSqe();
+   if( nullptr == pSqe )
+   {
+      a_ring.submit();
+      pSqe = a_ring.getSqe();
+   }
+   return pSqe;
+}
+
+
+
+/**
+ * @brief ...accept that stays armed, one completion per new connection, res is the accepted (non-blocking) fd
+ *
+ * @param a_fd ...listener
+ * @param a_nUserData ...
+ * @return bool
+ */
+bool network::URing::prepAcceptMultishot( const int32_t a_fd, const uint64_t a_nUserData )
+{
+   io_uring_sqe* pSqe = nextSqe( *this );
+   if( nullptr == pSqe )
+   {
+      return false;
+   }
+   pSqe->opcode         = IORING_OP_ACCEPT;
+   pSqe->fd             = a_fd;
+   pSqe->ioprio         = IORING_ACCEPT_MULTISHOT;
+   pSqe->accept_flags   = SOCK_NONBLOCK;
+   pSqe->user_data      = a_nUserData;
+   return true;
+}
+
+
+
+/**
+ * @brief ...recv that stays armed, every completion carries a buffer from the provided buffer ring
+ *
+ * @param a_fd ...socket
+ * @param a_nUserData ...
+ * @return bool
+ */
+bool network::URing::prepRecvMultishot( const int32_t a_fd, const uint64_t a_nUserData )
+{
+   io_uring_sqe* pSqe = nextSqe( *this );
+   if( nullptr == pSqe )
+   {
+      return false;
+   }
+   pSqe->opcode         = IORING_OP_RECV;
+   pSqe->fd             = a_fd;
+   pSqe->flags          = IOSQE_BUFFER_SELECT;
+   pSqe->ioprio         = IORING_RECV_MULTISHOT;
+   pSqe->buf_group      = m_nBufGroup;
+   pSqe->user_data      = a_nUserData;
+   return true;
+}
+
+
+
+/**
+ * @brief ...poll that stays armed, used when the application reads the socket itself
+ *
+ * @param a_fd ...socket
+ * @param a_nEvents ...POLLIN...
+ * @param a_nUserData ...
+ * @return bool
+ */
+bool network::URing::prepPollMultishot( const int32_t a_fd, const uint32_t a_nEvents, const uint64_t a_nUserData )
+{
+   if( false == prepPoll( a_fd, a_nEvents, a_nUserData ) )
+   {
+      return false;
+   }
+   m_pSqes[(m_nSqTail - 1) & m_nSqMask].len = IORING_POLL_ADD_MULTI;
+   return true;
+}
+
+
+
+/**
+ * @brief ...one shot poll
+ *
+ * @param a_fd ...socket
+ * @param a_nEvents ...POLLIN, POLLOUT...
+ * @param a_nUserData ...
+ * @return bool
+ */
+bool network::URing::prepPoll( const int32_t a_fd, const uint32_t a_nEvents, const uint64_t a_nUserData )
+{
+   io_uring_sqe* pSqe = nextSqe( *this );
+   if( nullptr == pSqe )
+   {
+      return false;
+   }
+   pSqe->opcode         = IORING_OP_POLL_ADD;
+   pSqe->fd             = a_fd;
+   pSqe->poll32_events  = a_nEvents;
+   pSqe->user_data      = a_nUserData;
+   return true;
+}
+
+
+
+/**
+ * @brief ...send, the buffer must stay untouched until the completion
+ *
+ * @param a_fd ...socket
+ * @param a_pBuffer ...
+ * @param a_nSize ...
+ * @param a_nUserData ...
+ * @return bool
+ */
+bool network::URing::prepSend( const int32_t a_fd, const void* a_pBuffer, const size_t a_nSize, const uint64_t a_nUserData )
+{
+   io_uring_sqe* pSqe = nextSqe( *this );
+   if( nullptr == pSqe )
+   {
+      return false;
+   }
+   pSqe->opcode         = IORING_OP_SEND;
+   pSqe->fd             = a_fd;
+   pSqe->addr           = reinterpret_cast<uint64_t>( a_pBuffer );
+   pSqe->len            = static_cast<uint32_t>( a_nSize );
+   pSqe->msg_flags      = MSG_NOSIGNAL;
+   pSqe->user_data      = a_nUserData;
+   return true;
+}
+
+
+
+/**
+ * @brief ...completion after a_nTimeout_ms, res -ETIME.  only one timeout can be in flight
+ *
+ * @param a_nTimeout_ms ...
+ * @param a_nUserData ...
+ * @return bool
+ */
+bool network::URing::prepTimeout( const int32_t a_nTimeout_ms, const uint64_t a_nUserData )
+{
+   io_uring_sqe* pSqe = nextSqe( *this );
+   if( nullptr == pSqe )
+   {
+      return false;
+   }
+   m_timeout.tv_sec     = a_nTimeout_ms / 1000;
+   m_timeout.tv_nsec    = static_cast<int64_t>( a_nTimeout_ms % 1000 ) * 1000000;
+   pSqe->opcode         = IORING_OP_TIMEOUT;
+   pSqe->fd             = -1;
+   pSqe->addr           = reinterpret_cast<uint64_t>( &m_timeout );
+   pSqe->len            = 1;
+   pSqe->user_data      = a_nUserData;
+   return true;
+}
+
+
+
+/**
+ * @brief ...cancel the request submitted with a_nTarget as user data, ex a multishot recv before the fd is closed
+ *
+ * @param a_nTarget ...user data of the request to cancel
+ * @param a_nUserData ...
+ * @return bool
+ */
+bool network::URing::prepCancel( const uint64_t a_nTarget, const uint64_t a_nUserData )
+{
+   io_uring_sqe* pSqe = nextSqe( *this );
+   if( nullptr == pSqe )
+   {
+      return false;
+   }
+   pSqe->opcode         = IORING_OP_ASYNC_CANCEL;
+   pSqe->fd             = -1;
+   pSqe->addr           = a_nTarget;
+   pSqe->user_data      = a_nUserData;
+   return true;
+}
+
+
+
+/**
+ * @brief ...io_uring_enter
+ *
+ * @param a_nSubmit ...entries to submit
+ * @param a_nWait ...completions to wait for
+ * @return int32_t
+ */
+int32_t network::URing::enter_( const uint32_t a_nSubmit, const uint32_t a_nWait )
+{
+   return static_cast<int32_t>( syscall( __NR_io_uring_enter, m_fdRing, a_nSubmit, a_nWait, (a_nWait > 0) ? IORING_ENTER_GETEVENTS : 0, nullptr, 0 ) );
+}
+
+
+
+/**
+ * @brief ...submit all prepared entries in one syscall
+ *
+ * @return int32_t entries submitted, -1 on error
+ */
+int32_t network::URing::submit()
+{
+   if( 0 == m_nToSubmit )
+   {
+      return 0;
+   }
+   __atomic_store_n( m_pSqTail, m_nSqTail, __ATOMIC_RELEASE );
+   int32_t nResult = enter_( m_nToSubmit, 0 );
+   if( nResult > 0 )
+   {
+      m_nToSubmit -= static_cast<uint32_t>( nResult );
+   }
+   return nResult;
+}
+
+
+
+/**
+ * @brief ...block until at least one completion, does not submit
+ *
+ * @return int32_t -1 on error, errno EINTR on a signal
+ */
+int32_t network::URing::wait()
+{
+   return enter_( 0, 1 );
+}
+
+
+
+/**
+ * @brief ...submit all prepared entries and block until at least one completion, one syscall
+ *
+ * @return int32_t -1 on error, errno EINTR on a signal
+ */
+int32_t network::URing::submitAndWait()
+{
+   __atomic_store_n( m_pSqTail, m_nSqTail, __ATOMIC_RELEASE );
+   int32_t nResult = enter_( m_nToSubmit, 1 );
+   if( nResult > 0 )
+   {
+      m_nToSubmit -= (static_cast<uint32_t>( nResult ) < m_nToSubmit) ? static_cast<uint32_t>( nResult ) : m_nToSubmit;
+   }
+   return nResult;
+}
+
+
+
+/**
+ * @brief ...next completion
+ *
+ * @return io_uring_cqe* nullptr if none, call cqeSeen when done with it
+ */
+io_uring_cqe* network::URing::peekCqe()
+{
+   const uint32_t nHead = *m_pCqHead;
+   if( nHead == __atomic_load_n( m_pCqTail, __ATOMIC_ACQUIRE ) )
+   {
+      return nullptr;
+   }
+   return &m_pCqes[nHead & m_nCqMask];
+}
+
+
+
+/**
+ * @brief ...release the completion returned by peekCqe
+ *
+ */
+void network::URing::cqeSeen()
+{
+   __atomic_store_n( m_pCqHead, *m_pCqHead + 1, __ATOMIC_RELEASE );
+}
+
+
+
+/**
+ * @brief ...true if the kernel has what the IO_URING engine uses: provided buffer rings and multishot recv (linux 6.0)
+ *
+ * @return bool
+ */
+bool network::URing::isSupported()
+{
+   static const bool bSupported = []()
+   {
+      struct utsname name;
+      int32_t nMajor = 0;
+      int32_t nMinor = 0;
+      if( (0 != uname( &name )) || (2 != sscanf( name.release, "%d.%d", &nMajor, &nMinor )) || (nMajor < 6) )
+      {
+         return false;
+      }
+      URing ring;
+      return ring.init( 8 ) && ring.setupBuffers( 0, 8, 64 );
+   }();
+   return bSupported;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace gdlib {
+namespace network
+{
+   /**
+    * @brief minimal io_uring ring used by the IO_URING engine of ServerAsync and ClientAsync.  Talks to the kernel with
+    * the raw syscalls (no liburing): submission and completion rings, one provided buffer ring for multishot recv,
+    * and the few opcodes the reactors need (multishot accept/recv/poll, send, timeout, cancel)
+    *
+    * getSqe, the prep calls and submit must be serialized by the owner, completions are read by one thread
+    */
+   class URing
+   {
+      private:
+         struct timespec_t
+         {
+            int64_t     tv_sec            = 0;     // same layout as __kernel_timespec
+            int64_t     tv_nsec           = 0;
+         };
+
+         int32_t        m_fdRing          = -1;
+         // submission ring
+         void*          m_pSqRing         = nullptr;
+         size_t         m_nSqRingSize     = 0;
+         uint32_t*      m_pSqHead         = nullptr;
+         uint32_t*      m_pSqTail         = nullptr;
+         uint32_t       m_nSqMask         = 0;
+         uint32_t       m_nSqEntries      = 0;
+         uint32_t*      m_pSqArray        = nullptr;
+         io_uring_sqe*  m_pSqes           = nullptr;
+         size_t         m_nSqesSize       = 0;
+         uint32_t       m_nSqTail         = 0;     // local tail, published on submit
+         uint32_t       m_nToSubmit       = 0;
+         // completion ring
+         void*          m_pCqRing         = nullptr;
+         size_t         m_nCqRingSize     = 0;
+         uint32_t*      m_pCqHead         = nullptr;
+         uint32_t*      m_pCqTail         = nullptr;
+         uint32_t       m_nCqMask         = 0;
+         io_uring_cqe*  m_pCqes           = nullptr;
+         // provided buffers for multishot recv
+         void*          m_pBufRing        = nullptr;
+         size_t         m_nBufRingSize    = 0;
+         uint8_t*       m_pBuffers        = nullptr;
+         uint32_t       m_nBufCount       = 0;
+         uint32_t       m_nBufSize        = 0;
+         uint16_t       m_nBufGroup       = 0;
+         uint16_t       m_nBufTail        = 0;
+         timespec_t     m_timeout         = timespec_t();   // one timeout in flight at a time
+
+         int32_t        enter_( const uint32_t a_nSubmit, const uint32_t a_nWait );
+
+      public:
+         URing() = default;
+         URing( const URing& ) = delete;
+         ~URing();
+
+         URing& operator =( const URing& ) = delete;
+
+         bool           init( const uint32_t a_nEntries );
+         void           release();
+         bool           setupBuffers( const uint16_t a_nGroup, const uint32_t a_nCount, const uint32_t a_nSize );
+         const uint8_t* buffer( const uint16_t a_nId ) const     { return m_pBuffers + static_cast<size_t>( a_nId ) * m_nBufSize; }
+         void           recycleBuffer( const uint16_t a_nId );
+
+         io_uring_sqe*  getSqe();
+         bool           prepAcceptMultishot( const int32_t a_fd, const uint64_t a_nUserData );
+         bool           prepRecvMultishot( const int32_t a_fd, const uint64_t a_nUserData );
+         bool           prepPollMultishot( const int32_t a_fd, const uint32_t a_nEvents, const uint64_t a_nUserData );
+         bool           prepPoll( const int32_t a_fd, const uint32_t a_nEvents, const uint64_t a_nUserData );
+         bool           prepSend( const int32_t a_fd, const void* a_pBuffer, const size_t a_nSize, const uint64_t a_nUserData );
+         bool           prepTimeout( const int32_t a_nTimeout_ms, const uint64_t a_nUserData );
+         bool           prepCancel( const uint64_t a_nTarget, const uint64_t a_nUserData );
+
+         int32_t        submit();
+         int32_t        wait();
+         int32_t        submitAndWait();
+         io_uring_cqe*  peekCqe();
+         void           cqeSeen();
+
+         int32_t        getfd() const     { return m_fdRing; }
+
+         static bool    isSupported();
+   };
+}
+}
@@ -0,0 +1,238 @@
+#include "workerpool.h"
+#include "bufferpool.h"
+#include <string.h>
+#include <errno.h>
+
+
+using namespace std;
+using namespace gdlib;
+
+
+// job the callback running on this worker thread was called for
+static thread_local int32_t  t_fdJob   = -1;
+static thread_local uint64_t t_nJobTag = 0;
+
+
+
+/**
+ * @brief ...
+ *
+ */
+network::WorkerPool::~WorkerPool()
+{
+   stop();
+}
+
+
+
+/**
+ * @brief ...start the workers
+ *
+ * @param a_nWorkers ...threads, > 0
+ * @param a_cbMessage ...called on a worker per message, the message is valid until the callback returns
+ * @param a_pData ...pointer to pass back to the callback
+ * @return bool false if already running or no callback
+ */
+bool network::WorkerPool::start( const uint32_t a_nWorkers, const workCallback_t a_cbMessage, void* const a_pData )
+{
+   if( (true == running()) || (0 == a_nWorkers) || (nullptr == a_cbMessage) )
+   {
+      return false;
+   }
+   m_cbMessage = a_cbMessage;
+   m_pData     = a_pData;
+   m_tpStart   = chrono::steady_clock::now();
+   for( uint32_t nIndex=0; nIndex<a_nWorkers; ++nIndex )
+   {
+      m_vecWorkers.emplace_back( new worker_t() );
+   }
+   for( auto& pWorker : m_vecWorkers )
+   {
+      pWorker->thd = thread( &WorkerPool::run_, this, std::ref( *pWorker ) );
+   }
+   return true;
+}
+
+
+
+/**
+ * @brief ...process what is queued, then end and join the workers
+ *
+ */
+void network::WorkerPool::stop()
+{
+   for( auto& pWorker : m_vecWorkers )
+   {
+      {
+         lock_guard<std::mutex> lock( pWorker->mux );
+         pWorker->bRun = false;
+      }
+      pWorker->cv.notify_one();
+   }
+   for( auto& pWorker : m_vecWorkers )
+   {
+      if( pWorker->thd.joinable() )
+      {
+         pWorker->thd.join();
+      }
+   }
+   m_vecWorkers.clear();
+}
+
+
+
+/**
+ * @brief ...copy a message and queue it to the worker of the fd
+ *
+ * @param a_fd ...connection, picks the worker
+ * @param a_pMessage ...
+ * @param a_nLength ...
+ * @param a_nTag ...kept with the message, see currentTag
+ * @return bool false, errno ECANCELED not running, EAGAIN the queue of the worker is at its limit, ENOMEM no buffer for
+ * the copy.  counted in stats nDropped
+ */
+bool network::WorkerPool::dispatch( const int32_t a_fd, const uint8_t* a_pMessage, const size_t a_nLength, const uint64_t a_nTag )
+{
+   if( false == running() )
+   {
+      errno = ECANCELED;
+      return false;
+   }
+   worker_t& worker = *m_vecWorkers[workerOf( a_fd )];
+   if( (0 != m_nQueueLimit) && (worker.nQueued.load( std::memory_order_relaxed ) >= m_nQueueLimit) )
+   {
+      worker.nDropped.fetch_add( 1, std::memory_order_relaxed );
+      errno = EAGAIN;
+      return false;
+   }
+   job_t  job;
+   size_t nCapacity;
+   job.fd       = a_fd;
+   job.nLength  = a_nLength;
+   job.nTag     = a_nTag;
+   job.pMessage = BufferPool::acquire( (0 == a_nLength) ? 1 : a_nLength, nCapacity );
+   if( nullptr == job.pMessage )
+   {
+      worker.nDropped.fetch_add( 1, std::memory_order_relaxed );
+      errno = ENOMEM;
+      return false;
+   }
+   memcpy( job.pMessage, a_pMessage, a_nLength );
+
+   bool     bWake;
+   uint64_t nQueued;
+   {
+      // counted with the push, the worker cannot take the job and subtract it first
+      lock_guard<std::mutex> lock( worker.mux );
+      bWake = worker.dqJobs.empty();
+      worker.dqJobs.push_back( job );
+      nQueued = worker.nQueued.fetch_add( 1, std::memory_order_relaxed ) + 1;
+   }
+   if( true == bWake )
+   {
+      worker.cv.notify_one();
+   }
+   uint64_t nHighWater = worker.nHighWater.load( std::memory_order_relaxed );
+   while( (nQueued > nHighWater) && (false == worker.nHighWater.compare_exchange_weak( nHighWater, nQueued, std::memory_order_relaxed )) )
+   {
+   }
+   return true;
+}
+
+
+
+/**
+ * @brief ...worker thread, in the callback: the tag dispatch was given with the message being handled
+ *
+ * @param a_fd ...
+ * @return uint64_t 0 when the calling thread is not handling a message of a_fd
+ */
+uint64_t network::WorkerPool::currentTag( const int32_t a_fd )
+{
+   return (a_fd == t_fdJob) ? t_nJobTag : 0;
+}
+
+
+
+/**
+ * @brief ...messageCallback_t that hands the message to a pool, a_pPool is the WorkerPool.  a message the pool refuses
+ * is dropped and counted in stats nDropped, ServerAsync reports it to its error callback instead
+ *
+ * @param a_fd ...
+ * @param a_pMessage ...
+ * @param a_nLength ...
+ * @param a_pPool ...
+ */
+void network::WorkerPool::dispatchMessage( const int32_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pPool )
+{
+   reinterpret_cast<WorkerPool*>( a_pPool )->dispatch( a_fd, a_pMessage, a_nLength );
+}
+
+
+
+/**
+ * @brief ...worker thread, take the waiting messages in one batch and call back in order
+ *
+ * @param a_worker ...
+ */
+void network::WorkerPool::run_( worker_t& a_worker )
+{
+   deque<job_t> dqBatch;
+   for( ;; )
+   {
+      {
+         unique_lock<std::mutex> lock( a_worker.mux );
+         a_worker.cv.wait( lock, [&a_worker] { return (false == a_worker.dqJobs.empty()) || (false == a_worker.bRun); } );
+         if( true == a_worker.dqJobs.empty() )
+         {
+            return;     // stopped and drained
+         }
+         dqBatch.swap( a_worker.dqJobs );
+      }
+
+      const auto tpBegin = chrono::steady_clock::now();
+      for( const job_t& job : dqBatch )
+      {
+         t_fdJob   = job.fd;
+         t_nJobTag = job.nTag;
+         m_cbMessage( job.fd, job.pMessage, job.nLength, m_pData );
+         BufferPool::release( job.pMessage );
+         a_worker.nQueued.fetch_sub( 1, std::memory_order_relaxed );
+      }
+      t_fdJob   = -1;
+      t_nJobTag = 0;
+      const auto nBusy_ns = chrono::duration_cast<chrono::nanoseconds>( chrono::steady_clock::now() - tpBegin ).count();
+      a_worker.nBusy_ns.fetch_add( static_cast<uint64_t>( nBusy_ns ), std::memory_order_relaxed );
+      a_worker.nProcessed.fetch_add( dqBatch.size(), std::memory_order_relaxed );
+      dqBatch.clear();
+   }
+}
+
+
+
+/**
+ * @brief ...queue depth and utilization of a worker
+ *
+ * @param a_nWorker ...0..size()-1
+ * @return network::workerStats_t
+ */
+network::workerStats_t network::WorkerPool::stats( const uint32_t a_nWorker ) const
+{
+   workerStats_t stats;
+   if( a_nWorker >= size() )
+   {
+      return stats;
+   }
+   const worker_t& worker = *m_vecWorkers[a_nWorker];
+   stats.nQueued     = worker.nQueued.load( std::memory_order_relaxed );
+   stats.nHighWater  = worker.nHighWater.load( std::memory_order_relaxed );
+   stats.nProcessed  = worker.nProcessed.load( std::memory_order_relaxed );
+   stats.nDropped    = worker.nDropped.load( std::memory_order_relaxed );
+   stats.nBusy_ns    = worker.nBusy_ns.load( std::memory_order_relaxed );
+   const auto nElapsed_ns = chrono::duration_cast<chrono::nanoseconds>( chrono::steady_clock::now() - m_tpStart ).count();
+   if( nElapsed_ns > 0 )
+   {
+      stats.dUtilization = static_cast<double>( stats.nBusy_ns ) / static_cast<double>( nElapsed_ns );
+   }
+   return stats;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gdlib {
+namespace network
+{
+   using workCallback_t = void( * )( const int32_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pData );  // same as messageCallback_t
+
+   /**
+    * @brief usage of one worker, see WorkerPool::stats
+    */
+   struct workerStats_t
+   {
+      uint64_t    nQueued        = 0;     // messages queued and not yet processed
+      uint64_t    nHighWater     = 0;     // most messages waiting at once
+      uint64_t    nProcessed     = 0;
+      uint64_t    nDropped       = 0;     // messages refused by dispatch, the queue was full or no buffer
+      uint64_t    nBusy_ns       = 0;     // time spent in the callback
+      double      dUtilization   = 0.0;   // busy time / time since start, 0..1
+   };
+
+
+
+   /**
+    * @brief fixed size pool of worker threads running the message callback off the reactor thread.  The reactor copies
+    * each message into a BufferPool buffer and queues it to worker fd % count, so the messages of a connection are
+    * processed in order by one worker while different connections spread across the workers.  A worker takes all
+    * waiting messages of its queue at once, the reactor and the worker meet on one lock per batch.  a queue has no limit
+    * by default.  setQueueLimit makes dispatch refuse messages beyond it (EAGAIN) instead of letting a slow callback grow
+    * memory without bound, opt in only where losing a message is acceptable, ex not on a framed stream
+    *
+    * dispatch is called by the reactors, the callback runs on the workers.  the tag given to dispatch, ex the use of the fd
+    * the message was read from, is returned by currentTag while the callback of the message runs
+    */
+   class WorkerPool
+   {
+      private:
+         struct job_t
+         {
+            int32_t     fd                = -1;
+            uint8_t*    pMessage          = nullptr;     // pool buffer, released after the callback
+            size_t      nLength           = 0;
+            uint64_t    nTag              = 0;           // of dispatch, currentTag while the callback runs
+         };
+
+         struct worker_t
+         {
+            std::mutex              mux         = {};
+            std::condition_variable cv          = {};
+            std::deque<job_t>       dqJobs      = std::deque<job_t>();
+            std::thread             thd         = std::thread();
+            bool                    bRun        = true;
+            std::atomic<uint64_t>   nQueued     = {0};
+            std::atomic<uint64_t>   nHighWater  = {0};
+            std::atomic<uint64_t>   nProcessed  = {0};
+            std::atomic<uint64_t>   nBusy_ns    = {0};
+            std::atomic<uint64_t>   nDropped    = {0};
+         };
+
+         std::vector<std::unique_ptr<worker_t>>   m_vecWorkers   = std::vector<std::unique_ptr<worker_t>>();
+         workCallback_t                           m_cbMessage    = nullptr;
+         void*                                    m_pData        = nullptr;
+         std::chrono::steady_clock::time_point    m_tpStart      = std::chrono::steady_clock::time_point();
+         uint64_t                                 m_nQueueLimit  = 0;         // messages per worker, 0 no limit
+
+         void run_( worker_t& a_worker );
+
+      public:
+         WorkerPool() = default;
+         WorkerPool( const WorkerPool& ) = delete;
+         ~WorkerPool();
+
+         WorkerPool& operator =( const WorkerPool& ) = delete;
+
+         bool           start( const uint32_t a_nWorkers, const workCallback_t a_cbMessage, void* const a_pData );
+         void           stop();
+         bool           dispatch( const int32_t a_fd, const uint8_t* a_pMessage, const size_t a_nLength, const uint64_t a_nTag = 0 );
+         void           setQueueLimit( const uint64_t a_nLimit )  { m_nQueueLimit = a_nLimit; }    // before start
+         bool           running() const                          { return false == m_vecWorkers.empty(); }
+         uint32_t       size() const                             { return static_cast<uint32_t>( m_vecWorkers.size() ); }
+         uint32_t       workerOf( const int32_t a_fd ) const     { return static_cast<uint32_t>( a_fd ) % size(); }
+         workerStats_t  stats( const uint32_t a_nWorker ) const;
+
+         static uint64_t currentTag( const int32_t a_fd );
+         static void    dispatchMessage( const int32_t& a_fd, const uint8_t* a_pMessage, const size_t a_nLength, void* const a_pPool );
+   };
+}
+}